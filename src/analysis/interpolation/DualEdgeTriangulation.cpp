@@ -36,14 +36,7 @@ DualEdgeTriangulation::~DualEdgeTriangulation()
     }
   }
 
-  //remove all the HalfEdge
-  if ( !mHalfEdge.isEmpty() )
-  {
-    for ( int i = 0; i < mHalfEdge.count(); i++ )
-    {
-      delete mHalfEdge[i];
-    }
-  }
+  //the HalfEdges are owned by mHalfEdgeStorage
 }
 
 void DualEdgeTriangulation::performConsistencyTest()
@@ -1188,8 +1181,8 @@ bool DualEdgeTriangulation::getTriangle( double x, double y, QgsPoint *p1, QgsPo
 
 unsigned int DualEdgeTriangulation::insertEdge( int dual, int next, int point, bool mbreak, bool forced )
 {
-  HalfEdge *edge = new HalfEdge( dual, next, point, mbreak, forced );
-  mHalfEdge.append( edge );
+  mHalfEdgeStorage.emplace_back( dual, next, point, mbreak, forced );
+  mHalfEdge.append( &mHalfEdgeStorage.back() );
   return mHalfEdge.count() - 1;
 
 }
@@ -2779,14 +2772,16 @@ bool DualEdgeTriangulation::readFromTAFF( QString filename )
       break2 = true;
     }
 
-    HalfEdge *hf1 = new HalfEdge();
+    mHalfEdgeStorage.emplace_back();
+    HalfEdge *hf1 = &mHalfEdgeStorage.back();
     hf1->setDual( nr2 );
     hf1->setNext( next1 );
     hf1->setPoint( point1 );
     hf1->setBreak( break1 );
     hf1->setForced( forced1 );
 
-    HalfEdge *hf2 = new HalfEdge();
+    mHalfEdgeStorage.emplace_back();
+    HalfEdge *hf2 = &mHalfEdgeStorage.back();
     hf2->setDual( nr1 );
     hf2->setNext( next2 );
     hf2->setPoint( point2 );
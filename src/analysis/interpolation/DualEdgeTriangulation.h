@@ -31,6 +31,7 @@
 #include <QBuffer>
 #include <QStringList>
 #include <QCursor>
+#include <deque>
 #include "qgis_analysis.h"
 
 #define SIP_NO_FILE
@@ -122,6 +123,8 @@ class ANALYSIS_EXPORT DualEdgeTriangulation: public Triangulation
     static const unsigned int DEFAULT_STORAGE_FOR_HALF_EDGES = 300006;
     //! Stores pointers to the HalfEdges
     QVector<HalfEdge *> mHalfEdge;
+    //! Owns the HalfEdges, allocated in large contiguous blocks which are never moved
+    std::deque<HalfEdge> mHalfEdgeStorage;
     //! Association to an interpolator object
     TriangleInterpolator *mTriangleInterpolator = nullptr;
     //! Member to store the behavior in case of crossing forced segments
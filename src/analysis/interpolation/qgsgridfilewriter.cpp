@@ -21,6 +21,17 @@
 #include "qgsfeedback.h"
 #include <QFile>
 #include <QFileInfo>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+
+#include <gdal.h>
+#include <cpl_string.h>
+
+//! Number of rows interpolated together before being written
+static const int ROWS_PER_BATCH = 64;
+
+static const double NODATA_VALUE = -9999;
 
 QgsGridFileWriter::QgsGridFileWriter( QgsInterpolator *i, const QString &outputPath, const QgsRectangle &extent, int nCols, int nRows, double cellSizeX, double cellSizeY )
   : mInterpolator( i )
@@ -45,6 +56,67 @@ QgsGridFileWriter::QgsGridFileWriter()
 }
 
 int QgsGridFileWriter::writeFile( QgsFeedback *feedback )
+{
+  switch ( mOutputFormat )
+  {
+    case GeoTiff:
+      return writeGeoTiff( feedback );
+
+    case AsciiGrid:
+      break;
+  }
+  return writeAsciiGrid( feedback );
+}
+
+void QgsGridFileWriter::interpolateRows( int firstRow, int rowCount, QVector<double> &values ) const
+{
+  values.resize( rowCount * mNumColumns );
+  double *data = values.data();
+
+  auto interpolateCell = [ = ]( int row, int column )
+  {
+    const double yValue = mInterpolationExtent.yMaximum() - mCellSizeY / 2.0 - ( firstRow + row ) * mCellSizeY; //calculate value in the center of the cell
+    const double xValue = mInterpolationExtent.xMinimum() + mCellSizeX / 2.0 + column * mCellSizeX;
+    double interpolatedValue;
+    if ( mInterpolator->interpolatePoint( xValue, yValue, interpolatedValue ) == 0 )
+      data[row * mNumColumns + column] = interpolatedValue;
+    else
+      data[row * mNumColumns + column] = NODATA_VALUE;
+  };
+  auto interpolateRow = [ = ]( int row )
+  {
+    for ( int j = 0; j < mNumColumns; ++j )
+      interpolateCell( row, j );
+  };
+
+  if ( rowCount > 1 && mInterpolator->supportsConcurrentInterpolation() )
+  {
+    QVector<int> rows;
+    rows.reserve( rowCount );
+    for ( int row = 0; row < rowCount; ++row )
+      rows << row;
+    QtConcurrent::blockingMap( rows, interpolateRow );
+  }
+  else
+  {
+    // walk the rows in serpentine order, interpolators locating the points
+    // from the last one (like the TIN) then only take a few steps per cell
+    for ( int row = 0; row < rowCount; ++row )
+    {
+      if ( ( firstRow + row ) % 2 == 0 )
+      {
+        interpolateRow( row );
+      }
+      else
+      {
+        for ( int j = mNumColumns - 1; j >= 0; --j )
+          interpolateCell( row, j );
+      }
+    }
+  }
+}
+
+int QgsGridFileWriter::writeAsciiGrid( QgsFeedback *feedback )
 {
   QFile outputFile( mOutputFilePath );
 
@@ -59,31 +131,34 @@ int QgsGridFileWriter::writeFile( QgsFeedback *feedback )
     return 2;
   }
 
+  mInterpolator->prepare();
+
   QTextStream outStream( &outputFile );
   outStream.setRealNumberPrecision( 8 );
   writeHeader( outStream );
 
-  double currentYValue = mInterpolationExtent.yMaximum() - mCellSizeY / 2.0; //calculate value in the center of the cell
-  double currentXValue;
-  double interpolatedValue;
-
-  for ( int i = 0; i < mNumRows; ++i )
+  QVector<double> values;
+  for ( int firstRow = 0; firstRow < mNumRows; firstRow += ROWS_PER_BATCH )
   {
-    currentXValue = mInterpolationExtent.xMinimum() + mCellSizeX / 2.0; //calculate value in the center of the cell
-    for ( int j = 0; j < mNumColumns; ++j )
+    const int rowCount = std::min( ROWS_PER_BATCH, mNumRows - firstRow );
+    interpolateRows( firstRow, rowCount, values );
+
+    const double *value = values.constData();
+    for ( int i = 0; i < rowCount; ++i )
     {
-      if ( mInterpolator->interpolatePoint( currentXValue, currentYValue, interpolatedValue ) == 0 )
+      for ( int j = 0; j < mNumColumns; ++j, ++value )
       {
-        outStream << interpolatedValue << ' ';
+        if ( *value != NODATA_VALUE )
+        {
+          outStream << *value << ' ';
+        }
+        else
+        {
+          outStream << "-9999 ";
+        }
       }
-      else
-      {
-        outStream << "-9999 ";
-      }
-      currentXValue += mCellSizeX;
+      outStream << endl;
     }
-    outStream << endl;
-    currentYValue -= mCellSizeY;
 
     if ( feedback )
     {
@@ -92,15 +167,11 @@ int QgsGridFileWriter::writeFile( QgsFeedback *feedback )
         outputFile.remove();
         return 3;
       }
-      feedback->setProgress( 100.0 * i / static_cast< double >( mNumRows ) );
+      feedback->setProgress( 100.0 * ( firstRow + rowCount ) / static_cast< double >( mNumRows ) );
     }
   }
 
   // create prj file
-  QgsInterpolator::LayerData ld;
-  ld = mInterpolator->layerData().at( 0 );
-  QgsVectorLayer *vl = ld.vectorLayer;
-  QString crs = vl->crs().toWkt();
   QFileInfo fi( mOutputFilePath );
   QString fileName = fi.absolutePath() + '/' + fi.completeBaseName() + ".prj";
   QFile prjFile( fileName );
@@ -109,13 +180,82 @@ int QgsGridFileWriter::writeFile( QgsFeedback *feedback )
     return 1;
   }
   QTextStream prjStream( &prjFile );
-  prjStream << crs;
+  prjStream << crsWkt();
   prjStream << endl;
   prjFile.close();
 
   return 0;
 }
 
+int QgsGridFileWriter::writeGeoTiff( QgsFeedback *feedback )
+{
+  if ( !mInterpolator )
+  {
+    return 2;
+  }
+
+  GDALAllRegister();
+  GDALDriverH driver = GDALGetDriverByName( "GTiff" );
+  if ( !driver )
+  {
+    return 1;
+  }
+
+  char **options = nullptr;
+  options = CSLSetNameValue( options, "COMPRESS", "LZW" );
+  options = CSLSetNameValue( options, "TILED", "YES" );
+  GDALDatasetH dataset = GDALCreate( driver, mOutputFilePath.toUtf8().constData(), mNumColumns, mNumRows, 1, GDT_Float32, options );
+  CSLDestroy( options );
+  if ( !dataset )
+  {
+    return 1;
+  }
+
+  double geoTransform[6] = { mInterpolationExtent.xMinimum(), mCellSizeX, 0, mInterpolationExtent.yMaximum(), 0, -mCellSizeY };
+  GDALSetGeoTransform( dataset, geoTransform );
+  GDALSetProjection( dataset, crsWkt().toUtf8().constData() );
+  GDALRasterBandH band = GDALGetRasterBand( dataset, 1 );
+  GDALSetRasterNoDataValue( band, NODATA_VALUE );
+
+  mInterpolator->prepare();
+
+  QVector<double> values;
+  for ( int firstRow = 0; firstRow < mNumRows; firstRow += ROWS_PER_BATCH )
+  {
+    const int rowCount = std::min( ROWS_PER_BATCH, mNumRows - firstRow );
+    interpolateRows( firstRow, rowCount, values );
+
+    if ( GDALRasterIO( band, GF_Write, 0, firstRow, mNumColumns, rowCount, values.data(), mNumColumns, rowCount, GDT_Float64, 0, 0 ) != CE_None )
+    {
+      GDALClose( dataset );
+      GDALDeleteDataset( driver, mOutputFilePath.toUtf8().constData() );
+      return 1;
+    }
+
+    if ( feedback )
+    {
+      if ( feedback->isCanceled() )
+      {
+        GDALClose( dataset );
+        GDALDeleteDataset( driver, mOutputFilePath.toUtf8().constData() );
+        return 3;
+      }
+      feedback->setProgress( 100.0 * ( firstRow + rowCount ) / static_cast< double >( mNumRows ) );
+    }
+  }
+
+  GDALClose( dataset );
+  return 0;
+}
+
+QString QgsGridFileWriter::crsWkt() const
+{
+  QgsInterpolator::LayerData ld;
+  ld = mInterpolator->layerData().at( 0 );
+  QgsVectorLayer *vl = ld.vectorLayer;
+  return vl->crs().toWkt();
+}
+
 int QgsGridFileWriter::writeHeader( QTextStream &outStream )
 {
   outStream << "NCOLS " << mNumColumns << endl;
@@ -21,17 +21,27 @@
 #include "qgsrectangle.h"
 #include <QString>
 #include <QTextStream>
+#include <QVector>
 #include "qgis_analysis.h"
 
 class QgsInterpolator;
 class QgsFeedback;
 
 /** \ingroup analysis
- * A class that does interpolation to a grid and writes the results to an ascii grid*/
-//todo: extend such that writing to other file types is possible
+ * A class that does interpolation to a grid and writes the results to an ascii grid or a GeoTIFF file.
+ * Rows are interpolated by batches, in parallel if the interpolator supports it, and written as soon as
+ * a batch is complete.*/
 class ANALYSIS_EXPORT QgsGridFileWriter
 {
   public:
+
+    //! Format of the output file
+    enum OutputFormat
+    {
+      AsciiGrid, //!< ESRI ascii grid, with a .prj file for the CRS
+      GeoTiff, //!< GeoTIFF written through GDAL, with float32 values
+    };
+
     QgsGridFileWriter( QgsInterpolator *i, const QString &outputPath, const QgsRectangle &extent, int nCols, int nRows, double cellSizeX, double cellSizeY );
 
     /** Writes the grid file.
@@ -40,11 +50,36 @@ class ANALYSIS_EXPORT QgsGridFileWriter
 
     int writeFile( QgsFeedback *feedback = nullptr );
 
+    /** Sets the format of the output file.
+     * \see outputFormat()
+     * \since QGIS 3.0
+     */
+    void setOutputFormat( OutputFormat format ) { mOutputFormat = format; }
+
+    /** Returns the format of the output file, ascii grid by default.
+     * \see setOutputFormat()
+     * \since QGIS 3.0
+     */
+    OutputFormat outputFormat() const { return mOutputFormat; }
+
   private:
 
     QgsGridFileWriter(); //forbidden
     int writeHeader( QTextStream &outStream );
 
+    //! Writes the grid as an ascii grid
+    int writeAsciiGrid( QgsFeedback *feedback );
+
+    //! Writes the grid as a GeoTIFF file
+    int writeGeoTiff( QgsFeedback *feedback );
+
+    /** Interpolates rowCount rows starting at firstRow into values (row by row),
+     * cells which cannot be interpolated are set to the no data value */
+    void interpolateRows( int firstRow, int rowCount, QVector<double> &values ) const;
+
+    //! Returns the WKT of the CRS of the interpolated layer
+    QString crsWkt() const;
+
     QgsInterpolator *mInterpolator = nullptr;
     QString mOutputFilePath;
     QgsRectangle mInterpolationExtent;
@@ -53,6 +88,8 @@ class ANALYSIS_EXPORT QgsGridFileWriter
 
     double mCellSizeX;
     double mCellSizeY;
+
+    OutputFormat mOutputFormat = AsciiGrid;
 };
 
 #endif
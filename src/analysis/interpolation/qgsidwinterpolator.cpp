@@ -16,6 +16,7 @@
  ***************************************************************************/
 
 #include "qgsidwinterpolator.h"
+#include <algorithm>
 #include <cmath>
 #include <limits>
 
@@ -29,11 +30,81 @@ QgsIDWInterpolator::QgsIDWInterpolator(): QgsInterpolator( QList<LayerData>() ),
 
 }
 
-int QgsIDWInterpolator::interpolatePoint( double x, double y, double &result )
+int QgsIDWInterpolator::prepare()
 {
+  int result = 0;
   if ( !mDataIsCached )
   {
-    cacheBaseData();
+    result = cacheBaseData();
+  }
+
+  mTree = mCachedBaseData;
+  buildTree( 0, mTree.size(), 0 );
+  mIsPrepared = true;
+  return result;
+}
+
+void QgsIDWInterpolator::buildTree( int begin, int end, int depth )
+{
+  if ( end - begin < 2 )
+    return;
+
+  const int median = begin + ( end - begin ) / 2;
+  vertexData *data = mTree.data();
+  if ( depth % 2 == 0 )
+    std::nth_element( data + begin, data + median, data + end, []( const vertexData & a, const vertexData & b ) { return a.x < b.x; } );
+  else
+    std::nth_element( data + begin, data + median, data + end, []( const vertexData & a, const vertexData & b ) { return a.y < b.y; } );
+
+  buildTree( begin, median, depth + 1 );
+  buildTree( median + 1, end, depth + 1 );
+}
+
+void QgsIDWInterpolator::searchTree( int begin, int end, int depth, double x, double y, double &maxSqrDist, std::vector< Neighbor > &neighbors ) const
+{
+  if ( begin >= end )
+    return;
+
+  const int median = begin + ( end - begin ) / 2;
+  const vertexData &vertex = mTree.at( median );
+
+  const double sqrDist = ( vertex.x - x ) * ( vertex.x - x ) + ( vertex.y - y ) * ( vertex.y - y );
+  if ( sqrDist <= maxSqrDist )
+  {
+    neighbors.push_back( Neighbor{ sqrDist, &vertex } );
+    std::push_heap( neighbors.begin(), neighbors.end() );
+    if ( mMaxNeighbors > 0 && static_cast< int >( neighbors.size() ) > mMaxNeighbors )
+    {
+      std::pop_heap( neighbors.begin(), neighbors.end() );
+      neighbors.pop_back();
+    }
+    if ( mMaxNeighbors > 0 && static_cast< int >( neighbors.size() ) == mMaxNeighbors )
+    {
+      maxSqrDist = std::min( maxSqrDist, neighbors.front().sqrDist );
+    }
+  }
+
+  // visit the side of the split containing the location first, the other one only if it may contain closer points
+  const double delta = depth % 2 == 0 ? x - vertex.x : y - vertex.y;
+  if ( delta < 0 )
+  {
+    searchTree( begin, median, depth + 1, x, y, maxSqrDist, neighbors );
+    if ( delta * delta <= maxSqrDist )
+      searchTree( median + 1, end, depth + 1, x, y, maxSqrDist, neighbors );
+  }
+  else
+  {
+    searchTree( median + 1, end, depth + 1, x, y, maxSqrDist, neighbors );
+    if ( delta * delta <= maxSqrDist )
+      searchTree( begin, median, depth + 1, x, y, maxSqrDist, neighbors );
+  }
+}
+
+int QgsIDWInterpolator::interpolatePoint( double x, double y, double &result )
+{
+  if ( !mIsPrepared )
+  {
+    prepare();
   }
 
   double currentWeight;
@@ -42,17 +113,40 @@ int QgsIDWInterpolator::interpolatePoint( double x, double y, double &result )
   double sumCounter = 0;
   double sumDenominator = 0;
 
-  Q_FOREACH ( const vertexData &vertex_it, mCachedBaseData )
+  if ( mMaxNeighbors <= 0 && mSearchRadius <= 0 )
+  {
+    Q_FOREACH ( const vertexData &vertex_it, mCachedBaseData )
+    {
+      distance = std::sqrt( ( vertex_it.x - x ) * ( vertex_it.x - x ) + ( vertex_it.y - y ) * ( vertex_it.y - y ) );
+      if ( ( distance - 0 ) < std::numeric_limits<double>::min() )
+      {
+        result = vertex_it.z;
+        return 0;
+      }
+      currentWeight = 1 / ( std::pow( distance, mDistanceCoefficient ) );
+      sumCounter += ( currentWeight * vertex_it.z );
+      sumDenominator += currentWeight;
+    }
+  }
+  else
   {
-    distance = std::sqrt( ( vertex_it.x - x ) * ( vertex_it.x - x ) + ( vertex_it.y - y ) * ( vertex_it.y - y ) );
-    if ( ( distance - 0 ) < std::numeric_limits<double>::min() )
+    std::vector< Neighbor > neighbors;
+    neighbors.reserve( mMaxNeighbors > 0 ? mMaxNeighbors + 1 : 64 );
+    double maxSqrDist = mSearchRadius > 0 ? mSearchRadius * mSearchRadius : std::numeric_limits<double>::max();
+    searchTree( 0, mTree.size(), 0, x, y, maxSqrDist, neighbors );
+
+    for ( const Neighbor &neighbor : neighbors )
     {
-      result = vertex_it.z;
-      return 0;
+      distance = std::sqrt( neighbor.sqrDist );
+      if ( ( distance - 0 ) < std::numeric_limits<double>::min() )
+      {
+        result = neighbor.vertex->z;
+        return 0;
+      }
+      currentWeight = 1 / ( std::pow( distance, mDistanceCoefficient ) );
+      sumCounter += ( currentWeight * neighbor.vertex->z );
+      sumDenominator += currentWeight;
     }
-    currentWeight = 1 / ( std::pow( distance, mDistanceCoefficient ) );
-    sumCounter += ( currentWeight * vertex_it.z );
-    sumDenominator += currentWeight;
   }
 
   if ( sumDenominator == 0.0 )
@@ -21,6 +21,8 @@
 #include "qgsinterpolator.h"
 #include "qgis_analysis.h"
 
+#include <vector>
+
 /** \ingroup analysis
  * \class QgsIDWInterpolator
  */
@@ -36,16 +38,81 @@ class ANALYSIS_EXPORT QgsIDWInterpolator: public QgsInterpolator
        \returns 0 in case of success*/
     int interpolatePoint( double x, double y, double &result ) override;
 
+    /** Caches the base data and builds the spatial index used to find the nearest points.
+     \returns 0 in case of success*/
+    int prepare() override;
+
+    bool supportsConcurrentInterpolation() const override { return true; }
+
     void setDistanceCoefficient( double p ) {mDistanceCoefficient = p;}
 
+    /** Sets the maximum number of nearest points used to interpolate a value.
+     * \param count maximum number of points, or 0 to use all points (the default)
+     * \see maxNeighbors()
+     * \see setSearchRadius()
+     * \since QGIS 3.0
+     */
+    void setMaxNeighbors( int count ) { mMaxNeighbors = count; }
+
+    /** Returns the maximum number of nearest points used to interpolate a value,
+     * 0 if all points are used.
+     * \see setMaxNeighbors()
+     * \since QGIS 3.0
+     */
+    int maxNeighbors() const { return mMaxNeighbors; }
+
+    /** Sets the radius (in map units) around the interpolated location within which the points
+     * are used. Locations without any point within the radius are not interpolated.
+     * \param radius search radius, or 0 for no limit (the default)
+     * \see searchRadius()
+     * \see setMaxNeighbors()
+     * \since QGIS 3.0
+     */
+    void setSearchRadius( double radius ) { mSearchRadius = radius; }
+
+    /** Returns the radius (in map units) around the interpolated location within which the points
+     * are used, 0 if there is no limit.
+     * \see setSearchRadius()
+     * \since QGIS 3.0
+     */
+    double searchRadius() const { return mSearchRadius; }
+
   private:
 
     QgsIDWInterpolator(); //forbidden
 
+    //! A point found by a search in the tree, with its squared distance to the searched location
+    struct Neighbor
+    {
+      double sqrDist;
+      const vertexData *vertex;
+      bool operator<( const Neighbor &other ) const { return sqrDist < other.sqrDist; }
+    };
+
+    //! Sorts the points between begin and end (excluded) of mTree as a balanced kd-tree
+    void buildTree( int begin, int end, int depth );
+
+    /** Collects the nearest points of x, y closer than maxSqrDist between begin and end (excluded) of mTree.
+     * neighbors is a max heap, maxSqrDist is reduced as soon as it contains mMaxNeighbors points.
+     */
+    void searchTree( int begin, int end, int depth, double x, double y, double &maxSqrDist, std::vector< Neighbor > &neighbors ) const;
+
     /** The parameter that sets how the values are weighted with distance.
        Smaller values mean sharper peaks at the data points. The default is a
        value of 2*/
     double mDistanceCoefficient;
+
+    //! Maximum number of points used for a location, 0 means all points
+    int mMaxNeighbors = 0;
+
+    //! Search radius, 0 means no limit
+    double mSearchRadius = 0;
+
+    //! Base data sorted as an implicit kd-tree: the median of each range splits it alternately along x and y
+    QVector<vertexData> mTree;
+
+    //! Whether prepare() has been called
+    bool mIsPrepared = false;
 };
 
 #endif
@@ -35,6 +35,14 @@ QgsInterpolator::QgsInterpolator()
 
 }
 
+int QgsInterpolator::prepare()
+{
+  if ( mDataIsCached )
+    return 0;
+
+  return cacheBaseData();
+}
+
 int QgsInterpolator::cacheBaseData()
 {
   if ( mLayerData.size() < 1 )
@@ -67,6 +67,19 @@ class ANALYSIS_EXPORT QgsInterpolator
        \returns 0 in case of success*/
     virtual int interpolatePoint( double x, double y, double &result ) = 0;
 
+    /** Prepares the interpolation, e.g. caches the base data. It is called before
+     * interpolating a whole grid, the default implementation caches the base data if needed.
+     * \returns 0 in case of success
+     * \since QGIS 3.0
+     */
+    virtual int prepare();
+
+    /** Returns true if interpolatePoint() may be called from several threads at the same
+     * time once prepare() has been called.
+     * \since QGIS 3.0
+     */
+    virtual bool supportsConcurrentInterpolation() const { return false; }
+
     //! \note not available in Python bindings
     QList<LayerData> layerData() const { return mLayerData; } SIP_SKIP
 
@@ -28,6 +28,44 @@
 #include "qgsvectorlayer.h"
 #include "qgswkbptr.h"
 #include "qgsfeedback.h"
+#include "qgslogger.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+///@cond PRIVATE
+namespace
+{
+  //! Side of the Hilbert curve grid the vertices are snapped to
+  const quint32 HILBERT_SIZE = 1 << 16;
+
+  //! Below this number of vertices, the first BRIO round is not split further
+  const int BRIO_MIN_ROUND_SIZE = 64;
+
+  //! Distance along the Hilbert curve of the cell x, y
+  quint32 hilbertIndex( quint32 x, quint32 y )
+  {
+    quint32 d = 0;
+    for ( quint32 s = HILBERT_SIZE / 2; s > 0; s /= 2 )
+    {
+      const quint32 rx = ( x & s ) > 0;
+      const quint32 ry = ( y & s ) > 0;
+      d += s * s * ( ( 3 * rx ) ^ ry );
+      if ( ry == 0 )
+      {
+        if ( rx == 1 )
+        {
+          x = HILBERT_SIZE - 1 - x;
+          y = HILBERT_SIZE - 1 - y;
+        }
+        std::swap( x, y );
+      }
+    }
+    return d;
+  }
+}
+///@endcond
 
 QgsTINInterpolator::QgsTINInterpolator( const QList<LayerData> &inputData, TINInterpolation interpolation, QgsFeedback *feedback )
   : QgsInterpolator( inputData )
@@ -132,6 +170,10 @@ void QgsTINInterpolator::initialize()
       }
     }
   }
+  if ( insertBufferedPoints() != 0 )
+  {
+    QgsDebugMsg( "Some vertices could not be inserted into the triangulation because of numerical problems" );
+  }
 
   if ( mInterpolation == CloughTocher )
   {
@@ -198,6 +240,7 @@ int QgsTINInterpolator::insertData( QgsFeature *f, bool zCoord, int attr, InputT
   currentWkbPtr.readHeader();
   //maybe a structure or break line
   Line3D *line = nullptr;
+  int result = 0;
 
   QgsWkbTypes::Type wkbType = g.wkbType();
   switch ( wkbType )
@@ -216,11 +259,7 @@ int QgsTINInterpolator::insertData( QgsFeature *f, bool zCoord, int attr, InputT
       {
         z = attributeValue;
       }
-      QgsPoint *point = new QgsPoint( x, y, z );
-      if ( mTriangulation->addPoint( point ) == -100 )
-      {
-        return -1;
-      }
+      mBufferedPoints << x << y << z;
       break;
     }
     case QgsWkbTypes::MultiPoint25D:
@@ -270,8 +309,7 @@ int QgsTINInterpolator::insertData( QgsFeature *f, bool zCoord, int attr, InputT
 
         if ( type == POINTS )
         {
-          //todo: handle error code -100
-          mTriangulation->addPoint( new QgsPoint( x, y, z ) );
+          mBufferedPoints << x << y << z;
         }
         else
         {
@@ -281,6 +319,10 @@ int QgsTINInterpolator::insertData( QgsFeature *f, bool zCoord, int attr, InputT
 
       if ( type != POINTS )
       {
+        if ( insertBufferedPoints() != 0 )
+        {
+          result = -1;
+        }
         mTriangulation->addLine( line, type == BREAK_LINES );
       }
       break;
@@ -314,8 +356,7 @@ int QgsTINInterpolator::insertData( QgsFeature *f, bool zCoord, int attr, InputT
 
           if ( type == POINTS )
           {
-            //todo: handle error code -100
-            mTriangulation->addPoint( new QgsPoint( x, y, z ) );
+            mBufferedPoints << x << y << z;
           }
           else
           {
@@ -324,6 +365,10 @@ int QgsTINInterpolator::insertData( QgsFeature *f, bool zCoord, int attr, InputT
         }
         if ( type != POINTS )
         {
+          if ( insertBufferedPoints() != 0 )
+          {
+            result = -1;
+          }
           mTriangulation->addLine( line, type == BREAK_LINES );
         }
       }
@@ -358,8 +403,7 @@ int QgsTINInterpolator::insertData( QgsFeature *f, bool zCoord, int attr, InputT
           }
           if ( type == POINTS )
           {
-            //todo: handle error code -100
-            mTriangulation->addPoint( new QgsPoint( x, y, z ) );
+            mBufferedPoints << x << y << z;
           }
           else
           {
@@ -369,6 +413,10 @@ int QgsTINInterpolator::insertData( QgsFeature *f, bool zCoord, int attr, InputT
 
         if ( type != POINTS )
         {
+          if ( insertBufferedPoints() != 0 )
+          {
+            result = -1;
+          }
           mTriangulation->addLine( line, type == BREAK_LINES );
         }
       }
@@ -408,8 +456,7 @@ int QgsTINInterpolator::insertData( QgsFeature *f, bool zCoord, int attr, InputT
             }
             if ( type == POINTS )
             {
-              //todo: handle error code -100
-              mTriangulation->addPoint( new QgsPoint( x, y, z ) );
+              mBufferedPoints << x << y << z;
             }
             else
             {
@@ -418,6 +465,10 @@ int QgsTINInterpolator::insertData( QgsFeature *f, bool zCoord, int attr, InputT
           }
           if ( type != POINTS )
           {
+            if ( insertBufferedPoints() != 0 )
+            {
+              result = -1;
+            }
             mTriangulation->addLine( line, type == BREAK_LINES );
           }
         }
@@ -429,6 +480,68 @@ int QgsTINInterpolator::insertData( QgsFeature *f, bool zCoord, int attr, InputT
       break;
   }
 
-  return 0;
+  return result;
 }
 
+int QgsTINInterpolator::insertBufferedPoints()
+{
+  const int nPoints = mBufferedPoints.size() / 3;
+  if ( nPoints == 0 )
+  {
+    return 0;
+  }
+  const double *coords = mBufferedPoints.constData();
+
+  double xMin = coords[0];
+  double xMax = coords[0];
+  double yMin = coords[1];
+  double yMax = coords[1];
+  for ( int i = 1; i < nPoints; ++i )
+  {
+    xMin = std::min( xMin, coords[3 * i] );
+    xMax = std::max( xMax, coords[3 * i] );
+    yMin = std::min( yMin, coords[3 * i + 1] );
+    yMax = std::max( yMax, coords[3 * i + 1] );
+  }
+  const double xScale = xMax > xMin ? ( HILBERT_SIZE - 1 ) / ( xMax - xMin ) : 0;
+  const double yScale = yMax > yMin ? ( HILBERT_SIZE - 1 ) / ( yMax - yMin ) : 0;
+
+  QVector<quint32> keys( nPoints );
+  for ( int i = 0; i < nPoints; ++i )
+  {
+    keys[i] = hilbertIndex( static_cast< quint32 >( ( coords[3 * i] - xMin ) * xScale ),
+                            static_cast< quint32 >( ( coords[3 * i + 1] - yMin ) * yScale ) );
+  }
+
+  //shuffle with a fixed seed, the triangulation must not change from run to run
+  QVector<int> order( nPoints );
+  std::iota( order.begin(), order.end(), 0 );
+  std::mt19937 generator( 1 );
+  std::shuffle( order.begin(), order.end(), generator );
+
+  //the last round holds half of the vertices, the one before a quarter, and so on
+  auto byKey = [&keys]( int a, int b ) { return keys[a] < keys[b]; };
+  int roundEnd = nPoints;
+  while ( roundEnd > BRIO_MIN_ROUND_SIZE )
+  {
+    const int roundStart = roundEnd / 2;
+    std::sort( order.begin() + roundStart, order.begin() + roundEnd, byKey );
+    roundEnd = roundStart;
+  }
+  std::sort( order.begin(), order.begin() + roundEnd, byKey );
+
+  int result = 0;
+  for ( int index : order )
+  {
+    if ( mFeedback && mFeedback->isCanceled() )
+    {
+      break;
+    }
+    if ( mTriangulation->addPoint( new QgsPoint( coords[3 * index], coords[3 * index + 1], coords[3 * index + 2] ) ) == -100 )
+    {
+      result = -1;
+    }
+  }
+  mBufferedPoints.clear();
+  return result;
+}
@@ -20,6 +20,7 @@
 
 #include "qgsinterpolator.h"
 #include <QString>
+#include <QVector>
 #include "qgis_analysis.h"
 
 class QgsFeatureSink;
@@ -90,12 +91,23 @@ class ANALYSIS_EXPORT QgsTINInterpolator: public QgsInterpolator
     //! Create dual edge triangulation
     void initialize();
 
+    /** Inserts the buffered vertices into the triangulation, ordered in biased
+     * randomized insertion order (BRIO) with the rounds sorted along a Hilbert curve.
+     * The walk locating each new vertex starts from the last inserted triangle,
+     * with this order it stays short
+     * \returns 0 in case of success, -1 if some vertices could not be inserted because of numerical problems
+     */
+    int insertBufferedPoints();
+
+    //! Vertices waiting for insertion into the triangulation, as x, y, z triplets
+    QVector<double> mBufferedPoints;
+
     /** Inserts the vertices of a feature into the triangulation
       \param f the feature
       \param zCoord true if the z coordinate is the interpolation attribute
       \param attr interpolation attribute index (if zCoord is false)
       \param type point/structure line, break line
-      \returns 0 in case of success, -1 if the feature could not be inserted because of numerical problems*/
+      \returns 0 in case of success, -1 if the vertices buffered before a line could not be inserted because of numerical problems*/
     int insertData( QgsFeature *f, bool zCoord, int attr, InputType type );
 };
 
@@ -18,8 +18,22 @@
 #include "qgsfeatureiterator.h"
 #include "qgsgeometry.h"
 
+#include <QDir>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+
 #define NO_DATA -9999
 
+//! Grids with more cells than this are stored in a memory mapped temporary file
+static const qint64 MAX_IN_MEMORY_CELLS = 128 * 1024 * 1024;
+
+//! Number of rows of the grid accumulated by a single task
+static const int ROWS_PER_TASK = 64;
+
+//! Number of rows written at once to the output file
+static const int ROWS_PER_WRITE = 256;
+
 QgsKernelDensityEstimation::QgsKernelDensityEstimation( const QgsKernelDensityEstimation::Parameters &parameters, const QString &outputFile, const QString &outputFormat )
   : mSource( parameters.source )
   , mOutputFile( outputFile )
@@ -83,10 +97,13 @@ QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::prepare()
   if ( mBounds.isNull() )
     return InvalidParameters;
 
-  int rows = std::max( std::ceil( mBounds.height() / mPixelSize ) + 1, 1.0 );
-  int cols = std::max( std::ceil( mBounds.width() / mPixelSize ) + 1, 1.0 );
+  mRows = std::max( std::ceil( mBounds.height() / mPixelSize ) + 1, 1.0 );
+  mColumns = std::max( std::ceil( mBounds.width() / mPixelSize ) + 1, 1.0 );
 
-  if ( !createEmptyLayer( driver, mBounds, rows, cols ) )
+  if ( !createEmptyLayer( driver, mBounds, mRows, mColumns ) )
+    return FileCreationError;
+
+  if ( !createGrid() )
     return FileCreationError;
 
   // open the raster in GA_Update mode
@@ -101,9 +118,38 @@ QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::prepare()
   if ( mRadiusField < 0 )
     mBufferSize = radiusSizeInPixels( mRadius );
 
+  mPoints.clear();
+
   return Success;
 }
 
+bool QgsKernelDensityEstimation::createGrid()
+{
+  mGrid = nullptr;
+  mGridBuffer.clear();
+  mGridFile.reset();
+
+  const qint64 cells = static_cast< qint64 >( mRows ) * mColumns;
+  if ( cells > MAX_IN_MEMORY_CELLS )
+  {
+    mGridFile.reset( new QTemporaryFile( QDir::tempPath() + "/qgis_kde_XXXXXX" ) );
+    if ( !mGridFile->open() || !mGridFile->resize( cells * static_cast< qint64 >( sizeof( float ) ) ) )
+      return false;
+
+    mGrid = reinterpret_cast< float * >( mGridFile->map( 0, cells * static_cast< qint64 >( sizeof( float ) ) ) );
+    if ( !mGrid )
+      return false;
+
+    std::fill( mGrid, mGrid + cells, static_cast< float >( NO_DATA ) );
+  }
+  else
+  {
+    mGridBuffer.assign( cells, NO_DATA );
+    mGrid = mGridBuffer.data();
+  }
+  return true;
+}
+
 QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::addFeature( const QgsFeature &feature )
 {
   QgsGeometry featureGeometry = feature.geometry();
@@ -156,61 +202,136 @@ QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::addFeature( const
       continue;
     }
 
-    // calculate the pixel position
-    unsigned int xPosition = ( ( ( *pointIt ).x() - mBounds.xMinimum() ) / mPixelSize ) - buffer;
-    unsigned int yPosition = ( ( ( *pointIt ).y() - mBounds.yMinimum() ) / mPixelSize ) - buffer;
-    unsigned int yPositionIO = ( ( mBounds.yMaximum() - ( *pointIt ).y() ) / mPixelSize ) - buffer;
+    // calculate the pixel position, blocks which do not fit in the raster are skipped
+    const double xPosition = ( ( ( *pointIt ).x() - mBounds.xMinimum() ) / mPixelSize ) - buffer;
+    const double yPosition = ( ( ( *pointIt ).y() - mBounds.yMinimum() ) / mPixelSize ) - buffer;
+    const double yPositionIO = ( ( mBounds.yMaximum() - ( *pointIt ).y() ) / mPixelSize ) - buffer;
+    if ( blockSize < 1 || xPosition <= -1 || yPositionIO <= -1 ||
+         static_cast< int >( xPosition ) + blockSize > mColumns || static_cast< int >( yPositionIO ) + blockSize > mRows )
+    {
+      result = RasterIoError;
+      continue;
+    }
+
+    // no pixel of the block is within the search bandwidth
+    if ( yPosition <= -1 )
+      continue;
+
+    KernelPoint point;
+    point.x = ( *pointIt ).x();
+    point.y = ( *pointIt ).y();
+    point.radius = radius;
+    point.weight = weight;
+    point.blockSize = blockSize;
+    point.column = static_cast< int >( xPosition );
+    point.row = static_cast< int >( yPositionIO );
+    point.rowFromBottom = static_cast< int >( yPosition );
+    mPoints << point;
+  }
 
+  return result;
+}
+
+void QgsKernelDensityEstimation::accumulateKernels( const QVector< int > &points, int firstRow, int lastRow )
+{
+  std::vector< double > xSqrDistances;
+  std::vector< double > ySqrDistances;
+
+  Q_FOREACH ( int pointIndex, points )
+  {
+    const KernelPoint &point = mPoints.at( pointIndex );
+    const int blockSize = point.blockSize;
 
-    // get the data
-    float *dataBuffer = ( float * ) CPLMalloc( sizeof( float ) * blockSize * blockSize );
-    if ( GDALRasterIO( mRasterBandH, GF_Read, xPosition, yPositionIO, blockSize, blockSize,
-                       dataBuffer, blockSize, blockSize, GDT_Float32, 0, 0 ) != CE_None )
+    // squared distances along each axis of the pixel centroids of the block
+    xSqrDistances.resize( blockSize );
+    ySqrDistances.resize( blockSize );
+    for ( int i = 0; i < blockSize; i++ )
     {
-      result = RasterIoError;
+      double pixelCentroidX = ( point.column + i + 0.5 ) * mPixelSize + mBounds.xMinimum();
+      double pixelCentroidY = ( point.rowFromBottom + i + 0.5 ) * mPixelSize + mBounds.yMinimum();
+      xSqrDistances[i] = std::pow( pixelCentroidX - point.x, 2.0 );
+      ySqrDistances[i] = std::pow( pixelCentroidY - point.y, 2.0 );
     }
 
-    for ( int xp = 0; xp < blockSize; xp++ )
+    const int ypStart = std::max( 0, firstRow - point.row );
+    const int ypEnd = std::min( blockSize, lastRow - point.row + 1 );
+    for ( int yp = ypStart; yp < ypEnd; yp++ )
     {
-      for ( int yp = 0; yp < blockSize; yp++ )
+      float *line = mGrid + static_cast< qint64 >( point.row + yp ) * mColumns + point.column;
+      for ( int xp = 0; xp < blockSize; xp++ )
       {
-        double pixelCentroidX = ( xPosition + xp + 0.5 ) * mPixelSize + mBounds.xMinimum();
-        double pixelCentroidY = ( yPosition + yp + 0.5 ) * mPixelSize + mBounds.yMinimum();
-
-        double distance = std::sqrt( std::pow( pixelCentroidX - ( *pointIt ).x(), 2.0 ) + std::pow( pixelCentroidY - ( *pointIt ).y(), 2.0 ) );
+        double distance = std::sqrt( xSqrDistances[xp] + ySqrDistances[yp] );
 
         // is pixel outside search bandwidth of feature?
-        if ( distance > radius )
+        if ( distance > point.radius )
         {
           continue;
         }
 
-        double pixelValue = weight * calculateKernelValue( distance, radius, mShape, mOutputValues );
-        int pos = xp + blockSize * yp;
-        if ( dataBuffer[ pos ] == NO_DATA )
+        double pixelValue = point.weight * calculateKernelValue( distance, point.radius, mShape, mOutputValues );
+        if ( line[ xp ] == NO_DATA )
         {
-          dataBuffer[ pos ] = 0;
+          line[ xp ] = 0;
         }
-        dataBuffer[ pos ] += pixelValue;
+        line[ xp ] += pixelValue;
       }
     }
-    if ( GDALRasterIO( mRasterBandH, GF_Write, xPosition, yPositionIO, blockSize, blockSize,
-                       dataBuffer, blockSize, blockSize, GDT_Float32, 0, 0 ) != CE_None )
-    {
-      result = RasterIoError;
-    }
-    CPLFree( dataBuffer );
   }
-
-  return result;
 }
 
 QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::finalise()
 {
+  Result result = Success;
+
+  if ( mGrid )
+  {
+    // the grid is split in bands of rows accumulated in parallel, the points of a band
+    // are added in the order of the features so that the result does not depend on threads
+    const int taskCount = ( mRows + ROWS_PER_TASK - 1 ) / ROWS_PER_TASK;
+    QVector< QVector< int > > taskPoints( taskCount );
+    for ( int i = 0; i < mPoints.size(); ++i )
+    {
+      const KernelPoint &point = mPoints.at( i );
+      const int lastTask = ( point.row + point.blockSize - 1 ) / ROWS_PER_TASK;
+      for ( int task = point.row / ROWS_PER_TASK; task <= lastTask; ++task )
+        taskPoints[ task ] << i;
+    }
+
+    QVector< int > tasks;
+    for ( int task = 0; task < taskCount; ++task )
+    {
+      if ( !taskPoints.at( task ).isEmpty() )
+        tasks << task;
+    }
+
+    auto accumulateTask = [this, &taskPoints]( int task )
+    {
+      accumulateKernels( taskPoints.at( task ), task * ROWS_PER_TASK, std::min( ( task + 1 ) * ROWS_PER_TASK, mRows ) - 1 );
+    };
+    QtConcurrent::blockingMap( tasks, accumulateTask );
+
+    // write the grid in large blocks
+    for ( int row = 0; row < mRows && result == Success; row += ROWS_PER_WRITE )
+    {
+      const int rowCount = std::min( ROWS_PER_WRITE, mRows - row );
+      if ( GDALRasterIO( mRasterBandH, GF_Write, 0, row, mColumns, rowCount,
+                         mGrid + static_cast< qint64 >( row ) * mColumns, mColumns, rowCount, GDT_Float32, 0, 0 ) != CE_None )
+      {
+        result = RasterIoError;
+      }
+    }
+  }
+
+  mPoints.clear();
+  mGrid = nullptr;
+  mGridBuffer.clear();
+  mGridBuffer.shrink_to_fit();
+  mGridFile.reset();
+
   GDALClose( ( GDALDatasetH ) mDatasetH );
   mDatasetH = nullptr;
   mRasterBandH = nullptr;
-  return Success;
+  return result;
 }
 
 int QgsKernelDensityEstimation::radiusSizeInPixels( double radius ) const
@@ -244,21 +365,8 @@ bool QgsKernelDensityEstimation::createEmptyLayer( GDALDriverH driver, const Qgs
   if ( GDALSetRasterNoDataValue( poBand, NO_DATA ) != CE_None )
     return false;
 
-  float *line = static_cast< float * >( CPLMalloc( sizeof( float ) * columns ) );
-  for ( int i = 0; i < columns; i++ )
-  {
-    line[i] = NO_DATA;
-  }
-  // Write the empty raster
-  for ( int i = 0; i < rows ; i++ )
-  {
-    if ( GDALRasterIO( poBand, GF_Write, 0, i, columns, 1, line, columns, 1, GDT_Float32, 0, 0 ) != CE_None )
-    {
-      return false;
-    }
-  }
-
-  CPLFree( line );
+  // the raster is written at once by finalise()
+  Q_UNUSED( rows );
   //close the dataset
   GDALClose( emptyDataset );
   return true;
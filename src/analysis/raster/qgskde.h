@@ -18,6 +18,10 @@
 
 #include "qgsrectangle.h"
 #include <QString>
+#include <QTemporaryFile>
+#include <QVector>
+#include <memory>
+#include <vector>
 
 // GDAL includes
 #include <gdal.h>
@@ -116,6 +120,7 @@ class ANALYSIS_EXPORT QgsKernelDensityEstimation
 
     /**
      * Adds a single feature to the KDE surface. prepare() must be called before adding features.
+     * The kernels of the features are accumulated when the surface is finalised.
      * \see prepare()
      * \see finalise()
      */
@@ -123,12 +128,36 @@ class ANALYSIS_EXPORT QgsKernelDensityEstimation
 
     /**
      * Finalises the output file. Must be called after adding all features via addFeature().
+     * The kernels of all features are accumulated in parallel into an in memory grid
+     * (memory mapped for large outputs) which is then written to the output file.
      * \see prepare()
      * \see addFeature()
      */
     Result finalise();
 
   private:
+#ifdef SIP_RUN
+    QgsKernelDensityEstimation( const QgsKernelDensityEstimation &rhs );
+#endif
+
+    //! A point added to the surface, with the position in pixels of the block covered by its kernel
+    struct KernelPoint
+    {
+      double x;
+      double y;
+      double radius;
+      double weight;
+      int blockSize;
+      //! Column of the left of the block
+      int column;
+      //! Row of the top of the block, counted from the top of the raster
+      int row;
+      //! Row of the bottom of the block, counted from the bottom of the raster
+      int rowFromBottom;
+    };
+
+    //! Adds the kernels of the points to the rows between firstRow and lastRow (included) of the grid
+    void accumulateKernels( const QVector< int > &points, int firstRow, int lastRow );
 
     //! Calculate the value given to a point width a given distance for a specified kernel shape
     double calculateKernelValue( const double distance, const double bandwidth, const KernelShape shape, const OutputValues outputType ) const;
@@ -165,9 +194,25 @@ class ANALYSIS_EXPORT QgsKernelDensityEstimation
     GDALDatasetH mDatasetH;
     GDALRasterBandH mRasterBandH;
 
-    //! Creates a new raster layer and initializes it to the no data value
+    int mRows = 0;
+    int mColumns = 0;
+
+    //! Points added to the surface, accumulated by finalise()
+    QVector< KernelPoint > mPoints;
+
+    //! Accumulation grid, row by row from the top of the raster
+    float *mGrid = nullptr;
+    //! Storage of the accumulation grid when it is held in memory
+    std::vector< float > mGridBuffer;
+    //! Storage of the accumulation grid when it is too large to be held in memory
+    std::unique_ptr< QTemporaryFile > mGridFile;
+
+    //! Creates a new raster layer with the no data value set
     bool createEmptyLayer( GDALDriverH driver, const QgsRectangle &bounds, int rows, int columns ) const;
     int radiusSizeInPixels( double radius ) const;
+
+    //! Allocates the accumulation grid and initializes it to the no data value
+    bool createGrid();
 };
 
 
@@ -0,0 +1,662 @@
+/***************************************************************************
+    qgsmemorycolumnarstore.cpp
+    --------------------------
+    begin                : October 2017
+    copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsmemorycolumnarstore.h"
+
+#include "qgsgeometry.h"
+
+#include <QDate>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTime>
+
+#include <algorithm>
+#include <limits>
+
+///@cond PRIVATE
+
+namespace
+{
+  //! Maximum number of children of a node of the packed R-tree
+  const int NODE_SIZE = 16;
+
+  //! Size of the chunks of WKB, a chunk only gets larger when holding a single larger geometry
+  const qint64 WKB_CHUNK_SIZE = 64 * 1024 * 1024;
+
+  //! Minimum size of the unused WKB before it is reclaimed
+  const qint64 MIN_UNUSED_WKB_SIZE = 1024 * 1024;
+
+  //! Number of distinct strings from which a dictionary has to save memory to be kept
+  const int MIN_DICTIONARY_SIZE = 1024;
+
+  //! Returns the distance along a Hilbert curve of order 16 of the cell (x, y)
+  quint32 hilbertIndex( quint32 x, quint32 y )
+  {
+    const quint32 n = 1 << 16;
+    quint32 d = 0;
+    for ( quint32 s = n / 2; s > 0; s /= 2 )
+    {
+      const quint32 rx = ( x & s ) > 0;
+      const quint32 ry = ( y & s ) > 0;
+      d += s * s * ( ( 3 * rx ) ^ ry );
+      if ( ry == 0 )
+      {
+        if ( rx == 1 )
+        {
+          x = n - 1 - x;
+          y = n - 1 - y;
+        }
+        std::swap( x, y );
+      }
+    }
+    return d;
+  }
+
+  //! Returns the box containing all the \a boxes from \a begin to \a end
+  QgsRectangle combinedBox( const QVector<QgsRectangle> &boxes, int begin, int end )
+  {
+    double xMin = std::numeric_limits<double>::max();
+    double yMin = std::numeric_limits<double>::max();
+    double xMax = -std::numeric_limits<double>::max();
+    double yMax = -std::numeric_limits<double>::max();
+    for ( int i = begin; i < end; ++i )
+    {
+      const QgsRectangle &box = boxes.at( i );
+      xMin = std::min( xMin, box.xMinimum() );
+      yMin = std::min( yMin, box.yMinimum() );
+      xMax = std::max( xMax, box.xMaximum() );
+      yMax = std::max( yMax, box.yMaximum() );
+    }
+    return QgsRectangle( xMin, yMin, xMax, yMax );
+  }
+}
+
+//
+// QgsMemoryPackedRTree
+//
+
+QgsMemoryPackedRTree::QgsMemoryPackedRTree( const QVector<int> &items, const QVector<QgsRectangle> &boxes )
+{
+  if ( items.isEmpty() )
+    return;
+
+  // order the items along a Hilbert curve over the extent of their box centers
+  const QgsRectangle extent = combinedBox( boxes, 0, boxes.size() );
+  const double width = extent.width() > 0 ? extent.width() : 1;
+  const double height = extent.height() > 0 ? extent.height() : 1;
+  const double cells = ( 1 << 16 ) - 1;
+  QVector< QPair< quint32, int > > order;
+  order.reserve( items.size() );
+  for ( int i = 0; i < items.size(); ++i )
+  {
+    const QgsRectangle &box = boxes.at( i );
+    const quint32 x = static_cast< quint32 >( cells * ( ( box.xMinimum() + box.xMaximum() ) / 2 - extent.xMinimum() ) / width );
+    const quint32 y = static_cast< quint32 >( cells * ( ( box.yMinimum() + box.yMaximum() ) / 2 - extent.yMinimum() ) / height );
+    order << qMakePair( hilbertIndex( x, y ), i );
+  }
+  std::sort( order.begin(), order.end() );
+
+  mItems.reserve( items.size() );
+  mItemBoxes.reserve( items.size() );
+  for ( const QPair< quint32, int > &entry : qAsConst( order ) )
+  {
+    mItems << items.at( entry.second );
+    mItemBoxes << boxes.at( entry.second );
+  }
+
+  // group consecutive boxes up to a single root
+  const QVector<QgsRectangle> *children = &mItemBoxes;
+  do
+  {
+    QVector<QgsRectangle> level;
+    level.reserve( ( children->size() + NODE_SIZE - 1 ) / NODE_SIZE );
+    for ( int begin = 0; begin < children->size(); begin += NODE_SIZE )
+      level << combinedBox( *children, begin, std::min( begin + NODE_SIZE, children->size() ) );
+    mLevels << level;
+    children = &mLevels.last();
+  }
+  while ( children->size() > 1 );
+}
+
+QVector<int> QgsMemoryPackedRTree::intersects( const QgsRectangle &rect ) const
+{
+  QVector<int> result;
+  if ( mLevels.isEmpty() )
+    return result;
+
+  // nodes to visit, as ( level, index ), the nodes of level 0 hold items
+  QVector< QPair< int, int > > stack;
+  stack << qMakePair( mLevels.size() - 1, 0 );
+  while ( !stack.isEmpty() )
+  {
+    const QPair< int, int > node = stack.takeLast();
+    if ( !mLevels.at( node.first ).at( node.second ).intersects( rect ) )
+      continue;
+
+    const int begin = node.second * NODE_SIZE;
+    if ( node.first == 0 )
+    {
+      const int end = std::min( begin + NODE_SIZE, mItems.size() );
+      for ( int i = begin; i < end; ++i )
+      {
+        if ( mItemBoxes.at( i ).intersects( rect ) )
+          result << mItems.at( i );
+      }
+    }
+    else
+    {
+      const int end = std::min( begin + NODE_SIZE, mLevels.at( node.first - 1 ).size() );
+      for ( int i = begin; i < end; ++i )
+        stack << qMakePair( node.first - 1, i );
+    }
+  }
+
+  std::sort( result.begin(), result.end() );
+  return result;
+}
+
+//
+// QgsMemoryColumn
+//
+
+QgsMemoryColumn::QgsMemoryColumn( QVariant::Type type, int rowCount )
+  : mType( type )
+{
+  switch ( type )
+  {
+    case QVariant::Int:
+    case QVariant::LongLong:
+      mStorage = IntegerStorage;
+      break;
+    case QVariant::Double:
+      mStorage = DoubleStorage;
+      break;
+    case QVariant::Date:
+      mStorage = DateStorage;
+      break;
+    case QVariant::Time:
+      mStorage = TimeStorage;
+      break;
+    case QVariant::String:
+      mStorage = DictionaryStorage;
+      break;
+    default:
+      mStorage = VariantStorage;
+      break;
+  }
+
+  for ( int i = 0; i < rowCount; ++i )
+    append( QVariant() );
+}
+
+QVariant QgsMemoryColumn::value( int row ) const
+{
+  if ( mStorage == VariantStorage )
+    return mVariants.at( row );
+
+  if ( mNulls.testBit( row ) )
+    return mInvalid.testBit( row ) ? QVariant() : QVariant( mType );
+
+  switch ( mStorage )
+  {
+    case IntegerStorage:
+      if ( mType == QVariant::Int )
+        return QVariant( static_cast< int >( mIntegers.at( row ) ) );
+      return QVariant( static_cast< qlonglong >( mIntegers.at( row ) ) );
+    case DoubleStorage:
+      return QVariant( mDoubles.at( row ) );
+    case DateStorage:
+      return QVariant( QDate::fromJulianDay( mIntegers.at( row ) ) );
+    case TimeStorage:
+      return QVariant( QTime::fromMSecsSinceStartOfDay( static_cast< int >( mIntegers.at( row ) ) ) );
+    case DictionaryStorage:
+      return QVariant( mStrings.at( mStringCodes.at( row ) ) );
+    case StringStorage:
+      return QVariant( mStrings.at( row ) );
+    case VariantStorage:
+      break;
+  }
+  return QVariant();
+}
+
+void QgsMemoryColumn::append( const QVariant &value )
+{
+  if ( !fitsStorage( value ) )
+    convertToVariantStorage();
+
+  mRowCount++;
+  switch ( mStorage )
+  {
+    case IntegerStorage:
+    case DateStorage:
+    case TimeStorage:
+      mIntegers.append( 0 );
+      break;
+    case DoubleStorage:
+      mDoubles.append( 0 );
+      break;
+    case DictionaryStorage:
+      mStringCodes.append( 0 );
+      break;
+    case StringStorage:
+      mStrings.append( QString() );
+      break;
+    case VariantStorage:
+      mVariants.append( value );
+      return;
+  }
+  mNulls.resize( mRowCount );
+  mInvalid.resize( mRowCount );
+  store( mRowCount - 1, value );
+
+  if ( mStorage == DictionaryStorage && mStrings.size() > MIN_DICTIONARY_SIZE && 2 * mStrings.size() > mRowCount )
+    convertToStringStorage();
+}
+
+void QgsMemoryColumn::setValue( int row, const QVariant &value )
+{
+  if ( !fitsStorage( value ) )
+    convertToVariantStorage();
+
+  if ( mStorage == VariantStorage )
+    mVariants[ row ] = value;
+  else
+    store( row, value );
+}
+
+void QgsMemoryColumn::removeRows( const QBitArray &removed )
+{
+  int kept = 0;
+  for ( int row = 0; row < mRowCount; ++row )
+  {
+    if ( removed.testBit( row ) )
+      continue;
+
+    switch ( mStorage )
+    {
+      case IntegerStorage:
+      case DateStorage:
+      case TimeStorage:
+        mIntegers[ kept ] = mIntegers.at( row );
+        break;
+      case DoubleStorage:
+        mDoubles[ kept ] = mDoubles.at( row );
+        break;
+      case DictionaryStorage:
+        mStringCodes[ kept ] = mStringCodes.at( row );
+        break;
+      case StringStorage:
+        mStrings[ kept ] = mStrings.at( row );
+        break;
+      case VariantStorage:
+        mVariants[ kept ] = mVariants.at( row );
+        break;
+    }
+    if ( mStorage != VariantStorage )
+    {
+      mNulls.setBit( kept, mNulls.testBit( row ) );
+      mInvalid.setBit( kept, mInvalid.testBit( row ) );
+    }
+    kept++;
+  }
+
+  mRowCount = kept;
+  switch ( mStorage )
+  {
+    case IntegerStorage:
+    case DateStorage:
+    case TimeStorage:
+      mIntegers.resize( kept );
+      break;
+    case DoubleStorage:
+      mDoubles.resize( kept );
+      break;
+    case DictionaryStorage:
+      mStringCodes.resize( kept );
+      break;
+    case StringStorage:
+      mStrings.resize( kept );
+      break;
+    case VariantStorage:
+      mVariants.resize( kept );
+      return;
+  }
+  mNulls.resize( kept );
+  mInvalid.resize( kept );
+}
+
+bool QgsMemoryColumn::fitsStorage( const QVariant &value ) const
+{
+  if ( mStorage == VariantStorage || !value.isValid() )
+    return true;
+
+  return value.type() == mType;
+}
+
+void QgsMemoryColumn::store( int row, const QVariant &value )
+{
+  const bool isNull = value.isNull();
+  mNulls.setBit( row, isNull );
+  mInvalid.setBit( row, !value.isValid() );
+  if ( isNull )
+    return;
+
+  switch ( mStorage )
+  {
+    case IntegerStorage:
+      mIntegers[ row ] = value.toLongLong();
+      break;
+    case DoubleStorage:
+      mDoubles[ row ] = value.toDouble();
+      break;
+    case DateStorage:
+      mIntegers[ row ] = value.toDate().toJulianDay();
+      break;
+    case TimeStorage:
+      mIntegers[ row ] = value.toTime().msecsSinceStartOfDay();
+      break;
+    case DictionaryStorage:
+      mStringCodes[ row ] = stringCode( value.toString() );
+      break;
+    case StringStorage:
+      mStrings[ row ] = value.toString();
+      break;
+    case VariantStorage:
+      break;
+  }
+}
+
+int QgsMemoryColumn::stringCode( const QString &string )
+{
+  const auto it = mStringIndex.constFind( string );
+  if ( it != mStringIndex.constEnd() )
+    return it.value();
+
+  const int code = mStrings.size();
+  mStrings << string;
+  mStringIndex.insert( string, code );
+  return code;
+}
+
+void QgsMemoryColumn::convertToVariantStorage()
+{
+  QVector<QVariant> variants;
+  variants.reserve( mRowCount );
+  for ( int row = 0; row < mRowCount; ++row )
+    variants << value( row );
+
+  mStorage = VariantStorage;
+  mVariants = variants;
+  mIntegers.clear();
+  mDoubles.clear();
+  mStringCodes.clear();
+  mStrings.clear();
+  mStringIndex.clear();
+  mNulls.clear();
+  mInvalid.clear();
+}
+
+void QgsMemoryColumn::convertToStringStorage()
+{
+  // mostly distinct strings, the dictionary only adds to their size
+  QVector<QString> strings;
+  strings.reserve( mRowCount );
+  for ( int row = 0; row < mRowCount; ++row )
+    strings << ( mNulls.testBit( row ) ? QString() : mStrings.at( mStringCodes.at( row ) ) );
+
+  mStorage = StringStorage;
+  mStrings = strings;
+  mStringCodes.clear();
+  mStringIndex.clear();
+}
+
+//
+// QgsMemoryColumnarStore
+//
+
+struct QgsMemoryColumnarStore::SpatialIndex
+{
+  QMutex mutex;
+  QVector<int> rows;
+  QVector<QgsRectangle> boxes;
+  std::unique_ptr< QgsMemoryPackedRTree > tree;
+};
+
+int QgsMemoryColumnarStore::row( QgsFeatureId id ) const
+{
+  const auto it = std::lower_bound( mIds.constBegin(), mIds.constEnd(), id );
+  if ( it == mIds.constEnd() || *it != id )
+    return -1;
+  return static_cast< int >( it - mIds.constBegin() );
+}
+
+void QgsMemoryColumnarStore::addColumn( QVariant::Type type )
+{
+  mColumns << QgsMemoryColumn( type, mIds.size() );
+}
+
+void QgsMemoryColumnarStore::removeColumn( int index )
+{
+  if ( index >= 0 && index < mColumns.size() )
+    mColumns.remove( index );
+}
+
+void QgsMemoryColumnarStore::addFeature( const QgsFeature &feature )
+{
+  mIds << feature.id();
+
+  const QgsAttributes attributes = feature.attributes();
+  for ( int i = 0; i < mColumns.size(); ++i )
+    mColumns[ i ].append( i < attributes.size() ? attributes.at( i ) : QVariant() );
+
+  if ( feature.hasGeometry() )
+  {
+    const QByteArray wkb = feature.geometry().exportToWkb();
+    mWkbPositions << appendWkb( wkb );
+    mWkbSizes << wkb.size();
+    mBoundingBoxes << feature.geometry().boundingBox();
+  }
+  else
+  {
+    mWkbPositions << 0;
+    mWkbSizes << 0;
+    mBoundingBoxes << QgsRectangle();
+  }
+
+  mSpatialIndex.reset();
+}
+
+void QgsMemoryColumnarStore::deleteFeatures( const QgsFeatureIds &ids )
+{
+  QBitArray removed( mIds.size() );
+  bool removing = false;
+  Q_FOREACH ( QgsFeatureId id, ids )
+  {
+    const int r = row( id );
+    if ( r < 0 )
+      continue;
+    removed.setBit( r );
+    removing = true;
+  }
+  if ( !removing )
+    return;
+
+  for ( int i = 0; i < mColumns.size(); ++i )
+    mColumns[ i ].removeRows( removed );
+
+  int kept = 0;
+  for ( int r = 0; r < mIds.size(); ++r )
+  {
+    if ( removed.testBit( r ) )
+    {
+      mUnusedWkbSize += mWkbSizes.at( r );
+      continue;
+    }
+    mIds[ kept ] = mIds.at( r );
+    mWkbPositions[ kept ] = mWkbPositions.at( r );
+    mWkbSizes[ kept ] = mWkbSizes.at( r );
+    mBoundingBoxes[ kept ] = mBoundingBoxes.at( r );
+    kept++;
+  }
+  mIds.resize( kept );
+  mWkbPositions.resize( kept );
+  mWkbSizes.resize( kept );
+  mBoundingBoxes.resize( kept );
+
+  compactWkb();
+  mSpatialIndex.reset();
+}
+
+void QgsMemoryColumnarStore::setAttribute( int row, int index, const QVariant &value )
+{
+  if ( index >= 0 && index < mColumns.size() )
+    mColumns[ index ].setValue( row, value );
+}
+
+QgsGeometry QgsMemoryColumnarStore::geometry( int row ) const
+{
+  QgsGeometry geometry;
+  const int size = mWkbSizes.at( row );
+  if ( size == 0 )
+    return geometry;
+
+  // parsed straight from the chunk, without copying the WKB
+  const qint64 position = mWkbPositions.at( row );
+  const QByteArray &chunk = mWkbChunks.at( static_cast< int >( position / WKB_CHUNK_SIZE ) );
+  geometry.fromWkb( QByteArray::fromRawData( chunk.constData() + position % WKB_CHUNK_SIZE, size ) );
+  return geometry;
+}
+
+void QgsMemoryColumnarStore::setGeometry( int row, const QgsGeometry &geometry )
+{
+  mUnusedWkbSize += mWkbSizes.at( row );
+  if ( geometry.isNull() )
+  {
+    mWkbPositions[ row ] = 0;
+    mWkbSizes[ row ] = 0;
+    mBoundingBoxes[ row ] = QgsRectangle();
+  }
+  else
+  {
+    const QByteArray wkb = geometry.exportToWkb();
+    mWkbPositions[ row ] = appendWkb( wkb );
+    mWkbSizes[ row ] = wkb.size();
+    mBoundingBoxes[ row ] = geometry.boundingBox();
+  }
+
+  compactWkb();
+  mSpatialIndex.reset();
+}
+
+void QgsMemoryColumnarStore::readFeature( int row, QgsFeature &feature, const QgsAttributeList &attributes, bool allAttributes ) const
+{
+  feature.setId( mIds.at( row ) );
+
+  QgsAttributes values( mColumns.size() );
+  if ( allAttributes )
+  {
+    for ( int i = 0; i < mColumns.size(); ++i )
+      values[ i ] = mColumns.at( i ).value( row );
+  }
+  else
+  {
+    for ( int i : attributes )
+    {
+      if ( i >= 0 && i < mColumns.size() )
+        values[ i ] = mColumns.at( i ).value( row );
+    }
+  }
+  feature.setAttributes( values );
+  feature.clearGeometry();
+  feature.setValid( true );
+}
+
+QgsRectangle QgsMemoryColumnarStore::extent() const
+{
+  QgsRectangle extent;
+  extent.setMinimal();
+  for ( int r = 0; r < mIds.size(); ++r )
+  {
+    if ( mWkbSizes.at( r ) > 0 )
+      extent.combineExtentWith( mBoundingBoxes.at( r ) );
+  }
+  return extent;
+}
+
+QVector<int> QgsMemoryColumnarStore::intersectingRows( const QgsRectangle &rect ) const
+{
+  prepareIndex();
+
+  QMutexLocker locker( &mSpatialIndex->mutex );
+  if ( !mSpatialIndex->tree )
+  {
+    mSpatialIndex->tree.reset( new QgsMemoryPackedRTree( mSpatialIndex->rows, mSpatialIndex->boxes ) );
+    mSpatialIndex->rows.clear();
+    mSpatialIndex->boxes.clear();
+  }
+  return mSpatialIndex->tree->intersects( rect );
+}
+
+void QgsMemoryColumnarStore::prepareIndex() const
+{
+  if ( mSpatialIndex )
+    return;
+
+  mSpatialIndex = std::make_shared< SpatialIndex >();
+  for ( int r = 0; r < mIds.size(); ++r )
+  {
+    if ( mWkbSizes.at( r ) == 0 )
+      continue;
+    mSpatialIndex->rows << r;
+    mSpatialIndex->boxes << mBoundingBoxes.at( r );
+  }
+}
+
+qint64 QgsMemoryColumnarStore::appendWkb( const QByteArray &wkb )
+{
+  if ( mWkbChunks.isEmpty() || ( !mWkbChunks.last().isEmpty() && mWkbChunks.last().size() + wkb.size() > WKB_CHUNK_SIZE ) )
+  {
+    mWkbChunks << QByteArray();
+    mWkbChunks.last().reserve( static_cast< int >( std::min< qint64 >( WKB_CHUNK_SIZE, std::max( wkb.size(), 4096 ) ) ) );
+  }
+
+  QByteArray &chunk = mWkbChunks.last();
+  const qint64 position = ( mWkbChunks.size() - 1 ) * WKB_CHUNK_SIZE + chunk.size();
+  chunk.append( wkb );
+  return position;
+}
+
+void QgsMemoryColumnarStore::compactWkb()
+{
+  qint64 totalSize = 0;
+  for ( const QByteArray &chunk : qAsConst( mWkbChunks ) )
+    totalSize += chunk.size();
+  if ( mUnusedWkbSize < MIN_UNUSED_WKB_SIZE || 2 * mUnusedWkbSize < totalSize )
+    return;
+
+  const QVector<QByteArray> chunks = mWkbChunks;
+  mWkbChunks.clear();
+  mUnusedWkbSize = 0;
+  for ( int r = 0; r < mIds.size(); ++r )
+  {
+    const int size = mWkbSizes.at( r );
+    if ( size == 0 )
+      continue;
+    const qint64 position = mWkbPositions.at( r );
+    const QByteArray &chunk = chunks.at( static_cast< int >( position / WKB_CHUNK_SIZE ) );
+    mWkbPositions[ r ] = appendWkb( QByteArray::fromRawData( chunk.constData() + position % WKB_CHUNK_SIZE, size ) );
+  }
+}
+
+///@endcond
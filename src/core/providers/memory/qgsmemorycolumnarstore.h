@@ -0,0 +1,210 @@
+/***************************************************************************
+    qgsmemorycolumnarstore.h
+    ------------------------
+    begin                : October 2017
+    copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef QGSMEMORYCOLUMNARSTORE_H
+#define QGSMEMORYCOLUMNARSTORE_H
+
+#define SIP_NO_FILE
+
+#include "qgsfeature.h"
+#include "qgsrectangle.h"
+
+#include <QBitArray>
+#include <QByteArray>
+#include <QHash>
+#include <QVector>
+
+#include <memory>
+
+///@cond PRIVATE
+
+/**
+ * Static R-tree over bounding boxes, packed in flat arrays: the boxes are sorted
+ * along a Hilbert curve and grouped by consecutive runs at every level.
+ */
+class QgsMemoryPackedRTree
+{
+  public:
+
+    //! Builds the tree over the \a boxes of the \a items
+    QgsMemoryPackedRTree( const QVector<int> &items, const QVector<QgsRectangle> &boxes );
+
+    //! Returns the items whose box intersects \a rect, in increasing order
+    QVector<int> intersects( const QgsRectangle &rect ) const;
+
+  private:
+
+    //! Items in the order of the leaves
+    QVector<int> mItems;
+    QVector<QgsRectangle> mItemBoxes;
+    //! Node boxes, from the level right above the items to the root
+    QVector< QVector<QgsRectangle> > mLevels;
+};
+
+/**
+ * Attribute values of a column of a QgsMemoryColumnarStore.
+ *
+ * Values are kept in a vector of the field type, with a bitmap flagging the null
+ * values, and strings are stored once in a dictionary. A column switches to a vector
+ * of QVariant as soon as it gets a value of another type.
+ */
+class QgsMemoryColumn
+{
+  public:
+
+    explicit QgsMemoryColumn( QVariant::Type type = QVariant::Invalid, int rowCount = 0 );
+
+    //! Returns the value of a \a row
+    QVariant value( int row ) const;
+
+    //! Adds a row with a \a value
+    void append( const QVariant &value );
+
+    //! Changes the value of a \a row
+    void setValue( int row, const QVariant &value );
+
+    //! Removes the rows flagged in \a removed
+    void removeRows( const QBitArray &removed );
+
+  private:
+
+    enum Storage
+    {
+      IntegerStorage, //!< Int and LongLong values
+      DoubleStorage,
+      DateStorage, //!< Julian days
+      TimeStorage, //!< Milliseconds since the start of the day
+      DictionaryStorage, //!< Codes of strings in a dictionary
+      StringStorage, //!< Strings, once the dictionary does not save memory
+      VariantStorage
+    };
+
+    //! Returns true if \a value can be stored without switching to QVariant storage
+    bool fitsStorage( const QVariant &value ) const;
+
+    //! Stores a \a value which fits the storage in an existing \a row
+    void store( int row, const QVariant &value );
+
+    //! Returns the dictionary code of a string, adding it to the dictionary if needed
+    int stringCode( const QString &string );
+
+    void convertToVariantStorage();
+    void convertToStringStorage();
+
+    QVariant::Type mType = QVariant::Invalid;
+    Storage mStorage = VariantStorage;
+    int mRowCount = 0;
+
+    QVector<qint64> mIntegers;
+    QVector<double> mDoubles;
+    QVector<int> mStringCodes;
+    QVector<QString> mStrings;
+    QHash<QString, int> mStringIndex;
+    QVector<QVariant> mVariants;
+
+    //! Null values, the values of these rows in the typed vectors are meaningless
+    QBitArray mNulls;
+    //! Null values which were invalid QVariant
+    QBitArray mInvalid;
+};
+
+/**
+ * Feature storage of QgsMemoryProvider with typed attribute columns and contiguous
+ * WKB geometries. Features are only built when they are read.
+ *
+ * Rows are kept in increasing feature id order. All the members are implicitly shared,
+ * copying a store is cheap.
+ */
+class QgsMemoryColumnarStore
+{
+  public:
+
+    //! Returns the number of features
+    int rowCount() const { return mIds.size(); }
+
+    //! Returns the row of a feature, or -1 if there is no feature with this \a id
+    int row( QgsFeatureId id ) const;
+
+    //! Appends a column of a field of the given \a type, with null values
+    void addColumn( QVariant::Type type );
+
+    //! Removes the column at \a index
+    void removeColumn( int index );
+
+    //! Adds a feature, its id must be greater than the id of all the stored features
+    void addFeature( const QgsFeature &feature );
+
+    //! Removes features
+    void deleteFeatures( const QgsFeatureIds &ids );
+
+    //! Changes the value of the attribute at \a index of a \a row
+    void setAttribute( int row, int index, const QVariant &value );
+
+    //! Returns true if the feature of a \a row has a geometry
+    bool hasGeometry( int row ) const { return mWkbSizes.at( row ) > 0; }
+
+    //! Returns the geometry of a \a row
+    QgsGeometry geometry( int row ) const;
+
+    //! Returns the bounding box of the geometry of a \a row
+    QgsRectangle boundingBox( int row ) const { return mBoundingBoxes.at( row ); }
+
+    //! Changes the geometry of a \a row
+    void setGeometry( int row, const QgsGeometry &geometry );
+
+    /**
+     * Builds the feature of a \a row, without geometry, with the attributes listed in
+     * \a attributes or with all the attributes if \a allAttributes is true.
+     */
+    void readFeature( int row, QgsFeature &feature, const QgsAttributeList &attributes, bool allAttributes ) const;
+
+    //! Returns the extent of the geometries
+    QgsRectangle extent() const;
+
+    //! Returns the rows whose geometry bounding box intersects \a rect, in increasing order
+    QVector<int> intersectingRows( const QgsRectangle &rect ) const;
+
+    /**
+     * Prepares the spatial index so that the copies made from now on share it.
+     * The index is built the first time one of them runs a query.
+     */
+    void prepareIndex() const;
+
+  private:
+
+    //! Lazily built spatial index over the geometries of a state of the store
+    struct SpatialIndex;
+
+    //! Adds a geometry at the end of the WKB chunks, returns its position
+    qint64 appendWkb( const QByteArray &wkb );
+
+    //! Rewrites the WKB chunks without the geometries which were replaced or removed
+    void compactWkb();
+
+    QVector<QgsFeatureId> mIds;
+    QVector<QgsMemoryColumn> mColumns;
+
+    QVector<QByteArray> mWkbChunks;
+    //! Position of a geometry: chunk index * chunk size + offset in the chunk
+    QVector<qint64> mWkbPositions;
+    QVector<int> mWkbSizes;
+    QVector<QgsRectangle> mBoundingBoxes;
+    //! Size of the geometries which were replaced or removed
+    qint64 mUnusedWkbSize = 0;
+
+    mutable std::shared_ptr< SpatialIndex > mSpatialIndex;
+};
+
+///@endcond
+
+#endif // QGSMEMORYCOLUMNARSTORE_H
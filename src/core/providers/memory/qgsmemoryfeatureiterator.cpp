@@ -56,9 +56,25 @@ QgsMemoryFeatureIterator::QgsMemoryFeatureIterator( QgsMemoryFeatureSource *sour
     mSelectRectEngine->prepareGeometry();
   }
 
+  if ( mSource->mColumnar )
+  {
+    // the columnar storage always has a spatial index
+    if ( !mFilterRect.isNull() )
+    {
+      mUsingFeatureIdList = true;
+      mRows = mSource->mStore.intersectingRows( mFilterRect );
+    }
+    else if ( mRequest.filterType() == QgsFeatureRequest::FilterFid )
+    {
+      mUsingFeatureIdList = true;
+      const int row = mSource->mStore.row( mRequest.filterFid() );
+      if ( row >= 0 )
+        mRows << row;
+    }
+  }
   // if there's spatial index, use it!
   // (but don't use it when selection rect is not specified)
-  if ( !mFilterRect.isNull() && mSource->mSpatialIndex )
+  else if ( !mFilterRect.isNull() && mSource->mSpatialIndex )
   {
     mUsingFeatureIdList = true;
     mFeatureIdList = mSource->mSpatialIndex->intersects( mFilterRect );
@@ -94,7 +110,9 @@ bool QgsMemoryFeatureIterator::fetchFeature( QgsFeature &feature )
   if ( mClosed )
     return false;
 
-  if ( mUsingFeatureIdList )
+  if ( mSource->mColumnar )
+    return nextFeatureColumnar( feature );
+  else if ( mUsingFeatureIdList )
     return nextFeatureUsingList( feature );
   else
     return nextFeatureTraverseAll( feature );
@@ -205,11 +223,69 @@ bool QgsMemoryFeatureIterator::nextFeatureTraverseAll( QgsFeature &feature )
   return hasFeature;
 }
 
+bool QgsMemoryFeatureIterator::nextFeatureColumnar( QgsFeature &feature )
+{
+  const QgsMemoryColumnarStore &store = mSource->mStore;
+  const bool exactIntersect = !mFilterRect.isNull() && mRequest.flags() & QgsFeatureRequest::ExactIntersect;
+  const bool fetchGeometry = !( mRequest.flags() & QgsFeatureRequest::NoGeometry );
+  // the attributes of an expression filter are not necessarily part of the subset
+  const bool allAttributes = !( mRequest.flags() & QgsFeatureRequest::SubsetOfAttributes )
+                             || mRequest.filterType() == QgsFeatureRequest::FilterExpression
+                             || mSubsetExpression;
+  const int rowCount = mUsingFeatureIdList ? mRows.size() : store.rowCount();
+
+  // only the requested parts of the features are built
+  while ( mRowIndex < rowCount )
+  {
+    const int row = mUsingFeatureIdList ? mRows.at( mRowIndex ) : mRowIndex;
+    ++mRowIndex;
+
+    QgsGeometry geometry;
+    if ( exactIntersect )
+    {
+      if ( !store.hasGeometry( row ) )
+        continue;
+      geometry = store.geometry( row );
+      if ( !mSelectRectEngine->intersects( geometry.geometry() ) )
+        continue;
+    }
+    else if ( fetchGeometry && store.hasGeometry( row ) )
+    {
+      geometry = store.geometry( row );
+    }
+
+    store.readFeature( row, feature, mRequest.subsetOfAttributes(), allAttributes );
+    feature.setFields( mSource->mFields ); // allow name-based attribute lookups
+
+    if ( mSubsetExpression )
+    {
+      if ( !fetchGeometry && !exactIntersect && store.hasGeometry( row ) )
+        feature.setGeometry( store.geometry( row ) );
+      else
+        feature.setGeometry( geometry );
+      mSource->mExpressionContext.setFeature( feature );
+      if ( !mSubsetExpression->evaluate( &mSource->mExpressionContext ).toBool() )
+        continue;
+    }
+
+    if ( fetchGeometry )
+      feature.setGeometry( geometry );
+    else
+      feature.clearGeometry();
+    geometryToDestinationCrs( feature, mTransform );
+    return true;
+  }
+
+  close();
+  return false;
+}
+
 bool QgsMemoryFeatureIterator::rewind()
 {
   if ( mClosed )
     return false;
 
+  mRowIndex = 0;
   if ( mUsingFeatureIdList )
     mFeatureIdListIterator = mFeatureIdList.constBegin();
   else
@@ -234,10 +310,18 @@ bool QgsMemoryFeatureIterator::close()
 QgsMemoryFeatureSource::QgsMemoryFeatureSource( const QgsMemoryProvider *p )
   : mFields( p->mFields )
   , mFeatures( p->mFeatures )
+  , mColumnar( p->mColumnar )
   , mSpatialIndex( p->mSpatialIndex ? new QgsSpatialIndex( *p->mSpatialIndex ) : nullptr )  // just shallow copy
   , mSubsetString( p->mSubsetString )
   , mCrs( p->mCrs )
 {
+  if ( mColumnar )
+  {
+    // the copies of the storage share its spatial index
+    p->mStore.prepareIndex();
+    mStore = p->mStore;
+  }
+
   mExpressionContext << QgsExpressionContextUtils::globalScope()
                      << QgsExpressionContextUtils::projectScope( QgsProject::instance() );
   mExpressionContext.setFields( mFields );
@@ -21,6 +21,7 @@
 #include "qgsexpressioncontext.h"
 #include "qgsfields.h"
 #include "qgsgeometry.h"
+#include "qgsmemorycolumnarstore.h"
 
 ///@cond PRIVATE
 
@@ -41,6 +42,8 @@ class QgsMemoryFeatureSource : public QgsAbstractFeatureSource
   private:
     QgsFields mFields;
     QgsFeatureMap mFeatures;
+    bool mColumnar = false;
+    QgsMemoryColumnarStore mStore;
     std::unique_ptr< QgsSpatialIndex > mSpatialIndex;
     QString mSubsetString;
     QgsExpressionContext mExpressionContext;
@@ -67,6 +70,7 @@ class QgsMemoryFeatureIterator : public QgsAbstractFeatureIteratorFromSource<Qgs
   private:
     bool nextFeatureUsingList( QgsFeature &feature );
     bool nextFeatureTraverseAll( QgsFeature &feature );
+    bool nextFeatureColumnar( QgsFeature &feature );
 
     QgsGeometry mSelectRectGeom;
     std::unique_ptr< QgsGeometryEngine > mSelectRectEngine;
@@ -75,6 +79,9 @@ class QgsMemoryFeatureIterator : public QgsAbstractFeatureIteratorFromSource<Qgs
     bool mUsingFeatureIdList = false;
     QList<QgsFeatureId> mFeatureIdList;
     QList<QgsFeatureId>::const_iterator mFeatureIdListIterator;
+    //! Rows of the columnar storage to traverse, when mUsingFeatureIdList is true
+    QVector<int> mRows;
+    int mRowIndex = 0;
     QgsExpression *mSubsetExpression = nullptr;
     QgsCoordinateTransform mTransform;
 
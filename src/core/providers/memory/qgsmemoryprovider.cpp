@@ -63,6 +63,11 @@ QgsMemoryProvider::QgsMemoryProvider( const QString &uri )
     mCrs.createFromString( crsDef );
   }
 
+  if ( url.hasQueryItem( QStringLiteral( "storage" ) ) && url.queryItemValue( QStringLiteral( "storage" ) ) == QLatin1String( "columnar" ) )
+  {
+    mColumnar = true;
+  }
+
   mNextFeatureId = 1;
 
   setNativeTypes( QList< NativeType >()
@@ -245,6 +250,10 @@ QString QgsMemoryProvider::dataSourceUri( bool expandAuthConfig ) const
   {
     uri.addQueryItem( QStringLiteral( "index" ), QStringLiteral( "yes" ) );
   }
+  if ( mColumnar )
+  {
+    uri.addQueryItem( QStringLiteral( "storage" ), QStringLiteral( "columnar" ) );
+  }
 
   QgsAttributeList attrs = const_cast<QgsMemoryProvider *>( this )->attributeIndexes();
   for ( int i = 0; i < attrs.size(); i++ )
@@ -272,6 +281,13 @@ QgsFeatureIterator QgsMemoryProvider::getFeatures( const QgsFeatureRequest &requ
 
 QgsRectangle QgsMemoryProvider::extent() const
 {
+  if ( mColumnar )
+  {
+    if ( mExtent.isEmpty() && mStore.rowCount() > 0 )
+      mExtent = mStore.extent();
+    return mExtent;
+  }
+
   if ( mExtent.isEmpty() && !mFeatures.isEmpty() )
   {
     mExtent.setMinimal();
@@ -293,7 +309,7 @@ QgsWkbTypes::Type QgsMemoryProvider::wkbType() const
 long QgsMemoryProvider::featureCount() const
 {
   if ( mSubsetString.isEmpty() )
-    return mFeatures.count();
+    return mColumnar ? mStore.rowCount() : mFeatures.count();
 
   // subset string set, no alternative but testing each feature
   QgsFeatureIterator fit = QgsFeatureIterator( new QgsMemoryFeatureIterator( new QgsMemoryFeatureSource( this ), true,  QgsFeatureRequest().setSubsetOfAttributes( QgsAttributeList() ) ) );
@@ -326,7 +342,7 @@ QgsCoordinateReferenceSystem QgsMemoryProvider::crs() const
 bool QgsMemoryProvider::addFeatures( QgsFeatureList &flist, Flags )
 {
   // whether or not to update the layer extent on the fly as we add features
-  bool updateExtent = mFeatures.isEmpty() || !mExtent.isEmpty();
+  bool updateExtent = ( mColumnar ? mStore.rowCount() == 0 : mFeatures.isEmpty() ) || !mExtent.isEmpty();
 
   // TODO: sanity checks of fields and geometries
   for ( QgsFeatureList::iterator it = flist.begin(); it != flist.end(); ++it )
@@ -334,7 +350,10 @@ bool QgsMemoryProvider::addFeatures( QgsFeatureList &flist, Flags )
     it->setId( mNextFeatureId );
     it->setValid( true );
 
-    mFeatures.insert( mNextFeatureId, *it );
+    if ( mColumnar )
+      mStore.addFeature( *it );
+    else
+      mFeatures.insert( mNextFeatureId, *it );
 
     if ( it->hasGeometry() )
     {
@@ -354,6 +373,13 @@ bool QgsMemoryProvider::addFeatures( QgsFeatureList &flist, Flags )
 
 bool QgsMemoryProvider::deleteFeatures( const QgsFeatureIds &id )
 {
+  if ( mColumnar )
+  {
+    mStore.deleteFeatures( id );
+    updateExtents();
+    return true;
+  }
+
   for ( QgsFeatureIds::const_iterator it = id.begin(); it != id.end(); ++it )
   {
     QgsFeatureMap::iterator fit = mFeatures.find( *it );
@@ -397,6 +423,12 @@ bool QgsMemoryProvider::addAttributes( const QList<QgsField> &attributes )
     // add new field as a last one
     mFields.append( *it );
 
+    if ( mColumnar )
+    {
+      mStore.addColumn( it->type() );
+      continue;
+    }
+
     for ( QgsFeatureMap::iterator fit = mFeatures.begin(); fit != mFeatures.end(); ++fit )
     {
       QgsFeature &f = fit.value();
@@ -443,6 +475,12 @@ bool QgsMemoryProvider::deleteAttributes( const QgsAttributeIds &attributes )
     int idx = *it;
     mFields.remove( idx );
 
+    if ( mColumnar )
+    {
+      mStore.removeColumn( idx );
+      continue;
+    }
+
     for ( QgsFeatureMap::iterator fit = mFeatures.begin(); fit != mFeatures.end(); ++fit )
     {
       QgsFeature &f = fit.value();
@@ -458,6 +496,18 @@ bool QgsMemoryProvider::changeAttributeValues( const QgsChangedAttributesMap &at
 {
   for ( QgsChangedAttributesMap::const_iterator it = attr_map.begin(); it != attr_map.end(); ++it )
   {
+    if ( mColumnar )
+    {
+      const int row = mStore.row( it.key() );
+      if ( row < 0 )
+        continue;
+
+      const QgsAttributeMap &attrs = it.value();
+      for ( QgsAttributeMap::const_iterator it2 = attrs.constBegin(); it2 != attrs.constEnd(); ++it2 )
+        mStore.setAttribute( row, it2.key(), it2.value() );
+      continue;
+    }
+
     QgsFeatureMap::iterator fit = mFeatures.find( it.key() );
     if ( fit == mFeatures.end() )
       continue;
@@ -473,6 +523,14 @@ bool QgsMemoryProvider::changeGeometryValues( const QgsGeometryMap &geometry_map
 {
   for ( QgsGeometryMap::const_iterator it = geometry_map.begin(); it != geometry_map.end(); ++it )
   {
+    if ( mColumnar )
+    {
+      const int row = mStore.row( it.key() );
+      if ( row >= 0 )
+        mStore.setGeometry( row, it.value() );
+      continue;
+    }
+
     QgsFeatureMap::iterator fit = mFeatures.find( it.key() );
     if ( fit == mFeatures.end() )
       continue;
@@ -518,6 +576,10 @@ bool QgsMemoryProvider::setSubsetString( const QString &theSQL, bool updateFeatu
 
 bool QgsMemoryProvider::createSpatialIndex()
 {
+  // the columnar storage has its own index
+  if ( mColumnar )
+    return true;
+
   if ( !mSpatialIndex )
   {
     mSpatialIndex = new QgsSpatialIndex();
@@ -18,6 +18,7 @@
 #include "qgsvectordataprovider.h"
 #include "qgscoordinatereferencesystem.h"
 #include "qgsfields.h"
+#include "qgsmemorycolumnarstore.h"
 
 ///@cond PRIVATE
 typedef QMap<QgsFeatureId, QgsFeature> QgsFeatureMap;
@@ -87,6 +88,10 @@ class QgsMemoryProvider : public QgsVectorDataProvider
     QgsFeatureMap mFeatures;
     QgsFeatureId mNextFeatureId;
 
+    // features in typed columns instead of mFeatures, with the "storage=columnar" uri option
+    bool mColumnar = false;
+    QgsMemoryColumnarStore mStore;
+
     // indexing
     QgsSpatialIndex *mSpatialIndex = nullptr;
 
@@ -470,6 +470,10 @@ void QgsCoordinateTransform::transformCoords( int numPoints, double *x, double *
   QgsDebugMsg( QString( "[[[[[[ Number of points to transform: %1 ]]]]]]" ).arg( numPoints ) );
 #endif
 
+  // common transformations are computed without proj
+  if ( d->fastTransform( numPoints, x, y, direction == ReverseTransform ) )
+    return;
+
   // use proj4 to do the transform
 
   // if the source/destination projection is lat/long, convert the points to radians
@@ -230,10 +230,14 @@ class CORE_EXPORT QgsCoordinateTransform
     /** Transform an array of coordinates to the destination CRS.
      * If the direction is ForwardTransform then coordinates are transformed from source to destination,
      * otherwise points are transformed from destination to source CRS.
+     *
+     * This is the most efficient way to transform many points: the whole array is transformed
+     * in a single call, and transformations between EPSG:4326 and EPSG:3857 are computed with
+     * closed form formulas instead of proj.
      * \param numPoint number of coordinates in arrays
      * \param x array of x coordinates to transform
      * \param y array of y coordinates to transform
-     * \param z array of z coordinates to transform
+     * \param z array of z coordinates to transform, may be a null pointer if there are no z values
      * \param direction transform direction (defaults to ForwardTransform)
      */
     void transformCoords( int numPoint, double *x, double *y, double *z, TransformDirection direction = ForwardTransform ) const;
@@ -27,10 +27,47 @@ extern "C"
 
 #include <QStringList>
 
+#include <atomic>
+#include <cmath>
+
 /// @cond PRIVATE
 
 thread_local QgsProjContextStore QgsCoordinateTransformPrivate::mProjContext;
 
+namespace
+{
+  //! Source of the ids of the proj projections, 0 is never used
+  std::atomic<quint64> sNextProjId( 1 );
+
+  /**
+   * Projections recently used by the current thread, indexed by the id of the
+   * projections. As ids are never reused, an entry of a freed transform can
+   * never be returned.
+   */
+  struct ThreadLocalProjCache
+  {
+    static const int SIZE = 8;
+    quint64 ids[SIZE] = {};
+    QPair< projPJ, projPJ > projections[SIZE];
+    int next = 0;
+  };
+  thread_local ThreadLocalProjCache sProjCache;
+
+  //! Radius of the sphere of the pseudo mercator projection
+  const double PSEUDO_MERCATOR_RADIUS = 6378137.0;
+
+  //! Adjusts a longitude in radians to the -pi, pi range, like proj does
+  inline double adjustLongitude( double lon )
+  {
+    if ( std::fabs( lon ) <= 3.14159265359 )
+      return lon;
+    lon += M_PI;
+    lon -= 2 * M_PI * std::floor( lon / ( 2 * M_PI ) );
+    lon -= M_PI;
+    return lon;
+  }
+}
+
 QgsProjContextStore::QgsProjContextStore()
 {
   context = pj_ctx_alloc();
@@ -46,6 +83,8 @@ QgsCoordinateTransformPrivate::QgsCoordinateTransformPrivate()
   , mShortCircuit( false )
   , mSourceDatumTransform( -1 )
   , mDestinationDatumTransform( -1 )
+  , mFastTransform( NoFastTransform )
+  , mProjId( sNextProjId++ )
 {
   setFinder();
 }
@@ -57,6 +96,8 @@ QgsCoordinateTransformPrivate::QgsCoordinateTransformPrivate( const QgsCoordinat
   , mDestCRS( destination )
   , mSourceDatumTransform( -1 )
   , mDestinationDatumTransform( -1 )
+  , mFastTransform( NoFastTransform )
+  , mProjId( sNextProjId++ )
 {
   setFinder();
   initialize();
@@ -70,6 +111,8 @@ QgsCoordinateTransformPrivate::QgsCoordinateTransformPrivate( const QgsCoordinat
   , mDestCRS( other.mDestCRS )
   , mSourceDatumTransform( other.mSourceDatumTransform )
   , mDestinationDatumTransform( other.mDestinationDatumTransform )
+  , mFastTransform( NoFastTransform )
+  , mProjId( sNextProjId++ )
 {
   //must reinitialize to setup mSourceProjection and mDestinationProjection
   initialize();
@@ -85,6 +128,7 @@ bool QgsCoordinateTransformPrivate::initialize()
 {
   mShortCircuit = true;
   mIsValid = false;
+  mFastTransform = NoFastTransform;
 
   if ( !mSourceCRS.isValid() )
   {
@@ -185,19 +229,32 @@ bool QgsCoordinateTransformPrivate::initialize()
     // Transform must take place
     mShortCircuit = false;
     QgsDebugMsgLevel( "Source/Dest CRS not equal, shortcircuit is not set.", 3 );
+
+    if ( mIsValid )
+      initFastTransform();
   }
   return mIsValid;
 }
 
 QPair<projPJ, projPJ> QgsCoordinateTransformPrivate::threadLocalProjData()
 {
+  // lock free lookup of the projections recently used by this thread
+  const quint64 currentId = mProjId.load();
+  for ( int i = 0; i < ThreadLocalProjCache::SIZE; ++i )
+  {
+    if ( sProjCache.ids[i] == currentId )
+      return sProjCache.projections[i];
+  }
+
   mProjLock.lockForRead();
 
   QMap < uintptr_t, QPair< projPJ, projPJ > >::const_iterator it = mProjProjections.constFind( reinterpret_cast< uintptr_t>( mProjContext.get() ) );
   if ( it != mProjProjections.constEnd() )
   {
     QPair<projPJ, projPJ> res = it.value();
+    const quint64 id = mProjId.load();
     mProjLock.unlock();
+    cacheProjData( id, res );
     return res;
   }
 
@@ -207,10 +264,128 @@ QPair<projPJ, projPJ> QgsCoordinateTransformPrivate::threadLocalProjData()
   QPair<projPJ, projPJ> res = qMakePair( pj_init_plus_ctx( mProjContext.get(), mSourceProjString.toUtf8() ),
                                          pj_init_plus_ctx( mProjContext.get(), mDestProjString.toUtf8() ) );
   mProjProjections.insert( reinterpret_cast< uintptr_t>( mProjContext.get() ), res );
+  const quint64 id = mProjId.load();
   mProjLock.unlock();
+  cacheProjData( id, res );
   return res;
 }
 
+void QgsCoordinateTransformPrivate::cacheProjData( quint64 id, const QPair<projPJ, projPJ> &projData )
+{
+  sProjCache.ids[sProjCache.next] = id;
+  sProjCache.projections[sProjCache.next] = projData;
+  sProjCache.next = ( sProjCache.next + 1 ) % ThreadLocalProjCache::SIZE;
+}
+
+bool QgsCoordinateTransformPrivate::fastTransform( int numPoints, double *x, double *y, bool reverse ) const
+{
+  if ( mFastTransform == NoFastTransform )
+    return false;
+
+  const bool toPseudoMercator = ( mFastTransform == Wgs84ToPseudoMercator ) != reverse;
+  if ( toPseudoMercator )
+  {
+    // proj fails at the poles and for longitudes over 10 radians, let it
+    // handle these points and report the errors
+    for ( int i = 0; i < numPoints; ++i )
+    {
+      if ( !( std::fabs( y[i] ) < 89.9999 ) || !( std::fabs( x[i] ) < 572.9 ) )
+        return false;
+    }
+    for ( int i = 0; i < numPoints; ++i )
+    {
+      const double lon = adjustLongitude( x[i] * DEG_TO_RAD );
+      const double lat = y[i] * DEG_TO_RAD;
+      x[i] = PSEUDO_MERCATOR_RADIUS * lon;
+      y[i] = PSEUDO_MERCATOR_RADIUS * std::log( std::tan( M_PI_4 + 0.5 * lat ) );
+    }
+  }
+  else
+  {
+    for ( int i = 0; i < numPoints; ++i )
+    {
+      if ( !std::isfinite( x[i] ) || !std::isfinite( y[i] ) )
+        return false;
+    }
+    for ( int i = 0; i < numPoints; ++i )
+    {
+      const double lon = adjustLongitude( x[i] / PSEUDO_MERCATOR_RADIUS );
+      const double lat = M_PI_2 - 2.0 * std::atan( std::exp( -y[i] / PSEUDO_MERCATOR_RADIUS ) );
+      x[i] = lon * RAD_TO_DEG;
+      y[i] = lat * RAD_TO_DEG;
+    }
+  }
+  return true;
+}
+
+void QgsCoordinateTransformPrivate::initFastTransform()
+{
+  mFastTransform = NoFastTransform;
+  if ( mSourceDatumTransform != -1 || mDestinationDatumTransform != -1 )
+    return;
+
+  const QString sourceAuthId = mSourceCRS.authid().toUpper();
+  const QString destAuthId = mDestCRS.authid().toUpper();
+  FastTransform candidate = NoFastTransform;
+  if ( sourceAuthId == QLatin1String( "EPSG:4326" ) && destAuthId == QLatin1String( "EPSG:3857" ) )
+    candidate = Wgs84ToPseudoMercator;
+  else if ( sourceAuthId == QLatin1String( "EPSG:3857" ) && destAuthId == QLatin1String( "EPSG:4326" ) )
+    candidate = PseudoMercatorToWgs84;
+  else
+    return;
+
+  // the definitions of the CRS may have been customized, check that the
+  // closed form gives the same results as proj on a grid of points
+  QPair<projPJ, projPJ> projData = threadLocalProjData();
+  projPJ wgs84Proj = candidate == Wgs84ToPseudoMercator ? projData.first : projData.second;
+  projPJ mercatorProj = candidate == Wgs84ToPseudoMercator ? projData.second : projData.first;
+  if ( !pj_is_latlong( wgs84Proj ) || pj_is_latlong( mercatorProj ) )
+    return;
+
+  QVector<double> lon, lat;
+  for ( int i = -180; i <= 180; i += 20 )
+  {
+    for ( int j = -85; j <= 85; j += 17 )
+    {
+      lon << i;
+      lat << j;
+    }
+  }
+  const int count = lon.size();
+  QVector<double> x( count ), y( count ), z( count, 0.0 );
+  for ( int i = 0; i < count; ++i )
+  {
+    x[i] = lon.at( i ) * DEG_TO_RAD;
+    y[i] = lat.at( i ) * DEG_TO_RAD;
+  }
+  if ( pj_transform( wgs84Proj, mercatorProj, count, 0, x.data(), y.data(), z.data() ) != 0 )
+    return;
+
+  mFastTransform = Wgs84ToPseudoMercator;
+  QVector<double> fastX = lon;
+  QVector<double> fastY = lat;
+  bool valid = fastTransform( count, fastX.data(), fastY.data(), false );
+  for ( int i = 0; valid && i < count; ++i )
+  {
+    // proj keeps +180 while the closed form returns -180, both are fine
+    const double xError = std::fabs( std::fabs( fastX.at( i ) ) - std::fabs( x.at( i ) ) );
+    valid = xError < 1e-4 && std::fabs( fastY.at( i ) - y.at( i ) ) < 1e-4;
+  }
+
+  // and back
+  valid = valid && fastTransform( count, x.data(), y.data(), true );
+  for ( int i = 0; valid && i < count; ++i )
+  {
+    valid = std::fabs( std::fabs( x.at( i ) ) - std::fabs( lon.at( i ) ) ) < 1e-9 && std::fabs( y.at( i ) - lat.at( i ) ) < 1e-9;
+  }
+
+  mFastTransform = valid ? candidate : NoFastTransform;
+  if ( !valid )
+  {
+    QgsDebugMsg( QString( "Closed form transformation from %1 to %2 does not match proj" ).arg( sourceAuthId, destAuthId ) );
+  }
+}
+
 QString QgsCoordinateTransformPrivate::stripDatumTransform( const QString &proj4 ) const
 {
   QStringList parameterSplit = proj4.split( '+', QString::SkipEmptyParts );
@@ -339,6 +514,7 @@ void QgsCoordinateTransformPrivate::freeProj()
     pj_free( it.value().second );
   }
   mProjProjections.clear();
+  mProjId.store( sNextProjId++ );
   mProjLock.unlock();
 }
 
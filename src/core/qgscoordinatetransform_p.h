@@ -33,6 +33,8 @@
 #include <QSharedData>
 #include "qgscoordinatereferencesystem.h"
 
+#include <atomic>
+
 typedef void *projPJ;
 typedef void *projCtx;
 
@@ -72,6 +74,22 @@ class QgsCoordinateTransformPrivate : public QSharedData
 
     QPair< projPJ, projPJ > threadLocalProjData();
 
+    //! Closed form transformations used instead of proj for common CRS pairs
+    enum FastTransform
+    {
+      NoFastTransform, //!< Use proj
+      Wgs84ToPseudoMercator, //!< EPSG:4326 to EPSG:3857
+      PseudoMercatorToWgs84, //!< EPSG:3857 to EPSG:4326
+    };
+
+    /**
+     * Transforms coordinates in place with the closed form transformation.
+     * Returns false, leaving the coordinates untouched, if there is no closed
+     * form transformation or if a point is outside of its domain, in which
+     * case proj must be used.
+     */
+    bool fastTransform( int numPoints, double *x, double *y, bool reverse ) const;
+
     //! Flag to indicate whether the transform is valid (ie has a valid
     //! source and destination crs)
     bool mIsValid;
@@ -100,9 +118,20 @@ class QgsCoordinateTransformPrivate : public QSharedData
      */
     static thread_local QgsProjContextStore mProjContext;
 
+    //! Closed form transformation used for the forward direction
+    FastTransform mFastTransform;
+
     QReadWriteLock mProjLock;
     QMap < uintptr_t, QPair< projPJ, projPJ > > mProjProjections;
 
+    /**
+     * Unique id of the current proj projections, changed whenever they are
+     * freed. Used as key of the thread local cache of projections, which
+     * avoids locking mProjLock for every transform. Atomic as the lock free
+     * lookup reads it while freeProj() may replace it.
+     */
+    std::atomic<quint64> mProjId;
+
     static QString datumTransformString( int datumTransform );
 
   private:
@@ -115,6 +144,12 @@ class QgsCoordinateTransformPrivate : public QSharedData
 
     void setFinder();
 
+    //! Stores projections in the thread local cache
+    static void cacheProjData( quint64 id, const QPair<projPJ, projPJ> &projData );
+
+    //! Sets mFastTransform if a closed form transformation matches proj for the CRS pair
+    void initFastTransform();
+
     void freeProj();
 };
 
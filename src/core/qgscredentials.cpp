@@ -73,6 +73,20 @@ void QgsCredentials::put( const QString &realm, const QString &username, const Q
   mCredentialCache.insert( realm, QPair<QString, QString>( username, password ) );
 }
 
+bool QgsCredentials::getCached( const QString &realm, QString &username, QString &password ) const
+{
+  if ( !mCredentialCache.contains( realm ) )
+    return false;
+
+  const QPair<QString, QString> credentials = mCredentialCache.value( realm );
+  if ( credentials.second.isNull() )
+    return false;
+
+  username = credentials.first;
+  password = credentials.second;
+  return true;
+}
+
 bool QgsCredentials::getMasterPassword( QString &password, bool stored )
 {
   if ( requestMasterPassword( password, stored ) )
@@ -46,6 +46,15 @@ class CORE_EXPORT QgsCredentials
     bool get( const QString &realm, QString &username SIP_INOUT, QString &password SIP_INOUT, const QString &message = QString() );
     void put( const QString &realm, const QString &username, const QString &password );
 
+    /**
+     * Retrieves the credentials stored with put() for the \a realm, without requesting them.
+     * Unlike get(), the credentials are kept in the cache. Call it between lock() and unlock()
+     * when the credentials may be stored from other threads.
+     * \returns true if credentials with a password are cached for the realm
+     * \since QGIS 3.0
+     */
+    bool getCached( const QString &realm, QString &username SIP_OUT, QString &password SIP_OUT ) const;
+
     bool getMasterPassword( QString &password SIP_INOUT, bool stored = false );
 
     //! retrieves instance
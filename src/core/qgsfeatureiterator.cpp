@@ -221,6 +221,11 @@ void QgsAbstractFeatureIterator::setInterruptionChecker( QgsInterruptionChecker
 {
 }
 
+QgsAbstractFeatureIterator::PrefetchStatistics QgsAbstractFeatureIterator::prefetchStatistics() const
+{
+  return PrefetchStatistics();
+}
+
 ///////
 
 QgsFeatureIterator &QgsFeatureIterator::operator=( const QgsFeatureIterator &other )
@@ -78,6 +78,31 @@ class CORE_EXPORT QgsAbstractFeatureIterator
      */
     CompileStatus compileStatus() const { return mCompileStatus; }
 
+    /** Statistics of the prefetching of features in a background thread.
+     * \see QgsFeatureRequest::Prefetch
+     * \since QGIS 3.0
+     */
+    struct PrefetchStatistics
+    {
+      //! True if the features are fetched in a background thread
+      bool prefetched = false;
+
+      //! Number of features fetched in the background thread
+      int prefetchedFeatures = 0;
+
+      //! Time in milliseconds the background thread spent waiting for the consumer to process features
+      double producerStallTime = 0;
+
+      //! Time in milliseconds the consumer spent waiting for the background thread to deliver features
+      double consumerStallTime = 0;
+    };
+
+    /** Returns the statistics of the prefetching of features. The default implementation
+     * returns the statistics of an iterator which does not prefetch features.
+     * \since QGIS 3.0
+     */
+    virtual PrefetchStatistics prefetchStatistics() const;
+
   protected:
 
     /**
@@ -289,6 +314,12 @@ class CORE_EXPORT QgsFeatureIterator
      */
     QgsAbstractFeatureIterator::CompileStatus compileStatus() const { return mIter->compileStatus(); }
 
+    /** Returns the statistics of the prefetching of features, e.g. to check whether
+     * the QgsFeatureRequest::Prefetch flag has been honored.
+     * \since QGIS 3.0
+     */
+    QgsAbstractFeatureIterator::PrefetchStatistics prefetchStatistics() const;
+
     friend bool operator== ( const QgsFeatureIterator &fi1, const QgsFeatureIterator &fi2 ) SIP_SKIP;
     friend bool operator!= ( const QgsFeatureIterator &fi1, const QgsFeatureIterator &fi2 ) SIP_SKIP;
 
@@ -367,6 +398,11 @@ inline void QgsFeatureIterator::setInterruptionChecker( QgsInterruptionChecker *
     mIter->setInterruptionChecker( interruptionChecker );
 }
 
+inline QgsAbstractFeatureIterator::PrefetchStatistics QgsFeatureIterator::prefetchStatistics() const
+{
+  return mIter ? mIter->prefetchStatistics() : QgsAbstractFeatureIterator::PrefetchStatistics();
+}
+
 #endif
 
 #endif // QGSFEATUREITERATOR_H
@@ -285,11 +285,22 @@ bool QgsFeatureRequest::acceptFeature( const QgsFeature &feature )
 #include "qgsfeatureiterator.h"
 #include "qgslogger.h"
 
+#include <QMutex>
+
+// iterators of a source may be opened and closed by the thread of a prefetching iterator
+Q_GLOBAL_STATIC( QMutex, sActiveIteratorsMutex )
+
 QgsAbstractFeatureSource::~QgsAbstractFeatureSource()
 {
-  while ( !mActiveIterators.empty() )
+  while ( true )
   {
-    QgsAbstractFeatureIterator *it = *mActiveIterators.begin();
+    QgsAbstractFeatureIterator *it = nullptr;
+    {
+      QMutexLocker locker( sActiveIteratorsMutex() );
+      if ( mActiveIterators.empty() )
+        break;
+      it = *mActiveIterators.begin();
+    }
     QgsDebugMsg( "closing active iterator" );
     it->close();
   }
@@ -297,11 +308,13 @@ QgsAbstractFeatureSource::~QgsAbstractFeatureSource()
 
 void QgsAbstractFeatureSource::iteratorOpened( QgsAbstractFeatureIterator *it )
 {
+  QMutexLocker locker( sActiveIteratorsMutex() );
   mActiveIterators.insert( it );
 }
 
 void QgsAbstractFeatureSource::iteratorClosed( QgsAbstractFeatureIterator *it )
 {
+  QMutexLocker locker( sActiveIteratorsMutex() );
   mActiveIterators.remove( it );
 }
 
@@ -71,7 +71,8 @@ class CORE_EXPORT QgsFeatureRequest
       NoFlags            = 0,
       NoGeometry         = 1,  //!< Geometry is not required. It may still be returned if e.g. required for a filter condition.
       SubsetOfAttributes = 2,  //!< Fetch only a subset of attributes (setSubsetOfAttributes sets this flag)
-      ExactIntersect     = 4   //!< Use exact geometry intersection (slower) instead of bounding boxes
+      ExactIntersect     = 4,  //!< Use exact geometry intersection (slower) instead of bounding boxes
+      Prefetch           = 8,  //!< Fetch features in a background thread while the previous ones are processed. Honored by vector layers and their feature sources (since QGIS 3.0)
     };
     Q_DECLARE_FLAGS( Flags, Flag )
 
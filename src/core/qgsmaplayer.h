@@ -412,6 +412,14 @@ class CORE_EXPORT QgsMapLayer : public QObject
      */
     bool readLayerXml( const QDomElement &layerElement, const QgsReadWriteContext &context );
 
+    /** Returns the data source of a layer as it is used by its \a provider, from the
+     * \a dataSource stored in a project file (e.g. with relative paths resolved
+     * through the \a context).
+     * \see readLayerXml()
+     * \since QGIS 3.0
+     */
+    static QString decodedSource( const QString &dataSource, const QString &provider, const QgsReadWriteContext &context );
+
     /** Stores state in Dom node
      * \param layerElement is a Dom element corresponding to ``maplayer'' tag
      * \param document is a the dom document being written
@@ -0,0 +1,240 @@
+/***************************************************************************
+    qgsprefetchingfeatureiterator.cpp
+    ---------------------------------
+    begin                : October 2017
+    copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsprefetchingfeatureiterator.h"
+#include "qgslogger.h"
+
+#include <QElapsedTimer>
+#include <QThread>
+
+#include <algorithm>
+#include <functional>
+
+///@cond PRIVATE
+namespace
+{
+  //! Number of features of the first batch, so that the consumer can start early
+  const int FIRST_BATCH_SIZE = 16;
+  //! Maximum number of features of a batch
+  const int BATCH_SIZE = 256;
+  //! Capacity of the buffer
+  const int BUFFER_SIZE = 4 * BATCH_SIZE;
+
+  class PrefetchThread : public QThread
+  {
+    public:
+      explicit PrefetchThread( const std::function< void() > &function )
+        : mFunction( function )
+      {}
+
+    protected:
+      void run() override
+      {
+        mFunction();
+      }
+
+    private:
+      std::function< void() > mFunction;
+  };
+}
+///@endcond
+
+QgsPrefetchingFeatureIterator::QgsPrefetchingFeatureIterator( QgsAbstractFeatureSource *source, bool ownSource, const QgsFeatureRequest &request )
+  : QgsAbstractFeatureIteratorFromSource<QgsAbstractFeatureSource>( source, ownSource, request )
+  , mProducerRequest( request )
+  , mBuffer( BUFFER_SIZE )
+{
+  mProducerRequest.setFlags( request.flags() & ~QgsFeatureRequest::Prefetch );
+}
+
+QgsPrefetchingFeatureIterator::~QgsPrefetchingFeatureIterator()
+{
+  // the thread must be stopped before the source is deleted
+  close();
+}
+
+bool QgsPrefetchingFeatureIterator::fetchFeature( QgsFeature &f )
+{
+  f.setValid( false );
+
+  if ( mClosed )
+    return false;
+
+  if ( mBatchIndex >= mBatch.size() && !takeBatch() )
+  {
+    close();
+    return false;
+  }
+
+  f = mBatch.at( mBatchIndex++ );
+  return true;
+}
+
+bool QgsPrefetchingFeatureIterator::takeBatch()
+{
+  if ( !mThread )
+  {
+    mThread.reset( new PrefetchThread( [this] { produce(); } ) );
+    mThread->start();
+  }
+
+  QMutexLocker locker( &mMutex );
+
+  QElapsedTimer timer;
+  timer.start();
+  while ( mBufferCount == 0 && !mProducerFinished )
+    mBufferNotEmpty.wait( &mMutex );
+  mConsumerStallTime += timer.nsecsElapsed();
+
+  if ( mBufferCount == 0 )
+    return false;
+
+  // swapping avoids allocating new features in the buffer
+  mBatch.resize( mBufferCount );
+  for ( int i = 0; i < mBufferCount; ++i )
+    std::swap( mBatch[ i ], mBuffer[( mBufferStart + i ) % BUFFER_SIZE ] );
+  mBufferStart = ( mBufferStart + mBufferCount ) % BUFFER_SIZE;
+  mBufferCount = 0;
+  mBatchIndex = 0;
+
+  mBufferNotFull.wakeAll();
+  return true;
+}
+
+void QgsPrefetchingFeatureIterator::produce()
+{
+  QgsInterruptionChecker *interruptionChecker = nullptr;
+  {
+    QMutexLocker locker( &mMutex );
+    interruptionChecker = mInterruptionChecker;
+  }
+
+  // the iterator is created and destroyed in this thread, like the iterators of map renderers
+  QgsFeatureIterator it = mSource->getFeatures( mProducerRequest );
+  it.setInterruptionChecker( interruptionChecker );
+
+  QVector<QgsFeature> batch;
+  batch.reserve( BATCH_SIZE );
+  int batchSize = FIRST_BATCH_SIZE;
+  QgsFeature f;
+  bool finished = false;
+  while ( !finished )
+  {
+    batch.clear();
+    while ( batch.size() < batchSize )
+    {
+      if ( mStopRequested.load() || ( interruptionChecker && interruptionChecker->mustStop() ) || !it.nextFeature( f ) )
+      {
+        finished = true;
+        break;
+      }
+      batch << f;
+    }
+    batchSize = std::min( 2 * batchSize, BATCH_SIZE );
+
+    QMutexLocker locker( &mMutex );
+
+    QElapsedTimer timer;
+    timer.start();
+    while ( !mStopRequested.load() && BUFFER_SIZE - mBufferCount < batch.size() )
+      mBufferNotFull.wait( &mMutex );
+    mProducerStallTime += timer.nsecsElapsed();
+
+    if ( mStopRequested.load() )
+      break;
+
+    for ( int i = 0; i < batch.size(); ++i )
+      std::swap( batch[ i ], mBuffer[( mBufferStart + mBufferCount + i ) % BUFFER_SIZE ] );
+    mBufferCount += batch.size();
+    mPrefetchedFeatures += batch.size();
+    mBufferNotEmpty.wakeAll();
+  }
+
+  it.close();
+
+  QMutexLocker locker( &mMutex );
+  mProducerFinished = true;
+  mBufferNotEmpty.wakeAll();
+}
+
+void QgsPrefetchingFeatureIterator::stopProducer()
+{
+  if ( !mThread )
+    return;
+
+  {
+    QMutexLocker locker( &mMutex );
+    mStopRequested.store( 1 );
+    mBufferNotFull.wakeAll();
+  }
+  mThread->wait();
+  mThread.reset();
+
+  QgsDebugMsgLevel( QStringLiteral( "Prefetching stalls: producer %1 ms, consumer %2 ms" ).arg( prefetchStatistics().producerStallTime ).arg( prefetchStatistics().consumerStallTime ), 2 );
+
+  mBuffer.fill( QgsFeature() );
+  mBufferStart = 0;
+  mBufferCount = 0;
+  mProducerFinished = false;
+  mStopRequested.store( 0 );
+  mBatch.clear();
+  mBatchIndex = 0;
+}
+
+bool QgsPrefetchingFeatureIterator::rewind()
+{
+  if ( mClosed )
+    return false;
+
+  // the next call to fetchFeature() starts over with a new iterator
+  stopProducer();
+  return true;
+}
+
+bool QgsPrefetchingFeatureIterator::close()
+{
+  if ( mClosed )
+    return false;
+
+  stopProducer();
+
+  iteratorClosed();
+
+  mClosed = true;
+  return true;
+}
+
+void QgsPrefetchingFeatureIterator::setInterruptionChecker( QgsInterruptionChecker *interruptionChecker )
+{
+  // only used by the threads started from now on
+  QMutexLocker locker( &mMutex );
+  mInterruptionChecker = interruptionChecker;
+}
+
+QgsAbstractFeatureIterator::PrefetchStatistics QgsPrefetchingFeatureIterator::prefetchStatistics() const
+{
+  QMutexLocker locker( &mMutex );
+  PrefetchStatistics statistics;
+  statistics.prefetched = true;
+  statistics.prefetchedFeatures = mPrefetchedFeatures;
+  statistics.producerStallTime = mProducerStallTime / 1000000.0;
+  statistics.consumerStallTime = mConsumerStallTime / 1000000.0;
+  return statistics;
+}
+
+bool QgsPrefetchingFeatureIterator::prepareOrderBy( const QList<QgsFeatureRequest::OrderByClause> &orderBys )
+{
+  Q_UNUSED( orderBys );
+  return true;
+}
@@ -0,0 +1,124 @@
+/***************************************************************************
+    qgsprefetchingfeatureiterator.h
+    -------------------------------
+    begin                : October 2017
+    copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef QGSPREFETCHINGFEATUREITERATOR_H
+#define QGSPREFETCHINGFEATUREITERATOR_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgsfeatureiterator.h"
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QVector>
+
+#include <memory>
+
+class QThread;
+
+/**
+ * \ingroup core
+ * Feature iterator which fetches the features of a source in a background thread,
+ * so that reading and decoding them overlaps with the processing of the previous
+ * features by the consumer.
+ *
+ * The background thread opens its own iterator on the source, with the request
+ * of this iterator minus the QgsFeatureRequest::Prefetch flag, and fills a bounded
+ * buffer with batches of features. It only starts with the first nextFeature() call,
+ * and it stops when the iterator is closed, rewound or interrupted through
+ * setInterruptionChecker(). The source must stay alive until the iterator is closed,
+ * and the callbacks of the request are called from the background thread.
+ *
+ * Sources can honor the QgsFeatureRequest::Prefetch flag by returning this iterator
+ * from their getFeatures() implementation.
+ *
+ * \since QGIS 3.0
+ */
+class CORE_EXPORT QgsPrefetchingFeatureIterator : public QgsAbstractFeatureIteratorFromSource<QgsAbstractFeatureSource>
+{
+  public:
+
+    /**
+     * Constructor for QgsPrefetchingFeatureIterator, fetching the features matching
+     * \a request from a \a source. If \a ownSource is true, the iterator deletes the
+     * source when it is destroyed.
+     */
+    QgsPrefetchingFeatureIterator( QgsAbstractFeatureSource *source, bool ownSource, const QgsFeatureRequest &request );
+
+    ~QgsPrefetchingFeatureIterator();
+
+    bool rewind() override;
+    bool close() override;
+    void setInterruptionChecker( QgsInterruptionChecker *interruptionChecker ) override;
+
+    /**
+     * Returns the statistics of the background thread. The stall times and the number
+     * of prefetched features add up over rewinds.
+     */
+    PrefetchStatistics prefetchStatistics() const override;
+
+  protected:
+
+    bool fetchFeature( QgsFeature &f ) override;
+
+    //! The iterator of the background thread already applies the filter
+    bool nextFeatureFilterExpression( QgsFeature &f ) override { return fetchFeature( f ); }
+
+    //! The iterator of the background thread already applies the filter
+    bool nextFeatureFilterFids( QgsFeature &f ) override { return fetchFeature( f ); }
+
+  private:
+
+    //! The iterator of the background thread already sorts the features
+    bool prepareOrderBy( const QList<QgsFeatureRequest::OrderByClause> &orderBys ) override;
+
+    //! Fills the buffer, runs in the background thread
+    void produce();
+
+    //! Moves the buffered features to mBatch, waiting for them if needed. Returns false at the end of the features
+    bool takeBatch();
+
+    //! Stops the background thread and empties the buffer
+    void stopProducer();
+
+    //! Request of the iterator of the background thread
+    QgsFeatureRequest mProducerRequest;
+
+    std::unique_ptr< QThread > mThread;
+
+    mutable QMutex mMutex;
+    QWaitCondition mBufferNotEmpty;
+    QWaitCondition mBufferNotFull;
+
+    //! Ring buffer of the fetched features
+    QVector<QgsFeature> mBuffer;
+    int mBufferStart = 0;
+    int mBufferCount = 0;
+    bool mProducerFinished = false;
+    QAtomicInt mStopRequested;
+    QgsInterruptionChecker *mInterruptionChecker = nullptr;
+
+    //! Features taken from the buffer by the consumer
+    QVector<QgsFeature> mBatch;
+    int mBatchIndex = 0;
+
+    //! Stall times in nanoseconds
+    qint64 mProducerStallTime = 0;
+    qint64 mConsumerStallTime = 0;
+    //! Features put in the buffer by the background thread
+    int mPrefetchedFeatures = 0;
+};
+
+#endif // QGSPREFETCHINGFEATUREITERATOR_H
@@ -17,6 +17,7 @@
 
 #include "qgsproject.h"
 
+#include "qgsapplication.h"
 #include "qgsdatasourceuri.h"
 #include "qgslabelingenginesettings.h"
 #include "qgslayertree.h"
@@ -30,9 +31,11 @@
 #include "qgssnappingconfig.h"
 #include "qgspathresolver.h"
 #include "qgsprojectversion.h"
+#include "qgsproviderregistry.h"
 #include "qgsrasterlayer.h"
 #include "qgsreadwritecontext.h"
 #include "qgsrectangle.h"
+#include "qgsruntimeprofiler.h"
 #include "qgsrelationmanager.h"
 #include "qgsannotationmanager.h"
 #include "qgsvectorlayer.h"
@@ -58,6 +61,11 @@
 #include <QTemporaryFile>
 #include <QDir>
 #include <QUrl>
+#include <QThread>
+#include <QTime>
+#include <QtConcurrentMap>
+
+#include <algorithm>
 
 #ifdef Q_OS_UNIX
 #include <utime.h>
@@ -648,6 +656,154 @@ void QgsProject::setSnappingConfig( const QgsSnappingConfig &snappingConfig )
   emit snappingConfigChanged( mSnappingConfig );
 }
 
+///@cond PRIVATE
+namespace
+{
+  //! Maximum number of threads creating the providers of layers sharing a connection
+  const int DEFAULT_PARALLEL_LAYERS_PER_CONNECTION = 4;
+
+  //! The provider of a project layer, created ahead of the layer
+  struct ProviderPreparation
+  {
+    QString providerKey;
+    QString dataSource;
+    QString layerName;
+    double time = 0;
+    //! Token of the provider handed over to the provider registry, 0 if none
+    int token = 0;
+  };
+
+  /**
+   * Returns the provider key of a project layer element, or an empty string if
+   * its provider cannot be created out of the main thread.
+   */
+  QString preparableProviderKey( const QDomElement &element, const QString &dataSource )
+  {
+    if ( element.attribute( QStringLiteral( "embedded" ) ) == QLatin1String( "1" ) )
+      return QString();
+
+    // the master password is asked for on the main thread, which is blocked meanwhile
+    if ( dataSource.contains( QLatin1String( "authcfg=" ) ) )
+      return QString();
+
+    // same defaults as QgsVectorLayer::readXml() and QgsRasterLayer::readXml()
+    const QString type = element.attribute( QStringLiteral( "type" ) );
+    QString providerKey = element.namedItem( QStringLiteral( "provider" ) ).toElement().text();
+    if ( type == QLatin1String( "vector" ) )
+    {
+      if ( providerKey.isEmpty() )
+        providerKey = dataSource.contains( QLatin1String( "dbname=" ) ) ? QStringLiteral( "postgres" ) : QStringLiteral( "ogr" );
+    }
+    else if ( type == QLatin1String( "raster" ) )
+    {
+      if ( providerKey.isEmpty() )
+        providerKey = QStringLiteral( "gdal" );
+    }
+    else
+    {
+      return QString();
+    }
+
+    // providers known to support being created on a worker thread. Postgres layers only
+    // use cached credentials there and share a connection per lane, the layers which
+    // fail to connect are created again on the main thread
+    if ( providerKey != QLatin1String( "ogr" ) && providerKey != QLatin1String( "gdal" ) && providerKey != QLatin1String( "postgres" ) )
+      return QString();
+
+    return providerKey;
+  }
+
+  /**
+   * Creates on worker threads the providers of the layers of a project, and hands them
+   * over to the provider registry for the layers to pick them up. The providers of layers
+   * sharing a connection (the same database or file) are created by at most
+   * \a maxPerConnection threads.
+   * \returns tokens of the providers handed over to the registry
+   */
+  QList< int > prepareProviders( const QVector<QDomNode> &layerNodes, const QgsReadWriteContext &context, int maxPerConnection )
+  {
+    QList< ProviderPreparation > preparations;
+    QMap< QString, QList< int > > connections;
+    Q_FOREACH ( const QDomNode &node, layerNodes )
+    {
+      const QDomElement element = node.toElement();
+      const QString dataSource = element.namedItem( QStringLiteral( "datasource" ) ).toElement().text();
+      const QString providerKey = preparableProviderKey( element, dataSource );
+      if ( providerKey.isEmpty() )
+        continue;
+
+      ProviderPreparation preparation;
+      preparation.providerKey = providerKey;
+      // decoded as QgsMapLayer::readLayerXml() does, from the stored provider key
+      const QString storedProviderKey = element.namedItem( QStringLiteral( "provider" ) ).toElement().text();
+      preparation.dataSource = QgsMapLayer::decodedSource( dataSource, storedProviderKey, context );
+      preparation.layerName = element.namedItem( QStringLiteral( "layername" ) ).toElement().text();
+
+      const QString connection = providerKey == QLatin1String( "postgres" )
+                                 ? QgsDataSourceUri( preparation.dataSource ).connectionInfo( false )
+                                 : preparation.dataSource.section( '|', 0, 0 );
+      connections[ providerKey + ':' + connection ] << preparations.size();
+      preparations << preparation;
+    }
+
+    // dispatch the layers of each connection to a bounded number of lanes, each lane
+    // creating its providers one after the other
+    QVector< QList< int > > lanes;
+    for ( auto it = connections.constBegin(); it != connections.constEnd(); ++it )
+    {
+      const int laneCount = std::min( maxPerConnection, it.value().size() );
+      const int firstLane = lanes.size();
+      lanes.resize( firstLane + laneCount );
+      for ( int i = 0; i < it.value().size(); ++i )
+        lanes[ firstLane + i % laneCount ] << it.value().at( i );
+    }
+
+    QThread *thread = QThread::currentThread();
+    QtConcurrent::blockingMap( lanes, [&preparations, thread]( const QList< int > &lane )
+    {
+      QgsProviderRegistry *registry = QgsProviderRegistry::instance();
+      QMap< int, QgsDataProvider * > providers;
+      registry->beginPreparationLane();
+      Q_FOREACH ( int index, lane )
+      {
+        ProviderPreparation &preparation = preparations[ index ];
+        QTime time;
+        time.start();
+        QgsDataProvider *provider = registry->createProvider( preparation.providerKey, preparation.dataSource );
+        preparation.time = time.elapsed() / 1000.0;
+        // invalid providers, e.g. which could not connect without asking for credentials,
+        // are created again by their layer
+        if ( provider && !provider->isValid() )
+        {
+          delete provider;
+          provider = nullptr;
+        }
+        if ( provider )
+          providers.insert( index, provider );
+      }
+      registry->endPreparationLane();
+
+      // the providers of the lane may share resources, they are handed over together
+      for ( auto it = providers.constBegin(); it != providers.constEnd(); ++it )
+      {
+        ProviderPreparation &preparation = preparations[ it.key() ];
+        it.value()->moveToThread( thread );
+        preparation.token = registry->addPreparedProvider( preparation.providerKey, preparation.dataSource, it.value() );
+      }
+    } );
+
+    QList< int > tokens;
+    Q_FOREACH ( const ProviderPreparation &preparation, preparations )
+    {
+      QgsDebugMsgLevel( QStringLiteral( "Provider of layer %1 created in %2 s" ).arg( preparation.layerName ).arg( preparation.time ), 2 );
+      if ( preparation.token )
+        tokens << preparation.token;
+    }
+    return tokens;
+  }
+}
+///@endcond
+
 bool QgsProject::_getMapLayers( const QDomDocument &doc, QList<QDomNode> &brokenNodes )
 {
   // Layer order is set by the restoring the legend settings from project file.
@@ -678,6 +834,22 @@ bool QgsProject::_getMapLayers( const QDomDocument &doc, QList<QDomNode> &broken
 
   QVector<QDomNode> sortedLayerNodes = depSorter.sortedLayerNodes();
 
+  QgsReadWriteContext context;
+  context.setPathResolver( pathResolver() );
+
+  QgsRuntimeProfiler *profiler = QgsApplication::profiler();
+  profiler->beginGroup( QStringLiteral( "Project layers" ) );
+
+  // the providers are created concurrently, the layers are still read and added in order
+  const int maxPerConnection = QgsSettings().value( QStringLiteral( "qgis/parallelLayerLoadingPerConnection" ), DEFAULT_PARALLEL_LAYERS_PER_CONNECTION ).toInt();
+  QList< int > preparedProviderTokens;
+  if ( maxPerConnection > 0 )
+  {
+    profiler->start( tr( "Creating providers" ) );
+    preparedProviderTokens = prepareProviders( sortedLayerNodes, context, maxPerConnection );
+    profiler->end();
+  }
+
   int i = 0;
   Q_FOREACH ( const QDomNode &node, sortedLayerNodes )
   {
@@ -694,17 +866,21 @@ bool QgsProject::_getMapLayers( const QDomDocument &doc, QList<QDomNode> &broken
     }
     else
     {
-      QgsReadWriteContext context;
-      context.setPathResolver( pathResolver() );
+      profiler->start( name );
       if ( !addLayer( element, brokenNodes, context ) )
       {
         returnStatus = false;
       }
+      profiler->end();
     }
     emit layerLoaded( i + 1, nl.count() );
     i++;
   }
 
+  // providers of layers which failed before picking them up
+  QgsProviderRegistry::instance()->clearPreparedProviders( preparedProviderTokens );
+  profiler->endGroup();
+
   return returnStatus;
 }
 
@@ -37,8 +37,8 @@ class QgsDataProvider;
  * For library based providers, the metadata class is used in a lazy load
  * implementation in QgsProviderRegistry.  To save memory, data providers
  * are only actually loaded via QLibrary calls if they're to be used.  (Though they're all
- * iteratively loaded once to get their metadata information, and then
- * unloaded when the QgsProviderRegistry is created.)  QgsProviderMetadata
+ * loaded once to get their metadata information when the QgsProviderRegistry is
+ * created, unless this information is found in the cache of the registry.)  QgsProviderMetadata
  * supplies enough information to be able to later load the associated shared
  * library object.
  *
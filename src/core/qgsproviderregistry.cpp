@@ -19,10 +19,19 @@
 #include "qgsproviderregistry.h"
 
 #include <QString>
+#include <QAtomicInt>
+#include <QDataStream>
+#include <QDateTime>
 #include <QDir>
 #include <QLibrary>
+#include <QLocale>
+#include <QSaveFile>
+#include <QMutexLocker>
+#include <QSet>
+#include <QThread>
 
 #include "qgis.h"
+#include "qgsapplication.h"
 #include "qgsdataprovider.h"
 #include "qgslogger.h"
 #include "qgsmessageoutput.h"
@@ -30,8 +39,12 @@
 #include "qgsprovidermetadata.h"
 #include "qgsvectorlayer.h"
 #include "qgsproject.h"
+#include "qgsruntimeprofiler.h"
+#include "qgssettings.h"
 #include "providers/memory/qgsmemoryprovider.h"
 
+#include <gdal.h>
+
 
 // typedefs for provider plugin functions of interest
 typedef QString providerkey_t();
@@ -47,87 +60,133 @@ typedef QString protocolDrivers_t();
 
 
 
-QgsProviderRegistry *QgsProviderRegistry::instance( const QString &pluginPath )
+///@cond PRIVATE
+namespace
 {
-  static QgsProviderRegistry *sInstance( new QgsProviderRegistry( pluginPath ) );
-  return sInstance;
-} // QgsProviderRegistry::instance
-
+  //! Lane of providers created in advance on the current thread, 0 outside of lanes
+  thread_local int sPreparationLane = 0;
 
+  //! Identifies the provider metadata cache files, and their format version
+  const quint32 METADATA_CACHE_MAGIC = 0x51505243;
+  const quint32 METADATA_CACHE_VERSION = 1;
 
-QgsProviderRegistry::QgsProviderRegistry( const QString &pluginPath )
-{
-  // At startup, examine the libs in the qgis/lib dir and store those that
-  // are a provider shared lib
-  // check all libs in the current plugin directory and get name and descriptions
-  //TODO figure out how to register and identify data source plugin for a specific
-  //TODO layer type
-#if 0
-  char **argv = qApp->argv();
-  QString appDir = argv[0];
-  int bin = appDir.findRev( "/bin", -1, false );
-  QString baseDir = appDir.left( bin );
-  QString mLibraryDirectory = baseDir + "/lib";
-#endif
-  mLibraryDirectory = pluginPath;
-  init();
-}
-
-
-void QgsProviderRegistry::init()
-{
-  // add standard providers
-  mProviders[ QgsMemoryProvider::providerKey() ] = new QgsProviderMetadata( QgsMemoryProvider::providerKey(), QgsMemoryProvider::providerDescription(), &QgsMemoryProvider::createProvider );
-
-  mLibraryDirectory.setSorting( QDir::Name | QDir::IgnoreCase );
-  mLibraryDirectory.setFilter( QDir::Files | QDir::NoSymLinks );
+  //! What the provider registry learns about a library by loading it
+  struct LibraryMetadata
+  {
+    qint64 lastModified = 0;
+    qint64 size = 0;
+    bool isProvider = false;
+    QString key;
+    QString description;
+    // null if the library does not have the corresponding function
+    QString databaseDrivers;
+    QString directoryDrivers;
+    QString protocolDrivers;
+    QString vectorFileFilters;
+    QString rasterFileFilters;
+  };
+
+  QDataStream &operator<<( QDataStream &stream, const LibraryMetadata &metadata )
+  {
+    return stream << metadata.lastModified << metadata.size << metadata.isProvider
+           << metadata.key << metadata.description
+           << metadata.databaseDrivers << metadata.directoryDrivers << metadata.protocolDrivers
+           << metadata.vectorFileFilters << metadata.rasterFileFilters;
+  }
 
-#if defined(Q_OS_WIN) || defined(__CYGWIN__)
-  mLibraryDirectory.setNameFilters( QStringList( "*.dll" ) );
-#elif defined(ANDROID)
-  mLibraryDirectory.setNameFilters( QStringList( "*provider.so" ) );
-#else
-  mLibraryDirectory.setNameFilters( QStringList( QStringLiteral( "*.so" ) ) );
-#endif
+  QDataStream &operator>>( QDataStream &stream, LibraryMetadata &metadata )
+  {
+    return stream >> metadata.lastModified >> metadata.size >> metadata.isProvider
+           >> metadata.key >> metadata.description
+           >> metadata.databaseDrivers >> metadata.directoryDrivers >> metadata.protocolDrivers
+           >> metadata.vectorFileFilters >> metadata.rasterFileFilters;
+  }
 
-  QgsDebugMsg( QString( "Checking %1 for provider plugins" ).arg( mLibraryDirectory.path() ) );
+  typedef QHash< QString, LibraryMetadata > LibraryMetadataCache;
 
-  if ( mLibraryDirectory.count() == 0 )
+  //! Returns the path of the provider metadata cache file
+  QString metadataCacheFilePath()
   {
-    QString msg = QObject::tr( "No QGIS data provider plugins found in:\n%1\n" ).arg( mLibraryDirectory.path() );
-    msg += QObject::tr( "No vector layers can be loaded. Check your QGIS installation" );
+    return QgsApplication::qgisSettingsDirPath() + QStringLiteral( "providers.cache" );
+  }
 
-    QgsMessageOutput *output = QgsMessageOutput::createMessageOutput();
-    output->setTitle( QObject::tr( "No Data Providers" ) );
-    output->setMessage( msg, QgsMessageOutput::MessageText );
-    output->showMessage();
-    return;
+  /**
+   * Returns a description of what the metadata of providers may depend on besides
+   * their library, e.g. the GDAL drivers listed in the file filters.
+   */
+  QString metadataCacheEnvironment()
+  {
+    QStringList environment;
+    // the filters and descriptions are translated, main() stores the locale of the translation
+    environment << Qgis::QGIS_VERSION
+                << QgsSettings().value( QStringLiteral( "locale/userLocale" ), QLocale().name() ).toString()
+                << GDALVersionInfo( "RELEASE_NAME" )
+                << QString::fromLocal8Bit( getenv( "GDAL_DRIVER_PATH" ) )
+                << QString::fromLocal8Bit( getenv( "GDAL_SKIP" ) )
+                << QString::fromLocal8Bit( getenv( "OGR_SKIP" ) );
+    return environment.join( '\n' );
   }
 
-  // provider file regex pattern, only files matching the pattern are loaded if the variable is defined
-  QString filePattern = getenv( "QGIS_PROVIDER_FILE" );
-  QRegExp fileRegexp;
-  if ( !filePattern.isEmpty() )
+  LibraryMetadataCache readMetadataCache( const QString &environment )
   {
-    fileRegexp.setPattern( filePattern );
+    LibraryMetadataCache cache;
+    QFile file( metadataCacheFilePath() );
+    if ( !file.open( QIODevice::ReadOnly ) )
+      return cache;
+
+    QDataStream stream( &file );
+    stream.setVersion( QDataStream::Qt_5_0 );
+    quint32 magic = 0;
+    quint32 version = 0;
+    QString cachedEnvironment;
+    stream >> magic >> version;
+    if ( magic != METADATA_CACHE_MAGIC || version != METADATA_CACHE_VERSION )
+      return cache;
+
+    stream >> cachedEnvironment;
+    if ( cachedEnvironment != environment )
+      return cache;
+
+    stream >> cache;
+    if ( stream.status() != QDataStream::Ok )
+    {
+      QgsDebugMsg( QString( "Ignoring the invalid provider cache %1" ).arg( file.fileName() ) );
+      cache.clear();
+    }
+    return cache;
   }
 
-  Q_FOREACH ( const QFileInfo &fi, mLibraryDirectory.entryInfoList() )
+  void writeMetadataCache( const QString &environment, const LibraryMetadataCache &cache )
   {
-    if ( !fileRegexp.isEmpty() )
+    // written atomically, other processes may read it at the same time
+    QSaveFile file( metadataCacheFilePath() );
+    if ( !file.open( QIODevice::WriteOnly ) )
     {
-      if ( fileRegexp.indexIn( fi.fileName() ) == -1 )
-      {
-        QgsDebugMsg( "provider " + fi.fileName() + " skipped because doesn't match pattern " + filePattern );
-        continue;
-      }
+      QgsDebugMsg( QString( "Cannot write the provider cache %1" ).arg( file.fileName() ) );
+      return;
     }
 
+    QDataStream stream( &file );
+    stream.setVersion( QDataStream::Qt_5_0 );
+    stream << METADATA_CACHE_MAGIC << METADATA_CACHE_VERSION << environment << cache;
+    if ( !file.commit() )
+      QgsDebugMsg( QString( "Cannot write the provider cache %1" ).arg( file.fileName() ) );
+  }
+
+  /**
+   * Loads a library to read its provider metadata. Returns false if the library cannot
+   * be loaded.
+   */
+  bool readLibraryMetadata( const QFileInfo &fi, LibraryMetadata &metadata )
+  {
+    metadata.lastModified = fi.lastModified().toMSecsSinceEpoch();
+    metadata.size = fi.size();
+
     QLibrary myLib( fi.filePath() );
     if ( !myLib.load() )
     {
       QgsDebugMsg( QString( "Checking %1: ...invalid (lib not loadable): %2" ).arg( myLib.fileName(), myLib.errorString() ) );
-      continue;
+      return false;
     }
 
     //MH: Added a further test to detect non-provider plugins linked to provider plugins.
@@ -136,7 +195,7 @@ void QgsProviderRegistry::init()
     if ( hasType )
     {
       QgsDebugMsg( QString( "Checking %1: ...invalid (has type method)" ).arg( myLib.fileName() ) );
-      continue;
+      return true;
     }
 
     // get the description and the key for the provider plugin
@@ -144,14 +203,14 @@ void QgsProviderRegistry::init()
     if ( !isProvider )
     {
       QgsDebugMsg( QString( "Checking %1: ...invalid (no isProvider method)" ).arg( myLib.fileName() ) );
-      continue;
+      return true;
     }
 
     // check to see if this is a provider plugin
     if ( !isProvider() )
     {
       QgsDebugMsg( QString( "Checking %1: ...invalid (not a provider)" ).arg( myLib.fileName() ) );
-      continue;
+      return true;
     }
 
     // looks like a provider. get the key and description
@@ -159,50 +218,53 @@ void QgsProviderRegistry::init()
     if ( !pDesc )
     {
       QgsDebugMsg( QString( "Checking %1: ...invalid (no description method)" ).arg( myLib.fileName() ) );
-      continue;
+      return true;
     }
 
     providerkey_t *pKey = reinterpret_cast< providerkey_t * >( cast_to_fptr( myLib.resolve( "providerKey" ) ) );
     if ( !pKey )
     {
       QgsDebugMsg( QString( "Checking %1: ...invalid (no providerKey method)" ).arg( myLib.fileName() ) );
-      continue;
+      return true;
     }
 
-    // add this provider to the provider map
-    mProviders[pKey()] = new QgsProviderMetadata( pKey(), pDesc(), myLib.fileName() );
+    metadata.isProvider = true;
+    metadata.key = pKey();
+    metadata.description = pDesc();
 
-    // load database drivers
+    // database drivers
     databaseDrivers_t *pDatabaseDrivers = reinterpret_cast< databaseDrivers_t * >( cast_to_fptr( myLib.resolve( "databaseDrivers" ) ) );
     if ( pDatabaseDrivers )
     {
-      mDatabaseDrivers = pDatabaseDrivers();
+      metadata.databaseDrivers = pDatabaseDrivers();
+      if ( metadata.databaseDrivers.isNull() )
+        metadata.databaseDrivers = QLatin1String( "" );
     }
 
-    // load directory drivers
+    // directory drivers
     directoryDrivers_t *pDirectoryDrivers = reinterpret_cast< directoryDrivers_t * >( cast_to_fptr( myLib.resolve( "directoryDrivers" ) ) );
     if ( pDirectoryDrivers )
     {
-      mDirectoryDrivers = pDirectoryDrivers();
+      metadata.directoryDrivers = pDirectoryDrivers();
+      if ( metadata.directoryDrivers.isNull() )
+        metadata.directoryDrivers = QLatin1String( "" );
     }
 
-    // load protocol drivers
+    // protocol drivers
     protocolDrivers_t *pProtocolDrivers = reinterpret_cast< protocolDrivers_t * >( cast_to_fptr( myLib.resolve( "protocolDrivers" ) ) );
     if ( pProtocolDrivers )
     {
-      mProtocolDrivers = pProtocolDrivers();
+      metadata.protocolDrivers = pProtocolDrivers();
+      if ( metadata.protocolDrivers.isNull() )
+        metadata.protocolDrivers = QLatin1String( "" );
     }
 
     // now get vector file filters, if any
     fileVectorFilters_t *pFileVectorFilters = reinterpret_cast< fileVectorFilters_t * >( cast_to_fptr( myLib.resolve( "fileVectorFilters" ) ) );
     if ( pFileVectorFilters )
     {
-      QString fileVectorFilters = pFileVectorFilters();
-
-      if ( !fileVectorFilters.isEmpty() )
-        mVectorFileFilters += fileVectorFilters;
-
-      QgsDebugMsg( QString( "Checking %1: ...loaded OK (%2 file filters)" ).arg( myLib.fileName() ).arg( fileVectorFilters.split( ";;" ).count() ) );
+      metadata.vectorFileFilters = pFileVectorFilters();
+      QgsDebugMsg( QString( "Checking %1: ...loaded OK (%2 file filters)" ).arg( myLib.fileName() ).arg( metadata.vectorFileFilters.split( ";;" ).count() ) );
     }
 
     // now get raster file filters, if any
@@ -211,16 +273,149 @@ void QgsProviderRegistry::init()
       reinterpret_cast< buildsupportedrasterfilefilter_t * >( cast_to_fptr( myLib.resolve( "buildSupportedRasterFileFilter" ) ) );
     if ( pBuild )
     {
-      QString fileRasterFilters;
-      pBuild( fileRasterFilters );
+      pBuild( metadata.rasterFileFilters );
+      QgsDebugMsg( "raster filters: " + metadata.rasterFileFilters );
+      QgsDebugMsg( QString( "Checking %1: ...loaded OK (%2 file filters)" ).arg( myLib.fileName() ).arg( metadata.rasterFileFilters.split( ";;" ).count() ) );
+    }
+
+    return true;
+  }
+}
+///@endcond
+
+QgsProviderRegistry *QgsProviderRegistry::instance( const QString &pluginPath )
+{
+  static QgsProviderRegistry *sInstance( new QgsProviderRegistry( pluginPath ) );
+  return sInstance;
+} // QgsProviderRegistry::instance
+
 
-      QgsDebugMsg( "raster filters: " + fileRasterFilters );
-      if ( !fileRasterFilters.isEmpty() )
-        mRasterFileFilters += fileRasterFilters;
 
-      QgsDebugMsg( QString( "Checking %1: ...loaded OK (%2 file filters)" ).arg( myLib.fileName() ).arg( fileRasterFilters.split( ";;" ).count() ) );
+QgsProviderRegistry::QgsProviderRegistry( const QString &pluginPath )
+{
+  // At startup, examine the libs in the qgis/lib dir and store those that
+  // are a provider shared lib
+  // check all libs in the current plugin directory and get name and descriptions
+  //TODO figure out how to register and identify data source plugin for a specific
+  //TODO layer type
+#if 0
+  char **argv = qApp->argv();
+  QString appDir = argv[0];
+  int bin = appDir.findRev( "/bin", -1, false );
+  QString baseDir = appDir.left( bin );
+  QString mLibraryDirectory = baseDir + "/lib";
+#endif
+  mLibraryDirectory = pluginPath;
+  QgsApplication::profiler()->start( QObject::tr( "Provider registry" ) );
+  init();
+  QgsApplication::profiler()->end();
+}
+
+
+void QgsProviderRegistry::init()
+{
+  // add standard providers
+  mProviders[ QgsMemoryProvider::providerKey() ] = new QgsProviderMetadata( QgsMemoryProvider::providerKey(), QgsMemoryProvider::providerDescription(), &QgsMemoryProvider::createProvider );
+
+  mLibraryDirectory.setSorting( QDir::Name | QDir::IgnoreCase );
+  mLibraryDirectory.setFilter( QDir::Files | QDir::NoSymLinks );
+
+#if defined(Q_OS_WIN) || defined(__CYGWIN__)
+  mLibraryDirectory.setNameFilters( QStringList( "*.dll" ) );
+#elif defined(ANDROID)
+  mLibraryDirectory.setNameFilters( QStringList( "*provider.so" ) );
+#else
+  mLibraryDirectory.setNameFilters( QStringList( QStringLiteral( "*.so" ) ) );
+#endif
+
+  QgsDebugMsg( QString( "Checking %1 for provider plugins" ).arg( mLibraryDirectory.path() ) );
+
+  if ( mLibraryDirectory.count() == 0 )
+  {
+    QString msg = QObject::tr( "No QGIS data provider plugins found in:\n%1\n" ).arg( mLibraryDirectory.path() );
+    msg += QObject::tr( "No vector layers can be loaded. Check your QGIS installation" );
+
+    QgsMessageOutput *output = QgsMessageOutput::createMessageOutput();
+    output->setTitle( QObject::tr( "No Data Providers" ) );
+    output->setMessage( msg, QgsMessageOutput::MessageText );
+    output->showMessage();
+    return;
+  }
+
+  // provider file regex pattern, only files matching the pattern are loaded if the variable is defined
+  QString filePattern = getenv( "QGIS_PROVIDER_FILE" );
+  QRegExp fileRegexp;
+  if ( !filePattern.isEmpty() )
+  {
+    fileRegexp.setPattern( filePattern );
+  }
+
+  // the metadata of unchanged libraries is read from the cache, they are
+  // then only loaded when first used
+  const QString cacheEnvironment = metadataCacheEnvironment();
+  const LibraryMetadataCache cache = readMetadataCache( cacheEnvironment );
+  LibraryMetadataCache updatedCache = cache;
+  bool cacheChanged = false;
+  if ( fileRegexp.isEmpty() )
+  {
+    // forget the libraries removed from the directory
+    const QString directoryPath = mLibraryDirectory.absolutePath();
+    for ( auto it = updatedCache.begin(); it != updatedCache.end(); )
+    {
+      if ( QFileInfo( it.key() ).absolutePath() == directoryPath )
+        it = updatedCache.erase( it );
+      else
+        ++it;
     }
   }
+
+  Q_FOREACH ( const QFileInfo &fi, mLibraryDirectory.entryInfoList() )
+  {
+    if ( !fileRegexp.isEmpty() )
+    {
+      if ( fileRegexp.indexIn( fi.fileName() ) == -1 )
+      {
+        QgsDebugMsg( "provider " + fi.fileName() + " skipped because doesn't match pattern " + filePattern );
+        continue;
+      }
+    }
+
+    LibraryMetadata metadata;
+    const auto cached = cache.constFind( fi.absoluteFilePath() );
+    if ( cached != cache.constEnd()
+         && cached->lastModified == fi.lastModified().toMSecsSinceEpoch()
+         && cached->size == fi.size() )
+    {
+      metadata = *cached;
+    }
+    else
+    {
+      // libraries which cannot be loaded are not cached, they may become
+      // loadable once their dependencies are installed
+      if ( !readLibraryMetadata( fi, metadata ) )
+        continue;
+      cacheChanged = true;
+    }
+    updatedCache.insert( fi.absoluteFilePath(), metadata );
+
+    if ( !metadata.isProvider )
+      continue;
+
+    // add this provider to the provider map
+    mProviders[metadata.key] = new QgsProviderMetadata( metadata.key, metadata.description, fi.filePath() );
+
+    if ( !metadata.databaseDrivers.isNull() )
+      mDatabaseDrivers = metadata.databaseDrivers;
+    if ( !metadata.directoryDrivers.isNull() )
+      mDirectoryDrivers = metadata.directoryDrivers;
+    if ( !metadata.protocolDrivers.isNull() )
+      mProtocolDrivers = metadata.protocolDrivers;
+    mVectorFileFilters += metadata.vectorFileFilters;
+    mRasterFileFilters += metadata.rasterFileFilters;
+  }
+
+  if ( cacheChanged || updatedCache.size() != cache.size() )
+    writeMetadataCache( cacheEnvironment, updatedCache );
 } // QgsProviderRegistry ctor
 
 
@@ -230,6 +425,12 @@ typedef void cleanupProviderFunction_t();
 void QgsProviderRegistry::clean()
 {
   QgsProject::instance()->removeAllMapLayers();
+  {
+    QMutexLocker locker( &mPreparedProvidersMutex );
+    Q_FOREACH ( const PreparedProvider &prepared, mPreparedProviders )
+      delete prepared.provider;
+    mPreparedProviders.clear();
+  }
 
   Providers::const_iterator it = mProviders.begin();
 
@@ -251,6 +452,12 @@ void QgsProviderRegistry::clean()
     ++it;
   }
   mProviders.clear();
+
+  mVectorFileFilters.clear();
+  mRasterFileFilters.clear();
+  mDatabaseDrivers.clear();
+  mDirectoryDrivers.clear();
+  mProtocolDrivers.clear();
 }
 
 QgsProviderRegistry::~QgsProviderRegistry()
@@ -359,6 +566,21 @@ QgsDataProvider *QgsProviderRegistry::createProvider( QString const &providerKey
   // XXX should I check for and possibly delete any pre-existing providers?
   // XXX How often will that scenario occur?
 
+  {
+    QMutexLocker locker( &mPreparedProvidersMutex );
+    const QPair< QString, QString > key( providerKey, dataSource );
+    for ( auto it = mPreparedProviders.find( key ); it != mPreparedProviders.end() && it.key() == key; ++it )
+    {
+      // a provider is only usable from the thread it lives in
+      if ( it.value().provider->thread() == QThread::currentThread() )
+      {
+        QgsDataProvider *provider = it.value().provider;
+        mPreparedProviders.erase( it );
+        return provider;
+      }
+    }
+  }
+
   const QgsProviderMetadata *metadata = providerMetadata( providerKey );
   if ( !metadata )
   {
@@ -420,6 +642,60 @@ QgsDataProvider *QgsProviderRegistry::createProvider( QString const &providerKey
   return dataProvider;
 } // QgsProviderRegistry::setDataProvider
 
+int QgsProviderRegistry::addPreparedProvider( const QString &providerKey, const QString &dataSource, QgsDataProvider *provider )
+{
+  if ( !provider )
+    return 0;
+
+  QMutexLocker locker( &mPreparedProvidersMutex );
+  PreparedProvider prepared;
+  prepared.provider = provider;
+  prepared.token = mNextPreparedProviderToken++;
+  mPreparedProviders.insert( qMakePair( providerKey, dataSource ), prepared );
+  return prepared.token;
+}
+
+void QgsProviderRegistry::clearPreparedProviders( const QList< int > &tokens )
+{
+  const QSet< int > tokenSet = tokens.toSet();
+  QMutexLocker locker( &mPreparedProvidersMutex );
+  for ( auto it = mPreparedProviders.begin(); it != mPreparedProviders.end(); )
+  {
+    if ( tokenSet.contains( it.value().token ) )
+    {
+      delete it.value().provider;
+      it = mPreparedProviders.erase( it );
+    }
+    else
+    {
+      ++it;
+    }
+  }
+}
+
+int QgsProviderRegistry::beginPreparationLane()
+{
+  static QAtomicInt sNextLane( 1 );
+  sPreparationLane = sNextLane.fetchAndAddOrdered( 1 );
+  return sPreparationLane;
+}
+
+void QgsProviderRegistry::endPreparationLane()
+{
+  sPreparationLane = 0;
+}
+
+int QgsProviderRegistry::preparationLane() const
+{
+  return sPreparationLane;
+}
+
+int QgsProviderRegistry::preparedProviderCount() const
+{
+  QMutexLocker locker( &mPreparedProvidersMutex );
+  return mPreparedProviders.size();
+}
+
 int QgsProviderRegistry::providerCapabilities( const QString &providerKey ) const
 {
   std::unique_ptr< QLibrary > library( createProviderLibrary( providerKey ) );
@@ -23,6 +23,9 @@
 
 #include <QDir>
 #include <QLibrary>
+#include <QMultiHash>
+#include <QMutex>
+#include <QPair>
 #include <QString>
 
 #include "qgis_core.h"
@@ -47,6 +50,10 @@ class QgsCoordinateReferenceSystem;
   * QGIS_PROVIDER_FILE is regexp pattern applied to provider file name (not provider key).
   * For example, if the variable is set to gdal|ogr|postgres it will load only providers gdal,
   * ogr and postgres.
+  *
+  * The key, description and file filters of the provider libraries are cached in
+  * the providers.cache file of the settings directory. Libraries which did not change
+  * since they were cached are only loaded when first used.
 */
 class CORE_EXPORT QgsProviderRegistry
 {
@@ -95,6 +102,67 @@ class CORE_EXPORT QgsProviderRegistry
     QgsDataProvider *createProvider( const QString &providerKey,
                                      const QString &dataSource ) SIP_FACTORY;
 
+    /**
+     * Hands over a \a provider created in advance, e.g. on a worker thread, for the
+     * \a providerKey and \a dataSource. The next call to createProvider() with the same
+     * key and data source made from the thread the provider lives in returns this
+     * provider instead of creating a new one.
+     * The registry takes ownership of the provider until then.
+     * \returns token identifying the provider, for clearPreparedProviders()
+     * \see clearPreparedProviders()
+     * \since QGIS 3.0
+     * \note not available in Python bindings
+     */
+    int addPreparedProvider( const QString &providerKey, const QString &dataSource, QgsDataProvider *provider ) SIP_SKIP;
+
+    /**
+     * Deletes the providers added with addPreparedProvider() which were not used, among
+     * the ones identified by \a tokens. Providers prepared by other callers, e.g. for a
+     * project read at the same time on another thread, are kept.
+     * \see addPreparedProvider()
+     * \since QGIS 3.0
+     * \note not available in Python bindings
+     */
+    void clearPreparedProviders( const QList< int > &tokens ) SIP_SKIP;
+
+    /**
+     * Starts a lane of providers created in advance on the current thread, one after the
+     * other. Providers created in the same lane may share resources such as database
+     * connections, which they would not share on other threads than the main one. The
+     * providers of a lane must be handed over to the thread they will live in together,
+     * after endPreparationLane().
+     * \returns identifier of the lane, unique for the session
+     * \see endPreparationLane()
+     * \see preparationLane()
+     * \since QGIS 3.0
+     * \note not available in Python bindings
+     */
+    int beginPreparationLane() SIP_SKIP;
+
+    /**
+     * Ends the lane of providers created in advance on the current thread.
+     * \see beginPreparationLane()
+     * \since QGIS 3.0
+     * \note not available in Python bindings
+     */
+    void endPreparationLane() SIP_SKIP;
+
+    /**
+     * Returns the identifier of the lane of providers created in advance on the current
+     * thread, or 0 if providers are not being created in advance on this thread.
+     * \see beginPreparationLane()
+     * \since QGIS 3.0
+     * \note not available in Python bindings
+     */
+    int preparationLane() const SIP_SKIP;
+
+    /**
+     * Returns the number of providers added with addPreparedProvider() which were not
+     * used yet.
+     * \since QGIS 3.0
+     */
+    int preparedProviderCount() const;
+
     /** Return the provider capabilities
         \param providerKey identificator of the provider
         \since QGIS 2.6
@@ -213,6 +281,22 @@ class CORE_EXPORT QgsProviderRegistry
     //! Directory in which provider plugins are installed
     QDir mLibraryDirectory;
 
+    //! Protects mPreparedProviders, which is filled from worker threads
+    mutable QMutex mPreparedProvidersMutex;
+
+    //! Provider created in advance, with its token
+    struct PreparedProvider
+    {
+      QgsDataProvider *provider;
+      int token;
+    };
+
+    //! Providers created in advance, by provider key and data source
+    QMultiHash< QPair< QString, QString >, PreparedProvider > mPreparedProviders;
+
+    //! Token of the next provider created in advance
+    int mNextPreparedProviderToken = 1;
+
     /** File filter string for vector files
      *
      * Built once when registry is constructed by appending strings returned
@@ -33,15 +33,23 @@ void QgsRuntimeProfiler::endGroup()
 
 void QgsRuntimeProfiler::start( const QString &name )
 {
-  mProfileTime.restart();
-  mCurrentName = name;
+  QTime time;
+  time.start();
+  mProfileTime.push( time );
+  mCurrentName.push( name );
 }
 
 void QgsRuntimeProfiler::end()
 {
-  QString name = mCurrentName;
+  if ( mCurrentName.isEmpty() )
+  {
+    qWarning( "QgsRuntimeProfiler::end: No matching start()" );
+    return;
+  }
+
+  QString name = mCurrentName.pop();
   name.prepend( mGroupPrefix );
-  double timing =  mProfileTime.elapsed() / 1000.0;
+  double timing =  mProfileTime.pop().elapsed() / 1000.0;
   mProfileTimes.append( QPair<QString, double>( name, timing ) );
   QgsDebugMsg( QStringLiteral( "PROFILE: %1 - %2" ).arg( name ).arg( timing ) );
 }
@@ -36,11 +36,12 @@ class CORE_EXPORT QgsRuntimeProfiler
      * \brief Start a profile event with the given name.
      * \param name The name of the profile event. Will have the name of
      * the active group appended after ending.
+     * Events can be nested, end() then ends the last started event.
      */
     void start( const QString &name );
 
     /**
-     * \brief End the current profile event.
+     * \brief End the last started profile event.
      */
     void end();
 
@@ -65,8 +66,8 @@ class CORE_EXPORT QgsRuntimeProfiler
   private:
     QString mGroupPrefix;
     QStack<QString> mGroupStack;
-    QTime mProfileTime;
-    QString mCurrentName;
+    QStack<QTime> mProfileTime;
+    QStack<QString> mCurrentName;
     QList<QPair<QString, double > > mProfileTimes;
 };
 
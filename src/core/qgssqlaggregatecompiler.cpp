@@ -0,0 +1,100 @@
+/***************************************************************************
+                             qgssqlaggregatecompiler.cpp
+                             ---------------------------
+    begin                : October 2017
+    copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgssqlaggregatecompiler.h"
+#include "qgssqlexpressioncompiler.h"
+#include "qgsexpression.h"
+#include "qgsfield.h"
+#include "qgssettings.h"
+
+#include <memory>
+
+QString QgsSqlAggregateCompiler::compile( QgsAggregateCalculator::Aggregate aggregate, const QgsField &field, const QString &from,
+    const QString &whereClause, const QgsAggregateCalculator::AggregateParameters &parameters ) const
+{
+  switch ( field.type() )
+  {
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+    case QVariant::Double:
+      break;
+
+    default:
+      return QString();
+  }
+
+  const QString function = aggregateFunction( aggregate, quotedIdentifier( field.name() ) );
+  if ( function.isEmpty() )
+    return QString();
+
+  QString where = whereClause;
+  if ( !parameters.filter.isEmpty() )
+  {
+    // the filter must be evaluated completely by the database, otherwise the
+    // aggregate is calculated from the features
+    if ( !QgsSettings().value( QStringLiteral( "qgis/compileExpressions" ), true ).toBool() )
+      return QString();
+
+    QgsExpression filter( parameters.filter );
+    if ( filter.hasParserError() )
+      return QString();
+
+    std::unique_ptr< QgsSqlExpressionCompiler > compiler( createExpressionCompiler() );
+    if ( compiler->compile( &filter ) != QgsSqlExpressionCompiler::Complete )
+      return QString();
+
+    where = where.isEmpty() ? compiler->result() : QStringLiteral( "( %1 ) AND ( %2 )" ).arg( where, compiler->result() );
+  }
+
+  QString sql = QStringLiteral( "SELECT %1 FROM %2" ).arg( castToReal( function ), from );
+  if ( !where.isEmpty() )
+  {
+    sql += QStringLiteral( " WHERE %1" ).arg( where );
+  }
+  return sql;
+}
+
+QString QgsSqlAggregateCompiler::aggregateFunction( QgsAggregateCalculator::Aggregate aggregate, const QString &column ) const
+{
+  switch ( aggregate )
+  {
+    case QgsAggregateCalculator::Count:
+      return QStringLiteral( "count(%1)" ).arg( column );
+    case QgsAggregateCalculator::CountDistinct:
+      return QStringLiteral( "count(DISTINCT %1)" ).arg( column );
+    case QgsAggregateCalculator::CountMissing:
+      return QStringLiteral( "count(*)-count(%1)" ).arg( column );
+    case QgsAggregateCalculator::Min:
+      return QStringLiteral( "min(%1)" ).arg( column );
+    case QgsAggregateCalculator::Max:
+      return QStringLiteral( "max(%1)" ).arg( column );
+    case QgsAggregateCalculator::Sum:
+      // the sum of no values is 0, as for QgsAggregateCalculator
+      return QStringLiteral( "coalesce(sum(%1),0)" ).arg( column );
+    case QgsAggregateCalculator::Mean:
+      return QStringLiteral( "avg(%1)" ).arg( column );
+    case QgsAggregateCalculator::Range:
+      return QStringLiteral( "max(%1)-min(%1)" ).arg( column );
+
+    default:
+      return QString();
+  }
+}
+
+QString QgsSqlAggregateCompiler::castToReal( const QString &value ) const
+{
+  return QStringLiteral( "CAST(%1 AS DOUBLE PRECISION)" ).arg( value );
+}
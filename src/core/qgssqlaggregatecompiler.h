@@ -0,0 +1,82 @@
+/***************************************************************************
+                             qgssqlaggregatecompiler.h
+                             -------------------------
+    begin                : October 2017
+    copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSSQLAGGREGATECOMPILER_H
+#define QGSSQLAGGREGATECOMPILER_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgsaggregatecalculator.h"
+
+class QgsField;
+class QgsSqlExpressionCompiler;
+
+/** \ingroup core
+ * \class QgsSqlAggregateCompiler
+ * \brief Generic aggregate compiler for translation to provider specific SQL statements.
+ *
+ * This class is designed to be overridden by providers to calculate aggregates in the database.
+ * Only numeric aggregates over numeric fields are compiled, their results do not depend on the
+ * ordering or on the text representation of the values. The base implementation uses standard SQL,
+ * providers override the hooks where their SQL dialect differs.
+ * \since QGIS 3.0
+ * \note Not part of stable API, may change in future versions of QGIS
+ * \note Not available in Python bindings
+ */
+class CORE_EXPORT QgsSqlAggregateCompiler
+{
+  public:
+
+    virtual ~QgsSqlAggregateCompiler() = default;
+
+    /** Returns the SQL statement calculating \a aggregate over \a field as a single real value.
+     * \param aggregate aggregate to calculate
+     * \param field field to calculate the aggregate over
+     * \param from FROM clause of the statement, e.g. the quoted table name
+     * \param whereClause WHERE clause of the provider, e.g. its subset string. May be empty.
+     * \param parameters aggregate parameters, whose filter is compiled to SQL
+     * \returns SQL statement, or an empty string if the aggregate, the field type or the filter
+     * can not be handled completely by the database and the aggregate must be calculated from
+     * the features instead
+     */
+    QString compile( QgsAggregateCalculator::Aggregate aggregate, const QgsField &field, const QString &from,
+                     const QString &whereClause, const QgsAggregateCalculator::AggregateParameters &parameters ) const;
+
+  protected:
+
+    /** Returns a quoted column identifier, in the format expected by the provider.
+     */
+    virtual QString quotedIdentifier( const QString &identifier ) const = 0;
+
+    /** Returns the SQL expression calculating \a aggregate over the quoted \a column, or an empty
+     * string if the database does not support the aggregate. The base implementation handles
+     * count, count distinct, count missing, min, max, sum, mean and range in standard SQL.
+     * Derived classes should override this to handle other aggregates or dialect differences.
+     */
+    virtual QString aggregateFunction( QgsAggregateCalculator::Aggregate aggregate, const QString &column ) const;
+
+    /** Casts the result of the aggregate to a real value. The base implementation casts
+     * to DOUBLE PRECISION.
+     */
+    virtual QString castToReal( const QString &value ) const;
+
+    /** Creates the expression compiler of the aggregate filters. Ownership is transferred
+     * to the caller.
+     */
+    virtual QgsSqlExpressionCompiler *createExpressionCompiler() const = 0;
+
+};
+
+#endif // QGSSQLAGGREGATECOMPILER_H
@@ -0,0 +1,346 @@
+/***************************************************************************
+    qgsstatisticalsketches.cpp
+    --------------------------
+    begin                : October 2017
+    copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsstatisticalsketches.h"
+
+#include <QPair>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+///@cond PRIVATE
+namespace
+{
+  //! Smallest capacity of a level of a quantile sketch
+  const int MIN_LEVEL_CAPACITY = 8;
+
+  //! Number of bits of the hash selecting a register of a distinct count sketch
+  const int REGISTER_BITS = 12;
+  const int REGISTER_COUNT = 1 << REGISTER_BITS;
+
+  //! Number of distinct values counted exactly before switching to the registers
+  const int EXACT_DISTINCT_LIMIT = 256;
+
+  //! 64 bit hash of a double, equal values have equal hashes
+  quint64 hashValue( double value )
+  {
+    if ( value == 0 )
+      value = 0; // -0 == 0
+    else if ( std::isnan( value ) )
+      value = std::numeric_limits<double>::quiet_NaN();
+
+    quint64 bits;
+    std::memcpy( &bits, &value, sizeof( bits ) );
+
+    // splitmix64 finalizer
+    bits += 0x9e3779b97f4a7c15ULL;
+    bits = ( bits ^ ( bits >> 30 ) ) * 0xbf58476d1ce4e5b9ULL;
+    bits = ( bits ^ ( bits >> 27 ) ) * 0x94d049bb133111ebULL;
+    return bits ^ ( bits >> 31 );
+  }
+}
+///@endcond
+
+//
+// QgsQuantileSketch
+//
+
+QgsQuantileSketch::QgsQuantileSketch( int k )
+  : mK( std::max( k, MIN_LEVEL_CAPACITY ) )
+{
+}
+
+void QgsQuantileSketch::add( double value )
+{
+  if ( mLevels.isEmpty() )
+    mLevels.resize( 1 );
+
+  mLevels[0].append( value );
+  mCount++;
+  if ( mLevels.at( 0 ).size() >= levelCapacity( 0 ) )
+    compress();
+}
+
+void QgsQuantileSketch::merge( const QgsQuantileSketch &other )
+{
+  if ( other.mCount == 0 )
+    return;
+
+  if ( mLevels.size() < other.mLevels.size() )
+    mLevels.resize( other.mLevels.size() );
+  for ( int level = 0; level < other.mLevels.size(); ++level )
+    mLevels[level] += other.mLevels.at( level );
+  mCount += other.mCount;
+  compress();
+}
+
+double QgsQuantileSketch::quantile( double fraction ) const
+{
+  if ( mCount == 0 )
+    return std::numeric_limits<double>::quiet_NaN();
+
+  QVector< QPair< double, qint64 > > weightedValues;
+  for ( int level = 0; level < mLevels.size(); ++level )
+  {
+    const qint64 weight = Q_INT64_C( 1 ) << level;
+    for ( double value : mLevels.at( level ) )
+      weightedValues << qMakePair( value, weight );
+  }
+  std::sort( weightedValues.begin(), weightedValues.end() );
+
+  const double rank = fraction * mCount;
+  qint64 cumulativeWeight = 0;
+  for ( const QPair< double, qint64 > &weightedValue : weightedValues )
+  {
+    cumulativeWeight += weightedValue.second;
+    if ( cumulativeWeight >= rank )
+      return weightedValue.first;
+  }
+  return weightedValues.last().first;
+}
+
+void QgsQuantileSketch::clear()
+{
+  mCount = 0;
+  mRandomState = 1;
+  mLevels.clear();
+}
+
+int QgsQuantileSketch::levelCapacity( int level ) const
+{
+  // the capacities decrease geometrically from the top level down
+  const int depth = mLevels.size() - 1 - level;
+  const int capacity = static_cast< int >( std::ceil( mK * std::pow( 2.0 / 3.0, depth ) ) );
+  return std::max( capacity, MIN_LEVEL_CAPACITY );
+}
+
+void QgsQuantileSketch::compress()
+{
+  // adding a level shrinks the capacity of the lower ones, so start over after each compaction
+  bool compacted = true;
+  while ( compacted )
+  {
+    compacted = false;
+    for ( int level = 0; level < mLevels.size(); ++level )
+    {
+      if ( mLevels.at( level ).size() >= levelCapacity( level ) )
+      {
+        compact( level );
+        compacted = true;
+        break;
+      }
+    }
+  }
+}
+
+void QgsQuantileSketch::compact( int level )
+{
+  if ( level + 1 == mLevels.size() )
+    mLevels.resize( level + 2 );
+
+  QVector< double > &values = mLevels[level];
+  QVector< double > &nextValues = mLevels[level + 1];
+  std::sort( values.begin(), values.end() );
+
+  // an odd value out stays at this level, then one value of every pair is
+  // promoted, either all the first or all the second ones
+  const int kept = values.size() % 2;
+  mRandomState ^= mRandomState << 13;
+  mRandomState ^= mRandomState >> 17;
+  mRandomState ^= mRandomState << 5;
+  const int offset = static_cast< int >( mRandomState & 1 );
+  for ( int i = kept + offset; i < values.size(); i += 2 )
+    nextValues.append( values.at( i ) );
+  values.resize( kept );
+}
+
+//
+// QgsDistinctCountSketch
+//
+
+void QgsDistinctCountSketch::add( double value )
+{
+  insertHash( hashValue( value ) );
+}
+
+void QgsDistinctCountSketch::merge( const QgsDistinctCountSketch &other )
+{
+  if ( other.isExact() )
+  {
+    Q_FOREACH ( quint64 hash, other.mHashes )
+      insertHash( hash );
+    return;
+  }
+
+  if ( isExact() )
+    switchToRegisters();
+  for ( int i = 0; i < REGISTER_COUNT; ++i )
+    mRegisters[i] = std::max( mRegisters.at( i ), other.mRegisters.at( i ) );
+}
+
+qint64 QgsDistinctCountSketch::count() const
+{
+  if ( isExact() )
+    return mHashes.size();
+
+  double sum = 0;
+  int emptyRegisters = 0;
+  for ( quint8 rank : mRegisters )
+  {
+    sum += std::ldexp( 1.0, -rank );
+    if ( rank == 0 )
+      emptyRegisters++;
+  }
+
+  const double alpha = 0.7213 / ( 1 + 1.079 / REGISTER_COUNT );
+  double estimate = alpha * REGISTER_COUNT * REGISTER_COUNT / sum;
+  if ( estimate <= 2.5 * REGISTER_COUNT && emptyRegisters > 0 )
+    estimate = REGISTER_COUNT * std::log( static_cast< double >( REGISTER_COUNT ) / emptyRegisters );
+  return static_cast< qint64 >( std::llround( estimate ) );
+}
+
+void QgsDistinctCountSketch::clear()
+{
+  mHashes.clear();
+  mRegisters.clear();
+}
+
+void QgsDistinctCountSketch::insertHash( quint64 hash )
+{
+  if ( !isExact() )
+  {
+    addToRegisters( hash );
+    return;
+  }
+
+  mHashes.insert( hash );
+  if ( mHashes.size() > EXACT_DISTINCT_LIMIT )
+    switchToRegisters();
+}
+
+void QgsDistinctCountSketch::addToRegisters( quint64 hash )
+{
+  // the first bits select the register, which keeps the longest run of
+  // leading zeros (+ 1) seen in the remaining bits
+  const int index = static_cast< int >( hash >> ( 64 - REGISTER_BITS ) );
+  quint64 remaining = hash << REGISTER_BITS;
+  quint8 rank = 1;
+  while ( rank <= 64 - REGISTER_BITS && !( remaining & ( Q_UINT64_C( 1 ) << 63 ) ) )
+  {
+    rank++;
+    remaining <<= 1;
+  }
+  if ( rank > mRegisters.at( index ) )
+    mRegisters[index] = rank;
+}
+
+void QgsDistinctCountSketch::switchToRegisters()
+{
+  mRegisters.fill( 0, REGISTER_COUNT );
+  Q_FOREACH ( quint64 hash, mHashes )
+    addToRegisters( hash );
+  mHashes.clear();
+}
+
+//
+// QgsFrequentValuesSketch
+//
+
+QgsFrequentValuesSketch::QgsFrequentValuesSketch( int capacity )
+  : mCapacity( std::max( capacity, 2 ) )
+{
+}
+
+void QgsFrequentValuesSketch::add( double value, qint64 count )
+{
+  mTotal += count;
+  mCounts[value] += count;
+  if ( mCounts.size() > mCapacity )
+    reduce();
+}
+
+void QgsFrequentValuesSketch::merge( const QgsFrequentValuesSketch &other )
+{
+  // the occurrences other has already forgotten are part of its error
+  mTotal += other.mTotal;
+  mMaximumError += other.mMaximumError;
+  for ( auto it = other.mCounts.constBegin(); it != other.mCounts.constEnd(); ++it )
+  {
+    mCounts[it.key()] += it.value();
+    if ( mCounts.size() > mCapacity )
+      reduce();
+  }
+}
+
+double QgsFrequentValuesSketch::mostFrequent() const
+{
+  double result = std::numeric_limits<double>::quiet_NaN();
+  qint64 resultCount = 0;
+  for ( auto it = mCounts.constBegin(); it != mCounts.constEnd(); ++it )
+  {
+    if ( it.value() > resultCount || ( it.value() == resultCount && it.key() < result ) )
+    {
+      result = it.key();
+      resultCount = it.value();
+    }
+  }
+  return result;
+}
+
+double QgsFrequentValuesSketch::leastFrequent() const
+{
+  double result = std::numeric_limits<double>::quiet_NaN();
+  if ( mMaximumError > 0 )
+    return result;
+
+  qint64 resultCount = std::numeric_limits<qint64>::max();
+  for ( auto it = mCounts.constBegin(); it != mCounts.constEnd(); ++it )
+  {
+    if ( it.value() < resultCount || ( it.value() == resultCount && it.key() < result ) )
+    {
+      result = it.key();
+      resultCount = it.value();
+    }
+  }
+  return result;
+}
+
+void QgsFrequentValuesSketch::clear()
+{
+  mTotal = 0;
+  mMaximumError = 0;
+  mCounts.clear();
+}
+
+void QgsFrequentValuesSketch::reduce()
+{
+  QVector< qint64 > counts;
+  counts.reserve( mCounts.size() );
+  for ( qint64 count : mCounts )
+    counts << count;
+  std::nth_element( counts.begin(), counts.begin() + counts.size() / 2, counts.end() );
+  const qint64 median = counts.at( counts.size() / 2 );
+
+  for ( auto it = mCounts.begin(); it != mCounts.end(); )
+  {
+    it.value() -= median;
+    if ( it.value() <= 0 )
+      it = mCounts.erase( it );
+    else
+      ++it;
+  }
+  mMaximumError += median;
+}
@@ -0,0 +1,213 @@
+/***************************************************************************
+    qgsstatisticalsketches.h
+    ------------------------
+    begin                : October 2017
+    copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSSTATISTICALSKETCHES_H
+#define QGSSTATISTICALSKETCHES_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+
+#include <QHash>
+#include <QSet>
+#include <QVector>
+
+/** \ingroup core
+ * \brief Approximate quantiles of a stream of doubles, in bounded memory.
+ *
+ * This is a KLL sketch (Karnin, Lang and Liberty, "Optimal quantile approximation
+ * in streams"). With the default accuracy parameter of 200 the sketch keeps fewer
+ * than 600 values whatever the count of added values, and the rank of the value returned
+ * by quantile() differs from the requested rank by less than 1.65% of the count
+ * with a 99% confidence.
+ *
+ * Sketches built over separate parts of the values can be combined with merge(),
+ * the result has the same error bound as a sketch built over all the values.
+ *
+ * The random choices of the sketch use a fixed seed, adding the same values in
+ * the same order always gives the same results.
+ *
+ * \since QGIS 3.0
+ * \note not available in Python bindings
+ */
+class CORE_EXPORT QgsQuantileSketch
+{
+  public:
+
+    /** Constructor for QgsQuantileSketch.
+     * \param k accuracy parameter, the rank error is roughly proportional to 1 / k
+     * and the memory used to k
+     */
+    explicit QgsQuantileSketch( int k = 200 );
+
+    //! Returns the accuracy parameter of the sketch
+    int k() const { return mK; }
+
+    //! Adds a value to the sketch
+    void add( double value );
+
+    /** Adds all the values of \a other to the sketch. Both sketches should use the
+     * same accuracy parameter.
+     */
+    void merge( const QgsQuantileSketch &other );
+
+    //! Returns the count of values added to the sketch
+    qint64 count() const { return mCount; }
+
+    /** Returns the value of rank \a fraction * count(), e.g. 0.5 for the median.
+     * A NaN value is returned if the sketch is empty.
+     */
+    double quantile( double fraction ) const;
+
+    //! Removes all the values from the sketch
+    void clear();
+
+  private:
+
+    //! Returns the maximum count of retained values at a level of the sketch
+    int levelCapacity( int level ) const;
+
+    //! Compacts the levels which exceed their capacity
+    void compress();
+
+    //! Moves half of the values of a level to the next level, with a doubled weight
+    void compact( int level );
+
+    int mK = 200;
+    qint64 mCount = 0;
+    quint32 mRandomState = 1;
+    //! Retained values, the weight of the values of level i is 2^i
+    QVector< QVector< double > > mLevels;
+};
+
+/** \ingroup core
+ * \brief Approximate count of distinct doubles, in bounded memory.
+ *
+ * The values are counted exactly up to 256 distinct values, larger counts are
+ * estimated with a HyperLogLog sketch of 4096 registers (Flajolet et al., with
+ * the linear counting correction for small cardinalities). The estimate has a
+ * relative standard error of 1.6%, the sketch uses 4 KB of memory.
+ *
+ * Sketches built over separate parts of the values can be combined with merge(),
+ * values found in several parts are only counted once.
+ *
+ * \since QGIS 3.0
+ * \note not available in Python bindings
+ */
+class CORE_EXPORT QgsDistinctCountSketch
+{
+  public:
+
+    //! Adds a value to the sketch
+    void add( double value );
+
+    //! Adds all the values of \a other to the sketch
+    void merge( const QgsDistinctCountSketch &other );
+
+    //! Returns the (estimated) count of distinct values added to the sketch
+    qint64 count() const;
+
+    //! Returns true if the count of distinct values is exact
+    bool isExact() const { return mRegisters.isEmpty(); }
+
+    //! Removes all the values from the sketch
+    void clear();
+
+  private:
+
+    //! Adds a hashed value, counted exactly or in the registers
+    void insertHash( quint64 hash );
+
+    //! Adds a hashed value to the registers
+    void addToRegisters( quint64 hash );
+
+    //! Moves the exactly counted values to the registers
+    void switchToRegisters();
+
+    QSet< quint64 > mHashes;
+    QVector< quint8 > mRegisters;
+};
+
+/** \ingroup core
+ * \brief Approximate occurrence counts of the most frequent doubles, in bounded memory.
+ *
+ * The sketch tracks at most capacity() values. While the count of distinct values
+ * does not exceed the capacity all the counts are exact. Otherwise, when the table
+ * is full, the median count is subtracted from all the counters and the values
+ * whose counter drops to zero are forgotten (Misra and Gries). The count of every
+ * value is then underestimated by at most maximumError(), which never exceeds
+ * 2 * total() / capacity(): any value making more than that share of the
+ * values is guaranteed to be tracked.
+ *
+ * Sketches built over separate parts of the values can be combined with merge(),
+ * the error bound holds for the merged sketch.
+ *
+ * \since QGIS 3.0
+ * \note not available in Python bindings
+ */
+class CORE_EXPORT QgsFrequentValuesSketch
+{
+  public:
+
+    /** Constructor for QgsFrequentValuesSketch.
+     * \param capacity maximum count of tracked values
+     */
+    explicit QgsFrequentValuesSketch( int capacity = 1024 );
+
+    //! Returns the maximum count of tracked values
+    int capacity() const { return mCapacity; }
+
+    //! Adds \a count occurrences of a value to the sketch
+    void add( double value, qint64 count = 1 );
+
+    //! Adds all the values of \a other to the sketch
+    void merge( const QgsFrequentValuesSketch &other );
+
+    //! Returns the count of values added to the sketch
+    qint64 total() const { return mTotal; }
+
+    /** Returns the maximum amount by which the counts of the tracked values are
+     * underestimated. The counts are exact when this is zero.
+     */
+    qint64 maximumError() const { return mMaximumError; }
+
+    //! Returns the tracked values and their (lower bound) occurrence counts
+    QHash< double, qint64 > counts() const { return mCounts; }
+
+    /** Returns the value with the most occurrences, the smallest one in case of a tie.
+     * A NaN value is returned if the sketch is empty.
+     */
+    double mostFrequent() const;
+
+    /** Returns the value with the fewest occurrences, the smallest one in case of a tie.
+     * A NaN value is returned if the sketch is empty or if it is not exact, as the
+     * least frequent values are the ones which are not tracked.
+     */
+    double leastFrequent() const;
+
+    //! Removes all the values from the sketch
+    void clear();
+
+  private:
+
+    //! Subtracts the median count from all the counters and drops the ones reaching zero
+    void reduce();
+
+    int mCapacity = 1024;
+    qint64 mTotal = 0;
+    qint64 mMaximumError = 0;
+    QHash< double, qint64 > mCounts;
+};
+
+#endif // QGSSTATISTICALSKETCHES_H
@@ -45,8 +45,14 @@ void QgsStatisticalSummary::reset()
   mMajority = 0;
   mFirstQuartile = 0;
   mThirdQuartile = 0;
+  mVariety = 0;
   mValueCount.clear();
   mValues.clear();
+  mRunningMean = 0;
+  mSumSquaredDiffs = 0;
+  mQuantiles.clear();
+  mDistinctValues.clear();
+  mFrequentValues.clear();
 }
 
 /***************************************************************************
@@ -74,6 +80,25 @@ void QgsStatisticalSummary::addValue( double value )
   mMin = std::min( mMin, value );
   mMax = std::max( mMax, value );
 
+  if ( mApproximate )
+  {
+    if ( mStatistics & QgsStatisticalSummary::StDev || mStatistics & QgsStatisticalSummary::StDevSample )
+    {
+      // Welford's single pass algorithm
+      double diff = value - mRunningMean;
+      mRunningMean += diff / mCount;
+      mSumSquaredDiffs += diff * ( value - mRunningMean );
+    }
+    if ( mStatistics & QgsStatisticalSummary::Median || mStatistics & QgsStatisticalSummary::FirstQuartile ||
+         mStatistics & QgsStatisticalSummary::ThirdQuartile || mStatistics & QgsStatisticalSummary::InterQuartileRange )
+      mQuantiles.add( value );
+    if ( mStatistics & QgsStatisticalSummary::Variety )
+      mDistinctValues.add( value );
+    if ( mStatistics & QgsStatisticalSummary::Majority || mStatistics & QgsStatisticalSummary::Minority )
+      mFrequentValues.add( value );
+    return;
+  }
+
   if ( mStatistics & QgsStatisticalSummary::Majority || mStatistics & QgsStatisticalSummary::Minority || mStatistics & QgsStatisticalSummary::Variety )
     mValueCount.insert( value, mValueCount.value( value, 0 ) + 1 );
 
@@ -98,6 +123,42 @@ void QgsStatisticalSummary::addVariant( const QVariant &value )
   }
 }
 
+void QgsStatisticalSummary::merge( const QgsStatisticalSummary &other )
+{
+  Q_ASSERT( mApproximate == other.mApproximate );
+
+  if ( mApproximate && other.mCount > 0 )
+  {
+    // combine the running means and sums of squared differences (Chan et al.)
+    double count = static_cast< double >( mCount ) + other.mCount;
+    double diff = other.mRunningMean - mRunningMean;
+    mSumSquaredDiffs += other.mSumSquaredDiffs + diff * diff * mCount * other.mCount / count;
+    mRunningMean += diff * other.mCount / count;
+  }
+
+  mCount += other.mCount;
+  mMissing += other.mMissing;
+  mSum += other.mSum;
+  if ( other.mCount > 0 )
+  {
+    mMin = std::min( mMin, other.mMin );
+    mMax = std::max( mMax, other.mMax );
+  }
+
+  if ( mApproximate )
+  {
+    mQuantiles.merge( other.mQuantiles );
+    mDistinctValues.merge( other.mDistinctValues );
+    mFrequentValues.merge( other.mFrequentValues );
+  }
+  else
+  {
+    for ( QMap< double, int >::const_iterator it = other.mValueCount.constBegin(); it != other.mValueCount.constEnd(); ++it )
+      mValueCount[ it.key()] += it.value();
+    mValues.append( other.mValues );
+  }
+}
+
 void QgsStatisticalSummary::finalize()
 {
   if ( mCount == 0 )
@@ -112,11 +173,20 @@ void QgsStatisticalSummary::finalize()
     mMajority = std::numeric_limits<double>::quiet_NaN();
     mFirstQuartile = std::numeric_limits<double>::quiet_NaN();
     mThirdQuartile = std::numeric_limits<double>::quiet_NaN();
+    mVariety = 0;
     return;
   }
 
   mMean = mSum / mCount;
 
+  if ( mApproximate )
+  {
+    finalizeApproximate();
+    return;
+  }
+
+  mVariety = mValueCount.count();
+
   if ( mStatistics & QgsStatisticalSummary::StDev || mStatistics & QgsStatisticalSummary::StDevSample )
   {
     double sumSquared = 0;
@@ -224,6 +294,29 @@ void QgsStatisticalSummary::finalize()
 
 }
 
+void QgsStatisticalSummary::finalizeApproximate()
+{
+  if ( mStatistics & QgsStatisticalSummary::StDev || mStatistics & QgsStatisticalSummary::StDevSample )
+  {
+    mStdev = std::pow( mSumSquaredDiffs / mCount, 0.5 );
+    mSampleStdev = std::pow( mSumSquaredDiffs / ( mCount - 1 ), 0.5 );
+  }
+
+  if ( mStatistics & QgsStatisticalSummary::Median )
+    mMedian = mQuantiles.quantile( 0.5 );
+  if ( mStatistics & QgsStatisticalSummary::FirstQuartile || mStatistics & QgsStatisticalSummary::InterQuartileRange )
+    mFirstQuartile = mQuantiles.quantile( 0.25 );
+  if ( mStatistics & QgsStatisticalSummary::ThirdQuartile || mStatistics & QgsStatisticalSummary::InterQuartileRange )
+    mThirdQuartile = mQuantiles.quantile( 0.75 );
+
+  if ( mStatistics & QgsStatisticalSummary::Minority )
+    mMinority = mFrequentValues.leastFrequent();
+  if ( mStatistics & QgsStatisticalSummary::Majority )
+    mMajority = mFrequentValues.mostFrequent();
+
+  mVariety = static_cast< int >( mDistinctValues.count() );
+}
+
 /***************************************************************************
  * This class is considered CRITICAL and any change MUST be accompanied with
  * full unit tests in testqgsstatisticalsummary.cpp.
@@ -259,7 +352,7 @@ double QgsStatisticalSummary::statistic( QgsStatisticalSummary::Statistic stat )
     case Majority:
       return mMajority;
     case Variety:
-      return mValueCount.count();
+      return mVariety;
     case FirstQuartile:
       return mFirstQuartile;
     case ThirdQuartile:
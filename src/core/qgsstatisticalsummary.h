@@ -20,6 +20,7 @@
 #include <QVariant>
 #include <cmath>
 #include "qgis_core.h"
+#include "qgsstatisticalsketches.h"
 
 /***************************************************************************
  * This class is considered CRITICAL and any change MUST be accompanied with
@@ -36,6 +37,12 @@
  * are calculated by default. Statistics which require slower computations are only calculated by
  * specifying the statistic in the constructor or via setStatistics().
  *
+ * By default the statistics are exact, which requires keeping every value in memory
+ * for the median, quartiles, standard deviations, variety, minority and majority.
+ * In approximate mode (see setApproximate()) these statistics are calculated in
+ * bounded memory instead, whatever the count of values. Summaries of separate parts
+ * of the values can be combined with merge(), e.g. to calculate statistics in parallel.
+ *
  * \since QGIS 2.9
  */
 
@@ -86,6 +93,33 @@ class CORE_EXPORT QgsStatisticalSummary
      */
     void setStatistics( QgsStatisticalSummary::Statistics stats ) { mStatistics = stats; }
 
+    /** Returns true if the statistics are approximated in bounded memory.
+     * \see setApproximate()
+     * \since QGIS 3.0
+     */
+    bool approximate() const { return mApproximate; }
+
+    /** Sets whether the statistics should be approximated in bounded memory, using
+     * sketches of the values instead of keeping all of them. In approximate mode:
+     *
+     * - the count, missing count, sum, mean, minimum, maximum and range are exact,
+     *   and the standard deviations are calculated in a single pass
+     * - the median and quartiles are the values whose rank is the half or the quarters
+     *   of the count (rather than Tukey's hinges). The rank of the returned values is
+     *   within 1.65% of the count of the exact one, with a 99% confidence
+     * - the variety is exact up to 256 distinct values, larger counts are estimated
+     *   with a relative standard error of 1.6%
+     * - the majority and minority are exact up to 1024 distinct values. Above that, the
+     *   returned majority may occur fewer times than the exact one, by at most 0.2% of
+     *   the count, and the minority cannot be calculated and is NaN
+     *
+     * The memory used by the approximated statistics is less than 64 KB.
+     * \note call reset() after changing the mode
+     * \see approximate()
+     * \since QGIS 3.0
+     */
+    void setApproximate( bool approximate ) { mApproximate = approximate; }
+
     /** Resets the calculated values
      */
     void reset();
@@ -135,6 +169,18 @@ class CORE_EXPORT QgsStatisticalSummary
      */
     void finalize();
 
+    /** Adds all the values of \a other to the statistics calculation, as if they had
+     * been added to this summary. This allows calculating the statistics of separate
+     * parts of the values, e.g. in parallel, and combining them. \a other should calculate
+     * the same statistics and use the same mode (see setApproximate()).
+     * \note finalize() must be called after merging the last summary and before
+     * retrieving calculated statistics.
+     * \see addValue()
+     * \see finalize()
+     * \since QGIS 3.0
+     */
+    void merge( const QgsStatisticalSummary &other );
+
     /** Returns the value of a specified statistic
      * \param stat statistic to return
      * \returns calculated value of statistic. A NaN value may be returned for invalid
@@ -199,7 +245,7 @@ class CORE_EXPORT QgsStatisticalSummary
      * This is only calculated if Statistic::Variety has been specified in the constructor
      * or via setStatistics.
      */
-    int variety() const { return mValueCount.count(); }
+    int variety() const { return mVariety; }
 
     /** Returns minority of values. The minority is the value with least occurrences in the list
      * This is only calculated if Statistic::Minority has been specified in the constructor
@@ -248,7 +294,11 @@ class CORE_EXPORT QgsStatisticalSummary
 
   private:
 
+    //! Calculates the statistics of the approximate mode, once the mean is known
+    void finalizeApproximate();
+
     Statistics mStatistics;
+    bool mApproximate = false;
 
     int mCount;
     int mMissing;
@@ -263,8 +313,16 @@ class CORE_EXPORT QgsStatisticalSummary
     double mMajority;
     double mFirstQuartile;
     double mThirdQuartile;
+    int mVariety;
     QMap< double, int > mValueCount;
     QList< double > mValues;
+
+    //! Running mean and sum of squared differences to the mean (approximate mode)
+    double mRunningMean;
+    double mSumSquaredDiffs;
+    QgsQuantileSketch mQuantiles;
+    QgsDistinctCountSketch mDistinctValues;
+    QgsFrequentValuesSketch mFrequentValues;
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS( QgsStatisticalSummary::Statistics )
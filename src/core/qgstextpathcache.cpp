@@ -0,0 +1,132 @@
+/***************************************************************************
+    qgstextpathcache.cpp
+    ---------------------
+    begin                : October 2017
+    copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstextpathcache.h"
+
+#include <QFont>
+#include <QMutexLocker>
+
+///@cond PRIVATE
+namespace
+{
+  /**
+   * Returns a copy of \a path which does not share its data. QPainter lazily caches
+   * things in the data of the paths it draws, so paths drawn by several threads
+   * must not be shared.
+   */
+  QPainterPath detachedCopy( const QPainterPath &path )
+  {
+    QPainterPath copy;
+    copy.setFillRule( path.fillRule() );
+    copy.addPath( path );
+    return copy;
+  }
+}
+///@endcond
+
+QgsTextPathCache *QgsTextPathCache::instance()
+{
+  static QgsTextPathCache sCache;
+  return &sCache;
+}
+
+QgsTextPathCache::QgsTextPathCache( int maximumSize )
+  : mPaths( maximumSize )
+{
+}
+
+QPainterPath QgsTextPathCache::textPath( const QFont &font, const QString &text )
+{
+  const QString key = fontKey( font ) + QLatin1Char( '\n' ) + text;
+
+  QPainterPath cached;
+  bool found = false;
+  {
+    QMutexLocker locker( &mMutex );
+    if ( QPainterPath *path = mPaths.object( key ) )
+    {
+      mHits++;
+      // the cached paths are never drawn, only copied, so their data can be read outside of the lock
+      cached = *path;
+      found = true;
+    }
+    else
+    {
+      mMisses++;
+    }
+  }
+  if ( found )
+    return detachedCopy( cached );
+
+  // shape the text outside of the lock, other threads may do the same
+  // string at the same time but they do not wait for each other
+  QPainterPath *path = new QPainterPath();
+  path->setFillRule( Qt::WindingFill );
+  path->addText( 0, 0, font, text );
+  const QPainterPath result = detachedCopy( *path );
+  const int cost = static_cast< int >( sizeof( QPainterPath ) + path->elementCount() * sizeof( QPainterPath::Element ) + key.size() * sizeof( QChar ) );
+
+  QMutexLocker locker( &mMutex );
+  mPaths.insert( key, path, cost );
+  return result;
+}
+
+void QgsTextPathCache::setMaximumSize( int bytes )
+{
+  QMutexLocker locker( &mMutex );
+  mPaths.setMaxCost( bytes );
+}
+
+int QgsTextPathCache::maximumSize() const
+{
+  QMutexLocker locker( &mMutex );
+  return mPaths.maxCost();
+}
+
+void QgsTextPathCache::clear()
+{
+  QMutexLocker locker( &mMutex );
+  mPaths.clear();
+}
+
+QgsTextPathCache::Statistics QgsTextPathCache::statistics() const
+{
+  QMutexLocker locker( &mMutex );
+  Statistics statistics;
+  statistics.hits = mHits;
+  statistics.misses = mMisses;
+  statistics.bytes = mPaths.totalCost();
+  return statistics;
+}
+
+void QgsTextPathCache::resetStatistics()
+{
+  QMutexLocker locker( &mMutex );
+  mHits = 0;
+  mMisses = 0;
+}
+
+QString QgsTextPathCache::fontKey( const QFont &font )
+{
+  // QFont::key() leaves out the spacing and capitalization settings
+  return QStringLiteral( "%1|%2|%3|%4|%5|%6|%7|%8|%9" ).arg( font.key() )
+         .arg( font.letterSpacingType() )
+         .arg( font.letterSpacing() )
+         .arg( font.wordSpacing() )
+         .arg( font.capitalization() )
+         .arg( font.kerning() )
+         .arg( font.stretch() )
+         .arg( font.hintingPreference() )
+         .arg( font.styleStrategy() );
+}
@@ -0,0 +1,104 @@
+/***************************************************************************
+    qgstextpathcache.h
+    ---------------------
+    begin                : October 2017
+    copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSTEXTPATHCACHE_H
+#define QGSTEXTPATHCACHE_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+
+#include <QCache>
+#include <QMutex>
+#include <QPainterPath>
+#include <QString>
+
+class QFont;
+
+/** \ingroup core
+ * \brief A cache of the glyph outlines of rendered text.
+ *
+ * Shaping a string and converting its glyphs to a QPainterPath is the most
+ * expensive part of drawing text as outlines, and the same strings are drawn
+ * again and again: once for the buffer and once for the text of every label,
+ * and for every label which repeats on the map. The outlines are cached by font
+ * and string, up to a budget in bytes, the least recently used ones are
+ * evicted first.
+ *
+ * The cache is thread safe, there is a single instance shared by all the
+ * rendering threads, see instance().
+ *
+ * \since QGIS 3.0
+ * \note not available in Python bindings
+ */
+class CORE_EXPORT QgsTextPathCache
+{
+  public:
+
+    //! Hit and miss counters of the cache
+    struct Statistics
+    {
+      //! Number of outlines found in the cache
+      qint64 hits = 0;
+      //! Number of outlines which had to be created
+      qint64 misses = 0;
+      //! Current size of the cached outlines, in bytes
+      int bytes = 0;
+    };
+
+    //! Returns the cache shared by all threads
+    static QgsTextPathCache *instance();
+
+    /** Constructor for QgsTextPathCache.
+     * \param maximumSize budget of the cached outlines, in bytes
+     */
+    explicit QgsTextPathCache( int maximumSize = DEFAULT_MAXIMUM_SIZE );
+
+    /** Returns the outline of \a text drawn with \a font, with the origin of
+     * the path at the left of the baseline. The path uses the winding fill rule.
+     * The returned path does not share its data with the cache, it can be drawn by
+     * several threads at the same time.
+     */
+    QPainterPath textPath( const QFont &font, const QString &text );
+
+    //! Sets the budget of the cached outlines, in bytes
+    void setMaximumSize( int bytes );
+
+    //! Returns the budget of the cached outlines, in bytes
+    int maximumSize() const;
+
+    //! Removes all the outlines from the cache
+    void clear();
+
+    //! Returns the statistics collected since the last call to resetStatistics()
+    Statistics statistics() const;
+
+    //! Resets the hit and miss counters
+    void resetStatistics();
+
+  private:
+
+    //! Default budget of the cached outlines, in bytes
+    static const int DEFAULT_MAXIMUM_SIZE = 16 * 1024 * 1024;
+
+    //! Returns a key identifying all the font properties which change the outlines
+    static QString fontKey( const QFont &font );
+
+    mutable QMutex mMutex;
+    QCache< QString, QPainterPath > mPaths;
+    qint64 mHits = 0;
+    qint64 mMisses = 0;
+};
+
+#endif // QGSTEXTPATHCACHE_H
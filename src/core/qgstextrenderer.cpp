@@ -17,6 +17,7 @@
 #include "qgstextrenderer.h"
 #include "qgis.h"
 #include "qgstextrenderer_p.h"
+#include "qgstextpathcache.h"
 #include "qgsfontutils.h"
 #include "qgspathresolver.h"
 #include "qgsreadwritecontext.h"
@@ -1833,9 +1834,7 @@ void QgsTextRenderer::drawBuffer( QgsRenderContext &context, const QgsTextRender
 
   double penSize = context.convertToPainterUnits( buffer.size(), buffer.sizeUnit(), buffer.sizeMapUnitScale() );
 
-  QPainterPath path;
-  path.setFillRule( Qt::WindingFill );
-  path.addText( 0, 0, format.scaledFont( context ), component.text );
+  const QPainterPath path = QgsTextPathCache::instance()->textPath( format.scaledFont( context ), component.text );
   QColor bufferColor = buffer.color();
   bufferColor.setAlphaF( buffer.opacity() );
   QPen pen( bufferColor );
@@ -2573,9 +2572,7 @@ void QgsTextRenderer::drawTextInternal( TextPart drawType,
     else
     {
       // draw text, QPainterPath method
-      QPainterPath path;
-      path.setFillRule( Qt::WindingFill );
-      path.addText( 0, 0, format.scaledFont( context ), subComponent.text );
+      const QPainterPath path = QgsTextPathCache::instance()->textPath( format.scaledFont( context ), subComponent.text );
 
       // store text's drawing in QPicture for drop shadow call
       QPicture textPict;
@@ -278,7 +278,16 @@ void QgsVectorFileWriter::init( QString vectorFileName,
 
   // create the data source
   if ( action == CreateOrOverwriteFile )
+  {
+    // nothing can use a new SQLite based file before it is completely written,
+    // so there is no point in syncing it to disk after each transaction
+    const bool sqliteBased = driverName == QLatin1String( "GPKG" ) || driverName == QLatin1String( "SQLite" );
+    if ( sqliteBased )
+      CPLSetThreadLocalConfigOption( "OGR_SQLITE_SYNCHRONOUS", "OFF" );
     mDS = OGR_Dr_CreateDataSource( poDriver, vectorFileName.toUtf8().constData(), options );
+    if ( sqliteBased )
+      CPLSetThreadLocalConfigOption( "OGR_SQLITE_SYNCHRONOUS", nullptr );
+  }
   else
     mDS = OGROpen( vectorFileName.toUtf8().constData(), TRUE, nullptr );
 
@@ -442,6 +451,8 @@ void QgsVectorFileWriter::init( QString vectorFileName,
     return;
   }
 
+  mTransactionsSupported = OGR_L_TestCapability( mLayer, OLCTransactions );
+
   OGRFeatureDefnH defn = OGR_L_GetLayerDefn( mLayer );
 
   QgsDebugMsg( "created layer" );
@@ -2215,6 +2226,23 @@ void QgsVectorFileWriter::resetMap( const QgsAttributeList &attributes )
 
 bool QgsVectorFileWriter::writeFeature( OGRLayerH layer, OGRFeatureH feature )
 {
+  if ( mFeaturesWritten == 0 )
+    mWriteTimer.start();
+
+  // group the features in large transactions, committing each feature on its
+  // own is what makes writing to databases slow
+  if ( mFeaturesInTransaction >= FEATURES_PER_TRANSACTION && !commitTransaction() )
+  {
+    OGR_F_Destroy( feature );
+    return false;
+  }
+  if ( mTransactionsSupported && !mInTransaction )
+  {
+    mInTransaction = OGR_L_StartTransaction( layer ) == OGRERR_NONE;
+    if ( !mInTransaction )
+      QgsDebugMsg( "Error when trying to enable transactions on OGRLayer." );
+  }
+
   if ( OGR_L_CreateFeature( layer, feature ) != OGRERR_NONE )
   {
     mErrorMessage = QObject::tr( "Feature creation error (OGR error: %1)" ).arg( QString::fromUtf8( CPLGetLastErrorMsg() ) );
@@ -2223,11 +2251,47 @@ bool QgsVectorFileWriter::writeFeature( OGRLayerH layer, OGRFeatureH feature )
     OGR_F_Destroy( feature );
     return false;
   }
+
+  mFeaturesWritten++;
+  mWriteNanoseconds = mWriteTimer.nsecsElapsed();
+  if ( mInTransaction )
+    mFeaturesInTransaction++;
+  return true;
+}
+
+double QgsVectorFileWriter::writeRate() const
+{
+  if ( mFeaturesWritten == 0 )
+    return 0;
+  return mFeaturesWritten / ( std::max( mWriteNanoseconds, Q_INT64_C( 1 ) ) / 1e9 );
+}
+
+bool QgsVectorFileWriter::commitTransaction()
+{
+  if ( !mInTransaction )
+    return true;
+
+  mInTransaction = false;
+  mFeaturesInTransaction = 0;
+  if ( OGR_L_CommitTransaction( mLayer ) != OGRERR_NONE )
+  {
+    mErrorMessage = QObject::tr( "Error while committing transaction (OGR error: %1)" ).arg( QString::fromUtf8( CPLGetLastErrorMsg() ) );
+    mError = ErrFeatureWriteFailed;
+    QgsMessageLog::logMessage( mErrorMessage, QObject::tr( "OGR" ) );
+    return false;
+  }
   return true;
 }
 
 QgsVectorFileWriter::~QgsVectorFileWriter()
 {
+  commitTransaction();
+
+  if ( mFeaturesWritten > 0 )
+  {
+    QgsDebugMsgLevel( QString( "Wrote %1 features in %2 s (%3 features/s)" ).arg( mFeaturesWritten ).arg( mWriteNanoseconds / 1e9 ).arg( writeRate(), 0, 'f', 0 ), 2 );
+  }
+
   if ( mDS )
   {
     OGR_DS_Destroy( mDS );
@@ -2570,15 +2634,6 @@ QgsVectorFileWriter::writeAsVectorFormat( QgsVectorLayer *layer,
 
   writer->startRender( layer );
 
-  // enabling transaction on databases that support it
-  bool transactionsEnabled = true;
-
-  if ( OGRERR_NONE != OGR_L_StartTransaction( writer->mLayer ) )
-  {
-    QgsDebugMsg( "Error when trying to enable transactions on OGRLayer." );
-    transactionsEnabled = false;
-  }
-
   writer->resetMap( attributes );
   // Reset mFields to layer fields, and not just exported fields
   writer->mFields = layer->fields();
@@ -2666,12 +2721,9 @@ QgsVectorFileWriter::writeAsVectorFormat( QgsVectorLayer *layer,
     n++;
   }
 
-  if ( transactionsEnabled )
+  if ( !writer->commitTransaction() )
   {
-    if ( OGRERR_NONE != OGR_L_CommitTransaction( writer->mLayer ) )
-    {
-      QgsDebugMsg( "Error while committing transaction on OGRLayer." );
-    }
+    QgsDebugMsg( "Error while committing transaction on OGRLayer." );
   }
 
   writer->stopRender( layer );
@@ -28,6 +28,7 @@
 #include "qgsvectorlayer.h"
 #include <ogr_api.h>
 
+#include <QElapsedTimer>
 #include <QPair>
 
 
@@ -525,6 +526,21 @@ class CORE_EXPORT QgsVectorFileWriter : public QgsFeatureSink
      */
     bool addFeatureWithStyle( QgsFeature &feature, QgsFeatureRenderer *renderer, QgsUnitTypes::DistanceUnit outputUnit = QgsUnitTypes::DistanceMeters );
 
+    /**
+     * Returns the number of features written to the data source.
+     * \since QGIS 3.0
+     * \see writeRate()
+     */
+    qint64 featuresWritten() const { return mFeaturesWritten; }
+
+    /**
+     * Returns the number of features written per second, between the writing of the first
+     * and of the last feature, or 0 if no feature was written.
+     * \since QGIS 3.0
+     * \see featuresWritten()
+     */
+    double writeRate() const;
+
     //! \note not available in Python bindings
     QMap<int, int> attrIdxToOgrIdx() { return mAttrIdxToOgrIdx; } SIP_SKIP
 
@@ -657,6 +673,23 @@ class CORE_EXPORT QgsVectorFileWriter : public QgsFeatureSink
     OGRFeatureH createFeature( const QgsFeature &feature );
     bool writeFeature( OGRLayerH layer, OGRFeatureH feature );
 
+    //! Commits the transaction grouping the last written features, if any
+    bool commitTransaction();
+
+    //! Count of features written in each transaction
+    static const int FEATURES_PER_TRANSACTION = 100000;
+
+    //! True if the layer supports transactions
+    bool mTransactionsSupported = false;
+    //! True if features are being written in a transaction
+    bool mInTransaction = false;
+    int mFeaturesInTransaction = 0;
+    qint64 mFeaturesWritten = 0;
+    //! Started when the first feature is written
+    QElapsedTimer mWriteTimer;
+    //! Time between the writing of the first feature and the end of the last one
+    qint64 mWriteNanoseconds = 0;
+
     //! Writes features considering symbol level order
     QgsVectorFileWriter::WriterError exportFeaturesSymbolLevels( QgsVectorLayer *layer, QgsFeatureIterator &fit, const QgsCoordinateTransform &ct, QString *errorMessage = nullptr );
     double mmScaleFactor( double scale, QgsUnitTypes::RenderUnit symbolUnits, QgsUnitTypes::DistanceUnit mapUnits );
@@ -58,6 +58,7 @@
 #include "qgsogcutils.h"
 #include "qgspainting.h"
 #include "qgspointxy.h"
+#include "qgsprefetchingfeatureiterator.h"
 #include "qgsproject.h"
 #include "qgsproviderregistry.h"
 #include "qgsrectangle.h"
@@ -936,6 +937,9 @@ QgsFeatureIterator QgsVectorLayer::getFeatures( const QgsFeatureRequest &request
   if ( !mValid || !mDataProvider )
     return QgsFeatureIterator();
 
+  if ( request.flags() & QgsFeatureRequest::Prefetch )
+    return QgsFeatureIterator( new QgsPrefetchingFeatureIterator( new QgsVectorLayerFeatureSource( this ), true, request ) );
+
   return QgsFeatureIterator( new QgsVectorLayerFeatureIterator( new QgsVectorLayerFeatureSource( this ), true, request ) );
 }
 
@@ -3455,9 +3459,9 @@ QVariant QgsVectorLayer::aggregate( QgsAggregateCalculator::Aggregate aggregate,
   if ( attrIndex >= 0 )
   {
     // aggregate is based on a field - if it's a provider field, we could possibly hand over the calculation
-    // to the provider itself
+    // to the provider itself, unless there are pending edits the provider does not know about
     QgsFields::FieldOrigin origin = mFields.fieldOrigin( attrIndex );
-    if ( origin == QgsFields::OriginProvider )
+    if ( origin == QgsFields::OriginProvider && !( mEditBuffer && mEditBuffer->isModified() ) )
     {
       bool providerOk = false;
       QVariant val = mDataProvider->aggregate( aggregate, attrIndex, parameters, context, providerOk );
@@ -26,6 +26,41 @@
 #include "qgsproject.h"
 #include "qgsmessagelog.h"
 #include "qgsexception.h"
+#include "qgsexpression.h"
+#include "qgsprefetchingfeatureiterator.h"
+
+#include <algorithm>
+
+///@cond PRIVATE
+namespace
+{
+  //! Maximum number of provider features read ahead to resolve their joins together
+  const int JOIN_BATCH_SIZE = 1000;
+
+  //! Maximum number of recently joined values kept for each join
+  const int JOIN_RECENT_ATTRIBUTES_SIZE = 10000;
+
+  //! Returns the literal of a join value in a filter expression
+  QString joinValueLiteral( const QVariant &joinValue )
+  {
+    QString v = joinValue.toString();
+    switch ( joinValue.type() )
+    {
+      case QVariant::Int:
+      case QVariant::LongLong:
+      case QVariant::Double:
+        break;
+
+      default:
+      case QVariant::String:
+        v.replace( '\'', QLatin1String( "''" ) );
+        v.prepend( '\'' ).append( '\'' );
+        break;
+    }
+    return v;
+  }
+}
+///@endcond
 
 QgsVectorLayerFeatureSource::QgsVectorLayerFeatureSource( const QgsVectorLayer *layer )
 {
@@ -94,6 +129,9 @@ QgsVectorLayerFeatureSource::~QgsVectorLayerFeatureSource()
 QgsFeatureIterator QgsVectorLayerFeatureSource::getFeatures( const QgsFeatureRequest &request )
 {
   // return feature iterator that does not own this source
+  if ( request.flags() & QgsFeatureRequest::Prefetch )
+    return QgsFeatureIterator( new QgsPrefetchingFeatureIterator( this, false, request ) );
+
   return QgsFeatureIterator( new QgsVectorLayerFeatureIterator( this, false, request ) );
 }
 
@@ -327,18 +365,8 @@ bool QgsVectorLayerFeatureIterator::fetchFeature( QgsFeature &f )
     mProviderIterator.setInterruptionChecker( mInterruptionChecker );
   }
 
-  while ( mProviderIterator.nextFeature( f ) )
+  while ( fetchNextProviderFeature( f ) )
   {
-    if ( mFetchConsidered.contains( f.id() ) )
-      continue;
-
-    // TODO[MD]: just one resize of attributes
-    f.setFields( mSource->mFields );
-
-    // update attributes
-    if ( mSource->mHasEditBuffer )
-      updateChangedAttributes( f );
-
     if ( mHasVirtualAttributes )
       addVirtualAttributes( f );
 
@@ -369,6 +397,67 @@ bool QgsVectorLayerFeatureIterator::fetchFeature( QgsFeature &f )
   return false;
 }
 
+bool QgsVectorLayerFeatureIterator::fetchNextProviderFeature( QgsFeature &f )
+{
+  if ( mBatchJoinInfoList.isEmpty() )
+  {
+    while ( mProviderIterator.nextFeature( f ) )
+    {
+      if ( mFetchConsidered.contains( f.id() ) )
+        continue;
+
+      // TODO[MD]: just one resize of attributes
+      f.setFields( mSource->mFields );
+
+      // update attributes
+      if ( mSource->mHasEditBuffer )
+        updateChangedAttributes( f );
+
+      return true;
+    }
+    return false;
+  }
+
+  if ( mJoinBatchPosition >= mJoinBatch.size() )
+  {
+    // read ahead the next batch of features, and query their joined attributes all at once
+    // instead of one request to the joined layer per feature
+    int batchSize = JOIN_BATCH_SIZE;
+    if ( mRequest.limit() >= 0 && mRequest.limit() < batchSize )
+      batchSize = std::max( static_cast< int >( mRequest.limit() ), 1 );
+
+    mJoinBatch.clear();
+    mJoinBatchPosition = 0;
+    QgsFeature batchFeature;
+    while ( mJoinBatch.size() < batchSize && mProviderIterator.nextFeature( batchFeature ) )
+    {
+      if ( mFetchConsidered.contains( batchFeature.id() ) )
+        continue;
+
+      batchFeature.setFields( mSource->mFields );
+      if ( mSource->mHasEditBuffer )
+        updateChangedAttributes( batchFeature );
+
+      mJoinBatch << batchFeature;
+    }
+
+    if ( mJoinBatch.isEmpty() )
+      return false;
+
+    Q_FOREACH ( const FetchJoinInfo &info, mBatchJoinInfoList )
+    {
+      QList< QVariant > joinValues;
+      joinValues.reserve( mJoinBatch.size() );
+      Q_FOREACH ( const QgsFeature &batchFeature, mJoinBatch )
+        joinValues << batchFeature.attribute( info.targetField );
+      info.prefetchJoinedAttributes( joinValues );
+    }
+  }
+
+  f = mJoinBatch.at( mJoinBatchPosition++ );
+  return true;
+}
+
 
 
 bool QgsVectorLayerFeatureIterator::rewind()
@@ -383,6 +472,8 @@ bool QgsVectorLayerFeatureIterator::rewind()
   else
   {
     mProviderIterator.rewind();
+    mJoinBatch.clear();
+    mJoinBatchPosition = 0;
     rewindEditBuffer();
   }
 
@@ -395,6 +486,8 @@ bool QgsVectorLayerFeatureIterator::close()
     return false;
 
   mProviderIterator.close();
+  mJoinBatch.clear();
+  mJoinBatchPosition = 0;
 
   iteratorClosed();
 
@@ -587,6 +680,7 @@ void QgsVectorLayerFeatureIterator::prepareJoin( int fieldIdx )
     info.indexOffset = mSource->mJoinBuffer->joinedFieldsOffset( joinInfo, mSource->mFields );
     info.targetField = mSource->mFields.indexFromName( joinInfo->targetFieldName() );
     info.joinField = joinLayer->fields().indexFromName( joinInfo->joinFieldName() );
+    info.recentAttributes.reset( new QCache< QString, QgsAttributes >( JOIN_RECENT_ATTRIBUTES_SIZE ) );
 
     // for joined fields, we always need to request the targetField from the provider too
     if ( !mPreparedFields.contains( info.targetField ) && !mFieldsToPrepare.contains( info.targetField ) )
@@ -652,6 +746,7 @@ void QgsVectorLayerFeatureIterator::prepareFields()
   mFieldsToPrepare.clear();
   mFetchJoinInfo.clear();
   mOrderedJoinInfoList.clear();
+  mBatchJoinInfoList.clear();
 
   mExpressionContext.reset( new QgsExpressionContext() );
   mExpressionContext->appendScope( QgsExpressionContextUtils::globalScope() );
@@ -675,6 +770,27 @@ void QgsVectorLayerFeatureIterator::prepareFields()
   {
     createOrderedJoinList();
   }
+
+  // joins without memory cache are resolved by batch, when their target field value
+  // is known before adding the virtual attributes
+  Q_FOREACH ( const FetchJoinInfo &info, mOrderedJoinInfoList )
+  {
+    if ( !info.joinInfo->cachedAttributes.isEmpty() )
+      continue;
+
+    switch ( mSource->mFields.fieldOrigin( info.targetField ) )
+    {
+      case QgsFields::OriginProvider:
+      case QgsFields::OriginEdit:
+        mBatchJoinInfoList << info;
+        break;
+
+      case QgsFields::OriginJoin:
+      case QgsFields::OriginExpression:
+      case QgsFields::OriginUnknown:
+        break;
+    }
+  }
 }
 
 void QgsVectorLayerFeatureIterator::createOrderedJoinList()
@@ -912,6 +1028,18 @@ void QgsVectorLayerFeatureIterator::FetchJoinInfo::addJoinedAttributesCached( Qg
 
 void QgsVectorLayerFeatureIterator::FetchJoinInfo::addJoinedAttributesDirect( QgsFeature &f, const QVariant &joinValue ) const
 {
+  const bool useRecentAttributes = recentAttributes && !joinValue.isNull();
+  if ( useRecentAttributes )
+  {
+    if ( const QgsAttributes *recent = recentAttributes->object( joinValue.toString() ) )
+    {
+      int index = indexOffset;
+      for ( int i = 0; i < recent->count(); ++i )
+        f.setAttribute( index++, recent->at( i ) );
+      return;
+    }
+  }
+
   // no memory cache, query the joined values by setting substring
   QString subsetString;
 
@@ -925,30 +1053,9 @@ void QgsVectorLayerFeatureIterator::FetchJoinInfo::addJoinedAttributesDirect( Qg
   }
   else
   {
-    QString v = joinValue.toString();
-    switch ( joinValue.type() )
-    {
-      case QVariant::Int:
-      case QVariant::LongLong:
-      case QVariant::Double:
-        break;
-
-      default:
-      case QVariant::String:
-        v.replace( '\'', QLatin1String( "''" ) );
-        v.prepend( '\'' ).append( '\'' );
-        break;
-    }
-    subsetString += '=' + v;
+    subsetString += '=' + joinValueLiteral( joinValue );
   }
 
-  // maybe user requested just a subset of layer's attributes
-  // so we do not have to cache everything
-  bool hasSubset = joinInfo->joinFieldNamesSubset();
-  QVector<int> subsetIndices;
-  if ( hasSubset )
-    subsetIndices = QgsVectorLayerJoinBuffer::joinSubsetIndices( joinLayer, *joinInfo->joinFieldNamesSubset() );
-
   // select (no geometry)
   QgsFeatureRequest request;
   request.setFlags( QgsFeatureRequest::NoGeometry );
@@ -959,31 +1066,101 @@ void QgsVectorLayerFeatureIterator::FetchJoinInfo::addJoinedAttributesDirect( Qg
 
   // get first feature
   QgsFeature fet;
+  QgsAttributes joined;
   if ( fi.nextFeature( fet ) )
   {
+    joined = joinedAttributes( fet.attributes() );
     int index = indexOffset;
-    QgsAttributes attr = fet.attributes();
-    if ( hasSubset )
-    {
-      for ( int i = 0; i < subsetIndices.count(); ++i )
-        f.setAttribute( index++, attr.at( subsetIndices.at( i ) ) );
-    }
-    else
-    {
-      // use all fields except for the one used for join (has same value as exiting field in target layer)
-      for ( int i = 0; i < attr.count(); ++i )
-      {
-        if ( i == joinField )
-          continue;
-
-        f.setAttribute( index++, attr.at( i ) );
-      }
-    }
+    for ( int i = 0; i < joined.count(); ++i )
+      f.setAttribute( index++, joined.at( i ) );
   }
   else
   {
     // no suitable join feature found, keeping empty (null) attributes
   }
+
+  if ( useRecentAttributes )
+    recentAttributes->insert( joinValue.toString(), new QgsAttributes( joined ) );
+}
+
+void QgsVectorLayerFeatureIterator::FetchJoinInfo::prefetchJoinedAttributes( const QList< QVariant > &joinValues ) const
+{
+  if ( !recentAttributes )
+    return;
+
+  // values which are not known yet
+  QSet< QString > pendingValues;
+  QStringList literals;
+  Q_FOREACH ( const QVariant &joinValue, joinValues )
+  {
+    if ( !joinValue.isValid() || joinValue.isNull() )
+      continue;
+
+    const QString key = joinValue.toString();
+    if ( pendingValues.contains( key ) || recentAttributes->contains( key ) )
+      continue;
+
+    pendingValues.insert( key );
+    literals << joinValueLiteral( joinValue );
+  }
+
+  if ( literals.isEmpty() )
+    return;
+
+  QgsAttributeList fetchAttributes = attributes;
+  if ( !fetchAttributes.contains( joinField ) )
+    fetchAttributes << joinField;
+
+  // a single IN request, which providers compile to SQL when they support it
+  QgsFeatureRequest request;
+  request.setFlags( QgsFeatureRequest::NoGeometry );
+  request.setSubsetOfAttributes( fetchAttributes );
+  request.setFilterExpression( QStringLiteral( "%1 IN (%2)" ).arg( QgsExpression::quotedColumnRef( joinInfo->joinFieldName() ),
+                               literals.join( QStringLiteral( "," ) ) ) );
+  QgsFeatureIterator fi = joinLayer->getFeatures( request );
+
+  QgsFeature fet;
+  while ( !pendingValues.isEmpty() && fi.nextFeature( fet ) )
+  {
+    // only keep the first feature matching a value, like addJoinedAttributesDirect()
+    const QString key = fet.attribute( joinField ).toString();
+    if ( !pendingValues.remove( key ) )
+      continue;
+
+    recentAttributes->insert( key, new QgsAttributes( joinedAttributes( fet.attributes() ) ) );
+  }
+
+  // values left in pendingValues are not stored as unmatched: the provider may compare them
+  // differently than their string representation (e.g. numbers with a string field), so they
+  // are resolved one by one by addJoinedAttributesDirect()
+}
+
+QgsAttributes QgsVectorLayerFeatureIterator::FetchJoinInfo::joinedAttributes( const QgsAttributes &joinFeatureAttributes ) const
+{
+  QgsAttributes joined;
+
+  // maybe user requested just a subset of layer's attributes
+  // so we do not have to cache everything
+  if ( joinInfo->joinFieldNamesSubset() )
+  {
+    QVector<int> subsetIndices = QgsVectorLayerJoinBuffer::joinSubsetIndices( joinLayer, *joinInfo->joinFieldNamesSubset() );
+    joined.reserve( subsetIndices.count() );
+    for ( int i = 0; i < subsetIndices.count(); ++i )
+      joined << joinFeatureAttributes.at( subsetIndices.at( i ) );
+  }
+  else
+  {
+    // use all fields except for the one used for join (has same value as exiting field in target layer)
+    joined.reserve( joinFeatureAttributes.count() );
+    for ( int i = 0; i < joinFeatureAttributes.count(); ++i )
+    {
+      if ( i == joinField )
+        continue;
+
+      joined << joinFeatureAttributes.at( i );
+    }
+  }
+  return joined;
 }
 
 
@@ -22,6 +22,7 @@
 #include "qgscoordinatereferencesystem.h"
 #include "qgsfeaturesource.h"
 
+#include <QCache>
 #include <QSet>
 #include <memory>
 
@@ -130,8 +131,27 @@ class CORE_EXPORT QgsVectorLayerFeatureIterator : public QgsAbstractFeatureItera
       int targetField;                  //!< Index of field (of this layer) that drives the join
       int joinField;                    //!< Index of field (of the joined layer) must have equal value
 
+      /** Recently joined attributes (starting at indexOffset) by join value, shared by the copies of the join info.
+       * An empty entry means that no feature of the joined layer matches the value.
+       * \note not available in Python bindings
+       */
+      std::shared_ptr< QCache< QString, QgsAttributes > > recentAttributes SIP_SKIP;
+
       void addJoinedAttributesCached( QgsFeature &f, const QVariant &joinValue ) const;
       void addJoinedAttributesDirect( QgsFeature &f, const QVariant &joinValue ) const;
+
+      /** Resolves the joined attributes of several join values with a single request
+       * to the joined layer and stores them in recentAttributes, so that the following
+       * calls to addJoinedAttributesDirect() with these values do not query the layer.
+       * \note not available in Python bindings
+       * \since QGIS 3.0
+       */
+      void prefetchJoinedAttributes( const QList< QVariant > &joinValues ) const SIP_SKIP;
+
+    private:
+
+      //! Returns the joined attributes (starting at indexOffset) of a feature of the joined layer
+      QgsAttributes joinedAttributes( const QgsAttributes &joinFeatureAttributes ) const;
     };
 
 
@@ -243,6 +263,21 @@ class CORE_EXPORT QgsVectorLayerFeatureIterator : public QgsAbstractFeatureItera
     //! Join list sorted by dependency
     QList< FetchJoinInfo > mOrderedJoinInfoList;
 
+    //! Joins not cached in memory whose target field comes from the provider, resolved by batch
+    QList< FetchJoinInfo > mBatchJoinInfoList;
+
+    //! Provider features read ahead to resolve their joins by batch
+    QVector< QgsFeature > mJoinBatch;
+
+    //! Position of the next feature in mJoinBatch
+    int mJoinBatchPosition = 0;
+
+    /**
+     * Fetches the next feature of the provider which is not overridden by the edit buffer,
+     * with its changed attributes. Features are read ahead by batch when there are joins to resolve.
+     */
+    bool fetchNextProviderFeature( QgsFeature &f );
+
     /**
      * Will always return true. We assume that ordering has been done on provider level already.
      *
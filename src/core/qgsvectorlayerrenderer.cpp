@@ -25,6 +25,7 @@
 #include "qgssinglesymbolrenderer.h"
 #include "qgssymbollayer.h"
 #include "qgssymbol.h"
+#include "qgssymbolgeometrypipeline.h"
 #include "qgsvectorlayer.h"
 #include "qgsvectorlayerdiagramprovider.h"
 #include "qgsvectorlayerfeatureiterator.h"
@@ -244,11 +245,30 @@ bool QgsVectorLayerRenderer::render()
   // in drawRenderer()
   fit.setInterruptionChecker( &mInterruptionChecker );
 
+#ifdef QGISDEBUG
+  // the geometry pipeline of the thread is only used by this layer while it is drawn
+  QgsSymbolGeometryPipeline &geometryPipeline = QgsSymbolGeometryPipeline::instance();
+  geometryPipeline.setCollectStatistics( QgsLogger::debugLevel() >= 2 );
+  geometryPipeline.resetStatistics();
+#endif
+
   if ( ( mRenderer->capabilities() & QgsFeatureRenderer::SymbolLevels ) && mRenderer->usingSymbolLevels() )
     drawRendererLevels( fit );
   else
     drawRenderer( fit );
 
+#ifdef QGISDEBUG
+  if ( geometryPipeline.collectStatistics() )
+  {
+    const QgsSymbolGeometryPipeline::Statistics stats = geometryPipeline.statistics();
+    QgsDebugMsgLevel( QString( "Geometry pipeline of layer %1: clip %2 ms, transform %3 ms, map to pixel %4 ms, %5 -> %6 vertices, %7 dropped rings" )
+                      .arg( layerId() )
+                      .arg( stats.clipTime / 1e6 ).arg( stats.transformTime / 1e6 ).arg( stats.mapToPixelTime / 1e6 )
+                      .arg( stats.inputVertices ).arg( stats.outputVertices ).arg( stats.droppedRings ), 2 );
+    geometryPipeline.setCollectStatistics( false );
+  }
+#endif
+
   if ( usingEffect )
   {
     mRenderer->paintEffect()->end( mContext );
@@ -23,6 +23,10 @@
 #include "qgscoordinatetransform.h"
 #include "qgsexception.h"
 
+#include <QThread>
+#include <QtConcurrentMap>
+#include <cmath>
+
 
 QgsRasterProjector::QgsRasterProjector()
   : QgsRasterInterface( nullptr )
@@ -85,11 +89,6 @@ ProjectorData::ProjectorData( const QgsRectangle &extent, int width, int height,
   , mSrcCols( 0 )
   , mSrcXRes( 0.0 )
   , mSrcYRes( 0.0 )
-  , mDestRowsPerMatrixRow( 0.0 )
-  , mDestColsPerMatrixCol( 0.0 )
-  , pHelperTop( nullptr )
-  , pHelperBottom( nullptr )
-  , mHelperTopRow( 0 )
   , mCPCols( 0 )
   , mCPRows( 0 )
   , mSqrTolerance( 0.0 )
@@ -122,82 +121,64 @@ ProjectorData::ProjectorData( const QgsRectangle &extent, int width, int height,
 
   // Calculate tolerance
   // TODO: Think it over better
-  // Note: we are checking on matrix each even point, that means that the real error
+  // Note: we are checking in the middle of the intervals, that means that the real error
   // in that moment is approximately half size
   double myDestRes = mDestXRes < mDestYRes ? mDestXRes : mDestYRes;
   mSqrTolerance = myDestRes * myDestRes;
 
-  if ( precision == QgsRasterProjector::Approximate )
-  {
-    mApproximate = true;
-  }
-  else
-  {
-    mApproximate = false;
-  }
+  mApproximate = precision == QgsRasterProjector::Approximate;
 
-  // Always try to calculate mCPMatrix, it is used in calcSrcExtent() for both Approximate and Exact
-  // Initialize the matrix by corners and middle points
-  mCPCols = mCPRows = 3;
-  for ( int i = 0; i < mCPRows; i++ )
-  {
-    QList<QgsPointXY> myRow;
-    myRow.append( QgsPointXY() );
-    myRow.append( QgsPointXY() );
-    myRow.append( QgsPointXY() );
-    mCPMatrix.insert( i, myRow );
-    // And the legal points
-    QList<bool> myLegalRow;
-    myLegalRow.append( bool( false ) );
-    myLegalRow.append( bool( false ) );
-    myLegalRow.append( bool( false ) );
-    mCPLegalMatrix.insert( i, myLegalRow );
-  }
-  for ( int i = 0; i < mCPRows; i++ )
+  // Always try to calculate the control points, they are used in calcSrcExtent() for both Approximate and Exact
+  // Initialize the grid by corners and middle points
+  mCPRows = mCPCols = 3;
+  mCPRowPos << 0 << mDestRows / 2.0 << mDestRows;
+  mCPColPos << 0 << mDestCols / 2.0 << mDestCols;
+  mCPX.resize( mCPRows * mCPCols );
+  mCPY.resize( mCPRows * mCPCols );
+  mCPLegal.fill( false, mCPRows * mCPCols );
+  QVector<int> indexes;
+  for ( int i = 0; i < mCPRows * mCPCols; i++ )
+    indexes << i;
+  calcCPs( indexes );
+
+  if ( !mInverseCt.isValid() )
   {
-    calcRow( i, inverseCt );
+    mApproximate = false;
   }
-
-  while ( true )
+  else
   {
-    bool myColsOK = checkCols( inverseCt );
-    if ( !myColsOK )
-    {
-      insertRows( inverseCt );
-    }
-    bool myRowsOK = checkRows( inverseCt );
-    if ( !myRowsOK )
-    {
-      insertCols( inverseCt );
-    }
-    if ( myColsOK && myRowsOK )
+    // Refine the grid only where it is needed. The interpolation error is
+    // checked in the middle of each interval, if it is too large a row or
+    // column of control points is inserted there.
+    bool converged = true;
+    while ( true )
     {
-      QgsDebugMsgLevel( "CP matrix within tolerance", 4 );
-      break;
+      int splitCount = splitIntervals( true, converged );
+      splitCount += splitIntervals( false, converged );
+      if ( splitCount == 0 )
+      {
+        QgsDebugMsgLevel( "CP matrix within tolerance", 4 );
+        break;
+      }
+      // What is the maximum reasonable size of transformatio matrix?
+      // TODO: consider better when to break - ratio
+      if ( mCPRows * mCPCols > 0.25 * mDestRows * mDestCols )
+      {
+        QgsDebugMsgLevel( "Too large CP matrix", 4 );
+        converged = false;
+        break;
+      }
     }
-    // What is the maximum reasonable size of transformatio matrix?
-    // TODO: consider better when to break - ratio
-    if ( mCPRows * mCPCols > 0.25 * mDestRows * mDestCols )
-      //if ( mCPRows * mCPCols > mDestRows * mDestCols )
-    {
-      QgsDebugMsgLevel( "Too large CP matrix", 4 );
+    if ( !converged )
       mApproximate = false;
-      break;
-    }
   }
   QgsDebugMsgLevel( QString( "CPMatrix size: mCPRows = %1 mCPCols = %2" ).arg( mCPRows ).arg( mCPCols ), 4 );
-  mDestRowsPerMatrixRow = static_cast< float >( mDestRows ) / ( mCPRows - 1 );
-  mDestColsPerMatrixCol = static_cast< float >( mDestCols ) / ( mCPCols - 1 );
 
   QgsDebugMsgLevel( "CPMatrix:", 5 );
   QgsDebugMsgLevel( cpToString(), 5 );
 
-  // init helper points
-  pHelperTop = new QgsPointXY[mDestCols];
-  pHelperBottom = new QgsPointXY[mDestCols];
-  calcHelper( 0, pHelperTop );
-  calcHelper( 1, pHelperBottom );
-  mHelperTopRow = 0;
+  if ( mApproximate )
+    calcHelpers();
 
   // Calculate source dimensions
   calcSrcExtent();
@@ -206,34 +187,251 @@ ProjectorData::ProjectorData( const QgsRectangle &extent, int width, int height,
   mSrcXRes = mSrcExtent.width() / mSrcCols;
 }
 
-ProjectorData::~ProjectorData()
+void ProjectorData::transformToSource( QVector<double> &x, QVector<double> &y, QVector<bool> &legal ) const
 {
-  delete[] pHelperTop;
-  delete[] pHelperBottom;
+  const int count = x.size();
+  legal.fill( true, count );
+
+  const QVector<double> destX = x;
+  const QVector<double> destY = y;
+  QVector<double> z( count, 0.0 );
+  try
+  {
+    mInverseCt.transformCoords( count, x.data(), y.data(), z.data() );
+  }
+  catch ( QgsCsException &e )
+  {
+    Q_UNUSED( e );
+    // Retry point by point to only lose the points which cannot be transformed
+    for ( int i = 0; i < count; i++ )
+    {
+      x[i] = destX.at( i );
+      y[i] = destY.at( i );
+      double pointZ = 0;
+      try
+      {
+        mInverseCt.transformCoords( 1, &x[i], &y[i], &pointZ );
+      }
+      catch ( QgsCsException &e )
+      {
+        Q_UNUSED( e );
+        legal[i] = false;
+      }
+    }
+  }
+
+  for ( int i = 0; i < count; i++ )
+  {
+    // proj returns HUGE_VAL for the points it cannot transform
+    if ( !std::isfinite( x.at( i ) ) || !std::isfinite( y.at( i ) ) )
+      legal[i] = false;
+  }
 }
 
+void ProjectorData::calcCPs( const QVector<int> &indexes )
+{
+  if ( !mInverseCt.isValid() )
+  {
+    Q_FOREACH ( int index, indexes )
+      mCPLegal[index] = false;
+    return;
+  }
+
+  QVector<double> x, y;
+  QVector<bool> legal;
+  x.reserve( indexes.size() );
+  y.reserve( indexes.size() );
+  Q_FOREACH ( int index, indexes )
+  {
+    x << destX( mCPColPos.at( index % mCPCols ) );
+    y << destY( mCPRowPos.at( index / mCPCols ) );
+  }
+
+  transformToSource( x, y, legal );
+
+  for ( int i = 0; i < indexes.size(); i++ )
+  {
+    const int index = indexes.at( i );
+    mCPX[index] = x.at( i );
+    mCPY[index] = y.at( i );
+    mCPLegal[index] = legal.at( i );
+  }
+}
+
+bool ProjectorData::checkInterval( bool rows, int interval ) const
+{
+  // control points along the interval: one per column when checking between two rows
+  const int count = rows ? mCPCols : mCPRows;
+  QVector<double> srcX( count ), srcY( count ), z( count, 0.0 );
+  for ( int i = 0; i < count; i++ )
+  {
+    const int index1 = rows ? cpIndex( interval, i ) : cpIndex( i, interval );
+    const int index2 = rows ? cpIndex( interval + 1, i ) : cpIndex( i, interval + 1 );
+    if ( !mCPLegal.at( index1 ) || !mCPLegal.at( index2 ) )
+    {
+      // There was an error earlier in transform
+      return false;
+    }
+    srcX[i] = ( mCPX.at( index1 ) + mCPX.at( index2 ) ) / 2;
+    srcY[i] = ( mCPY.at( index1 ) + mCPY.at( index2 ) ) / 2;
+  }
+
+  try
+  {
+    mInverseCt.transformCoords( count, srcX.data(), srcY.data(), z.data(), QgsCoordinateTransform::ReverseTransform );
+  }
+  catch ( QgsCsException &e )
+  {
+    Q_UNUSED( e );
+    // Caught an error in transform
+    return false;
+  }
+
+  const QVector<double> &positions = rows ? mCPRowPos : mCPColPos;
+  const double middle = ( positions.at( interval ) + positions.at( interval + 1 ) ) / 2;
+  for ( int i = 0; i < count; i++ )
+  {
+    const double x = rows ? destX( mCPColPos.at( i ) ) : destX( middle );
+    const double y = rows ? destY( middle ) : destY( mCPRowPos.at( i ) );
+    const double sqrDist = ( srcX.at( i ) - x ) * ( srcX.at( i ) - x ) + ( srcY.at( i ) - y ) * ( srcY.at( i ) - y );
+    // also false for NaN
+    if ( !( sqrDist <= mSqrTolerance ) )
+      return false;
+  }
+  return true;
+}
+
+int ProjectorData::splitIntervals( bool rows, bool &converged )
+{
+  const QVector<double> positions = rows ? mCPRowPos : mCPColPos;
+
+  QVector<double> newPositions;
+  QVector<int> oldLine; // index of the line in the old grid, -1 for new lines
+  int splitCount = 0;
+  for ( int i = 0; i < positions.size(); i++ )
+  {
+    newPositions << positions.at( i );
+    oldLine << i;
+    if ( i == positions.size() - 1 || checkInterval( rows, i ) )
+      continue;
+
+    // intervals of one destination cell cannot be split any further
+    if ( positions.at( i + 1 ) - positions.at( i ) <= 1 )
+    {
+      converged = false;
+      continue;
+    }
+
+    newPositions << ( positions.at( i ) + positions.at( i + 1 ) ) / 2;
+    oldLine << -1;
+    splitCount++;
+  }
+
+  if ( splitCount == 0 )
+    return 0;
+
+  QgsDebugMsgLevel( QString( "insert %1 new %2" ).arg( splitCount ).arg( rows ? "rows" : "cols" ), 3 );
+
+  const int oldCols = mCPCols;
+  const QVector<double> oldX = mCPX;
+  const QVector<double> oldY = mCPY;
+  const QVector<bool> oldLegal = mCPLegal;
+
+  if ( rows )
+  {
+    mCPRowPos = newPositions;
+    mCPRows = newPositions.size();
+  }
+  else
+  {
+    mCPColPos = newPositions;
+    mCPCols = newPositions.size();
+  }
+  mCPX.resize( mCPRows * mCPCols );
+  mCPY.resize( mCPRows * mCPCols );
+  mCPLegal.resize( mCPRows * mCPCols );
+
+  QVector<int> newIndexes;
+  for ( int r = 0; r < mCPRows; r++ )
+  {
+    for ( int c = 0; c < mCPCols; c++ )
+    {
+      const int line = oldLine.at( rows ? r : c );
+      if ( line < 0 )
+      {
+        newIndexes << cpIndex( r, c );
+        continue;
+      }
+      const int oldIndex = rows ? line * oldCols + c : r * oldCols + line;
+      mCPX[cpIndex( r, c )] = oldX.at( oldIndex );
+      mCPY[cpIndex( r, c )] = oldY.at( oldIndex );
+      mCPLegal[cpIndex( r, c )] = oldLegal.at( oldIndex );
+    }
+  }
+  calcCPs( newIndexes );
+
+  return splitCount;
+}
+
+void ProjectorData::calcHelpers()
+{
+  // Control point column interval and position in the interval of each destination column
+  QVector<int> colInterval( mDestCols );
+  QVector<double> colFrac( mDestCols );
+  int interval = 0;
+  for ( int col = 0; col < mDestCols; col++ )
+  {
+    const double center = col + 0.5;
+    while ( interval < mCPCols - 2 && center >= mCPColPos.at( interval + 1 ) )
+      interval++;
+    colInterval[col] = interval;
+    colFrac[col] = ( center - mCPColPos.at( interval ) ) / ( mCPColPos.at( interval + 1 ) - mCPColPos.at( interval ) );
+  }
+
+  mRowInterval.resize( mDestRows );
+  mRowFrac.resize( mDestRows );
+  interval = 0;
+  for ( int row = 0; row < mDestRows; row++ )
+  {
+    const double center = row + 0.5;
+    while ( interval < mCPRows - 2 && center >= mCPRowPos.at( interval + 1 ) )
+      interval++;
+    mRowInterval[row] = interval;
+    mRowFrac[row] = ( center - mCPRowPos.at( interval ) ) / ( mCPRowPos.at( interval + 1 ) - mCPRowPos.at( interval ) );
+  }
+
+  mHelperX.resize( mCPRows * mDestCols );
+  mHelperY.resize( mCPRows * mDestCols );
+  for ( int r = 0; r < mCPRows; r++ )
+  {
+    double *helperX = mHelperX.data() + r * mDestCols;
+    double *helperY = mHelperY.data() + r * mDestCols;
+    for ( int col = 0; col < mDestCols; col++ )
+    {
+      const int index = cpIndex( r, colInterval.at( col ) );
+      const double frac = colFrac.at( col );
+      helperX[col] = mCPX.at( index ) + ( mCPX.at( index + 1 ) - mCPX.at( index ) ) * frac;
+      helperY[col] = mCPY.at( index ) + ( mCPY.at( index + 1 ) - mCPY.at( index ) ) * frac;
+    }
+  }
+}
 
 void ProjectorData::calcSrcExtent()
 {
-  /* Run around the mCPMatrix and find source extent */
+  /* Run around the control points and find source extent */
   // Attention, source limits are not necessarily on destination edges, e.g.
   // for destination EPSG:32661 Polar Stereographic and source EPSG:4326,
   // the maximum y may be in the middle of destination extent
   // TODO: How to find extent exactly and quickly?
-  // For now, we run through all matrix
-  // mCPMatrix is used for both Approximate and Exact because QgsCoordinateTransform::transformBoundingBox()
+  // For now, we run through all control points
+  // The control points are used for both Approximate and Exact because QgsCoordinateTransform::transformBoundingBox()
   // is not precise enough, see #13665
-  QgsPointXY myPoint = mCPMatrix[0][0];
-  mSrcExtent = QgsRectangle( myPoint.x(), myPoint.y(), myPoint.x(), myPoint.y() );
-  for ( int i = 0; i < mCPRows; i++ )
+  mSrcExtent = QgsRectangle( mCPX.at( 0 ), mCPY.at( 0 ), mCPX.at( 0 ), mCPY.at( 0 ) );
+  for ( int i = 0; i < mCPRows * mCPCols; i++ )
   {
-    for ( int j = 0; j < mCPCols ; j++ )
+    if ( mCPLegal.at( i ) )
     {
-      myPoint = mCPMatrix[i][j];
-      if ( mCPLegalMatrix[i][j] )
-      {
-        mSrcExtent.combineExtentWith( myPoint.x(), myPoint.y() );
-      }
+      mSrcExtent.combineExtentWith( mCPX.at( i ), mCPY.at( i ) );
     }
   }
   // Expand a bit to avoid possible approx coords falling out because of representation error?
@@ -277,7 +475,7 @@ void ProjectorData::calcSrcExtent()
   QgsDebugMsgLevel( "mSrcExtent = " + mSrcExtent.toString(), 4 );
 }
 
-QString ProjectorData::cpToString()
+QString ProjectorData::cpToString() const
 {
   QString myString;
   for ( int i = 0; i < mCPRows; i++ )
@@ -288,10 +486,9 @@ QString ProjectorData::cpToString()
     {
       if ( j > 0 )
         myString += QLatin1String( "  " );
-      QgsPointXY myPoint = mCPMatrix[i][j];
-      if ( mCPLegalMatrix[i][j] )
+      if ( mCPLegal.at( cpIndex( i, j ) ) )
       {
-        myString += myPoint.toString();
+        myString += QgsPointXY( mCPX.at( cpIndex( i, j ) ), mCPY.at( cpIndex( i, j ) ) ).toString();
       }
       else
       {
@@ -314,24 +511,29 @@ void ProjectorData::calcSrcRowsCols()
 
   if ( mApproximate )
   {
-    // For now, we take cell sizes projected to source but not to source axes
-    double myDestColsPerMatrixCell = static_cast< double >( mDestCols ) / mCPCols;
-    double myDestRowsPerMatrixCell = static_cast< double >( mDestRows ) / mCPRows;
-    QgsDebugMsgLevel( QString( "myDestColsPerMatrixCell = %1 myDestRowsPerMatrixCell = %2" ).arg( myDestColsPerMatrixCell ).arg( myDestRowsPerMatrixCell ), 4 );
+    // For now, we take cell sizes projected to source but not to source axes.
+    // The intervals of the grid are not regular, the size of each one is scaled
+    // so that a regular grid gives the same resolution as the former
+    // mDestCols / mCPCols destination cells per matrix cell.
+    const double colScale = static_cast< double >( mCPCols - 1 ) / mCPCols;
+    const double rowScale = static_cast< double >( mCPRows - 1 ) / mCPRows;
     for ( int i = 0; i < mCPRows - 1; i++ )
     {
+      const double myDestRowsPerMatrixCell = ( mCPRowPos.at( i + 1 ) - mCPRowPos.at( i ) ) * rowScale;
       for ( int j = 0; j < mCPCols - 1; j++ )
       {
-        QgsPointXY myPointA = mCPMatrix[i][j];
-        QgsPointXY myPointB = mCPMatrix[i][j + 1];
-        QgsPointXY myPointC = mCPMatrix[i + 1][j];
-        if ( mCPLegalMatrix[i][j] && mCPLegalMatrix[i][j + 1] && mCPLegalMatrix[i + 1][j] )
+        const int indexA = cpIndex( i, j );
+        const int indexB = cpIndex( i, j + 1 );
+        const int indexC = cpIndex( i + 1, j );
+        if ( mCPLegal.at( indexA ) && mCPLegal.at( indexB ) && mCPLegal.at( indexC ) )
         {
-          double mySize = std::sqrt( myPointA.sqrDist( myPointB ) ) / myDestColsPerMatrixCell;
+          const double myDestColsPerMatrixCell = ( mCPColPos.at( j + 1 ) - mCPColPos.at( j ) ) * colScale;
+          QgsPointXY myPointA( mCPX.at( indexA ), mCPY.at( indexA ) );
+          double mySize = std::sqrt( myPointA.sqrDist( mCPX.at( indexB ), mCPY.at( indexB ) ) ) / myDestColsPerMatrixCell;
           if ( mySize < myMinSize )
             myMinSize = mySize;
 
-          mySize = std::sqrt( myPointA.sqrDist( myPointC ) ) / myDestRowsPerMatrixCell;
+          mySize = std::sqrt( myPointA.sqrDist( mCPX.at( indexC ), mCPY.at( indexC ) ) ) / myDestRowsPerMatrixCell;
           if ( mySize < myMinSize )
             myMinSize = mySize;
         }
@@ -375,354 +577,88 @@ void ProjectorData::calcSrcRowsCols()
   QgsDebugMsgLevel( QString( "mSrcRows = %1 mSrcCols = %2" ).arg( mSrcRows ).arg( mSrcCols ), 4 );
 }
 
-
-inline void ProjectorData::destPointOnCPMatrix( int row, int col, double *theX, double *theY )
+bool ProjectorData::srcRowCols( int destRow, int *srcRows, int *srcCols ) const
 {
-  *theX = mDestExtent.xMinimum() + col * mDestExtent.width() / ( mCPCols - 1 );
-  *theY = mDestExtent.yMaximum() - row * mDestExtent.height() / ( mCPRows - 1 );
-}
+  // Source coordinates of the centers of the destination cells, stored in
+  // contiguous arrays so that the loops below can be vectorized by the compiler
+  QVector<double> srcX( mDestCols );
+  QVector<double> srcY( mDestCols );
+  double *x = srcX.data();
+  double *y = srcY.data();
 
-inline int ProjectorData::matrixRow( int destRow )
-{
-  return static_cast< int >( std::floor( ( destRow + 0.5 ) / mDestRowsPerMatrixRow ) );
-}
-inline int ProjectorData::matrixCol( int destCol )
-{
-  return static_cast< int >( std::floor( ( destCol + 0.5 ) / mDestColsPerMatrixCol ) );
-}
-
-void ProjectorData::calcHelper( int matrixRow, QgsPointXY *points )
-{
-  // TODO?: should we also precalc dest cell center coordinates for x and y?
-  for ( int myDestCol = 0; myDestCol < mDestCols; myDestCol++ )
-  {
-    double myDestX = mDestExtent.xMinimum() + ( myDestCol + 0.5 ) * mDestXRes;
-
-    int myMatrixCol = matrixCol( myDestCol );
-
-    double myDestXMin, myDestYMin, myDestXMax, myDestYMax;
-
-    destPointOnCPMatrix( matrixRow, myMatrixCol, &myDestXMin, &myDestYMin );
-    destPointOnCPMatrix( matrixRow, myMatrixCol + 1, &myDestXMax, &myDestYMax );
-
-    double xfrac = ( myDestX - myDestXMin ) / ( myDestXMax - myDestXMin );
-
-    QgsPointXY &mySrcPoint0 = mCPMatrix[matrixRow][myMatrixCol];
-    QgsPointXY &mySrcPoint1 = mCPMatrix[matrixRow][myMatrixCol + 1];
-    double s = mySrcPoint0.x() + ( mySrcPoint1.x() - mySrcPoint0.x() ) * xfrac;
-    double t = mySrcPoint0.y() + ( mySrcPoint1.y() - mySrcPoint0.y() ) * xfrac;
-
-    points[myDestCol].setX( s );
-    points[myDestCol].setY( t );
-  }
-}
-
-void ProjectorData::nextHelper()
-{
-  // We just switch pHelperTop and pHelperBottom, memory is not lost
-  QgsPointXY *tmp = nullptr;
-  tmp = pHelperTop;
-  pHelperTop = pHelperBottom;
-  pHelperBottom = tmp;
-  calcHelper( mHelperTopRow + 2, pHelperBottom );
-  mHelperTopRow++;
-}
-
-bool ProjectorData::srcRowCol( int destRow, int destCol, int *srcRow, int *srcCol )
-{
   if ( mApproximate )
   {
-    return approximateSrcRowCol( destRow, destCol, srcRow, srcCol );
-  }
-  else
-  {
-    return preciseSrcRowCol( destRow, destCol, srcRow, srcCol );
-  }
-}
-
-bool ProjectorData::preciseSrcRowCol( int destRow, int destCol, int *srcRow, int *srcCol )
-{
-#ifdef QGISDEBUG
-  QgsDebugMsgLevel( QString( "theDestRow = %1" ).arg( destRow ), 5 );
-  QgsDebugMsgLevel( QString( "theDestRow = %1 mDestExtent.yMaximum() = %2 mDestYRes = %3" ).arg( destRow ).arg( mDestExtent.yMaximum() ).arg( mDestYRes ), 5 );
-#endif
-
-  // Get coordinate of center of destination cell
-  double x = mDestExtent.xMinimum() + ( destCol + 0.5 ) * mDestXRes;
-  double y = mDestExtent.yMaximum() - ( destRow + 0.5 ) * mDestYRes;
-  double z = 0;
-
-#ifdef QGISDEBUG
-  QgsDebugMsgLevel( QString( "x = %1 y = %2" ).arg( x ).arg( y ), 5 );
-#endif
-
-  if ( mInverseCt.isValid() )
-  {
-    mInverseCt.transformInPlace( x, y, z );
-  }
-
-#ifdef QGISDEBUG
-  QgsDebugMsgLevel( QString( "x = %1 y = %2" ).arg( x ).arg( y ), 5 );
-#endif
-
-  if ( !mExtent.contains( QgsPointXY( x, y ) ) )
-  {
-    return false;
-  }
-  // Get source row col
-  *srcRow = static_cast< int >( std::floor( ( mSrcExtent.yMaximum() - y ) / mSrcYRes ) );
-  *srcCol = static_cast< int >( std::floor( ( x - mSrcExtent.xMinimum() ) / mSrcXRes ) );
-#ifdef QGISDEBUG
-  QgsDebugMsgLevel( QString( "mSrcExtent.yMinimum() = %1 mSrcExtent.yMaximum() = %2 mSrcYRes = %3" ).arg( mSrcExtent.yMinimum() ).arg( mSrcExtent.yMaximum() ).arg( mSrcYRes ), 5 );
-  QgsDebugMsgLevel( QString( "theSrcRow = %1 srcCol = %2" ).arg( *srcRow ).arg( *srcCol ), 5 );
-#endif
-
-  // With epsg 32661 (Polar Stereographic) it was happening that *srcCol == mSrcCols
-  // For now silently correct limits to avoid crashes
-  // TODO: review
-  // should not happen
-  if ( *srcRow >= mSrcRows ) return false;
-  if ( *srcRow < 0 ) return false;
-  if ( *srcCol >= mSrcCols ) return false;
-  if ( *srcCol < 0 ) return false;
-
-  return true;
-}
-
-bool ProjectorData::approximateSrcRowCol( int destRow, int destCol, int *srcRow, int *srcCol )
-{
-  int myMatrixRow = matrixRow( destRow );
-  int myMatrixCol = matrixCol( destCol );
-
-  if ( myMatrixRow > mHelperTopRow )
-  {
-    // TODO: make it more robust (for random, not sequential reading)
-    nextHelper();
-  }
-
-  double myDestY = mDestExtent.yMaximum() - ( destRow + 0.5 ) * mDestYRes;
-
-  // See the schema in javax.media.jai.WarpGrid doc (but up side down)
-  // TODO: use some kind of cache of values which can be reused
-  double myDestXMin, myDestYMin, myDestXMax, myDestYMax;
-
-  destPointOnCPMatrix( myMatrixRow + 1, myMatrixCol, &myDestXMin, &myDestYMin );
-  destPointOnCPMatrix( myMatrixRow, myMatrixCol + 1, &myDestXMax, &myDestYMax );
-
-  double yfrac = ( myDestY - myDestYMin ) / ( myDestYMax - myDestYMin );
-
-  QgsPointXY &myTop = pHelperTop[destCol];
-  QgsPointXY &myBot = pHelperBottom[destCol];
-
-  // Warning: this is very SLOW compared to the following code!:
-  //double mySrcX = myBot.x() + (myTop.x() - myBot.x()) * yfrac;
-  //double mySrcY = myBot.y() + (myTop.y() - myBot.y()) * yfrac;
-
-  double tx = myTop.x();
-  double ty = myTop.y();
-  double bx = myBot.x();
-  double by = myBot.y();
-  double mySrcX = bx + ( tx - bx ) * yfrac;
-  double mySrcY = by + ( ty - by ) * yfrac;
-
-  if ( !mExtent.contains( QgsPointXY( mySrcX, mySrcY ) ) )
-  {
-    return false;
-  }
-
-  // TODO: check again cell selection (coor is in the middle)
-
-  *srcRow = static_cast< int >( std::floor( ( mSrcExtent.yMaximum() - mySrcY ) / mSrcYRes ) );
-  *srcCol = static_cast< int >( std::floor( ( mySrcX - mSrcExtent.xMinimum() ) / mSrcXRes ) );
-
-  // For now silently correct limits to avoid crashes
-  // TODO: review
-  // should not happen
-  if ( *srcRow >= mSrcRows ) return false;
-  if ( *srcRow < 0 ) return false;
-  if ( *srcCol >= mSrcCols ) return false;
-  if ( *srcCol < 0 ) return false;
-
-  return true;
-}
-
-void ProjectorData::insertRows( const QgsCoordinateTransform &ct )
-{
-  for ( int r = 0; r < mCPRows - 1; r++ )
-  {
-    QList<QgsPointXY> myRow;
-    QList<bool> myLegalRow;
-    myRow.reserve( mCPCols );
-    myLegalRow.reserve( mCPCols );
-    for ( int c = 0; c < mCPCols; ++c )
+    // Interpolate between the helpers of the two control point rows around the destination row
+    const int interval = mRowInterval.at( destRow );
+    const double frac = mRowFrac.at( destRow );
+    const double *topX = mHelperX.constData() + interval * mDestCols;
+    const double *topY = mHelperY.constData() + interval * mDestCols;
+    const double *botX = topX + mDestCols;
+    const double *botY = topY + mDestCols;
+    for ( int col = 0; col < mDestCols; ++col )
     {
-      myRow.append( QgsPointXY() );
-      myLegalRow.append( false );
+      x[col] = topX[col] + ( botX[col] - topX[col] ) * frac;
+      y[col] = topY[col] + ( botY[col] - topY[col] ) * frac;
     }
-    QgsDebugMsgLevel( QString( "insert new row at %1" ).arg( 1 + r * 2 ), 3 );
-    mCPMatrix.insert( 1 + r * 2, myRow );
-    mCPLegalMatrix.insert( 1 + r * 2, myLegalRow );
-  }
-  mCPRows += mCPRows - 1;
-  for ( int r = 1; r < mCPRows - 1; r += 2 )
-  {
-    calcRow( r, ct );
   }
-}
-
-void ProjectorData::insertCols( const QgsCoordinateTransform &ct )
-{
-  for ( int r = 0; r < mCPRows; r++ )
-  {
-    for ( int c = 0; c < mCPCols - 1; c++ )
-    {
-      mCPMatrix[r].insert( 1 + c * 2, QgsPointXY() );
-      mCPLegalMatrix[r].insert( 1 + c * 2, false );
-    }
-  }
-  mCPCols += mCPCols - 1;
-  for ( int c = 1; c < mCPCols - 1; c += 2 )
-  {
-    calcCol( c, ct );
-  }
-
-}
-
-void ProjectorData::calcCP( int row, int col, const QgsCoordinateTransform &ct )
-{
-  double myDestX, myDestY;
-  destPointOnCPMatrix( row, col, &myDestX, &myDestY );
-  QgsPointXY myDestPoint( myDestX, myDestY );
-  try
+  else
   {
-    if ( ct.isValid() )
+    const double rowY = destY( destRow + 0.5 );
+    for ( int col = 0; col < mDestCols; ++col )
     {
-      mCPMatrix[row][col] = ct.transform( myDestPoint );
-      mCPLegalMatrix[row][col] = true;
+      x[col] = destX( col + 0.5 );
+      y[col] = rowY;
     }
-    else
-    {
-      mCPLegalMatrix[row][col] = false;
-    }
-  }
-  catch ( QgsCsException &e )
-  {
-    Q_UNUSED( e );
-    // Caught an error in transform
-    mCPLegalMatrix[row][col] = false;
-  }
-}
-
-bool ProjectorData::calcRow( int row, const QgsCoordinateTransform &ct )
-{
-  QgsDebugMsgLevel( QString( "theRow = %1" ).arg( row ), 3 );
-  for ( int i = 0; i < mCPCols; i++ )
-  {
-    calcCP( row, i, ct );
-  }
-
-  return true;
-}
-
-bool ProjectorData::calcCol( int col, const QgsCoordinateTransform &ct )
-{
-  QgsDebugMsgLevel( QString( "theCol = %1" ).arg( col ), 3 );
-  for ( int i = 0; i < mCPRows; i++ )
-  {
-    calcCP( i, col, ct );
-  }
-
-  return true;
-}
-
-bool ProjectorData::checkCols( const QgsCoordinateTransform &ct )
-{
-  if ( !ct.isValid() )
-  {
-    return false;
-  }
-
-  for ( int c = 0; c < mCPCols; c++ )
-  {
-    for ( int r = 1; r < mCPRows - 1; r += 2 )
+    if ( mInverseCt.isValid() )
     {
-      double myDestX, myDestY;
-      destPointOnCPMatrix( r, c, &myDestX, &myDestY );
-      QgsPointXY myDestPoint( myDestX, myDestY );
-
-      QgsPointXY mySrcPoint1 = mCPMatrix[r - 1][c];
-      QgsPointXY mySrcPoint2 = mCPMatrix[r][c];
-      QgsPointXY mySrcPoint3 = mCPMatrix[r + 1][c];
-
-      QgsPointXY mySrcApprox( ( mySrcPoint1.x() + mySrcPoint3.x() ) / 2, ( mySrcPoint1.y() + mySrcPoint3.y() ) / 2 );
-      if ( !mCPLegalMatrix[r - 1][c] || !mCPLegalMatrix[r][c] || !mCPLegalMatrix[r + 1][c] )
+      // Transform the whole row in a single call
+      QVector<bool> legal;
+      transformToSource( srcX, srcY, legal );
+      x = srcX.data();
+      y = srcY.data();
+      for ( int col = 0; col < mDestCols; ++col )
       {
-        // There was an error earlier in transform, just abort
-        return false;
-      }
-      try
-      {
-        QgsPointXY myDestApprox = ct.transform( mySrcApprox, QgsCoordinateTransform::ReverseTransform );
-        double mySqrDist = myDestApprox.sqrDist( myDestPoint );
-        if ( mySqrDist > mSqrTolerance )
-        {
-          return false;
-        }
-      }
-      catch ( QgsCsException &e )
-      {
-        Q_UNUSED( e );
-        // Caught an error in transform
-        return false;
+        if ( !legal.at( col ) )
+          x[col] = std::numeric_limits<double>::quiet_NaN();
       }
     }
   }
-  return true;
-}
 
-bool ProjectorData::checkRows( const QgsCoordinateTransform &ct )
-{
-  if ( !ct.isValid() )
+  const double xMin = mExtent.xMinimum();
+  const double xMax = mExtent.xMaximum();
+  const double yMin = mExtent.yMinimum();
+  const double yMax = mExtent.yMaximum();
+  const double srcXMin = mSrcExtent.xMinimum();
+  const double srcYMax = mSrcExtent.yMaximum();
+  bool inside = false;
+  for ( int col = 0; col < mDestCols; ++col )
   {
-    return false;
-  }
-
-  for ( int r = 0; r < mCPRows; r++ )
-  {
-    for ( int c = 1; c < mCPCols - 1; c += 2 )
+    // comparisons are false for NaN
+    if ( !( x[col] >= xMin && x[col] <= xMax && y[col] >= yMin && y[col] <= yMax ) )
     {
-      double myDestX, myDestY;
-      destPointOnCPMatrix( r, c, &myDestX, &myDestY );
+      srcRows[col] = -1;
+      srcCols[col] = -1;
+      continue;
+    }
 
-      QgsPointXY myDestPoint( myDestX, myDestY );
-      QgsPointXY mySrcPoint1 = mCPMatrix[r][c - 1];
-      QgsPointXY mySrcPoint2 = mCPMatrix[r][c];
-      QgsPointXY mySrcPoint3 = mCPMatrix[r][c + 1];
+    const int row = static_cast< int >( std::floor( ( srcYMax - y[col] ) / mSrcYRes ) );
+    const int column = static_cast< int >( std::floor( ( x[col] - srcXMin ) / mSrcXRes ) );
 
-      QgsPointXY mySrcApprox( ( mySrcPoint1.x() + mySrcPoint3.x() ) / 2, ( mySrcPoint1.y() + mySrcPoint3.y() ) / 2 );
-      if ( !mCPLegalMatrix[r][c - 1] || !mCPLegalMatrix[r][c] || !mCPLegalMatrix[r][c + 1] )
-      {
-        // There was an error earlier in transform, just abort
-        return false;
-      }
-      try
-      {
-        QgsPointXY myDestApprox = ct.transform( mySrcApprox, QgsCoordinateTransform::ReverseTransform );
-        double mySqrDist = myDestApprox.sqrDist( myDestPoint );
-        if ( mySqrDist > mSqrTolerance )
-        {
-          return false;
-        }
-      }
-      catch ( QgsCsException &e )
-      {
-        Q_UNUSED( e );
-        // Caught an error in transform
-        return false;
-      }
+    // With epsg 32661 (Polar Stereographic) it was happening that srcCol == mSrcCols
+    // For now silently correct limits to avoid crashes
+    // TODO: review
+    // should not happen
+    if ( row < 0 || row >= mSrcRows || column < 0 || column >= mSrcCols )
+    {
+      srcRows[col] = -1;
+      srcCols[col] = -1;
+      continue;
     }
+    srcRows[col] = row;
+    srcCols[col] = column;
+    inside = true;
   }
-  return true;
+  return inside;
 }
 
 /// @endcond
@@ -810,42 +746,77 @@ QgsRasterBlock *QgsRasterProjector::block( int bandNo, QgsRectangle  const &exte
 
   outputBlock->setIsNoData();
 
-  int srcRow, srcCol;
-  for ( int i = 0; i < height; ++i )
+  // Split the destination rows in blocks processed in parallel, rows are
+  // independent and the no data bitmap of the output block is row aligned.
+  // Small blocks are processed in the current thread.
+  int rowsPerBlock = height;
+  if ( static_cast< qgssize >( width ) * height >= 100000 )
   {
-    if ( feedback && feedback->isCanceled() )
-      break;
-    for ( int j = 0; j < width; ++j )
+    const int blockCount = std::max( 1, QThread::idealThreadCount() ) * 4;
+    rowsPerBlock = std::max( 1, ( height + blockCount - 1 ) / blockCount );
+  }
+  QVector<int> rowBlocks;
+  for ( int row = 0; row < height; row += rowsPerBlock )
+    rowBlocks << row;
+
+  // bits() may detach the image of image blocks, do it before sharing the blocks between threads
+  inputBlock->bits( 0 );
+  outputBlock->bits( 0 );
+
+  QgsRasterBlock *input = inputBlock.get();
+  QgsRasterBlock *output = outputBlock.get();
+  const ProjectorData *projectorData = &pd;
+  auto projectRows = [ = ]( int startRow )
+  {
+    QVector<int> srcRows( width );
+    QVector<int> srcCols( width );
+    const int endRow = std::min( startRow + rowsPerBlock, height );
+    for ( int i = startRow; i < endRow; ++i )
     {
-      bool inside = pd.srcRowCol( i, j, &srcRow, &srcCol );
-      if ( !inside ) continue; // we have everything set to no data
+      if ( feedback && feedback->isCanceled() )
+        break;
 
-      qgssize srcIndex = static_cast< qgssize >( srcRow ) * pd.srcCols() + srcCol;
+      bool inside = projectorData->srcRowCols( i, srcRows.data(), srcCols.data() );
+      if ( !inside ) continue; // we have everything set to no data
 
-      // isNoData() may be slow so we check doNoData first
-      if ( doNoData && inputBlock->isNoData( srcRow, srcCol ) )
+      for ( int j = 0; j < width; ++j )
       {
-        outputBlock->setIsNoData( i, j );
-        continue;
-      }
+        const int srcRow = srcRows.at( j );
+        const int srcCol = srcCols.at( j );
+        if ( srcRow < 0 ) continue;
 
-      qgssize destIndex = static_cast< qgssize >( i ) * width + j;
-      char *srcBits = inputBlock->bits( srcIndex );
-      char *destBits = outputBlock->bits( destIndex );
-      if ( !srcBits )
-      {
-        // QgsDebugMsg( QString( "Cannot get input block data: row = %1 col = %2" ).arg( i ).arg( j ) );
-        continue;
-      }
-      if ( !destBits )
-      {
-        // QgsDebugMsg( QString( "Cannot set output block data: srcRow = %1 srcCol = %2" ).arg( srcRow ).arg( srcCol ) );
-        continue;
+        qgssize srcIndex = static_cast< qgssize >( srcRow ) * projectorData->srcCols() + srcCol;
+
+        // isNoData() may be slow so we check doNoData first
+        if ( doNoData && input->isNoData( srcRow, srcCol ) )
+        {
+          output->setIsNoData( i, j );
+          continue;
+        }
+
+        qgssize destIndex = static_cast< qgssize >( i ) * width + j;
+        char *srcBits = input->bits( srcIndex );
+        char *destBits = output->bits( destIndex );
+        if ( !srcBits )
+        {
+          // QgsDebugMsg( QString( "Cannot get input block data: row = %1 col = %2" ).arg( i ).arg( j ) );
+          continue;
+        }
+        if ( !destBits )
+        {
+          // QgsDebugMsg( QString( "Cannot set output block data: srcRow = %1 srcCol = %2" ).arg( srcRow ).arg( srcCol ) );
+          continue;
+        }
+        memcpy( destBits, srcBits, pixelSize );
+        output->setIsData( i, j );
       }
-      memcpy( destBits, srcBits, pixelSize );
-      outputBlock->setIsData( i, j );
     }
-  }
+  };
+
+  if ( rowBlocks.size() == 1 )
+    projectRows( 0 );
+  else
+    QtConcurrent::blockingMap( rowBlocks, projectRows );
 
   return outputBlock.release();
 }
@@ -34,6 +34,7 @@
 #include "qgsrasterinterface.h"
 
 #include <cmath>
+#include <QVector>
 
 class QgsPointXY;
 
@@ -115,24 +116,33 @@ class CORE_EXPORT QgsRasterProjector : public QgsRasterInterface
 
 /**
  * Internal class for reprojection of rasters - either exact or approximate.
- * QgsRasterProjector creates it and then keeps calling srcRowCol() to get source pixel position
- * for every destination pixel position.
+ * QgsRasterProjector creates it and then calls srcRowCols() to get the source
+ * pixel positions of each destination row. srcRowCols() may be called from
+ * several threads at the same time.
+ *
+ * The approximation interpolates source coordinates between control points
+ * transformed with the coordinate transform. Rows or columns of control points
+ * are only inserted in the intervals where the interpolation error exceeds
+ * the tolerance, so that the grid is denser only where the transformation is
+ * strongly non linear.
  */
 class ProjectorData
 {
   public:
     //! Initialize reprojector and calculate matrix
     ProjectorData( const QgsRectangle &extent, int width, int height, QgsRasterInterface *input, const QgsCoordinateTransform &inverseCt, QgsRasterProjector::Precision precision );
-    ~ProjectorData();
 
     ProjectorData( const ProjectorData &other ) = delete;
     ProjectorData &operator=( const ProjectorData &other ) = delete;
 
-    /** \brief Get source row and column indexes for current source extent and resolution
-        If source pixel is outside source extent srcRow and srcCol are left unchanged.
-        \returns true if inside source
+    /** \brief Get source row and column indexes of the cells of a destination row for current source extent and resolution
+        Indexes of cells outside source are set to -1.
+        \param destRow destination row
+        \param srcRows array of destination width source row indexes
+        \param srcCols array of destination width source column indexes
+        \returns true if at least one cell is inside source
      */
-    bool srcRowCol( int destRow, int destCol, int *srcRow, int *srcCol );
+    bool srcRowCols( int destRow, int *srcRows, int *srcCols ) const;
 
     QgsRectangle srcExtent() const { return mSrcExtent; }
     int srcRows() const { return mSrcRows; }
@@ -140,33 +150,36 @@ class ProjectorData
 
   private:
 
-    //! \brief get destination point for _current_ destination position
-    void destPointOnCPMatrix( int row, int col, double *theX, double *theY );
-
-    //! \brief Get matrix upper left row/col indexes for destination row/col
-    int matrixRow( int destRow );
-    int matrixCol( int destCol );
+    //! Index of a control point in the flat arrays
+    int cpIndex( int row, int col ) const { return row * mCPCols + col; }
 
-    //! \brief Get precise source row and column indexes for current source extent and resolution
-    inline bool preciseSrcRowCol( int destRow, int destCol, int *srcRow, int *srcCol );
+    //! Destination x of a position in destination columns
+    double destX( double col ) const { return mDestExtent.xMinimum() + col * mDestXRes; }
 
-    //! \brief Get approximate source row and column indexes for current source extent and resolution
-    inline bool approximateSrcRowCol( int destRow, int destCol, int *srcRow, int *srcCol );
+    //! Destination y of a position in destination rows
+    double destY( double row ) const { return mDestExtent.yMaximum() - row * mDestYRes; }
 
-    //! \brief insert rows to matrix
-    void insertRows( const QgsCoordinateTransform &ct );
+    /** \brief transform destination coordinates to source, in place
+      * legal is set to false for the points which cannot be transformed */
+    void transformToSource( QVector<double> &x, QVector<double> &y, QVector<bool> &legal ) const;
 
-    //! \brief insert columns to matrix
-    void insertCols( const QgsCoordinateTransform &ct );
+    //! Calculate the given control points
+    void calcCPs( const QVector<int> &indexes );
 
-    //! Calculate single control point in current matrix
-    void calcCP( int row, int col, const QgsCoordinateTransform &ct );
+    /** \brief check the interpolation error in the middle of an interval between
+      * two control point rows (if rows is true) or columns
+      * returns true if within threshold */
+    bool checkInterval( bool rows, int interval ) const;
 
-    //! \brief calculate matrix row
-    bool calcRow( int row, const QgsCoordinateTransform &ct );
+    /** \brief insert control point rows (if rows is true) or columns in the middle
+      * of the intervals where the interpolation error exceeds the threshold
+      * \param rows true to check and split row intervals, false for columns
+      * \param converged set to false if an interval exceeds the threshold but cannot be split
+      * \returns number of inserted rows or columns */
+    int splitIntervals( bool rows, bool &converged );
 
-    //! \brief calculate matrix column
-    bool calcCol( int col, const QgsCoordinateTransform &ct );
+    //! Calculate the source points interpolated along control point rows for every destination column
+    void calcHelpers();
 
     //! \brief calculate source extent
     void calcSrcExtent();
@@ -174,22 +187,8 @@ class ProjectorData
     //! \brief calculate minimum source width and height
     void calcSrcRowsCols();
 
-    /** \brief check error along columns
-      * returns true if within threshold */
-    bool checkCols( const QgsCoordinateTransform &ct );
-
-    /** \brief check error along rows
-      * returns true if within threshold */
-    bool checkRows( const QgsCoordinateTransform &ct );
-
-    //! Calculate array of src helper points
-    void calcHelper( int matrixRow, QgsPointXY *points );
-
-    //! Calc / switch helper
-    void nextHelper();
-
-    //! Get mCPMatrix as string
-    QString cpToString();
+    //! Get control points as string
+    QString cpToString() const;
 
     /** Use approximation (requested precision is Approximate and it is possible to calculate
      *  an approximation matrix with a sufficient precision) */
@@ -231,33 +230,37 @@ class ProjectorData
     //! Source y resolution
     double mSrcYRes;
 
-    //! Number of destination rows per matrix row
-    double mDestRowsPerMatrixRow;
+    //! Positions of control point rows, in destination rows (0 to mDestRows)
+    QVector<double> mCPRowPos;
+
+    //! Positions of control point columns, in destination columns (0 to mDestCols)
+    QVector<double> mCPColPos;
+
+    //! Source x of control points, row by row
+    QVector<double> mCPX;
 
-    //! Number of destination cols per matrix col
-    double mDestColsPerMatrixCol;
+    //! Source y of control points, row by row
+    QVector<double> mCPY;
 
-    //! Grid of source control points
-    QList< QList<QgsPointXY> > mCPMatrix;
+    //! Control points transformation possible indicator
+    /* Same size as mCPX */
+    QVector<bool> mCPLegal;
 
-    //! Grid of source control points transformation possible indicator
-    /* Same size as mCPMatrix */
-    QList< QList<bool> > mCPLegalMatrix;
+    //! Control point row interval of each destination row
+    QVector<int> mRowInterval;
 
-    //! Array of source points for each destination column on top of current CPMatrix grid row
-    /* Warning: using QList is slow on access */
-    QgsPointXY *pHelperTop = nullptr;
+    //! Position of each destination row in its control point row interval (0 = top, 1 = bottom)
+    QVector<double> mRowFrac;
 
-    //! Array of source points for each destination column on bottom of current CPMatrix grid row
-    /* Warning: using QList is slow on access */
-    QgsPointXY *pHelperBottom = nullptr;
+    //! Source x interpolated along each control point row for every destination column
+    QVector<double> mHelperX;
 
-    //! Current mHelperTop matrix row
-    int mHelperTopRow;
+    //! Source y interpolated along each control point row for every destination column
+    QVector<double> mHelperY;
 
-    //! Number of mCPMatrix columns
+    //! Number of control point columns
     int mCPCols;
-    //! Number of mCPMatrix rows
+    //! Number of control point rows
     int mCPRows;
 
     //! Maximum tolerance in destination units
@@ -30,6 +30,8 @@
 
 #include <QDomDocument>
 #include <QDomElement>
+#include <QRect>
+#include <QtConcurrentMap>
 
 QgsHeatmapRenderer::QgsHeatmapRenderer()
   : QgsFeatureRenderer( QStringLiteral( "heatmapRenderer" ) )
@@ -61,6 +63,38 @@ void QgsHeatmapRenderer::initializeValues( QgsRenderContext &context )
   mFeaturesRendered = 0;
   mRadiusPixels = std::round( context.convertToPainterUnits( mRadius, mRadiusUnit, mRadiusMapUnitScale ) / mRenderQuality );
   mRadiusSquared = mRadiusPixels * mRadiusPixels;
+  mPoints.clear();
+  mPositiveWeights = true;
+  calculateStencil();
+}
+
+void QgsHeatmapRenderer::calculateStencil()
+{
+  // pixels from -radius to radius - 1 around the point, within the radius
+  const int size = 2 * mRadiusPixels;
+  mStencil.fill( 0, size * size );
+  mStencilRowStart.fill( 0, size );
+  mStencilRowEnd.fill( 0, size );
+  for ( int row = 0; row < size; ++row )
+  {
+    const int dy = row - mRadiusPixels;
+    int start = size;
+    int end = 0;
+    for ( int col = 0; col < size; ++col )
+    {
+      const int dx = col - mRadiusPixels;
+      double distanceSquared = std::pow( dx, 2.0 ) + std::pow( dy, 2.0 );
+      if ( distanceSquared > mRadiusSquared )
+      {
+        continue;
+      }
+      mStencil[ row * size + col ] = quarticKernel( std::sqrt( distanceSquared ), mRadiusPixels );
+      start = std::min( start, col );
+      end = col + 1;
+    }
+    mStencilRowStart[ row ] = start;
+    mStencilRowEnd[ row ] = std::max( start, end );
+  }
 }
 
 void QgsHeatmapRenderer::startRender( QgsRenderContext &context, const QgsFields &fields )
@@ -136,9 +170,6 @@ bool QgsHeatmapRenderer::renderFeature( QgsFeature &feature, QgsRenderContext &c
     }
   }
 
-  int width = context.painter()->device()->width() / mRenderQuality;
-  int height = context.painter()->device()->height() / mRenderQuality;
-
   //transform geometry if required
   QgsGeometry geom = feature.geometry();
   QgsCoordinateTransform xform = context.coordinateTransform();
@@ -150,37 +181,18 @@ bool QgsHeatmapRenderer::renderFeature( QgsFeature &feature, QgsRenderContext &c
   //convert point to multipoint
   QgsMultiPoint multiPoint = convertToMultipoint( &geom );
 
-  //loop through all points in multipoint
+  //collect the points, they are splatted on the heatmap when rendering stops
   for ( QgsMultiPoint::const_iterator pointIt = multiPoint.constBegin(); pointIt != multiPoint.constEnd(); ++pointIt )
   {
     QgsPointXY pixel = context.mapToPixel().transform( *pointIt );
-    int pointX = pixel.x() / mRenderQuality;
-    int pointY = pixel.y() / mRenderQuality;
-    for ( int x = std::max( pointX - mRadiusPixels, 0 ); x < std::min( pointX + mRadiusPixels, width ); ++x )
-    {
-      for ( int y = std::max( pointY - mRadiusPixels, 0 ); y < std::min( pointY + mRadiusPixels, height ); ++y )
-      {
-        int index = y * width + x;
-        if ( index >= mValues.count() )
-        {
-          continue;
-        }
-        double distanceSquared = std::pow( pointX - x, 2.0 ) + std::pow( pointY - y, 2.0 );
-        if ( distanceSquared > mRadiusSquared )
-        {
-          continue;
-        }
-
-        double score = weight * quarticKernel( std::sqrt( distanceSquared ), mRadiusPixels );
-        double value = mValues.at( index ) + score;
-        if ( value > mCalculatedMaxValue )
-        {
-          mCalculatedMaxValue = value;
-        }
-        mValues[ index ] = value;
-      }
-    }
+    HeatmapPoint point;
+    point.x = pixel.x() / mRenderQuality;
+    point.y = pixel.y() / mRenderQuality;
+    point.weight = weight;
+    mPoints.append( point );
   }
+  if ( !( weight >= 0 ) )
+    mPositiveWeights = false;
 
   mFeaturesRendered++;
 #if 0
@@ -221,8 +233,148 @@ double QgsHeatmapRenderer::triangularKernel( const double distance, const int ba
   return ( 1. - ( distance / static_cast< double >( bandwidth ) ) );
 }
 
+void QgsHeatmapRenderer::splatPoints( int width, int height )
+{
+  if ( mPoints.isEmpty() || mRadiusPixels <= 0 )
+    return;
+
+  QVector<HeatmapPoint> points;
+  if ( mPositiveWeights && mPoints.size() > width * height / 4 )
+  {
+    // Dense input: sum the weights of the points per pixel first, then splat
+    // the occupied pixels. This is the convolution of the weight grid with the
+    // stencil, restricted to the non empty cells.
+    QVector<double> grid( width * height, 0.0 );
+    QVector<bool> occupied( width * height, false );
+    Q_FOREACH ( const HeatmapPoint &point, mPoints )
+    {
+      if ( point.x < 0 || point.x >= width || point.y < 0 || point.y >= height )
+      {
+        // outside of the image but within the radius
+        points.append( point );
+        continue;
+      }
+      const int index = point.y * width + point.x;
+      grid[ index ] += point.weight;
+      occupied[ index ] = true;
+    }
+    for ( int index = 0; index < grid.size(); ++index )
+    {
+      if ( !occupied.at( index ) )
+        continue;
+      HeatmapPoint cell;
+      cell.x = index % width;
+      cell.y = index / width;
+      cell.weight = grid.at( index );
+      points.append( cell );
+    }
+  }
+  else
+  {
+    points = mPoints;
+  }
+  mPoints.clear();
+
+  // Bin the points in tiles covering their stencil, each tile is then processed
+  // independently. Within a tile the points keep their order, so every pixel
+  // receives the same sequence of additions as when splatting points one by one.
+  const int tileSize = std::max( 128, 2 * mRadiusPixels );
+  const int tileCols = ( width + tileSize - 1 ) / tileSize;
+  const int tileRows = ( height + tileSize - 1 ) / tileSize;
+  QVector< QVector<int> > tilePoints( tileCols * tileRows );
+  for ( int i = 0; i < points.size(); ++i )
+  {
+    const HeatmapPoint &point = points.at( i );
+    const int xMin = std::max( point.x - mRadiusPixels, 0 );
+    const int xMax = std::min( point.x + mRadiusPixels, width ) - 1;
+    const int yMin = std::max( point.y - mRadiusPixels, 0 );
+    const int yMax = std::min( point.y + mRadiusPixels, height ) - 1;
+    if ( xMin > xMax || yMin > yMax )
+      continue;
+
+    for ( int tileRow = yMin / tileSize; tileRow <= yMax / tileSize; ++tileRow )
+    {
+      for ( int tileCol = xMin / tileSize; tileCol <= xMax / tileSize; ++tileCol )
+      {
+        tilePoints[ tileRow * tileCols + tileCol ].append( i );
+      }
+    }
+  }
+
+  QVector<int> tiles;
+  for ( int tile = 0; tile < tilePoints.size(); ++tile )
+  {
+    if ( !tilePoints.at( tile ).isEmpty() )
+      tiles << tile;
+  }
+  QVector<double> tileMax( tilePoints.size(), 0.0 );
+  auto splatTile = [ &, tileSize, tileCols, width, height ]( int tile )
+  {
+    const QRect area( ( tile % tileCols ) * tileSize, ( tile / tileCols ) * tileSize, tileSize, tileSize );
+    tileMax[ tile ] = splatPoints( points, tilePoints.at( tile ), area.intersected( QRect( 0, 0, width, height ) ), width );
+  };
+
+  // small heatmaps are not worth the threads
+  const double work = static_cast< double >( points.size() ) * mStencil.size();
+  if ( tiles.size() > 1 && work > 1000000 )
+  {
+    QtConcurrent::blockingMap( tiles, splatTile );
+  }
+  else
+  {
+    Q_FOREACH ( int tile, tiles )
+      splatTile( tile );
+  }
+
+  Q_FOREACH ( int tile, tiles )
+  {
+    if ( tileMax.at( tile ) > mCalculatedMaxValue )
+    {
+      mCalculatedMaxValue = tileMax.at( tile );
+    }
+  }
+}
+
+double QgsHeatmapRenderer::splatPoints( const QVector<HeatmapPoint> &points, const QVector<int> &indexes, const QRect &area, int width )
+{
+  const int size = 2 * mRadiusPixels;
+  double *values = mValues.data();
+  const double *stencil = mStencil.constData();
+  double maxValue = 0;
+  Q_FOREACH ( int i, indexes )
+  {
+    const HeatmapPoint &point = points.at( i );
+    const int yMin = std::max( point.y - mRadiusPixels, area.top() );
+    const int yMax = std::min( point.y + mRadiusPixels, area.bottom() + 1 );
+    for ( int y = yMin; y < yMax; ++y )
+    {
+      const int row = y - point.y + mRadiusPixels;
+      const int xMin = std::max( point.x - mRadiusPixels + mStencilRowStart.at( row ), area.left() );
+      const int xMax = std::min( point.x - mRadiusPixels + mStencilRowEnd.at( row ), area.right() + 1 );
+      double *rowValues = values + static_cast< qgssize >( y ) * width;
+      const double *rowStencil = stencil + row * size;
+      const int offset = mRadiusPixels - point.x;
+      for ( int x = xMin; x < xMax; ++x )
+      {
+        const double value = rowValues[ x ] + point.weight * rowStencil[ x + offset ];
+        if ( value > maxValue )
+        {
+          maxValue = value;
+        }
+        rowValues[ x ] = value;
+      }
+    }
+  }
+  return maxValue;
+}
+
 void QgsHeatmapRenderer::stopRender( QgsRenderContext &context )
 {
+  if ( context.painter() )
+  {
+    splatPoints( context.painter()->device()->width() / mRenderQuality,
+                 context.painter()->device()->height() / mRenderQuality );
+  }
   renderImage( context );
   mWeightExpression.reset();
 }
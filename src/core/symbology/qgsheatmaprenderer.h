@@ -165,8 +165,31 @@ class CORE_EXPORT QgsHeatmapRenderer : public QgsFeatureRenderer
 
   private:
 
+    //! A point of the heatmap, in heatmap pixels
+    struct HeatmapPoint
+    {
+      int x;
+      int y;
+      double weight;
+    };
+
     QVector<double> mValues;
 
+    //! Points collected by renderFeature(), splatted when rendering stops
+    QVector<HeatmapPoint> mPoints;
+
+    //! True if all the collected points have a positive or null weight
+    bool mPositiveWeights = true;
+
+    //! Kernel values for the pixels around a point, (2 * mRadiusPixels) rows of (2 * mRadiusPixels) values
+    QVector<double> mStencil;
+
+    //! First column of each stencil row within the radius
+    QVector<int> mStencilRowStart;
+
+    //! End (excluded) of each stencil row within the radius
+    QVector<int> mStencilRowEnd;
+
     double mCalculatedMaxValue;
 
     double mRadius;
@@ -195,6 +218,17 @@ class CORE_EXPORT QgsHeatmapRenderer : public QgsFeatureRenderer
     QgsMultiPoint convertToMultipoint( const QgsGeometry *geom );
     void initializeValues( QgsRenderContext &context );
     void renderImage( QgsRenderContext &context );
+
+    //! Computes the kernel stencil for the current radius
+    void calculateStencil();
+
+    //! Adds the stencils of the collected points to mValues
+    void splatPoints( int width, int height );
+
+    /** Adds the stencils of some points to the values of the pixels within an area.
+     * \returns the maximum value written to a pixel
+     */
+    double splatPoints( const QVector<HeatmapPoint> &points, const QVector<int> &indexes, const QRect &area, int width );
 };
 
 
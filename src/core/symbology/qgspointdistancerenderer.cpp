@@ -18,7 +18,6 @@
 #include "qgspointdistancerenderer.h"
 #include "qgsgeometry.h"
 #include "qgssymbollayerutils.h"
-#include "qgsspatialindex.h"
 #include "qgsmultipoint.h"
 #include "qgslogger.h"
 
@@ -34,7 +33,6 @@ QgsPointDistanceRenderer::QgsPointDistanceRenderer( const QString &rendererName,
   , mTolerance( 3 )
   , mToleranceUnit( QgsUnitTypes::RenderMillimeters )
   , mDrawLabels( true )
-  , mSpatialIndex( nullptr )
 {
   mRenderer.reset( QgsFeatureRenderer::defaultRenderer( QgsWkbTypes::PointGeometry ) );
 }
@@ -89,43 +87,29 @@ bool QgsPointDistanceRenderer::renderFeature( QgsFeature &feature, QgsRenderCont
     transformedFeature.setGeometry( geom );
   }
 
-  double searchDistance = context.convertToMapUnits( mTolerance, mToleranceUnit, mToleranceMapUnitScale );
   QgsPointXY point = transformedFeature.geometry().asPoint();
-  QList<QgsFeatureId> intersectList = mSpatialIndex->intersects( searchRect( point, searchDistance ) );
-  if ( intersectList.empty() )
+  int groupIdx = findGroup( point );
+  if ( groupIdx < 0 )
   {
-    mSpatialIndex->insertFeature( transformedFeature );
     // create new group
     ClusteredGroup newGroup;
     newGroup << GroupedFeature( transformedFeature, symbol->clone(), selected, label );
     mClusteredGroups.push_back( newGroup );
+    groupIdx = mClusteredGroups.count() - 1;
+    mGroupLocations.append( point );
+    mGroupAnchors.append( point );
+    mGridCells[ gridCell( point )].append( groupIdx );
     // add to group index
-    mGroupIndex.insert( transformedFeature.id(), mClusteredGroups.count() - 1 );
-    mGroupLocations.insert( transformedFeature.id(), point );
+    mGroupIndex.insert( transformedFeature.id(), groupIdx );
   }
   else
   {
-    // find group with closest location to this point (may be more than one within search tolerance)
-    QgsFeatureId minDistFeatureId = intersectList.at( 0 );
-    double minDist = mGroupLocations.value( minDistFeatureId ).distance( point );
-    for ( int i = 1; i < intersectList.count(); ++i )
-    {
-      QgsFeatureId candidateId = intersectList.at( i );
-      double newDist = mGroupLocations.value( candidateId ).distance( point );
-      if ( newDist < minDist )
-      {
-        minDist = newDist;
-        minDistFeatureId = candidateId;
-      }
-    }
-
-    int groupIdx = mGroupIndex[ minDistFeatureId ];
     ClusteredGroup &group = mClusteredGroups[groupIdx];
 
     // calculate new centroid of group
-    QgsPointXY oldCenter = mGroupLocations.value( minDistFeatureId );
-    mGroupLocations[ minDistFeatureId ] = QgsPointXY( ( oldCenter.x() * group.size() + point.x() ) / ( group.size() + 1.0 ),
-                                          ( oldCenter.y() * group.size() + point.y() ) / ( group.size() + 1.0 ) );
+    QgsPointXY oldCenter = mGroupLocations.at( groupIdx );
+    mGroupLocations[ groupIdx ] = QgsPointXY( ( oldCenter.x() * group.size() + point.x() ) / ( group.size() + 1.0 ),
+                                  ( oldCenter.y() * group.size() + point.y() ) / ( group.size() + 1.0 ) );
 
     // add to a group
     group << GroupedFeature( transformedFeature, symbol->clone(), selected, label );
@@ -292,7 +276,12 @@ void QgsPointDistanceRenderer::startRender( QgsRenderContext &context, const Qgs
   mClusteredGroups.clear();
   mGroupIndex.clear();
   mGroupLocations.clear();
-  mSpatialIndex = new QgsSpatialIndex;
+  mGroupAnchors.clear();
+  mGridCells.clear();
+
+  mSearchDistance = context.convertToMapUnits( mTolerance, mToleranceUnit, mToleranceMapUnitScale );
+  // a zero tolerance only groups identical points, any cell size works then
+  mGridCellSize = mSearchDistance > 0 ? mSearchDistance : 1;
 
   if ( mLabelAttributeName.isEmpty() )
   {
@@ -325,8 +314,8 @@ void QgsPointDistanceRenderer::stopRender( QgsRenderContext &context )
   mClusteredGroups.clear();
   mGroupIndex.clear();
   mGroupLocations.clear();
-  delete mSpatialIndex;
-  mSpatialIndex = nullptr;
+  mGroupAnchors.clear();
+  mGridCells.clear();
 
   mRenderer->stopRender( context );
 }
@@ -345,6 +334,46 @@ QgsRectangle QgsPointDistanceRenderer::searchRect( const QgsPointXY &p, double d
   return QgsRectangle( p.x() - distance, p.y() - distance, p.x() + distance, p.y() + distance );
 }
 
+QgsPointDistanceRenderer::GridCell QgsPointDistanceRenderer::gridCell( const QgsPointXY &point ) const
+{
+  return GridCell( static_cast< qint64 >( std::floor( point.x() / mGridCellSize ) ),
+                   static_cast< qint64 >( std::floor( point.y() / mGridCellSize ) ) );
+}
+
+int QgsPointDistanceRenderer::findGroup( const QgsPointXY &point ) const
+{
+  const QgsRectangle rect = searchRect( point, mSearchDistance );
+  const GridCell cell = gridCell( point );
+
+  // find group with closest location to this point (may be more than one within search tolerance),
+  // ties are resolved in favor of the oldest group so that results do not depend on the hash order
+  int minDistGroup = -1;
+  double minDist = 0;
+  for ( qint64 cellX = cell.first - 1; cellX <= cell.first + 1; ++cellX )
+  {
+    for ( qint64 cellY = cell.second - 1; cellY <= cell.second + 1; ++cellY )
+    {
+      QHash< GridCell, QVector< int > >::const_iterator it = mGridCells.constFind( GridCell( cellX, cellY ) );
+      if ( it == mGridCells.constEnd() )
+        continue;
+
+      Q_FOREACH ( int candidate, it.value() )
+      {
+        if ( !rect.contains( mGroupAnchors.at( candidate ) ) )
+          continue;
+
+        double dist = mGroupLocations.at( candidate ).sqrDist( point );
+        if ( minDistGroup < 0 || dist < minDist || ( dist == minDist && candidate < minDistGroup ) )
+        {
+          minDist = dist;
+          minDistGroup = candidate;
+        }
+      }
+    }
+  }
+  return minDistGroup;
+}
+
 void QgsPointDistanceRenderer::printGroupInfo() const
 {
 #ifdef QGISDEBUG
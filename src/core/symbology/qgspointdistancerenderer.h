@@ -22,8 +22,9 @@
 #include "qgis.h"
 #include "qgsrenderer.h"
 #include <QFont>
-
-class QgsSpatialIndex;
+#include <QHash>
+#include <QPair>
+#include <QVector>
 
 /** \class QgsPointDistanceRenderer
  * \ingroup core
@@ -242,13 +243,10 @@ class CORE_EXPORT QgsPointDistanceRenderer: public QgsFeatureRenderer
     QList<ClusteredGroup> mClusteredGroups;
 
     //! Mapping of feature ID to the feature's group index.
-    QMap<QgsFeatureId, int> mGroupIndex;
-
-    //! Mapping of feature ID to approximate group location
-    QMap<QgsFeatureId, QgsPointXY > mGroupLocations;
+    QHash<QgsFeatureId, int> mGroupIndex;
 
-    //! Spatial index for fast lookup of nearby points.
-    QgsSpatialIndex *mSpatialIndex = nullptr;
+    //! Approximate location of each group, in the same order as mClusteredGroups
+    QVector< QgsPointXY > mGroupLocations;
 
     /** Renders the labels for a group.
      * \param centerPoint center point of group
@@ -261,6 +259,32 @@ class CORE_EXPORT QgsPointDistanceRenderer: public QgsFeatureRenderer
 
   private:
 
+    //! Cell of the grouping grid containing a point
+    typedef QPair< qint64, qint64 > GridCell;
+
+    //! Search distance in map units, set in startRender()
+    double mSearchDistance = 0;
+
+    //! Size of the cells of the grouping grid in map units
+    double mGridCellSize = 1;
+
+    /** Uniform grid of the groups, each group is stored in the cell of the location
+     * of its first point. Cells are as large as the search distance so the groups
+     * matching a point are always in the 3x3 cells around it.
+     */
+    QHash< GridCell, QVector< int > > mGridCells;
+
+    //! Location of the first point of each group, in the same order as mClusteredGroups
+    QVector< QgsPointXY > mGroupAnchors;
+
+    //! Returns the cell of the grouping grid containing a point
+    GridCell gridCell( const QgsPointXY &point ) const;
+
+    /** Returns the index of the group a point belongs to, or -1 if the point is
+     * not within the search distance of any group.
+     */
+    int findGroup( const QgsPointXY &point ) const;
+
     /** Draws a group of clustered points.
      * \param centerPoint central point (geographic centroid) of all points contained within the cluster
      * \param context destination render context
@@ -35,6 +35,75 @@
 #include <QFileInfo>
 #include <QNetworkReply>
 #include <QNetworkRequest>
+#include <QVector>
+
+///@cond PRIVATE
+namespace
+{
+  //! Number of images kept by each thread in front of the shared cache
+  const int FRONT_CACHE_SIZE = 64;
+
+  //! Larger images are not kept in the front caches
+  const int FRONT_CACHE_MAX_IMAGE_BYTES = 512 * 1024;
+
+  struct FrontCacheEntry
+  {
+    quint64 cacheId = 0;
+    QString path;
+    double size = 0;
+    QColor fill;
+    QColor stroke;
+    double strokeWidth = 0;
+    double widthScaleFactor = 0;
+    //! Image of the shared cache entry, null once the entry is evicted
+    QWeakPointer< QImage > image;
+  };
+
+  //! Images last returned to the thread, indexed by the hash of their parameters modulo FRONT_CACHE_SIZE
+  thread_local QVector< FrontCacheEntry > sFrontCache( FRONT_CACHE_SIZE );
+
+  std::atomic< quint64 > sNextCacheId( 1 );
+
+  /** Doubles of the parameters of an image are compared and hashed once quantized,
+   * so that parameters considered equal always have the same hash.
+   */
+  inline qint64 quantized( double value )
+  {
+    return qRound64( value * 1e6 );
+  }
+
+  inline bool quantizedEqual( double value1, double value2 )
+  {
+    return quantized( value1 ) == quantized( value2 );
+  }
+
+  //! Locks a mutex, counting the times it was already held by another thread
+  class ContentionCountingLocker
+  {
+    public:
+      ContentionCountingLocker( QMutex &mutex, std::atomic< qint64 > &contentions )
+        : mMutex( mutex )
+      {
+        if ( !mMutex.tryLock() )
+        {
+          contentions++;
+          mMutex.lock();
+        }
+      }
+
+      ~ContentionCountingLocker()
+      {
+        mMutex.unlock();
+      }
+
+      ContentionCountingLocker( const ContentionCountingLocker &other ) = delete;
+      ContentionCountingLocker &operator=( const ContentionCountingLocker &other ) = delete;
+
+    private:
+      QMutex &mMutex;
+  };
+}
+///@endcond
 
 QgsSvgCacheEntry::QgsSvgCacheEntry()
   : path( QString() )
@@ -96,6 +165,9 @@ QgsSvgCache::QgsSvgCache( QObject *parent )
   , mTotalSize( 0 )
   , mLeastRecentEntry( nullptr )
   , mMostRecentEntry( nullptr )
+  , mCacheId( sNextCacheId++ )
+  , mFrontCacheHits( 0 )
+  , mContentions( 0 )
 {
   mMissingSvg = QStringLiteral( "<svg width='10' height='10'><text x='5' y='10' font-size='10' text-anchor='middle'>?</text></svg>" ).toLatin1();
 }
@@ -109,7 +181,21 @@ QgsSvgCache::~QgsSvgCache()
 QImage QgsSvgCache::svgAsImage( const QString &file, double size, const QColor &fill, const QColor &stroke, double strokeWidth,
                                 double widthScaleFactor, bool &fitsInCache )
 {
-  QMutexLocker locker( &mMutex );
+  // images are mostly requested again by the same thread, look in its front cache first
+  FrontCacheEntry &front = sFrontCache[ entryHash( file, size, fill, stroke, strokeWidth, widthScaleFactor ) % FRONT_CACHE_SIZE ];
+  if ( front.cacheId == mCacheId && front.path == file && quantizedEqual( front.size, size ) && front.fill == fill && front.stroke == stroke &&
+       quantizedEqual( front.strokeWidth, strokeWidth ) && quantizedEqual( front.widthScaleFactor, widthScaleFactor ) )
+  {
+    const QSharedPointer< QImage > image = front.image.toStrongRef();
+    if ( image )
+    {
+      mFrontCacheHits++;
+      fitsInCache = true;
+      return *image;
+    }
+  }
+
+  ContentionCountingLocker locker( mMutex, mContentions );
 
   fitsInCache = true;
   QgsSvgCacheEntry *currentEntry = cacheEntry( file, size, fill, stroke, strokeWidth, widthScaleFactor );
@@ -133,6 +219,7 @@ QImage QgsSvgCache::svgAsImage( const QString &file, double size, const QColor &
       fitsInCache = false;
       delete currentEntry->image;
       currentEntry->image = nullptr;
+      currentEntry->sharedImage.clear();
       //currentEntry->image = new QImage( 0, 0 );
 
       // instead cache picture
@@ -148,13 +235,28 @@ QImage QgsSvgCache::svgAsImage( const QString &file, double size, const QColor &
     trimToMaximumSize();
   }
 
+  if ( fitsInCache && currentEntry->image->byteCount() <= FRONT_CACHE_MAX_IMAGE_BYTES )
+  {
+    front.cacheId = mCacheId;
+    front.path = file;
+    front.size = size;
+    front.fill = fill;
+    front.stroke = stroke;
+    front.strokeWidth = strokeWidth;
+    front.widthScaleFactor = widthScaleFactor;
+    // shares the data of the entry image, no memory is used out of the cache budget
+    if ( !currentEntry->sharedImage )
+      currentEntry->sharedImage.reset( new QImage( *( currentEntry->image ) ) );
+    front.image = currentEntry->sharedImage.toWeakRef();
+  }
+
   return *( currentEntry->image );
 }
 
 QPicture QgsSvgCache::svgAsPicture( const QString &path, double size, const QColor &fill, const QColor &stroke, double strokeWidth,
                                     double widthScaleFactor, bool forceVectorOutput )
 {
-  QMutexLocker locker( &mMutex );
+  ContentionCountingLocker locker( mMutex, mContentions );
 
   QgsSvgCacheEntry *currentEntry = cacheEntry( path, size, fill, stroke, strokeWidth, widthScaleFactor );
 
@@ -172,7 +274,7 @@ QPicture QgsSvgCache::svgAsPicture( const QString &path, double size, const QCol
 QByteArray QgsSvgCache::svgContent( const QString &path, double size, const QColor &fill, const QColor &stroke, double strokeWidth,
                                     double widthScaleFactor )
 {
-  QMutexLocker locker( &mMutex );
+  ContentionCountingLocker locker( mMutex, mContentions );
 
   QgsSvgCacheEntry *currentEntry = cacheEntry( path, size, fill, stroke, strokeWidth, widthScaleFactor );
 
@@ -181,7 +283,7 @@ QByteArray QgsSvgCache::svgContent( const QString &path, double size, const QCol
 
 QSizeF QgsSvgCache::svgViewboxSize( const QString &path, double size, const QColor &fill, const QColor &stroke, double strokeWidth, double widthScaleFactor )
 {
-  QMutexLocker locker( &mMutex );
+  ContentionCountingLocker locker( mMutex, mContentions );
 
   QgsSvgCacheEntry *currentEntry = cacheEntry( path, size, fill, stroke, strokeWidth, widthScaleFactor );
 
@@ -195,7 +297,7 @@ QgsSvgCacheEntry *QgsSvgCache::insertSvg( const QString &path, double size, cons
 
   replaceParamsAndCacheSvg( entry );
 
-  mEntryLookup.insert( path, entry );
+  mEntryLookup.insert( entryHash( path, size, fill, stroke, strokeWidth, widthScaleFactor ), entry );
 
   //insert to most recent place in entry list
   if ( !mMostRecentEntry ) //inserting first entry
@@ -484,6 +586,7 @@ void QgsSvgCache::cacheImage( QgsSvgCacheEntry *entry )
 
   delete entry->image;
   entry->image = nullptr;
+  entry->sharedImage.clear();
 
   QSvgRenderer r( entry->svgContent );
   double hwRatio = 1.0;
@@ -562,14 +665,13 @@ QgsSvgCacheEntry *QgsSvgCache::cacheEntry( const QString &path, double size, con
 {
   //search entries in mEntryLookup
   QgsSvgCacheEntry *currentEntry = nullptr;
-  QList<QgsSvgCacheEntry *> entries = mEntryLookup.values( path );
-
-  QList<QgsSvgCacheEntry *>::iterator entryIt = entries.begin();
-  for ( ; entryIt != entries.end(); ++entryIt )
+  const uint hash = entryHash( path, size, fill, stroke, strokeWidth, widthScaleFactor );
+  QMultiHash< uint, QgsSvgCacheEntry * >::const_iterator entryIt = mEntryLookup.constFind( hash );
+  for ( ; entryIt != mEntryLookup.constEnd() && entryIt.key() == hash; ++entryIt )
   {
-    QgsSvgCacheEntry *cacheEntry = *entryIt;
-    if ( qgsDoubleNear( cacheEntry->size, size ) && cacheEntry->fill == fill && cacheEntry->stroke == stroke &&
-         qgsDoubleNear( cacheEntry->strokeWidth, strokeWidth ) && qgsDoubleNear( cacheEntry->widthScaleFactor, widthScaleFactor ) )
+    QgsSvgCacheEntry *cacheEntry = entryIt.value();
+    if ( cacheEntry->path == path && quantizedEqual( cacheEntry->size, size ) && cacheEntry->fill == fill && cacheEntry->stroke == stroke &&
+         quantizedEqual( cacheEntry->strokeWidth, strokeWidth ) && quantizedEqual( cacheEntry->widthScaleFactor, widthScaleFactor ) )
     {
       currentEntry = cacheEntry;
       break;
@@ -580,10 +682,12 @@ QgsSvgCacheEntry *QgsSvgCache::cacheEntry( const QString &path, double size, con
   //cache and replace params in svg content
   if ( !currentEntry )
   {
+    mMisses++;
     currentEntry = insertSvg( path, size, fill, stroke, strokeWidth, widthScaleFactor );
   }
   else
   {
+    mHits++;
     takeEntryFromList( currentEntry );
     if ( !mMostRecentEntry ) //list is empty
     {
@@ -871,10 +975,41 @@ void QgsSvgCache::containsElemParams( const QDomElement &elem, bool &hasFillPara
   }
 }
 
-void QgsSvgCache::removeCacheEntry( const QString &s, QgsSvgCacheEntry *entry )
+void QgsSvgCache::removeCacheEntry( QgsSvgCacheEntry *entry )
 {
+  mEntryLookup.remove( entryHash( entry->path, entry->size, entry->fill, entry->stroke, entry->strokeWidth, entry->widthScaleFactor ), entry );
   delete entry;
-  mEntryLookup.remove( s, entry );
+}
+
+uint QgsSvgCache::entryHash( const QString &path, double size, const QColor &fill, const QColor &stroke, double strokeWidth, double widthScaleFactor )
+{
+  uint hash = qHash( path );
+  hash = hash * 31 + qHash( quantized( size ) );
+  hash = hash * 31 + qHash( fill.rgba() );
+  hash = hash * 31 + qHash( stroke.rgba() );
+  hash = hash * 31 + qHash( quantized( strokeWidth ) );
+  hash = hash * 31 + qHash( quantized( widthScaleFactor ) );
+  return hash;
+}
+
+QgsSvgCache::Statistics QgsSvgCache::statistics() const
+{
+  QMutexLocker locker( &mMutex );
+  Statistics statistics;
+  statistics.frontCacheHits = mFrontCacheHits;
+  statistics.hits = mHits;
+  statistics.misses = mMisses;
+  statistics.contentions = mContentions;
+  return statistics;
+}
+
+void QgsSvgCache::resetStatistics()
+{
+  QMutexLocker locker( &mMutex );
+  mFrontCacheHits = 0;
+  mHits = 0;
+  mMisses = 0;
+  mContentions = 0;
 }
 
 void QgsSvgCache::printEntryList()
@@ -906,7 +1041,7 @@ void QgsSvgCache::trimToMaximumSize()
     entry = entry->nextEntry;
 
     takeEntryFromList( bkEntry );
-    mEntryLookup.remove( bkEntry->path, bkEntry );
+    mEntryLookup.remove( entryHash( bkEntry->path, bkEntry->size, bkEntry->fill, bkEntry->stroke, bkEntry->strokeWidth, bkEntry->widthScaleFactor ), bkEntry );
     mTotalSize -= bkEntry->dataSize();
     delete bkEntry;
   }
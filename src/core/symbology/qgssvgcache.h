@@ -27,6 +27,8 @@
 #include <QUrl>
 #include <QObject>
 #include <QSizeF>
+#include <QSharedPointer>
+#include <atomic>
 
 #include "qgis_core.h"
 
@@ -72,6 +74,14 @@ class CORE_EXPORT QgsSvgCacheEntry
     QColor fill;
     QColor stroke;
     QImage *image = nullptr;
+
+    /** Shared copy of image. The front caches of the threads only keep weak
+     * references to it, so that they never keep an evicted image alive.
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    QSharedPointer< QImage > sharedImage SIP_SKIP;
+
     QPicture *picture = nullptr;
     //content (with params replaced)
     QByteArray svgContent;
@@ -185,6 +195,32 @@ class CORE_EXPORT QgsSvgCache : public QObject
     //! Get image data
     QByteArray getImageData( const QString &path ) const;
 
+    /** Statistics of the lookups in the cache.
+     * \see statistics()
+     * \since QGIS 3.0
+     */
+    struct Statistics
+    {
+      //! Number of images found in the front cache of the calling thread, without locking the cache
+      qint64 frontCacheHits = 0;
+      //! Number of lookups which found an existing entry
+      qint64 hits = 0;
+      //! Number of lookups which created a new entry
+      qint64 misses = 0;
+      //! Number of lookups which had to wait for another thread to release the cache
+      qint64 contentions = 0;
+    };
+
+    /** Returns the statistics collected since the last call to resetStatistics().
+     * \since QGIS 3.0
+     */
+    Statistics statistics() const;
+
+    /** Resets the lookup statistics.
+     * \since QGIS 3.0
+     */
+    void resetStatistics();
+
     //! Get SVG content
     QByteArray svgContent( const QString &path, double size, const QColor &fill, const QColor &stroke, double strokeWidth,
                            double widthScaleFactor );
@@ -223,8 +259,8 @@ class CORE_EXPORT QgsSvgCache : public QObject
     void downloadProgress( qint64, qint64 );
 
   private:
-    //! Entry pointers accessible by file name
-    QMultiHash< QString, QgsSvgCacheEntry * > mEntryLookup;
+    //! Entry pointers accessible by the hash of all their parameters, see entryHash()
+    QMultiHash< uint, QgsSvgCacheEntry * > mEntryLookup;
     //! Estimated total size of all images, pictures and svgContent
     long mTotalSize;
 
@@ -250,7 +286,10 @@ class CORE_EXPORT QgsSvgCache : public QObject
     double calcSizeScaleFactor( QgsSvgCacheEntry *entry, const QDomElement &docElem, QSizeF &viewboxSize ) const;
 
     //! Release memory and remove cache entry from mEntryLookup
-    void removeCacheEntry( const QString &s, QgsSvgCacheEntry *entry );
+    void removeCacheEntry( QgsSvgCacheEntry *entry );
+
+    //! Hash of the parameters of an entry, used as key in mEntryLookup
+    static uint entryHash( const QString &path, double size, const QColor &fill, const QColor &stroke, double strokeWidth, double widthScaleFactor );
 
     //! For debugging
     void printEntryList();
@@ -259,7 +298,15 @@ class CORE_EXPORT QgsSvgCache : public QObject
     QByteArray mMissingSvg;
 
     //! Mutex to prevent concurrent access to the class from multiple threads at once (may corrupt the entries otherwise).
-    QMutex mMutex;
+    mutable QMutex mMutex;
+
+    //! Identifies the cache in the per thread front caches, unlike its address it is never reused
+    quint64 mCacheId;
+
+    std::atomic< qint64 > mFrontCacheHits;
+    std::atomic< qint64 > mContentions;
+    qint64 mHits = 0;
+    qint64 mMisses = 0;
 
 };
 
@@ -21,6 +21,7 @@
 #include "qgsfillsymbollayer.h"
 #include "qgsgeometrygeneratorsymbollayer.h"
 #include "qgsmaptopixelgeometrysimplifier.h"
+#include "qgssymbolgeometrypipeline.h"
 
 #include "qgslogger.h"
 #include "qgsrendercontext.h" // for bigSymbolPreview
@@ -101,74 +102,15 @@ QgsSymbol::QgsSymbol( SymbolType type, const QgsSymbolLayerList &layers )
 
 QPolygonF QgsSymbol::_getLineString( QgsRenderContext &context, const QgsCurve &curve, bool clipToExtent )
 {
-  const unsigned int nPoints = curve.numPoints();
-
-  QgsCoordinateTransform ct = context.coordinateTransform();
-  const QgsMapToPixel &mtp = context.mapToPixel();
   QPolygonF pts;
-
-  //apply clipping for large lines to achieve a better rendering performance
-  if ( clipToExtent && nPoints > 1 )
-  {
-    const QgsRectangle &e = context.extent();
-    const double cw = e.width() / 10;
-    const double ch = e.height() / 10;
-    const QgsRectangle clipRect( e.xMinimum() - cw, e.yMinimum() - ch, e.xMaximum() + cw, e.yMaximum() + ch );
-    pts = QgsClipper::clippedLine( curve, clipRect );
-  }
-  else
-  {
-    pts = curve.asQPolygonF();
-  }
-
-  //transform the QPolygonF to screen coordinates
-  if ( ct.isValid() )
-  {
-    ct.transformPolygon( pts );
-  }
-
-  QPointF *ptr = pts.data();
-  for ( int i = 0; i < pts.size(); ++i, ++ptr )
-  {
-    mtp.transformInPlace( ptr->rx(), ptr->ry() );
-  }
-
+  QgsSymbolGeometryPipeline::instance().lineString( pts, context, curve, clipToExtent );
   return pts;
 }
 
 QPolygonF QgsSymbol::_getPolygonRing( QgsRenderContext &context, const QgsCurve &curve, bool clipToExtent )
 {
-  const QgsCoordinateTransform ct = context.coordinateTransform();
-  const QgsMapToPixel &mtp = context.mapToPixel();
-  const QgsRectangle &e = context.extent();
-  const double cw = e.width() / 10;
-  const double ch = e.height() / 10;
-  QgsRectangle clipRect( e.xMinimum() - cw, e.yMinimum() - ch, e.xMaximum() + cw, e.yMaximum() + ch );
-
-  QPolygonF poly = curve.asQPolygonF();
-
-  if ( curve.numPoints() < 1 )
-    return QPolygonF();
-
-  //clip close to view extent, if needed
-  const QRectF ptsRect = poly.boundingRect();
-  if ( clipToExtent && !context.extent().contains( ptsRect ) )
-  {
-    QgsClipper::trimPolygon( poly, clipRect );
-  }
-
-  //transform the QPolygonF to screen coordinates
-  if ( ct.isValid() )
-  {
-    ct.transformPolygon( poly );
-  }
-
-  QPointF *ptr = poly.data();
-  for ( int i = 0; i < poly.size(); ++i, ++ptr )
-  {
-    mtp.transformInPlace( ptr->rx(), ptr->ry() );
-  }
-
+  QPolygonF poly;
+  QgsSymbolGeometryPipeline::instance().polygonRing( poly, context, curve, clipToExtent, true );
   return poly;
 }
 
@@ -176,10 +118,12 @@ void QgsSymbol::_getPolygon( QPolygonF &pts, QList<QPolygonF> &holes, QgsRenderC
 {
   holes.clear();
 
-  pts = _getPolygonRing( context, *polygon.exteriorRing(), clipToExtent );
+  QgsSymbolGeometryPipeline &pipeline = QgsSymbolGeometryPipeline::instance();
+  pipeline.polygonRing( pts, context, *polygon.exteriorRing(), clipToExtent, true );
+  QPolygonF hole;
   for ( int idx = 0; idx < polygon.numInteriorRings(); idx++ )
   {
-    const QPolygonF hole = _getPolygonRing( context, *( polygon.interiorRing( idx ) ), clipToExtent );
+    pipeline.polygonRing( hole, context, *( polygon.interiorRing( idx ) ), clipToExtent, false );
     if ( !hole.isEmpty() ) holes.append( hole );
   }
 }
@@ -721,8 +665,9 @@ void QgsSymbol::renderFeature( const QgsFeature &feature, QgsRenderContext &cont
   // Collection of markers to paint, only used for no curve types.
   QPolygonF markers;
 
-  // Simplify the geometry, if needed.
-  if ( context.vectorSimplifyMethod().forceLocalOptimization() )
+  // Simplify the geometry, if needed. Distance based simplification is done
+  // in pixel space while converting the geometry to screen coordinates.
+  if ( context.vectorSimplifyMethod().forceLocalOptimization() && !QgsSymbolGeometryPipeline::simplifiesInPixelSpace( context ) )
   {
     const int simplifyHints = context.vectorSimplifyMethod().simplifyHints();
     const QgsMapToPixelSimplifier simplifier( simplifyHints, context.vectorSimplifyMethod().tolerance(),
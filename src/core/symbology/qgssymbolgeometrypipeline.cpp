@@ -0,0 +1,260 @@
+/***************************************************************************
+    qgssymbolgeometrypipeline.cpp
+    ---------------------
+    begin                : October 2017
+    copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgssymbolgeometrypipeline.h"
+#include "qgsclipper.h"
+#include "qgscoordinatetransform.h"
+#include "qgscurve.h"
+#include "qgsrendercontext.h"
+#include "qgsvectorsimplifymethod.h"
+
+#include <QElapsedTimer>
+#include <QTransform>
+
+#include <algorithm>
+#include <limits>
+
+///@cond PRIVATE
+namespace
+{
+  //! Extent of the context extended by 10% on each side, used to clip large geometries
+  QgsRectangle clipRectangle( const QgsRenderContext &context )
+  {
+    const QgsRectangle &e = context.extent();
+    const double cw = e.width() / 10;
+    const double ch = e.height() / 10;
+    return QgsRectangle( e.xMinimum() - cw, e.yMinimum() - ch, e.xMaximum() + cw, e.yMaximum() + ch );
+  }
+}
+///@endcond
+
+QgsSymbolGeometryPipeline &QgsSymbolGeometryPipeline::instance()
+{
+  static thread_local QgsSymbolGeometryPipeline sPipeline;
+  return sPipeline;
+}
+
+bool QgsSymbolGeometryPipeline::simplifiesInPixelSpace( const QgsRenderContext &context )
+{
+  const QgsVectorSimplifyMethod &method = context.vectorSimplifyMethod();
+  return method.forceLocalOptimization()
+         && ( method.simplifyHints() & QgsVectorSimplifyMethod::GeometrySimplification )
+         && method.simplifyAlgorithm() == QgsVectorSimplifyMethod::Distance
+         && method.threshold() > 0;
+}
+
+void QgsSymbolGeometryPipeline::lineString( QPolygonF &result, const QgsRenderContext &context, const QgsCurve &curve, bool clipToExtent )
+{
+  QElapsedTimer timer;
+  if ( mCollectStatistics )
+  {
+    timer.start();
+    mStatistics.inputVertices += curve.numPoints();
+  }
+
+  //apply clipping for large lines to achieve a better rendering performance
+  const QgsRectangle clipRect = clipRectangle( context );
+  if ( clipToExtent && curve.numPoints() > 1 && !clipRect.contains( curve.boundingBox() ) )
+  {
+    result = QgsClipper::clippedLine( curve, clipRect );
+    load( result );
+  }
+  else
+  {
+    load( curve );
+  }
+
+  if ( mCollectStatistics )
+    mStatistics.clipTime += timer.nsecsElapsed();
+
+  transformToScreen( result, context, false );
+}
+
+void QgsSymbolGeometryPipeline::polygonRing( QPolygonF &result, const QgsRenderContext &context, const QgsCurve &curve, bool clipToExtent, bool exteriorRing )
+{
+  if ( curve.numPoints() < 1 )
+  {
+    result.clear();
+    return;
+  }
+
+  QElapsedTimer timer;
+  if ( mCollectStatistics )
+  {
+    timer.start();
+    mStatistics.inputVertices += curve.numPoints();
+  }
+
+  const QgsRectangle boundingBox = curve.boundingBox();
+
+  // holes smaller than the simplification tolerance are not visible, the bounding
+  // box of the curve is cached so they are dropped without touching the vertices
+  if ( !exteriorRing && simplifiesInPixelSpace( context ) )
+  {
+    const double tolerance = context.vectorSimplifyMethod().tolerance();
+    if ( boundingBox.width() < tolerance && boundingBox.height() < tolerance )
+    {
+      result.clear();
+      if ( mCollectStatistics )
+        mStatistics.droppedRings++;
+      return;
+    }
+  }
+
+  //clip close to view extent, if needed
+  if ( clipToExtent && !context.extent().contains( boundingBox ) )
+  {
+    result = curve.asQPolygonF();
+    QgsClipper::trimPolygon( result, clipRectangle( context ) );
+    load( result );
+  }
+  else
+  {
+    load( curve );
+  }
+
+  if ( mCollectStatistics )
+    mStatistics.clipTime += timer.nsecsElapsed();
+
+  transformToScreen( result, context, true );
+}
+
+void QgsSymbolGeometryPipeline::load( const QgsCurve &curve )
+{
+  const int nPoints = curve.numPoints();
+  mX.resize( nPoints );
+  mY.resize( nPoints );
+  double *x = mX.data();
+  double *y = mY.data();
+  for ( int i = 0; i < nPoints; ++i )
+  {
+    x[i] = curve.xAt( i );
+    y[i] = curve.yAt( i );
+  }
+}
+
+void QgsSymbolGeometryPipeline::load( const QPolygonF &polygon )
+{
+  const int nPoints = polygon.size();
+  mX.resize( nPoints );
+  mY.resize( nPoints );
+  double *x = mX.data();
+  double *y = mY.data();
+  const QPointF *pt = polygon.constData();
+  for ( int i = 0; i < nPoints; ++i, ++pt )
+  {
+    x[i] = pt->x();
+    y[i] = pt->y();
+  }
+}
+
+void QgsSymbolGeometryPipeline::transformToScreen( QPolygonF &result, const QgsRenderContext &context, bool ring )
+{
+  const int nPoints = mX.size();
+  double *x = mX.data();
+  double *y = mY.data();
+
+  QElapsedTimer timer;
+  if ( mCollectStatistics )
+    timer.start();
+
+  const QgsCoordinateTransform &ct = context.coordinateTransform();
+  if ( ct.isValid() && !ct.isShortCircuited() )
+  {
+    mZ.resize( nPoints );
+    std::fill( mZ.begin(), mZ.end(), 0.0 );
+    ct.transformCoords( nPoints, x, y, mZ.data() );
+
+    if ( mCollectStatistics )
+    {
+      mStatistics.transformTime += timer.nsecsElapsed();
+      timer.restart();
+    }
+  }
+
+  // The map to pixel transform is affine, apply its coefficients directly
+  QTransform matrix = context.mapToPixel().transform();
+  if ( !matrix.isInvertible() )
+  {
+    // QgsMapToPixel keeps its last valid matrix in that case
+    const QgsMapToPixel &mtp = context.mapToPixel();
+    for ( int i = 0; i < nPoints; ++i )
+      mtp.transformInPlace( x[i], y[i] );
+    matrix = QTransform();
+  }
+  const double m11 = matrix.m11();
+  const double m12 = matrix.m12();
+  const double m21 = matrix.m21();
+  const double m22 = matrix.m22();
+  const double dx = matrix.dx();
+  const double dy = matrix.dy();
+
+  double tolerance = 0;
+  if ( simplifiesInPixelSpace( context ) )
+    tolerance = context.vectorSimplifyMethod().threshold();
+  const double sqrTolerance = tolerance * tolerance;
+
+  result.resize( nPoints );
+  QPointF *out = result.data();
+  int count = 0;
+  double xMin = std::numeric_limits<double>::max();
+  double yMin = std::numeric_limits<double>::max();
+  double xMax = std::numeric_limits<double>::lowest();
+  double yMax = std::numeric_limits<double>::lowest();
+  for ( int i = 0; i < nPoints; ++i )
+  {
+    const double px = m11 * x[i] + m21 * y[i] + dx;
+    const double py = m12 * x[i] + m22 * y[i] + dy;
+
+    if ( sqrTolerance > 0 )
+    {
+      xMin = std::min( xMin, px );
+      yMin = std::min( yMin, py );
+      xMax = std::max( xMax, px );
+      yMax = std::max( yMax, py );
+
+      // drop the vertices too close to the last kept one, but always keep the end points
+      if ( count > 0 && i < nPoints - 1 )
+      {
+        const double deltaX = px - out[count - 1].x();
+        const double deltaY = py - out[count - 1].y();
+        if ( deltaX * deltaX + deltaY * deltaY < sqrTolerance )
+          continue;
+      }
+    }
+    out[count++] = QPointF( px, py );
+  }
+
+  if ( ring && sqrTolerance > 0 && nPoints > 0 && count < 4 )
+  {
+    // the ring collapsed, draw its bounding box like the map to pixel simplifier does
+    result.resize( 5 );
+    out = result.data();
+    out[0] = QPointF( xMin, yMin );
+    out[1] = QPointF( xMax, yMin );
+    out[2] = QPointF( xMax, yMax );
+    out[3] = QPointF( xMin, yMax );
+    out[4] = QPointF( xMin, yMin );
+  }
+  else
+  {
+    result.resize( count );
+  }
+
+  if ( mCollectStatistics )
+  {
+    mStatistics.mapToPixelTime += timer.nsecsElapsed();
+    mStatistics.outputVertices += result.size();
+  }
+}
@@ -0,0 +1,125 @@
+/***************************************************************************
+    qgssymbolgeometrypipeline.h
+    ---------------------
+    begin                : October 2017
+    copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSSYMBOLGEOMETRYPIPELINE_H
+#define QGSSYMBOLGEOMETRYPIPELINE_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+
+#include <QPolygonF>
+#include <QVector>
+
+class QgsCurve;
+class QgsRenderContext;
+
+/** \ingroup core
+ * \brief Converts the curves of the rendered features to screen coordinates.
+ *
+ * Clipping to the (extended) extent, coordinate transform, simplification
+ * and map to pixel transform are done in a single sweep over scratch
+ * buffers which are reused from feature to feature. When local
+ * simplification with the distance algorithm is requested, it is done here
+ * in pixel space instead of simplifying the geometry in map units before
+ * rendering, and interior rings smaller than the tolerance are dropped
+ * before any other work.
+ *
+ * There is one pipeline per thread, see instance().
+ *
+ * \since QGIS 3.0
+ * \note not available in Python bindings
+ */
+class CORE_EXPORT QgsSymbolGeometryPipeline
+{
+  public:
+
+    //! Statistics of the pipeline, times are in nanoseconds
+    struct Statistics
+    {
+      //! Time spent loading and clipping the curves
+      qint64 clipTime = 0;
+      //! Time spent in the coordinate transform
+      qint64 transformTime = 0;
+      //! Time spent in the map to pixel transform and the simplification
+      qint64 mapToPixelTime = 0;
+      //! Number of input vertices
+      qint64 inputVertices = 0;
+      //! Number of output vertices
+      qint64 outputVertices = 0;
+      //! Number of rings dropped because they are smaller than the simplification tolerance
+      int droppedRings = 0;
+    };
+
+    //! Returns the pipeline of the current thread
+    static QgsSymbolGeometryPipeline &instance();
+
+    /** Returns true if the simplification requested by the render context
+     * is done in pixel space by the pipeline, in that case the geometry must
+     * not be simplified beforehand.
+     */
+    static bool simplifiesInPixelSpace( const QgsRenderContext &context );
+
+    /** Converts a line string to screen coordinates.
+     * \param result the screen coordinates
+     * \param context the render context
+     * \param curve the line string in layer coordinates
+     * \param clipToExtent clip the line to the extended extent of the context
+     * \throws QgsCsException if the coordinate transform fails
+     */
+    void lineString( QPolygonF &result, const QgsRenderContext &context, const QgsCurve &curve, bool clipToExtent );
+
+    /** Converts a polygon ring to screen coordinates.
+     * \param result the screen coordinates, empty if the ring was dropped
+     * \param context the render context
+     * \param curve the ring in layer coordinates
+     * \param clipToExtent clip the ring to the extended extent of the context
+     * \param exteriorRing true for an exterior ring, interior rings may be dropped
+     * \throws QgsCsException if the coordinate transform fails
+     */
+    void polygonRing( QPolygonF &result, const QgsRenderContext &context, const QgsCurve &curve, bool clipToExtent, bool exteriorRing );
+
+    //! Enables collection of the statistics, including stage timing
+    void setCollectStatistics( bool collect ) { mCollectStatistics = collect; }
+
+    //! Returns true if statistics are collected
+    bool collectStatistics() const { return mCollectStatistics; }
+
+    //! Returns the statistics collected since the last call to resetStatistics()
+    Statistics statistics() const { return mStatistics; }
+
+    //! Resets the statistics
+    void resetStatistics() { mStatistics = Statistics(); }
+
+  private:
+
+    //! Loads the coordinates of a curve into the scratch buffers
+    void load( const QgsCurve &curve );
+
+    //! Loads the coordinates of a polygon into the scratch buffers
+    void load( const QPolygonF &polygon );
+
+    /** Transforms the scratch buffers to screen coordinates into result,
+     * dropping the vertices closer than the simplification tolerance */
+    void transformToScreen( QPolygonF &result, const QgsRenderContext &context, bool ring );
+
+    QVector<double> mX;
+    QVector<double> mY;
+    QVector<double> mZ;
+
+    bool mCollectStatistics = false;
+    Statistics mStatistics;
+};
+
+#endif // QGSSYMBOLGEOMETRYPIPELINE_H
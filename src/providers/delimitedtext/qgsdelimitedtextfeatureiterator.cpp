@@ -519,15 +519,19 @@ QgsDelimitedTextFeatureSource::QgsDelimitedTextFeatureSource( const QgsDelimited
   , mCrs( p->mCrs )
 {
   QUrl url = p->mFile->url();
+  bool watchFile = false;
 
   // make sure watcher not created when using iterator (e.g. for rendering, see issue #15558)
   if ( url.hasQueryItem( QStringLiteral( "watchFile" ) ) )
   {
+    watchFile = url.queryItemValue( QStringLiteral( "watchFile" ) ).toUpper().startsWith( 'Y' );
     url.removeQueryItem( QStringLiteral( "watchFile" ) );
   }
 
   mFile.reset( new QgsDelimitedTextFile() );
   mFile->setFromUrl( url );
+  // the line offsets of a watched file would be stale once it is rewritten, it is read as a stream
+  mFile->setUseBlockReads( !watchFile );
 
   mExpressionContext << QgsExpressionContextUtils::globalScope()
                      << QgsExpressionContextUtils::projectScope( QgsProject::instance() );
@@ -28,6 +28,34 @@
 #include <QStringList>
 #include <QRegExp>
 #include <QUrl>
+#include <QThread>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <cstring>
+
+///@cond PRIVATE
+namespace
+{
+  //! Count of lines between two entries of the line offset index
+  const int LINE_OFFSET_STEP = 64;
+
+  //! Size of the blocks read from files, and scanned by each thread when building the line offset index
+  const qint64 BLOCK_SIZE = 4 * 1024 * 1024;
+
+  //! Block of a file scanned for line ends
+  struct FileChunk
+  {
+    //! Offset of the block in the file
+    qint64 begin;
+    QByteArray data;
+    //! Count of line ends in the block
+    qint64 lineEnds;
+    //! Count of line ends before the block
+    qint64 lineEndsBefore;
+  };
+}
+///@endcond
 
 
 QgsDelimitedTextFile::QgsDelimitedTextFile( const QString &url )
@@ -78,6 +106,11 @@ void QgsDelimitedTextFile::close()
     delete mFile;
     mFile = nullptr;
   }
+  mBlockReads = false;
+  mBlockBuffer.clear();
+  mBlockPos = 0;
+  mBlockStart = 0;
+  mLineOffsets.clear();
   if ( mWatcher )
   {
     delete mWatcher;
@@ -102,7 +135,7 @@ bool QgsDelimitedTextFile::open()
       delete mFile;
       mFile = nullptr;
     }
-    if ( mFile )
+    if ( mFile && ! openBlockReads() )
     {
       mStream = new QTextStream( mFile );
       if ( ! mEncoding.isEmpty() )
@@ -110,6 +143,9 @@ bool QgsDelimitedTextFile::open()
         QTextCodec *codec =  QTextCodec::codecForName( mEncoding.toLatin1() );
         mStream->setCodec( codec );
       }
+    }
+    if ( mFile )
+    {
       if ( mUseWatcher )
       {
         mWatcher = new QFileSystemWatcher();
@@ -326,6 +362,12 @@ void QgsDelimitedTextFile::setUseWatcher( bool useWatcher )
   mUseWatcher = useWatcher;
 }
 
+void QgsDelimitedTextFile::setUseBlockReads( bool useBlockReads )
+{
+  resetDefinition();
+  mUseBlockReads = useBlockReads;
+}
+
 QString QgsDelimitedTextFile::type()
 {
   if ( mType == DelimTypeWhitespace ) return QStringLiteral( "whitespace" );
@@ -555,16 +597,14 @@ QgsDelimitedTextFile::Status  QgsDelimitedTextFile::reset()
   if ( ! isValid() || ! open() ) return InvalidDefinition;
 
   // Reset the file pointer
-  mStream->seek( 0 );
-  mLineNumber = 0;
-  mRecordNumber = -1;
+  rewind();
   mRecordLineNumber = -1;
 
   // Skip header lines
+  QString buffer;
   for ( int i = mSkipLines; i-- > 0; )
   {
-    if ( mStream->readLine().isNull() ) return RecordEOF;
-    mLineNumber++;
+    if ( nextLine( buffer, false ) != RecordOk ) return RecordEOF;
   }
   // Read the column names
   Status result = RecordOk;
@@ -580,12 +620,51 @@ QgsDelimitedTextFile::Status  QgsDelimitedTextFile::reset()
 
 QgsDelimitedTextFile::Status QgsDelimitedTextFile::nextLine( QString &buffer, bool skipBlank )
 {
-  if ( ! mStream )
+  if ( ! mFile )
   {
     Status status = reset();
     if ( status != RecordOk ) return status;
   }
 
+  if ( mBlockReads )
+  {
+    bool atEnd = false;
+    for ( ;; )
+    {
+      const char *line = mBlockBuffer.constData() + mBlockPos;
+      const char *bufferEnd = mBlockBuffer.constData() + mBlockBuffer.size();
+      const char *lineEnd = static_cast<const char *>( std::memchr( line, '\n', bufferEnd - line ) );
+      int nextPos;
+      if ( lineEnd )
+      {
+        nextPos = lineEnd - mBlockBuffer.constData() + 1;
+        // Same line ends as QTextStream::readLine, "\n" or "\r\n"
+        if ( lineEnd > line && lineEnd[-1] == '\r' ) lineEnd--;
+      }
+      else if ( ! atEnd )
+      {
+        // The line continues in the next block, a file truncated meanwhile just ends
+        atEnd = ! readBlock();
+        continue;
+      }
+      else if ( line < bufferEnd )
+      {
+        // Last line, without line end
+        lineEnd = bufferEnd;
+        nextPos = mBlockBuffer.size();
+      }
+      else
+      {
+        return RecordEOF;
+      }
+      buffer = QString::fromUtf8( line, lineEnd - line );
+      mBlockPos = nextPos;
+      mLineNumber++;
+      if ( skipBlank && buffer.isEmpty() ) continue;
+      return RecordOk;
+    }
+  }
+
   while ( ! mStream->atEnd() )
   {
     buffer = mStream->readLine();
@@ -601,12 +680,19 @@ QgsDelimitedTextFile::Status QgsDelimitedTextFile::nextLine( QString &buffer, bo
 
 bool QgsDelimitedTextFile::setNextLineNumber( long nextLineNumber )
 {
-  if ( ! mStream ) return false;
-  if ( mLineNumber > nextLineNumber - 1 )
+  if ( ! mFile ) return false;
+  if ( mBlockReads && ( mLineNumber > nextLineNumber - 1 || mLineNumber < nextLineNumber - 1 - LINE_OFFSET_STEP ) )
   {
+    // Jump to the closest indexed line before the requested one
+    if ( mLineOffsets.isEmpty() ) buildLineOffsets();
+    const int offsetIndex = std::min( std::max( nextLineNumber - 1, 0L ) / LINE_OFFSET_STEP, static_cast<long>( mLineOffsets.size() - 1 ) );
     mRecordNumber = -1;
-    mStream->seek( 0 );
-    mLineNumber = 0;
+    seekBlocks( mLineOffsets.at( offsetIndex ) );
+    mLineNumber = static_cast<long>( offsetIndex ) * LINE_OFFSET_STEP;
+  }
+  else if ( mLineNumber > nextLineNumber - 1 )
+  {
+    rewind();
   }
   QString buffer;
   while ( mLineNumber < nextLineNumber - 1 )
@@ -617,6 +703,124 @@ bool QgsDelimitedTextFile::setNextLineNumber( long nextLineNumber )
 
 }
 
+bool QgsDelimitedTextFile::openBlockReads()
+{
+  // The index of watched files would be stale once they change
+  if ( mUseWatcher || ! mUseBlockReads ) return false;
+
+  // Only UTF-8 can be decoded line by line from the raw bytes
+  QTextCodec *codec = QTextCodec::codecForName( mEncoding.toLatin1() );
+  if ( ! codec || codec->mibEnum() != 106 ) return false;
+
+  // A UTF-16 byte order mark would have the stream override the encoding
+  const QByteArray start = mFile->peek( 3 );
+  if ( start.startsWith( "\xff\xfe" ) || start.startsWith( "\xfe\xff" ) ) return false;
+
+  // The file is read with QFile rather than mapped in memory: reading the pages
+  // of a mapped file truncated by another process would crash
+  mBlockReads = true;
+  mBlockStart = start.startsWith( "\xef\xbb\xbf" ) ? 3 : 0;
+  mLineOffsets.clear();
+  seekBlocks( mBlockStart );
+  return true;
+}
+
+bool QgsDelimitedTextFile::readBlock()
+{
+  mBlockBuffer.remove( 0, mBlockPos );
+  mBlockPos = 0;
+  const int size = mBlockBuffer.size();
+  mBlockBuffer.resize( size + BLOCK_SIZE );
+  const qint64 read = mFile->read( mBlockBuffer.data() + size, BLOCK_SIZE );
+  mBlockBuffer.resize( size + static_cast<int>( std::max( read, Q_INT64_C( 0 ) ) ) );
+  return read > 0;
+}
+
+void QgsDelimitedTextFile::seekBlocks( qint64 offset )
+{
+  mFile->seek( offset );
+  mBlockBuffer.clear();
+  mBlockPos = 0;
+}
+
+void QgsDelimitedTextFile::rewind()
+{
+  if ( mBlockReads )
+    seekBlocks( mBlockStart );
+  else
+    mStream->seek( 0 );
+  mLineNumber = 0;
+  mRecordNumber = -1;
+}
+
+void QgsDelimitedTextFile::buildLineOffsets()
+{
+  // The blocks are read by batches of one block per thread, which are then scanned in parallel
+  const int batchSize = std::max( QThread::idealThreadCount(), 1 );
+
+  QVector<qint64> offsets;
+  offsets << mBlockStart;
+  qint64 lineEnds = 0;
+  mFile->seek( mBlockStart );
+  for ( bool atEnd = false; ! atEnd; )
+  {
+    QVector<FileChunk> chunks;
+    while ( chunks.size() < batchSize )
+    {
+      FileChunk chunk;
+      chunk.begin = mFile->pos();
+      chunk.data = mFile->read( BLOCK_SIZE );
+      chunk.lineEnds = 0;
+      chunk.lineEndsBefore = 0;
+      if ( chunk.data.isEmpty() )
+      {
+        atEnd = true;
+        break;
+      }
+      chunks << chunk;
+    }
+
+    // First count the line ends of each block...
+    QtConcurrent::blockingMap( chunks, []( FileChunk & chunk )
+    {
+      const char *p = chunk.data.constData();
+      const char *end = p + chunk.data.size();
+      while ( ( p = static_cast<const char *>( std::memchr( p, '\n', end - p ) ) ) )
+      {
+        chunk.lineEnds++;
+        p++;
+      }
+    } );
+
+    for ( FileChunk &chunk : chunks )
+    {
+      chunk.lineEndsBefore = lineEnds;
+      lineEnds += chunk.lineEnds;
+    }
+
+    // ... then each block knows the numbers of its lines and stores the offsets of
+    // the indexed ones. A line end at the end of the file does not start a line,
+    // its offset is the end of the file.
+    offsets.resize( static_cast<int>( lineEnds / LINE_OFFSET_STEP + 1 ) );
+    qint64 *offsetData = offsets.data();
+    QtConcurrent::blockingMap( chunks, [offsetData]( const FileChunk & chunk )
+    {
+      qint64 line = chunk.lineEndsBefore;
+      const char *data = chunk.data.constData();
+      const char *p = data;
+      const char *end = data + chunk.data.size();
+      while ( ( p = static_cast<const char *>( std::memchr( p, '\n', end - p ) ) ) )
+      {
+        line++;
+        p++;
+        if ( line % LINE_OFFSET_STEP == 0 ) offsetData[line / LINE_OFFSET_STEP] = chunk.begin + ( p - data );
+      }
+    } );
+  }
+
+  mLineOffsets = offsets;
+}
+
 void QgsDelimitedTextFile::appendField( QStringList &record, QString field, bool quoted )
 {
   if ( mMaxFields > 0 && record.size() >= mMaxFields ) return;
@@ -18,8 +18,10 @@
 #ifndef QGSDELIMITEDTEXTFILE_H
 #define QGSDELIMITEDTEXTFILE_H
 
+#include <QByteArray>
 #include <QStringList>
 #include <QRegExp>
+#include <QVector>
 #include <QUrl>
 #include <QObject>
 
@@ -306,6 +308,13 @@ class QgsDelimitedTextFile : public QObject
 
     void setUseWatcher( bool useWatcher );
 
+    /** Set to read UTF-8 files in raw blocks, whose line offsets are indexed,
+     *  or as a text stream. The index of files which may be rewritten while
+     *  they are read would be stale, they must be read as a stream.
+     * \param useBlockReads True to read the file in blocks, false to read it as a stream
+     */
+    void setUseBlockReads( bool useBlockReads );
+
   signals:
 
     /** Signal sent when the file is updated by another process
@@ -350,6 +359,31 @@ class QgsDelimitedTextFile : public QObject
      */
     bool setNextLineNumber( long nextLineNumber );
 
+    /** Reads UTF-8 files in raw blocks, without a text stream, so that
+     *  the lines can be located from the line offset index.
+     *  \returns blocks True if the file is read in blocks
+     */
+    bool openBlockReads();
+
+    /** Reads the next block of the file at the end of the buffer, dropping
+     *  the lines already read from the buffer.
+     *  \returns read False at the end of the file
+     */
+    bool readBlock();
+
+    /** Moves the file read in blocks to \a offset, which must be the start of a line
+     */
+    void seekBlocks( qint64 offset );
+
+    /** Rewinds the file to the start of the first line
+     */
+    void rewind();
+
+    /** Builds the index of the offsets of the lines of the file read in blocks,
+     *  the blocks are scanned in parallel.
+     */
+    void buildLineOffsets();
+
     /** Utility routine to add a field to a record, accounting for trimming
      *  and discarding, and maximum field count
      */
@@ -363,6 +397,18 @@ class QgsDelimitedTextFile : public QObject
     QFile *mFile = nullptr;
     QTextStream *mStream = nullptr;
     bool mUseWatcher;
+    bool mUseBlockReads = true;
+
+    // True if the file is read in blocks, in which case there is no stream
+    bool mBlockReads = false;
+    // Blocks read from the file, from the start of the next line to read
+    QByteArray mBlockBuffer;
+    // Offset in the buffer of the next line to read
+    int mBlockPos = 0;
+    // Offset of the first line, after any byte order mark
+    qint64 mBlockStart = 0;
+    // Offsets of every LINE_OFFSET_STEP'th line of the file read in blocks, built on the first seek
+    QVector<qint64> mLineOffsets;
     QFileSystemWatcher *mWatcher = nullptr;
 
     // Parameters common to parsers
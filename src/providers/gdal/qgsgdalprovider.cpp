@@ -46,6 +46,12 @@
 #include <QTime>
 #include <QTextDocument>
 #include <QDebug>
+#include <QThread>
+#include <QtConcurrentMap>
+#include <QtConcurrentRun>
+
+#include <algorithm>
+#include <cmath>
 
 #include <gdalwarper.h>
 #include <ogr_spatialref.h>
@@ -58,6 +64,13 @@
 static QString PROVIDER_KEY = QStringLiteral( "gdal" );
 static QString PROVIDER_DESCRIPTION = QStringLiteral( "GDAL provider" );
 
+// maximum number of dataset handles used by parallel reads
+static const int MAX_READ_WORKERS = 8;
+// windows with less pixels are read with a single RasterIO call
+static const int PARALLEL_READ_MIN_PIXELS = 256 * 256;
+// minimum number of source rows of the strips decoded by a worker
+static const int READ_STRIP_MIN_ROWS = 128;
+
 struct QgsGdalProgress
 {
   int type;
@@ -191,12 +204,29 @@ QgsGdalProvider::QgsGdalProvider( const QString &uri, bool update )
 
   QgsDebugMsg( "GdalDataset opened" );
   initBaseDataset();
+
+  QgsSettings s;
+  bool parallelRead = s.value( QStringLiteral( "qgis/gdalParallelRead" ), true ).toBool();
+
+  // in-memory datasets cannot be opened a second time
+  if ( mGdalDataset && qstrcmp( GDALGetDriverShortName( GDALGetDatasetDriver( mGdalDataset ) ), "MEM" ) == 0 )
+    parallelRead = false;
+
+  const int workerCount = std::min( QThread::idealThreadCount(), MAX_READ_WORKERS );
+  if ( parallelRead && workerCount > 1 )
+  {
+    mParallelReader = std::make_shared< QgsGdalParallelReader >( gdalUri.toUtf8(), workerCount,
+                      s.value( QStringLiteral( "qgis/gdalReadAhead" ), false ).toBool() );
+  }
 }
 
 QgsGdalProvider *QgsGdalProvider::clone() const
 {
   QgsGdalProvider *provider = new QgsGdalProvider( dataSourceUri() );
   provider->copyBaseSettings( *this );
+  // renders work on clones, they share the handles, block caches and statistics of the layer provider
+  if ( mParallelReader && provider->mParallelReader )
+    provider->mParallelReader = mParallelReader;
   return provider;
 }
 
@@ -260,6 +290,9 @@ void QgsGdalProvider::closeDataset()
   }
   mValid = false;
 
+  if ( mParallelReader )
+    mParallelReader->closeDatasets();
+
   GDALDereferenceDataset( mGdalBaseDataset );
   mGdalBaseDataset = nullptr;
 
@@ -388,6 +421,21 @@ QString QgsGdalProvider::metadata()
     myMetadata += QLatin1String( "</p>\n" );
   }
 
+  if ( mParallelReader )
+  {
+    const QgsGdalParallelReader::Statistics &statistics = mParallelReader->statistics;
+    myMetadata += QLatin1String( "<p class=\"glossy\">" );
+    myMetadata += tr( "Read statistics" );
+    myMetadata += QLatin1String( "</p>\n" );
+    myMetadata += QLatin1String( "<p>" );
+    myMetadata += tr( "Reads: %1 (%2 in parallel)" ).arg( statistics.reads.load() ).arg( statistics.parallelReads.load() );
+    myMetadata += QLatin1String( "<br>" );
+    myMetadata += tr( "Blocks read in parallel: %1 (estimated block cache hits: %2)" ).arg( statistics.blocks.load() ).arg( statistics.estimatedBlockCacheHits.load() );
+    myMetadata += QLatin1String( "<br>" );
+    myMetadata += tr( "Blocks read ahead: %1" ).arg( statistics.readAheadBlocks.load() );
+    myMetadata += QLatin1String( "</p>\n" );
+  }
+
   return myMetadata;
 }
 
@@ -603,19 +651,8 @@ void QgsGdalProvider::readBlock( int bandNo, QgsRectangle  const &extent, int pi
     QgsDebugMsg( QString( "Couldn't allocate temporary buffer of %1 bytes" ).arg( dataSize * tmpWidth * tmpHeight ) );
     return;
   }
-  GDALRasterBandH gdalBand = getBand( bandNo );
-  GDALDataType type = ( GDALDataType )mGdalDataType.at( bandNo - 1 );
-  CPLErrorReset();
-
-  CPLErr err = gdalRasterIO( gdalBand, GF_Read,
-                             srcLeft, srcTop, srcWidth, srcHeight,
-                             ( void * )tmpBlock,
-                             tmpWidth, tmpHeight, type,
-                             0, 0, feedback );
-
-  if ( err != CPLE_None )
+  if ( !readWindow( bandNo, srcLeft, srcTop, srcWidth, srcHeight, tmpBlock, tmpWidth, tmpHeight, feedback ) )
   {
-    QgsLogger::warning( "RasterIO error: " + QString::fromUtf8( CPLGetLastErrorMsg() ) );
     qgsFree( tmpBlock );
     return;
   }
@@ -657,6 +694,280 @@ void QgsGdalProvider::readBlock( int bandNo, QgsRectangle  const &extent, int pi
   qgsFree( tmpBlock );
 }
 
+bool QgsGdalProvider::readWindow( int bandNo, int srcLeft, int srcTop, int srcWidth, int srcHeight,
+                                  char *buffer, int bufWidth, int bufHeight, QgsRasterBlockFeedback *feedback )
+{
+  GDALDataType type = ( GDALDataType )mGdalDataType.at( bandNo - 1 );
+
+  if ( mParallelReader )
+  {
+    mParallelReader->statistics.reads.ref();
+
+    QgsGdalParallelReader::Raster raster;
+    raster.xSize = xSize();
+    raster.ySize = ySize();
+    raster.xBlockSize = mXBlockSize;
+    raster.yBlockSize = mYBlockSize;
+    raster.hasPyramids = mHasPyramids;
+    raster.maskBandExposedAsAlpha = mMaskBandExposedAsAlpha;
+
+    if ( canReadInParallel()
+         && static_cast<qint64>( bufWidth ) * bufHeight >= PARALLEL_READ_MIN_PIXELS
+         && srcHeight > QgsGdalParallelReader::stripRows( raster ) )
+    {
+      return mParallelReader->read( raster, bandNo, type, srcLeft, srcTop, srcWidth, srcHeight, buffer, bufWidth, bufHeight, feedback );
+    }
+  }
+
+  GDALRasterBandH gdalBand = getBand( bandNo );
+  CPLErrorReset();
+
+  CPLErr err = gdalRasterIO( gdalBand, GF_Read,
+                             srcLeft, srcTop, srcWidth, srcHeight,
+                             ( void * )buffer,
+                             bufWidth, bufHeight, type,
+                             0, 0, feedback );
+
+  if ( err != CPLE_None )
+  {
+    QgsLogger::warning( "RasterIO error: " + QString::fromUtf8( CPLGetLastErrorMsg() ) );
+    return false;
+  }
+  return true;
+}
+
+bool QgsGdalProvider::canReadInParallel() const
+{
+  // the handles of the parallel reader would not see the changes done in update mode,
+  // and warped VRTs only exist in memory
+  return mParallelReader && !mUpdate && mGdalDataset == mGdalBaseDataset;
+}
+
+QgsGdalParallelReader::QgsGdalParallelReader( const QByteArray &uri, int workerCount, bool readAhead )
+  : mUri( uri )
+  , mReadAhead( readAhead )
+{
+  for ( int i = 0; i < workerCount; ++i )
+    mWorkers.emplace_back( new Worker() );
+}
+
+QgsGdalParallelReader::~QgsGdalParallelReader()
+{
+  closeDatasets();
+}
+
+int QgsGdalParallelReader::stripRows( const Raster &raster )
+{
+  const int blockRows = std::max( 1, raster.yBlockSize );
+  return blockRows * ( ( READ_STRIP_MIN_ROWS + blockRows - 1 ) / blockRows );
+}
+
+bool QgsGdalParallelReader::read( const Raster &raster, int bandNo, GDALDataType type, int srcLeft, int srcTop, int srcWidth, int srcHeight,
+                                  char *buffer, int bufWidth, int bufHeight, QgsRasterBlockFeedback *feedback )
+{
+  statistics.parallelReads.ref();
+  if ( !readStrips( raster, bandNo, type, srcLeft, srcTop, srcWidth, srcHeight, buffer, bufWidth, bufHeight, feedback, false ) )
+    return false;
+
+  if ( mReadAhead && !( feedback && feedback->isCanceled() ) )
+    startReadAhead( raster, bandNo, type, srcLeft, srcTop, srcWidth, srcHeight, bufWidth, bufHeight );
+  return true;
+}
+
+bool QgsGdalParallelReader::readStrips( const Raster &raster, int bandNo, GDALDataType type, int srcLeft, int srcTop, int srcWidth, int srcHeight,
+                                        char *buffer, int bufWidth, int bufHeight, QgsRasterBlockFeedback *feedback, bool readAhead )
+{
+  struct Strip
+  {
+    int bufTop;
+    int bufHeight;
+  };
+  struct WorkerStrips
+  {
+    int worker;
+    QList<Strip> strips;
+  };
+
+  const int rows = stripRows( raster );
+  const double xRatio = static_cast<double>( srcWidth ) / bufWidth;
+  const double yRatio = static_cast<double>( srcHeight ) / bufHeight;
+
+  // Split the buffer rows according to the strip of the source row they sample
+  // (nearest neighbour as done by RasterIO). Strips are assigned to the workers
+  // according to their position in the raster, so that the same blocks are
+  // decoded by the same handle and may be found in its block cache.
+  QVector<WorkerStrips> workerStrips( static_cast<int>( mWorkers.size() ) );
+  for ( int i = 0; i < workerStrips.size(); ++i )
+    workerStrips[i].worker = i;
+
+  int bufTop = 0;
+  while ( bufTop < bufHeight )
+  {
+    const int srcRow = srcTop + static_cast<int>( ( bufTop + 0.5 ) * yRatio );
+    const int stripIndex = srcRow / rows;
+    // first buffer row sampling the next strip
+    const int bufBottom = qBound( bufTop + 1, static_cast<int>( std::ceil( ( ( stripIndex + 1 ) * rows - srcTop ) / yRatio - 0.5 ) ), bufHeight );
+
+    Strip strip;
+    strip.bufTop = bufTop;
+    strip.bufHeight = bufBottom - bufTop;
+    workerStrips[ stripIndex % workerStrips.size()].strips << strip;
+    bufTop = bufBottom;
+  }
+
+  QVector<WorkerStrips> tasks;
+  Q_FOREACH ( const WorkerStrips &w, workerStrips )
+  {
+    if ( !w.strips.isEmpty() )
+      tasks << w;
+  }
+
+  // blocks of the level of overviews likely used by GDAL, for the statistics
+  int level = 0;
+  if ( raster.hasPyramids )
+  {
+    for ( double ratio = std::min( xRatio, yRatio ); ratio >= 2 && level < 16; ratio /= 2 )
+      ++level;
+  }
+  const qint64 blockWidth = static_cast<qint64>( std::max( 1, raster.xBlockSize ) ) << level;
+  const qint64 blockHeight = static_cast<qint64>( std::max( 1, raster.yBlockSize ) ) << level;
+
+  const int dataSize = GDALGetDataTypeSize( type ) / 8;
+  QAtomicInt failures;
+
+  auto readTask = [ &, this ]( WorkerStrips & task )
+  {
+    Worker &worker = *mWorkers[ task.worker ];
+    QMutexLocker locker( &worker.mutex );
+    if ( !worker.dataset )
+    {
+      worker.dataset = QgsGdalProviderBase::gdalOpen( mUri.constData(), GA_ReadOnly );
+      if ( !worker.dataset )
+      {
+        QgsLogger::warning( "Cannot open GDAL dataset for parallel read: " + QString::fromUtf8( CPLGetLastErrorMsg() ) );
+        failures.ref();
+        return;
+      }
+    }
+    GDALRasterBandH band = raster.maskBandExposedAsAlpha && bandNo == GDALGetRasterCount( worker.dataset ) + 1
+                           ? GDALGetMaskBand( GDALGetRasterBand( worker.dataset, 1 ) )
+                           : GDALGetRasterBand( worker.dataset, bandNo );
+
+    int blocks = 0;
+    int hits = 0;
+    Q_FOREACH ( const Strip &strip, task.strips )
+    {
+      if ( failures.load() || ( feedback && feedback->isCanceled() ) )
+        break;
+
+      // the floating point window keeps the sampling of the whole window
+      GDALRasterIOExtraArg extra;
+      INIT_RASTERIO_EXTRA_ARG( extra );
+      extra.bFloatingPointWindowValidity = TRUE;
+      extra.dfXOff = srcLeft;
+      extra.dfXSize = srcWidth;
+      extra.dfYOff = srcTop + strip.bufTop * yRatio;
+      extra.dfYSize = strip.bufHeight * yRatio;
+
+      const int yOff = std::max( srcTop, static_cast<int>( std::floor( extra.dfYOff ) ) );
+      const int yEnd = std::min( srcTop + srcHeight, static_cast<int>( std::ceil( extra.dfYOff + extra.dfYSize ) ) );
+
+      if ( worker.decodedBlocks.size() > 65536 )
+        worker.decodedBlocks.clear();
+      for ( qint64 row = yOff / blockHeight; row <= ( yEnd - 1 ) / blockHeight; ++row )
+      {
+        for ( qint64 col = srcLeft / blockWidth; col <= ( srcLeft + srcWidth - 1 ) / blockWidth; ++col )
+        {
+          const qint64 key = ( static_cast<qint64>( bandNo ) << 56 ) | ( static_cast<qint64>( level ) << 48 ) | ( row << 24 ) | col;
+          if ( worker.decodedBlocks.contains( key ) )
+            hits++;
+          else
+            worker.decodedBlocks.insert( key );
+          blocks++;
+        }
+      }
+
+      CPLErr err = GDALRasterIOEx( band, GF_Read, srcLeft, yOff, srcWidth, yEnd - yOff,
+                                   buffer + static_cast<qint64>( dataSize ) * strip.bufTop * bufWidth,
+                                   bufWidth, strip.bufHeight, type, 0, 0, &extra );
+      if ( err != CE_None )
+      {
+        QgsLogger::warning( "RasterIO error: " + QString::fromUtf8( CPLGetLastErrorMsg() ) );
+        failures.ref();
+        break;
+      }
+    }
+
+    if ( readAhead )
+    {
+      statistics.readAheadBlocks.fetchAndAddRelaxed( blocks );
+    }
+    else
+    {
+      statistics.blocks.fetchAndAddRelaxed( blocks );
+      statistics.estimatedBlockCacheHits.fetchAndAddRelaxed( hits );
+    }
+  };
+
+  QtConcurrent::blockingMap( tasks, readTask );
+
+  return failures.load() == 0;
+}
+
+void QgsGdalParallelReader::startReadAhead( const Raster &raster, int bandNo, GDALDataType type, int srcLeft, int srcTop, int srcWidth, int srcHeight,
+    int bufWidth, int bufHeight )
+{
+  // do not pile up read-ahead requests if the previous one is still running
+  if ( mRunningReadAheads.load() > 0 )
+    return;
+
+  const double xRatio = static_cast<double>( srcWidth ) / bufWidth;
+  const double yRatio = static_cast<double>( srcHeight ) / bufHeight;
+  const int marginRows = stripRows( raster );
+  const int marginCols = std::max( raster.xBlockSize, srcWidth / 4 );
+
+  // a strip above and below, a quarter of the window on each side
+  QList<QRect> windows;
+  windows << QRect( srcLeft, srcTop - marginRows, srcWidth, marginRows )
+          << QRect( srcLeft, srcTop + srcHeight, srcWidth, marginRows )
+          << QRect( srcLeft - marginCols, srcTop, marginCols, srcHeight )
+          << QRect( srcLeft + srcWidth, srcTop, marginCols, srcHeight );
+
+  const QRect rasterRect( 0, 0, raster.xSize, raster.ySize );
+  const int dataSize = GDALGetDataTypeSize( type ) / 8;
+
+  // the task keeps the reader alive, the provider which started it may be a clone deleted meanwhile
+  std::shared_ptr< QgsGdalParallelReader > reader = shared_from_this();
+  mRunningReadAheads.ref();
+  QtConcurrent::run( [ = ]
+  {
+    Q_FOREACH ( const QRect &window, windows )
+    {
+      const QRect rect = window.intersected( rasterRect );
+      if ( rect.isEmpty() )
+        continue;
+
+      const int width = std::max( 1, static_cast<int>( std::round( rect.width() / xRatio ) ) );
+      const int height = std::max( 1, static_cast<int>( std::round( rect.height() / yRatio ) ) );
+      QByteArray data( dataSize * width * height, Qt::Uninitialized );
+      reader->readStrips( raster, bandNo, type, rect.x(), rect.y(), rect.width(), rect.height(), data.data(), width, height, nullptr, true );
+    }
+    reader->mRunningReadAheads.deref();
+  } );
+}
+
+void QgsGdalParallelReader::closeDatasets()
+{
+  for ( const std::unique_ptr< Worker > &worker : mWorkers )
+  {
+    QMutexLocker locker( &worker->mutex );
+    if ( worker->dataset )
+      GDALClose( worker->dataset );
+    worker->dataset = nullptr;
+    worker->decodedBlocks.clear();
+  }
+}
+
 //void * QgsGdalProvider::readBlock( int bandNo, QgsRectangle  const & extent, int width, int height )
 //{
 //  return 0;
@@ -1481,6 +1792,10 @@ QString QgsGdalProvider::buildPyramids( const QList<QgsRasterPyramid> &rasterPyr
     return QStringLiteral( "ERROR_VIRTUAL" );
   }
 
+  // the handles of the parallel reads must be reopened to see the new overviews
+  if ( mParallelReader )
+    mParallelReader->closeDatasets();
+
   // check if building internally
   if ( format == QgsRaster::PyramidsInternal )
   {
@@ -32,6 +32,12 @@
 #include <QDomElement>
 #include <QMap>
 #include <QVector>
+#include <QMutex>
+#include <QSet>
+#include <QAtomicInt>
+
+#include <memory>
+#include <vector>
 
 class QgsRasterPyramid;
 
@@ -45,6 +51,96 @@ int CPL_STDCALL progressCallback( double dfComplete,
 
 class QgsCoordinateTransform;
 
+/**
+ * Decodes large windows of a GDAL dataset in parallel strips of block rows. Each strip
+ * is always decoded with the same read only handle on the dataset, so that its blocks
+ * are found in the block cache of this handle when they are read again.
+ *
+ * A reader is shared by a provider and its clones, so that the handles, the blocks
+ * read ahead and the statistics outlive the clones used by each render.
+ */
+class QgsGdalParallelReader : public std::enable_shared_from_this< QgsGdalParallelReader >
+{
+  public:
+
+    //! Properties of the raster needed to read it
+    struct Raster
+    {
+      int xSize = 0;
+      int ySize = 0;
+      int xBlockSize = 0;
+      int yBlockSize = 0;
+      bool hasPyramids = false;
+      bool maskBandExposedAsAlpha = false;
+    };
+
+    //! Statistics of the reads, shown in the metadata
+    struct Statistics
+    {
+      QAtomicInt reads;
+      QAtomicInt parallelReads;
+      QAtomicInt blocks;
+
+      /**
+       * Blocks of the parallel reads which the same worker handle already read
+       * earlier. This estimates the GDAL block cache hits, GDAL does not report them.
+       */
+      QAtomicInt estimatedBlockCacheHits;
+      QAtomicInt readAheadBlocks;
+    };
+
+    /**
+     * Constructor for QgsGdalParallelReader, opening up to \a workerCount handles
+     * on the dataset at \a uri.
+     */
+    QgsGdalParallelReader( const QByteArray &uri, int workerCount, bool readAhead );
+
+    ~QgsGdalParallelReader();
+
+    //! Number of source rows of the strips of a \a raster, a multiple of the block height
+    static int stripRows( const Raster &raster );
+
+    /**
+     * Reads a window of a band into a buffer, resampling it with nearest neighbour
+     * if the buffer size differs from the window size. When read-ahead is enabled,
+     * the blocks around the window are then decoded in the background.
+     */
+    bool read( const Raster &raster, int bandNo, GDALDataType type, int srcLeft, int srcTop, int srcWidth, int srcHeight,
+               char *buffer, int bufWidth, int bufHeight, QgsRasterBlockFeedback *feedback );
+
+    //! Closes the dataset handles, the next reads open them again
+    void closeDatasets();
+
+    Statistics statistics;
+
+  private:
+
+    //! Read only handle on the dataset, a GDAL dataset must not be used by several threads at the same time
+    struct Worker
+    {
+      QMutex mutex;
+      GDALDatasetH dataset = nullptr;
+
+      //! Blocks decoded with this handle, which may still be in its GDAL block cache
+      QSet<qint64> decodedBlocks;
+    };
+
+    //! Reads a window, each strip being decoded by the handle owning it
+    bool readStrips( const Raster &raster, int bandNo, GDALDataType type, int srcLeft, int srcTop, int srcWidth, int srcHeight,
+                     char *buffer, int bufWidth, int bufHeight, QgsRasterBlockFeedback *feedback, bool readAhead );
+
+    //! Decodes in the background the blocks around a window
+    void startReadAhead( const Raster &raster, int bandNo, GDALDataType type, int srcLeft, int srcTop, int srcWidth, int srcHeight,
+                         int bufWidth, int bufHeight );
+
+    QByteArray mUri;
+    bool mReadAhead = false;
+    std::vector< std::unique_ptr< Worker > > mWorkers;
+
+    //! Number of read-ahead tasks running
+    QAtomicInt mRunningReadAheads;
+};
+
 /**
 
   \brief Data provider for GDAL layers.
@@ -214,6 +310,20 @@ class QgsGdalProvider : public QgsRasterDataProvider, QgsGdalProviderBase
 
     //! Wrapper for GDALGetRasterBand() that takes into account mMaskBandExposedAsAlpha.
     GDALRasterBandH getBand( int bandNo ) const;
+
+    /**
+     * Reads a window of the raster into a buffer, resampling it with nearest
+     * neighbour if the buffer size differs from the window size. Large windows
+     * are decoded in parallel.
+     */
+    bool readWindow( int bandNo, int srcLeft, int srcTop, int srcWidth, int srcHeight,
+                     char *buffer, int bufWidth, int bufHeight, QgsRasterBlockFeedback *feedback );
+
+    //! Returns true if reads can be split over the handles of the parallel reader
+    bool canReadInParallel() const;
+
+    //! Parallel reader, shared with the clones of the provider. Null if parallel reads are disabled.
+    std::shared_ptr< QgsGdalParallelReader > mParallelReader;
 };
 
 #endif
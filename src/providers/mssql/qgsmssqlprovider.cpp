@@ -46,6 +46,8 @@
 
 #include "qgsmssqldataitems.h"
 #include "qgsmssqlfeatureiterator.h"
+#include "qgsmssqlexpressioncompiler.h"
+#include "qgssqlaggregatecompiler.h"
 
 #ifdef HAVE_GUI
 #include "qgsmssqlsourceselect.h"
@@ -656,6 +658,90 @@ QSet<QVariant> QgsMssqlProvider::uniqueValues( int index, int limit ) const
   return uniqueValues;
 }
 
+///@cond PRIVATE
+namespace
+{
+  //! Aggregates in the Transact-SQL dialect
+  class QgsMssqlAggregateCompiler : public QgsSqlAggregateCompiler
+  {
+    public:
+      explicit QgsMssqlAggregateCompiler( const QgsMssqlProvider *provider )
+        : mProvider( provider )
+      {}
+
+    protected:
+      QString quotedIdentifier( const QString &identifier ) const override
+      {
+        return QStringLiteral( "[%1]" ).arg( identifier );
+      }
+
+      QString aggregateFunction( QgsAggregateCalculator::Aggregate aggregate, const QString &column ) const override
+      {
+        // sums and averages of integer columns are integers, which may overflow or be truncated
+        const QString real = QStringLiteral( "CAST(%1 AS FLOAT)" ).arg( column );
+        switch ( aggregate )
+        {
+          case QgsAggregateCalculator::Sum:
+          case QgsAggregateCalculator::Mean:
+          case QgsAggregateCalculator::Range:
+            return QgsSqlAggregateCompiler::aggregateFunction( aggregate, real );
+          case QgsAggregateCalculator::StDev:
+            return QStringLiteral( "stdevp(%1)" ).arg( real );
+          case QgsAggregateCalculator::StDevSample:
+            return QStringLiteral( "stdev(%1)" ).arg( real );
+          default:
+            // the median is only available as a window function
+            return QgsSqlAggregateCompiler::aggregateFunction( aggregate, column );
+        }
+      }
+
+      QString castToReal( const QString &value ) const override
+      {
+        return QStringLiteral( "CAST(%1 AS FLOAT)" ).arg( value );
+      }
+
+      QgsSqlExpressionCompiler *createExpressionCompiler() const override
+      {
+        QgsMssqlFeatureSource source( mProvider );
+        return new QgsMssqlExpressionCompiler( &source );
+      }
+
+    private:
+      const QgsMssqlProvider *mProvider = nullptr;
+  };
+}
+///@endcond
+
+QVariant QgsMssqlProvider::aggregate( QgsAggregateCalculator::Aggregate aggregate, int index, const QgsAggregateCalculator::AggregateParameters &parameters,
+                                     QgsExpressionContext *context, bool &ok ) const
+{
+  Q_UNUSED( context );
+  ok = false;
+
+  if ( !mValid || index < 0 || index >= mAttributeFields.count() )
+    return QVariant();
+
+  QgsMssqlAggregateCompiler compiler( this );
+  const QString sql = compiler.compile( aggregate, mAttributeFields.at( index ), QStringLiteral( "[%1].[%2]" ).arg( mSchemaName, mTableName ),
+                                        mSqlWhereClause, parameters );
+  if ( sql.isEmpty() )
+    return QVariant();
+
+  QSqlQuery query = QSqlQuery( mDatabase );
+  query.setForwardOnly( true );
+
+  if ( !query.exec( sql ) || !query.next() )
+  {
+    QgsDebugMsg( QString( "Failed to calculate aggregate: %1 (%2)" ).arg( sql, query.lastError().text() ) );
+    return QVariant();
+  }
+
+  ok = true;
+  if ( query.isNull( 0 ) )
+    return QVariant();
+  return query.value( 0 ).toDouble();
+}
+
 
 // update the extent, wkb type and srid for this layer
 void QgsMssqlProvider::UpdateStatistics( bool estimate ) const
@@ -23,6 +23,8 @@ email                : sherman at mrcc.com
 #include "qgslocalec.h"
 #include "qgsfeedback.h"
 #include "qgssettings.h"
+#include "qgssqlaggregatecompiler.h"
+#include "qgssqliteexpressioncompiler.h"
 #include "qgsapplication.h"
 #include "qgsdataitem.h"
 #include "qgsdataprovider.h"
@@ -1211,11 +1213,15 @@ OGRGeometryH QgsOgrProvider::ConvertGeometryIfNecessary( OGRGeometryH hGeom )
   return OGR_G_ForceTo( hGeom, layerGeomType, nullptr );
 }
 
-bool QgsOgrProvider::addFeaturePrivate( QgsFeature &f, Flags flags )
+bool QgsOgrProvider::addFeaturePrivate( QgsFeature &f, Flags flags, OGRFeatureH feature )
 {
   bool returnValue = true;
   OGRFeatureDefnH fdef = OGR_L_GetLayerDefn( ogrLayer );
-  OGRFeatureH feature = OGR_F_Create( fdef );
+
+  // the OGR feature is shared by all the features of a batch, clear what
+  // the previous feature left in it
+  OGR_F_SetFID( feature, OGRNullFID );
+  OGR_F_SetGeometryDirectly( feature, nullptr );
 
   if ( f.hasGeometry() )
   {
@@ -1257,10 +1263,12 @@ bool QgsOgrProvider::addFeaturePrivate( QgsFeature &f, Flags flags )
   }
 
   //add possible attribute information
-  for ( int ogrAttId = 0; qgisAttId < attrs.count(); ++qgisAttId, ++ogrAttId )
+  const int ogrFieldCount = OGR_FD_GetFieldCount( fdef );
+  int ogrAttId = 0;
+  for ( ; qgisAttId < attrs.count(); ++qgisAttId, ++ogrAttId )
   {
     // don't try to set field from attribute map if it's not present in layer
-    if ( ogrAttId >= OGR_FD_GetFieldCount( fdef ) )
+    if ( ogrAttId >= ogrFieldCount )
       continue;
 
     //if(!s.isEmpty())
@@ -1341,10 +1349,13 @@ bool QgsOgrProvider::addFeaturePrivate( QgsFeature &f, Flags flags )
 
         default:
           QgsMessageLog::logMessage( tr( "type %1 for attribute %2 not found" ).arg( type ).arg( qgisAttId ), tr( "OGR" ) );
+          OGR_F_UnsetField( feature, ogrAttId );
           break;
       }
     }
   }
+  for ( ; ogrAttId < ogrFieldCount; ++ogrAttId )
+    OGR_F_UnsetField( feature, ogrAttId );
 
   if ( OGR_L_CreateFeature( ogrLayer, feature ) != OGRERR_NONE )
   {
@@ -1364,7 +1375,6 @@ bool QgsOgrProvider::addFeaturePrivate( QgsFeature &f, Flags flags )
       }
     }
   }
-  OGR_F_Destroy( feature );
 
   return returnValue;
 }
@@ -1379,15 +1389,20 @@ bool QgsOgrProvider::addFeatures( QgsFeatureList &flist, Flags flags )
 
   const bool inTransaction = startTransaction();
 
+  // a single OGR feature is filled for each of the features
+  OGRFeatureH feature = OGR_F_Create( OGR_L_GetLayerDefn( ogrLayer ) );
+
   bool returnvalue = true;
   for ( QgsFeatureList::iterator it = flist.begin(); it != flist.end(); ++it )
   {
-    if ( !addFeaturePrivate( *it, flags ) )
+    if ( !addFeaturePrivate( *it, flags, feature ) )
     {
       returnvalue = false;
     }
   }
 
+  OGR_F_Destroy( feature );
+
   if ( inTransaction )
   {
     commitTransaction();
@@ -3137,6 +3152,88 @@ QVariant QgsOgrProvider::maximumValue( int index ) const
   return value;
 }
 
+///@cond PRIVATE
+namespace
+{
+  //! Aggregates in the SQLite dialect of the GeoPackage and SQLite drivers
+  class QgsOgrAggregateCompiler : public QgsSqlAggregateCompiler
+  {
+    public:
+      QgsOgrAggregateCompiler( const QgsFields &fields, QTextCodec *encoding, const QString &driverName )
+        : mFields( fields )
+        , mEncoding( encoding )
+        , mDriverName( driverName )
+      {}
+
+    protected:
+      QString quotedIdentifier( const QString &identifier ) const override
+      {
+        return mEncoding->toUnicode( QgsOgrProviderUtils::quotedIdentifier( mEncoding->fromUnicode( identifier ), mDriverName ) );
+      }
+
+      QString aggregateFunction( QgsAggregateCalculator::Aggregate aggregate, const QString &column ) const override
+      {
+        // total() is the sum as a real value, 0 for no values
+        if ( aggregate == QgsAggregateCalculator::Sum )
+          return QStringLiteral( "total(%1)" ).arg( column );
+        return QgsSqlAggregateCompiler::aggregateFunction( aggregate, column );
+      }
+
+      QgsSqlExpressionCompiler *createExpressionCompiler() const override
+      {
+        return new QgsSQLiteExpressionCompiler( mFields );
+      }
+
+    private:
+      QgsFields mFields;
+      QTextCodec *mEncoding = nullptr;
+      QString mDriverName;
+  };
+}
+///@endcond
+
+QVariant QgsOgrProvider::aggregate( QgsAggregateCalculator::Aggregate aggregate, int index, const QgsAggregateCalculator::AggregateParameters &parameters,
+                                   QgsExpressionContext *context, bool &ok ) const
+{
+  Q_UNUSED( context );
+  ok = false;
+
+  // only the SQLite based drivers run the SQL natively, OGR SQL would read all the features anyway,
+  // and a subset string which is a whole SELECT statement can not be used as WHERE clause
+  if ( !mValid || index < 0 || index >= mAttributeFields.count() ||
+       ( ogrDriverName != QLatin1String( "GPKG" ) && ogrDriverName != QLatin1String( "SQLite" ) ) ||
+       mSubsetString.startsWith( QLatin1String( "SELECT " ), Qt::CaseInsensitive ) )
+  {
+    return QVariant();
+  }
+
+  QgsOgrAggregateCompiler compiler( mAttributeFields, textEncoding(), ogrDriverName );
+  const QString from = textEncoding()->toUnicode( quotedIdentifier( OGR_FD_GetName( OGR_L_GetLayerDefn( ogrLayer ) ) ) );
+  const QString statement = compiler.compile( aggregate, mAttributeFields.at( index ), from, mSubsetString, parameters );
+  if ( statement.isEmpty() )
+    return QVariant();
+
+  const QByteArray sql = textEncoding()->fromUnicode( statement );
+  OGRLayerH l = OGR_DS_ExecuteSQL( ogrDataSource, sql.constData(), nullptr, nullptr );
+  if ( !l )
+  {
+    QgsDebugMsg( QString( "Failed to execute SQL: %1" ).arg( textEncoding()->toUnicode( sql ) ) );
+    return QVariant();
+  }
+
+  QVariant value;
+  OGRFeatureH f = OGR_L_GetNextFeature( l );
+  if ( f )
+  {
+    ok = true;
+    if ( OGR_F_IsFieldSetAndNotNull( f, 0 ) )
+      value = OGR_F_GetFieldAsDouble( f, 0 );
+    OGR_F_Destroy( f );
+  }
+  OGR_DS_ReleaseResultSet( ogrDataSource, l );
+  return value;
+}
+
 QByteArray QgsOgrProvider::quotedIdentifier( const QByteArray &field ) const
 {
   return QgsOgrProviderUtils::quotedIdentifier( field, ogrDriverName );
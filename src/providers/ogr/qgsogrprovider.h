@@ -106,6 +106,8 @@ class QgsOgrProvider : public QgsVectorDataProvider
     virtual QSet< QVariant > uniqueValues( int index, int limit = -1 ) const override;
     virtual QStringList uniqueStringsMatching( int index, const QString &substring, int limit = -1,
         QgsFeedback *feedback = nullptr ) const override;
+    QVariant aggregate( QgsAggregateCalculator::Aggregate aggregate, int index, const QgsAggregateCalculator::AggregateParameters &parameters,
+                        QgsExpressionContext *context, bool &ok ) const override;
 
     QString name() const override;
     QString description() const override;
@@ -225,7 +227,8 @@ class QgsOgrProvider : public QgsVectorDataProvider
 
     mutable QStringList mSubLayerList;
 
-    bool addFeaturePrivate( QgsFeature &f, QgsFeatureSink::Flags flags );
+    //! Adds a feature, \a feature is the OGR feature to fill and write, reused for all the features of a batch
+    bool addFeaturePrivate( QgsFeature &f, QgsFeatureSink::Flags flags, OGRFeatureH feature );
     //! Deletes one feature
     bool deleteFeature( QgsFeatureId id );
 
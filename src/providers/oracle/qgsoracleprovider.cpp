@@ -29,6 +29,8 @@
 #include "qgsoracletablemodel.h"
 #include "qgsoracledataitems.h"
 #include "qgsoraclefeatureiterator.h"
+#include "qgsoracleexpressioncompiler.h"
+#include "qgssqlaggregatecompiler.h"
 #include "qgsoracleconnpool.h"
 
 #ifdef HAVE_GUI
@@ -1100,6 +1102,79 @@ QSet<QVariant> QgsOracleProvider::uniqueValues( int index, int limit ) const
   return uniqueValues;
 }
 
+///@cond PRIVATE
+namespace
+{
+  //! Aggregates in the Oracle dialect
+  class QgsOracleAggregateCompiler : public QgsSqlAggregateCompiler
+  {
+    public:
+      explicit QgsOracleAggregateCompiler( const QgsOracleProvider *provider )
+        : mProvider( provider )
+      {}
+
+    protected:
+      QString quotedIdentifier( const QString &identifier ) const override
+      {
+        return QgsOracleConn::quotedIdentifier( identifier );
+      }
+
+      QString aggregateFunction( QgsAggregateCalculator::Aggregate aggregate, const QString &column ) const override
+      {
+        switch ( aggregate )
+        {
+          case QgsAggregateCalculator::StDev:
+            return QStringLiteral( "stddev_pop(%1)" ).arg( column );
+          case QgsAggregateCalculator::StDevSample:
+            return QStringLiteral( "stddev_samp(%1)" ).arg( column );
+          case QgsAggregateCalculator::Median:
+            return QStringLiteral( "median(%1)" ).arg( column );
+          default:
+            return QgsSqlAggregateCompiler::aggregateFunction( aggregate, column );
+        }
+      }
+
+      QgsSqlExpressionCompiler *createExpressionCompiler() const override
+      {
+        QgsOracleFeatureSource source( mProvider );
+        return new QgsOracleExpressionCompiler( &source );
+      }
+
+    private:
+      const QgsOracleProvider *mProvider = nullptr;
+  };
+}
+///@endcond
+
+QVariant QgsOracleProvider::aggregate( QgsAggregateCalculator::Aggregate aggregate, int index, const QgsAggregateCalculator::AggregateParameters &parameters,
+                                      QgsExpressionContext *context, bool &ok ) const
+{
+  Q_UNUSED( context );
+  ok = false;
+
+  if ( !mConnection || index < 0 || index >= mAttributeFields.count() )
+    return QVariant();
+
+  QgsOracleAggregateCompiler compiler( this );
+  const QString sql = compiler.compile( aggregate, mAttributeFields.at( index ), mQuery, mSqlWhereClause, parameters );
+  if ( sql.isEmpty() )
+    return QVariant();
+
+  QSqlQuery qry( *mConnection );
+  if ( !exec( qry, sql, QVariantList() ) || !qry.next() )
+  {
+    QgsMessageLog::logMessage( tr( "Unable to execute the query.\nThe error message from the database was:\n%1.\nSQL: %2" )
+                               .arg( qry.lastError().text() )
+                               .arg( qry.lastQuery() ), tr( "Oracle" ) );
+    return QVariant();
+  }
+
+  ok = true;
+  if ( qry.isNull( 0 ) )
+    return QVariant();
+  return qry.value( 0 ).toDouble();
+}
+
 // Returns the maximum value of an attribute
 QVariant QgsOracleProvider::maximumValue( int index ) const
 {
@@ -137,33 +137,36 @@ Oid QgsPostgresResult::PQoidValue()
 }
 
 
-QMap<QString, QgsPostgresConn *> QgsPostgresConn::sConnectionsRO;
-QMap<QString, QgsPostgresConn *> QgsPostgresConn::sConnectionsRW;
+QgsPostgresConn::SharedConnections QgsPostgresConn::sConnectionsRO;
+QgsPostgresConn::SharedConnections QgsPostgresConn::sConnectionsRW;
+QMutex QgsPostgresConn::sConnectionsLock;
 const int QgsPostgresConn::GEOM_TYPE_SELECT_LIMIT = 100;
 
 QgsPostgresConn *QgsPostgresConn::connectDb( const QString &conninfo, bool readonly, bool shared, bool transaction )
 {
-  QMap<QString, QgsPostgresConn *> &connections =
+  SharedConnections &connections =
     readonly ? QgsPostgresConn::sConnectionsRO : QgsPostgresConn::sConnectionsRW;
 
   // This is called from may places where shared parameter cannot be forced to false (QgsVectorLayerExporter)
-  // and which is run in a different thread (drag and drop in browser)
-  if ( QApplication::instance()->thread() != QThread::currentThread() )
+  // and which is run in a different thread (drag and drop in browser).
+  // Sharing connection between threads is not safe, see https://issues.qgis.org/issues/13141,
+  // but the providers of a lane created in advance are created one after the other, and
+  // are then handed over together to the thread they will live in
+  const int lane = QgsProviderRegistry::instance()->preparationLane();
+  if ( QApplication::instance()->thread() != QThread::currentThread() && lane == 0 )
   {
     shared = false;
   }
 
+  const QPair< int, QString > key( lane, conninfo );
   if ( shared )
   {
-    // sharing connection between threads is not safe
-    // See https://issues.qgis.org/issues/13141
-    Q_ASSERT( QApplication::instance()->thread() == QThread::currentThread() );
-
-    if ( connections.contains( conninfo ) )
+    QMutexLocker locker( &sConnectionsLock );
+    if ( connections.contains( key ) )
     {
       QgsDebugMsg( QString( "Using cached connection for %1" ).arg( conninfo ) );
-      connections[conninfo]->mRef++;
-      return connections[conninfo];
+      connections[key]->mRef++;
+      return connections[key];
     }
   }
 
@@ -177,7 +180,8 @@ QgsPostgresConn *QgsPostgresConn::connectDb( const QString &conninfo, bool reado
 
   if ( shared )
   {
-    connections.insert( conninfo, conn );
+    QMutexLocker locker( &sConnectionsLock );
+    connections.insert( key, conn );
   }
 
   return conn;
@@ -241,11 +245,16 @@ QgsPostgresConn::QgsPostgresConn( const QString &conninfo, bool readOnly, bool s
 
     QgsCredentials::instance()->lock();
 
+    const bool preparing = QgsProviderRegistry::instance()->preparationLane() != 0;
     int i = 0;
     while ( PQstatus() != CONNECTION_OK && i < 5 )
     {
       ++i;
-      bool ok = QgsCredentials::instance()->get( conninfo, username, password, PQerrorMessage() );
+      // in a lane of providers created in advance only cached credentials are tried once,
+      // requesting them would wait for the main thread, which waits for the lane
+      bool ok = !preparing
+                ? QgsCredentials::instance()->get( conninfo, username, password, PQerrorMessage() )
+                : i == 1 && QgsCredentials::instance()->getCached( conninfo, username, password );
       if ( !ok )
         break;
 
@@ -338,11 +347,12 @@ void QgsPostgresConn::unref()
 
   if ( mShared )
   {
-    QMap<QString, QgsPostgresConn *> &connections = mReadOnly ? sConnectionsRO : sConnectionsRW;
+    QMutexLocker locker( &sConnectionsLock );
+    SharedConnections &connections = mReadOnly ? sConnectionsRO : sConnectionsRW;
 
-    QString key = connections.key( this, QString() );
+    const QPair< int, QString > key = connections.key( this, qMakePair( -1, QString() ) );
 
-    Q_ASSERT( !key.isNull() );
+    Q_ASSERT( !key.second.isNull() );
     connections.remove( key );
   }
 
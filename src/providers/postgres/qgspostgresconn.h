@@ -187,9 +187,10 @@ class QgsPostgresConn : public QObject
 
   public:
     /*
-     * \param shared allow using a shared connection. Should never be
-     *        called from a thread other than the main one.
-     *        An assertion guards against such programmatic error.
+     * \param shared allow using a shared connection. Connections are only
+     *        shared on the main thread, and within a lane of providers created
+     *        in advance (see QgsProviderRegistry::beginPreparationLane()).
+     *        Elsewhere a new connection is always opened.
      */
     static QgsPostgresConn *connectDb( const QString &connInfo, bool readOnly, bool shared = true, bool transaction = false );
 
@@ -383,8 +384,13 @@ class QgsPostgresConn : public QObject
 
     bool mReadOnly;
 
-    static QMap<QString, QgsPostgresConn *> sConnectionsRW;
-    static QMap<QString, QgsPostgresConn *> sConnectionsRO;
+    //! Shared connections, by preparation lane (0 for the main thread) and connection info
+    typedef QMap< QPair< int, QString >, QgsPostgresConn * > SharedConnections;
+
+    static SharedConnections sConnectionsRW;
+    static SharedConnections sConnectionsRO;
+    //! Protects the shared connection maps, which lanes fill from worker threads
+    static QMutex sConnectionsLock;
 
     //! Count number of spatial columns in a given relation
     void addColumnInfo( QgsPostgresLayerProperty &layerProperty, const QString &schemaName, const QString &viewName, bool fetchPkCandidates );
@@ -34,6 +34,8 @@
 #include "qgspostgresconnpool.h"
 #include "qgspostgresdataitems.h"
 #include "qgspostgresfeatureiterator.h"
+#include "qgspostgresexpressioncompiler.h"
+#include "qgssqlaggregatecompiler.h"
 #include "qgspostgrestransaction.h"
 #include "qgslogger.h"
 #include "qgsfeedback.h"
@@ -1595,6 +1597,81 @@ QSet<QVariant> QgsPostgresProvider::uniqueValues( int index, int limit ) const
   return uniqueValues;
 }
 
+///@cond PRIVATE
+namespace
+{
+  //! Aggregates in the PostgreSQL dialect
+  class QgsPostgresAggregateCompiler : public QgsSqlAggregateCompiler
+  {
+    public:
+      QgsPostgresAggregateCompiler( const QgsPostgresProvider *provider, int pgVersion )
+        : mProvider( provider )
+        , mPgVersion( pgVersion )
+      {}
+
+    protected:
+      QString quotedIdentifier( const QString &identifier ) const override
+      {
+        return QgsPostgresConn::quotedIdentifier( identifier );
+      }
+
+      QString aggregateFunction( QgsAggregateCalculator::Aggregate aggregate, const QString &column ) const override
+      {
+        switch ( aggregate )
+        {
+          case QgsAggregateCalculator::StDev:
+            return QStringLiteral( "stddev_pop(%1)" ).arg( column );
+          case QgsAggregateCalculator::StDevSample:
+            return QStringLiteral( "stddev_samp(%1)" ).arg( column );
+          case QgsAggregateCalculator::Median:
+            if ( mPgVersion < 90400 )
+              return QString();
+            return QStringLiteral( "percentile_cont(0.5) WITHIN GROUP (ORDER BY %1)" ).arg( column );
+          default:
+            return QgsSqlAggregateCompiler::aggregateFunction( aggregate, column );
+        }
+      }
+
+      QgsSqlExpressionCompiler *createExpressionCompiler() const override
+      {
+        QgsPostgresFeatureSource source( mProvider );
+        return new QgsPostgresExpressionCompiler( &source );
+      }
+
+    private:
+      const QgsPostgresProvider *mProvider = nullptr;
+      int mPgVersion;
+  };
+}
+///@endcond
+
+QVariant QgsPostgresProvider::aggregate( QgsAggregateCalculator::Aggregate aggregate, int index, const QgsAggregateCalculator::AggregateParameters &parameters,
+                                        QgsExpressionContext *context, bool &ok ) const
+{
+  Q_UNUSED( context );
+  ok = false;
+
+  if ( index < 0 || index >= mAttributeFields.count() )
+    return QVariant();
+
+  QgsPostgresAggregateCompiler compiler( this, connectionRO()->pgVersion() );
+  const QString sql = compiler.compile( aggregate, field( index ), mQuery, mSqlWhereClause, parameters );
+  if ( sql.isEmpty() )
+    return QVariant();
+
+  QgsPostgresResult result( connectionRO()->PQexec( sql ) );
+  if ( result.PQresultStatus() != PGRES_TUPLES_OK || result.PQntuples() != 1 )
+  {
+    QgsDebugMsg( QString( "Failed to calculate aggregate: %1" ).arg( sql ) );
+    return QVariant();
+  }
+
+  ok = true;
+  if ( result.PQgetisnull( 0, 0 ) )
+    return QVariant();
+  return result.PQgetvalue( 0, 0 ).toDouble();
+}
+
 QStringList QgsPostgresProvider::uniqueStringsMatching( int index, const QString &substring, int limit, QgsFeedback *feedback ) const
 {
   QStringList results;
@@ -130,6 +130,8 @@ class QgsPostgresProvider : public QgsVectorDataProvider
     virtual QStringList uniqueStringsMatching( int index, const QString &substring, int limit = -1,
         QgsFeedback *feedback = nullptr ) const override;
     virtual void enumValues( int index, QStringList &enumList ) const override;
+    QVariant aggregate( QgsAggregateCalculator::Aggregate aggregate, int index, const QgsAggregateCalculator::AggregateParameters &parameters,
+                        QgsExpressionContext *context, bool &ok ) const override;
     bool isValid() const override;
     virtual bool isSaveAndLoadStyleToDatabaseSupported() const override { return true; }
     virtual bool isDeleteStyleFromDatabaseSupported() const override { return true; }
@@ -30,6 +30,8 @@ email                : a.furieri@lqt.it
 #include "qgsspatialiteconnpool.h"
 #include "qgsspatialitefeatureiterator.h"
 #include "qgsfeedback.h"
+#include "qgssqlaggregatecompiler.h"
+#include "qgssqliteexpressioncompiler.h"
 
 #include "qgsjsonutils.h"
 #include "qgsvectorlayer.h"
@@ -3582,6 +3584,81 @@ QVariant QgsSpatiaLiteProvider::minimumValue( int index ) const
   }
 }
 
+///@cond PRIVATE
+namespace
+{
+  //! Aggregates in the SQLite dialect, which has no standard deviation nor median
+  class QgsSpatiaLiteAggregateCompiler : public QgsSqlAggregateCompiler
+  {
+    public:
+      explicit QgsSpatiaLiteAggregateCompiler( const QgsFields &fields )
+        : mFields( fields )
+      {}
+
+    protected:
+      QString quotedIdentifier( const QString &identifier ) const override
+      {
+        return QgsSpatiaLiteProvider::quotedIdentifier( identifier );
+      }
+
+      QString aggregateFunction( QgsAggregateCalculator::Aggregate aggregate, const QString &column ) const override
+      {
+        // total() is the sum as a real value, 0 for no values
+        if ( aggregate == QgsAggregateCalculator::Sum )
+          return QStringLiteral( "total(%1)" ).arg( column );
+        return QgsSqlAggregateCompiler::aggregateFunction( aggregate, column );
+      }
+
+      QgsSqlExpressionCompiler *createExpressionCompiler() const override
+      {
+        return new QgsSQLiteExpressionCompiler( mFields );
+      }
+
+    private:
+      QgsFields mFields;
+  };
+}
+///@endcond
+
+QVariant QgsSpatiaLiteProvider::aggregate( QgsAggregateCalculator::Aggregate aggregate, int index, const QgsAggregateCalculator::AggregateParameters &parameters,
+    QgsExpressionContext *context, bool &ok ) const
+{
+  Q_UNUSED( context );
+  ok = false;
+
+  if ( index < 0 || index >= mAttributeFields.count() )
+    return QVariant();
+
+  QgsSpatiaLiteAggregateCompiler compiler( mAttributeFields );
+  const QString sql = compiler.compile( aggregate, mAttributeFields.at( index ), mQuery, mSubsetString, parameters );
+  if ( sql.isEmpty() )
+    return QVariant();
+
+  char **results = nullptr;
+  int rows;
+  int columns;
+  char *errMsg = nullptr;
+  int ret = sqlite3_get_table( mSqliteHandle, sql.toUtf8().constData(), &results, &rows, &columns, &errMsg );
+  if ( ret != SQLITE_OK )
+  {
+    QgsMessageLog::logMessage( tr( "SQLite error: %2\nSQL: %1" ).arg( sql, errMsg ? errMsg : tr( "unknown cause" ) ), tr( "SpatiaLite" ) );
+    if ( errMsg )
+    {
+      sqlite3_free( errMsg );
+    }
+    return QVariant();
+  }
+
+  QVariant value;
+  if ( rows == 1 && results[columns] )
+  {
+    value = QString::fromUtf8( results[columns] ).toDouble();
+  }
+  sqlite3_free_table( results );
+  ok = rows == 1;
+  return value;
+}
+
 // Returns the maximum value of an attribute
 QVariant QgsSpatiaLiteProvider::maximumValue( int index ) const
 {
@@ -99,6 +99,8 @@ class QgsSpatiaLiteProvider: public QgsVectorDataProvider
     virtual QSet<QVariant> uniqueValues( int index, int limit = -1 ) const override;
     virtual QStringList uniqueStringsMatching( int index, const QString &substring, int limit = -1,
         QgsFeedback *feedback = nullptr ) const override;
+    QVariant aggregate( QgsAggregateCalculator::Aggregate aggregate, int index, const QgsAggregateCalculator::AggregateParameters &parameters,
+                        QgsExpressionContext *context, bool &ok ) const override;
 
     bool isValid() const override;
     virtual bool isSaveAndLoadStyleToDatabaseSupported() const override { return true; }
@@ -18,6 +18,7 @@ email                : hugo dot mercier at oslandia dot com
 #include <iostream>
 #include <cstdint>
 #include <stdexcept>
+#include <algorithm>
 
 #include <QCoreApplication>
 #include <QBuffer>
@@ -36,6 +37,17 @@ email                : hugo dot mercier at oslandia dot com
 #include "qgsvirtuallayerblob.h"
 #include "qgsslottofunction.h"
 #include "qgsfeatureiterator.h"
+#include "qgsexpression.h"
+
+// rough fraction of the features matching a constraint, used to estimate the rows returned
+// by a scan so that SQLite can choose a good join order
+static const double EQUALITY_SELECTIVITY = 0.01;
+static const double RANGE_SELECTIVITY = 0.25;
+static const double LIKE_SELECTIVITY = 0.25;
+static const double RECTANGLE_SELECTIVITY = 0.05;
+
+// row count assumed when the provider does not know its feature count
+static const double UNKNOWN_FEATURE_COUNT = 100000;
 
 /**
  * Create metadata tables if needed
@@ -162,6 +174,25 @@ struct VTable
 
     QgsFields fields() const { return mFields; }
 
+    /**
+     * Feature count of the layer, -1 if unknown. SQLite asks for it many times while
+     * planning a statement, it is cached until a cursor is opened on the table.
+     */
+    long featureCount()
+    {
+      if ( !mValid )
+        return 0;
+      if ( !mFeatureCountCached )
+      {
+        mFeatureCount = mLayer ? mLayer->featureCount() : mProvider->featureCount();
+        mFeatureCountCached = true;
+      }
+      return mFeatureCount;
+    }
+
+    //! Drops the cached feature count, once the statement which was planned with it is run
+    void resetFeatureCount() { mFeatureCountCached = false; }
+
   private:
 
     VTable( const VTable &other );
@@ -191,6 +222,9 @@ struct VTable
 
     bool mValid;
 
+    long mFeatureCount = 0;
+    bool mFeatureCountCached = false;
+
     QgsFields mFields;
 
     void init_()
@@ -472,104 +506,136 @@ int vtableRename( sqlite3_vtab *vtab, const char *newName )
   return SQLITE_OK;
 }
 
+// The constraints pushed to the provider are described in idxStr, one line per argument
+// of vtableFilter: "F" for the primary key, "R" for the _search_frame_ rectangle and
+// "C <column> <op>" for a comparison. The first line lists the columns read by the
+// query, or is "*" when SQLite does not tell.
+static bool isPushableComparison( unsigned char op )
+{
+  switch ( op )
+  {
+    case SQLITE_INDEX_CONSTRAINT_EQ:
+    case SQLITE_INDEX_CONSTRAINT_GT:
+    case SQLITE_INDEX_CONSTRAINT_LE:
+    case SQLITE_INDEX_CONSTRAINT_LT:
+    case SQLITE_INDEX_CONSTRAINT_GE:
+#ifdef SQLITE_INDEX_CONSTRAINT_LIKE
+    case SQLITE_INDEX_CONSTRAINT_LIKE:
+#endif
+      return true;
+    default:
+      return false;
+  }
+}
+
 int vtableBestIndex( sqlite3_vtab *pvtab, sqlite3_index_info *indexInfo )
 {
   VTable *vtab = reinterpret_cast< VTable * >( pvtab );
+  const int fieldCount = vtab->fields().count();
+
+  double rows = vtab->featureCount();
+  if ( rows < 0 )
+    rows = UNKNOWN_FEATURE_COUNT;
+
+  QStringList plan;
+
+  // columns read by the query, the last bit of the mask stands for all the columns from the 63rd
+  QStringList columns;
+#if SQLITE_VERSION_NUMBER >= 3010000
+  if ( sqlite3_libversion_number() >= 3010000 )
+  {
+    for ( int column = 1; column <= fieldCount + 1; ++column )
+    {
+      if ( indexInfo->colUsed & ( static_cast< sqlite3_uint64 >( 1 ) << std::min( column, 63 ) ) )
+        columns << QString::number( column );
+    }
+    plan << columns.join( QStringLiteral( "," ) );
+  }
+  else
+#endif
+  {
+    plan << QStringLiteral( "*" );
+  }
+
+  // request for primary key filter with '=', nothing is more selective
+  int pkConstraint = -1;
   for ( int i = 0; i < indexInfo->nConstraint; i++ )
   {
-    // request for primary key filter with '='
     if ( ( indexInfo->aConstraint[i].usable ) &&
          ( vtab->pkColumn() == indexInfo->aConstraint[i].iColumn ) &&
          ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_EQ ) )
     {
-      indexInfo->aConstraintUsage[i].argvIndex = 1;
-      indexInfo->aConstraintUsage[i].omit = 1;
-      indexInfo->idxNum = 1; // PK filter
-      indexInfo->estimatedCost = 1.0;
-      indexInfo->idxStr = nullptr;
-      indexInfo->needToFreeIdxStr = 0;
-      return SQLITE_OK;
+      pkConstraint = i;
+      break;
     }
+  }
 
-    // request for filter with a comparison operator
-    if ( ( indexInfo->aConstraint[i].usable ) &&
-         ( indexInfo->aConstraint[i].iColumn > 0 ) &&
-         ( indexInfo->aConstraint[i].iColumn <= vtab->fields().count() ) &&
-         ( ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_EQ ) || // if no PK
-           ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_GT ) ||
-           ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_LE ) ||
-           ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_LT ) ||
-           ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_GE )
-#ifdef SQLITE_INDEX_CONSTRAINT_LIKE
-           || ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_LIKE )
-#endif
-         ) )
+  if ( pkConstraint >= 0 )
+  {
+    indexInfo->aConstraintUsage[pkConstraint].argvIndex = 1;
+    indexInfo->aConstraintUsage[pkConstraint].omit = 1;
+    plan << QStringLiteral( "F" );
+    rows = 1;
+  }
+  else
+  {
+    int argc = 0;
+    bool hasRectangle = false;
+    for ( int i = 0; i < indexInfo->nConstraint; i++ )
     {
-      indexInfo->aConstraintUsage[i].argvIndex = 1;
-      indexInfo->aConstraintUsage[i].omit = 1;
-      indexInfo->idxNum = 3; // expression filter
-      indexInfo->estimatedCost = 2.0; // probably better than no index
+      const int column = indexInfo->aConstraint[i].iColumn;
+      const unsigned char op = indexInfo->aConstraint[i].op;
+      if ( !indexInfo->aConstraint[i].usable )
+        continue;
 
-      QString expr = vtab->fields().at( indexInfo->aConstraint[i].iColumn - 1 ).name();
-      switch ( indexInfo->aConstraint[i].op )
+      if ( column == 0 && op == SQLITE_INDEX_CONSTRAINT_EQ && !hasRectangle )
       {
-        case SQLITE_INDEX_CONSTRAINT_EQ:
-          expr += QLatin1String( " = " );
-          break;
-        case SQLITE_INDEX_CONSTRAINT_GT:
-          expr += QLatin1String( " > " );
-          break;
-        case SQLITE_INDEX_CONSTRAINT_LE:
-          expr += QLatin1String( " <= " );
-          break;
-        case SQLITE_INDEX_CONSTRAINT_LT:
-          expr += QLatin1String( " < " );
-          break;
-        case SQLITE_INDEX_CONSTRAINT_GE:
-          expr += QLatin1String( " >= " );
-          break;
+        // rtree filtering, the _search_frame_ column cannot be tested by SQLite
+        indexInfo->aConstraintUsage[i].argvIndex = ++argc;
+        indexInfo->aConstraintUsage[i].omit = 1;
+        plan << QStringLiteral( "R" );
+        rows *= RECTANGLE_SELECTIVITY;
+        hasRectangle = true;
+      }
+      else if ( column > 0 && column <= fieldCount && isPushableComparison( op ) )
+      {
+        // the expression may match more features than SQLite (type conversions, case of LIKE),
+        // so SQLite checks the comparison again
+        indexInfo->aConstraintUsage[i].argvIndex = ++argc;
+        indexInfo->aConstraintUsage[i].omit = 0;
+        plan << QStringLiteral( "C %1 %2" ).arg( column ).arg( op );
+        if ( op == SQLITE_INDEX_CONSTRAINT_EQ )
+          rows *= EQUALITY_SELECTIVITY;
 #ifdef SQLITE_INDEX_CONSTRAINT_LIKE
-        case SQLITE_INDEX_CONSTRAINT_LIKE:
-          expr += QLatin1String( " LIKE " );
-          break;
+        else if ( op == SQLITE_INDEX_CONSTRAINT_LIKE )
+          rows *= LIKE_SELECTIVITY;
 #endif
-        default:
-          break;
+        else
+          rows *= RANGE_SELECTIVITY;
       }
-
-      QByteArray ba = expr.toUtf8();
-      char *cp = ( char * )sqlite3_malloc( ba.size() + 1 );
-      memcpy( cp, ba.constData(), ba.size() + 1 );
-
-      indexInfo->idxStr = cp;
-      indexInfo->needToFreeIdxStr = 1;
-      return SQLITE_OK;
-    }
-
-    // request for rtree filtering
-    if ( ( indexInfo->aConstraint[i].usable ) &&
-         ( 0 == indexInfo->aConstraint[i].iColumn ) &&
-         ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_EQ ) )
-    {
-      indexInfo->aConstraintUsage[i].argvIndex = 1;
-      // do not test for equality, since it is used for filtering, not to return an actual value
-      indexInfo->aConstraintUsage[i].omit = 1;
-      indexInfo->idxNum = 2; // RTree filter
-      indexInfo->estimatedCost = 1.0;
-      indexInfo->idxStr = nullptr;
-      indexInfo->needToFreeIdxStr = 0;
-      return SQLITE_OK;
     }
   }
+
+  rows = std::max( rows, 1.0 );
   indexInfo->idxNum = 0;
-  indexInfo->estimatedCost = 10.0;
-  indexInfo->idxStr = nullptr;
-  indexInfo->needToFreeIdxStr = 0;
+  indexInfo->estimatedCost = rows;
+#if SQLITE_VERSION_NUMBER >= 3008002
+  if ( sqlite3_libversion_number() >= 3008002 )
+    indexInfo->estimatedRows = static_cast< sqlite3_int64 >( rows );
+#endif
+
+  QByteArray ba = plan.join( QStringLiteral( "\n" ) ).toUtf8();
+  char *cp = ( char * )sqlite3_malloc( ba.size() + 1 );
+  memcpy( cp, ba.constData(), ba.size() + 1 );
+  indexInfo->idxStr = cp;
+  indexInfo->needToFreeIdxStr = 1;
   return SQLITE_OK;
 }
 
 int vtableOpen( sqlite3_vtab *vtab, sqlite3_vtab_cursor **outCursor )
 {
+  // the statement is planned, the layer may change before the next one
+  reinterpret_cast< VTable * >( vtab )->resetFeatureCount();
   VTableCursor *ncursor = new VTableCursor( reinterpret_cast< VTable * >( vtab ) );
   *outCursor = reinterpret_cast< sqlite3_vtab_cursor * >( ncursor );
   return SQLITE_OK;
@@ -584,55 +650,128 @@ int vtableClose( sqlite3_vtab_cursor *cursor )
   return SQLITE_OK;
 }
 
-int vtableFilter( sqlite3_vtab_cursor *cursor, int idxNum, const char *idxStr, int argc, sqlite3_value **argv )
+// Returns the expression comparing a field to a value, or an empty string if the
+// comparison cannot be done by the provider (SQLite still checks it)
+static QString comparisonExpression( const QString &fieldName, int op, sqlite3_value *value )
 {
-  Q_UNUSED( argc );
-  Q_UNUSED( idxStr );
-
-  QgsFeatureRequest request;
-  if ( idxNum == 1 )
+  QVariant v;
+  switch ( sqlite3_value_type( value ) )
   {
-    // id filter
-    request.setFilterFid( sqlite3_value_int( argv[0] ) );
+    case SQLITE_INTEGER:
+      v = static_cast< qlonglong >( sqlite3_value_int64( value ) );
+      break;
+    case SQLITE_FLOAT:
+      v = sqlite3_value_double( value );
+      break;
+    case SQLITE_TEXT:
+    {
+      int n = sqlite3_value_bytes( value );
+      const char *t = reinterpret_cast<const char *>( sqlite3_value_text( value ) );
+      v = QString::fromUtf8( t, n );
+      break;
+    }
+    case SQLITE_NULL:
+    case SQLITE_BLOB: // comparison to blob ignored
+    default:
+      return QString();
   }
-  else if ( idxNum == 2 )
+
+  QString opString;
+  switch ( op )
   {
-    // rtree filter
-    const char *blob = reinterpret_cast< const char * >( sqlite3_value_blob( argv[0] ) );
-    int bytes = sqlite3_value_bytes( argv[0] );
-    QgsRectangle r( spatialiteBlobBbox( blob, bytes ) );
-    request.setFilterRect( r );
+    case SQLITE_INDEX_CONSTRAINT_EQ:
+      opString = QStringLiteral( " = " );
+      break;
+    case SQLITE_INDEX_CONSTRAINT_GT:
+      opString = QStringLiteral( " > " );
+      break;
+    case SQLITE_INDEX_CONSTRAINT_LE:
+      opString = QStringLiteral( " <= " );
+      break;
+    case SQLITE_INDEX_CONSTRAINT_LT:
+      opString = QStringLiteral( " < " );
+      break;
+    case SQLITE_INDEX_CONSTRAINT_GE:
+      opString = QStringLiteral( " >= " );
+      break;
+#ifdef SQLITE_INDEX_CONSTRAINT_LIKE
+    case SQLITE_INDEX_CONSTRAINT_LIKE:
+      // SQLite LIKE is case insensitive and has no escape character
+      if ( v.toString().contains( '\\' ) )
+        return QString();
+      opString = QStringLiteral( " ILIKE " );
+      break;
+#endif
+    default:
+      return QString();
   }
-  else if ( idxNum == 3 )
+
+  return QgsExpression::quotedColumnRef( fieldName ) + opString + QgsExpression::quotedValue( v );
+}
+
+int vtableFilter( sqlite3_vtab_cursor *cursor, int idxNum, const char *idxStr, int argc, sqlite3_value **argv )
+{
+  Q_UNUSED( idxNum );
+
+  VTableCursor *c = reinterpret_cast<VTableCursor *>( cursor );
+  const QgsFields fields = c->mVtab->fields();
+  const QStringList plan = QString::fromUtf8( idxStr ).split( '\n' );
+
+  QgsFeatureRequest request;
+  QStringList expressions;
+  bool hasRectangle = false;
+  for ( int i = 0; i < argc && i + 1 < plan.size(); ++i )
   {
-    // comparison operator filter
-    // build an expression filter and rely on expression compiler if available
-    QString expr = idxStr;
-    switch ( sqlite3_value_type( argv[0] ) )
+    const QString &constraint = plan.at( i + 1 );
+    if ( constraint == QLatin1String( "F" ) )
     {
-      case SQLITE_INTEGER:
-        expr += QString::number( sqlite3_value_int64( argv[0] ) );
-        break;
-      case SQLITE_FLOAT:
-        expr += QString::number( sqlite3_value_double( argv[0] ) );
-        break;
-      case SQLITE_TEXT:
+      // id filter
+      request.setFilterFid( sqlite3_value_int64( argv[i] ) );
+    }
+    else if ( constraint == QLatin1String( "R" ) )
+    {
+      // rtree filter
+      const char *blob = reinterpret_cast< const char * >( sqlite3_value_blob( argv[i] ) );
+      int bytes = sqlite3_value_bytes( argv[i] );
+      QgsRectangle r( spatialiteBlobBbox( blob, bytes ) );
+      request.setFilterRect( r );
+      hasRectangle = true;
+    }
+    else
+    {
+      // comparison operator filter
+      // build an expression filter and rely on expression compiler if available
+      const QStringList parts = constraint.split( ' ' );
+      const int column = parts.value( 1 ).toInt();
+      if ( column > 0 && column <= fields.count() )
       {
-        int n = sqlite3_value_bytes( argv[0] );
-        const char *t = reinterpret_cast<const char *>( sqlite3_value_text( argv[0] ) );
-        QString str = QString::fromUtf8( t, n );
-        expr += "'" + str.replace( QLatin1String( "'" ), QLatin1String( "''" ) ) + "'";
-        break;
+        const QString expression = comparisonExpression( fields.at( column - 1 ).name(), parts.value( 2 ).toInt(), argv[i] );
+        if ( !expression.isEmpty() )
+          expressions << expression;
       }
-      case SQLITE_NULL:
-      case SQLITE_BLOB: // comparison to blob ignored
-      default:
-        expr += QLatin1String( " is null" );
-        break;
     }
-    request.setFilterExpression( expr );
   }
-  VTableCursor *c = reinterpret_cast<VTableCursor *>( cursor );
+  if ( !expressions.isEmpty() )
+    request.setFilterExpression( expressions.join( QStringLiteral( " AND " ) ) );
+
+  // only fetch the columns read by the query
+  if ( !plan.isEmpty() && plan.first() != QLatin1String( "*" ) )
+  {
+    QgsAttributeList attributes;
+    bool geometry = false;
+    Q_FOREACH ( const QString &column, plan.first().split( ',', QString::SkipEmptyParts ) )
+    {
+      const int index = column.toInt();
+      if ( index == fields.count() + 1 )
+        geometry = true;
+      else
+        attributes << index - 1;
+    }
+    request.setSubsetOfAttributes( attributes );
+    if ( !geometry && !hasRectangle )
+      request.setFlags( request.flags() | QgsFeatureRequest::NoGeometry );
+  }
+
   c->filter( request );
   return SQLITE_OK;
 }
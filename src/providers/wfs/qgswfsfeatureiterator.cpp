@@ -29,9 +29,79 @@
 #include "qgsexception.h"
 
 #include <QDir>
+#include <QFutureWatcher>
 #include <QProgressDialog>
 #include <QTimer>
 #include <QStyle>
+#include <QtConcurrentRun>
+
+#include <deque>
+#include <memory>
+
+///@cond PRIVATE
+namespace
+{
+  //! Features of a page of a GetFeature response, parsed in a worker thread
+  struct ParsedPage
+  {
+    QVector<QgsWFSFeatureGmlIdPair> features;
+    //! Whether some features had no gml:id
+    bool missingIds = false;
+    //! Empty if the page is valid
+    QString errorMessage;
+  };
+
+  //! Parses a complete GetFeature response and deletes the parser
+  ParsedPage parsePage( QgsGmlStreamingParser *parser, const QByteArray &data, bool swapAxes )
+  {
+    ParsedPage page;
+    QString errorMsg;
+    if ( !parser->processData( data, true, errorMsg ) )
+    {
+      page.errorMessage = errorMsg;
+    }
+    else if ( parser->isException() )
+    {
+      page.errorMessage = parser->exceptionText();
+    }
+
+    QVector<QgsGmlStreamingParser::QgsGmlFeaturePtrGmlIdPair> featurePtrList = parser->getAndStealReadyFeatures();
+    page.features.reserve( featurePtrList.size() );
+    for ( int i = 0; i < featurePtrList.size(); i++ )
+    {
+      QgsFeature &f = *( featurePtrList[i].first );
+      QString gmlId( featurePtrList[i].second );
+      if ( gmlId.isEmpty() )
+      {
+        gmlId = QgsWFSUtils::getMD5( f );
+        page.missingIds = true;
+      }
+      if ( swapAxes && f.hasGeometry() )
+      {
+        QgsGeometry g = f.geometry();
+        g.transform( QTransform( 0, 1, 1, 0, 0, 0 ) );
+        f.setGeometry( g );
+      }
+      page.features.push_back( QgsWFSFeatureGmlIdPair( f, gmlId ) );
+      delete featurePtrList[i].first;
+    }
+    delete parser;
+    return page;
+  }
+
+  //! Page requested by QgsWFSFeatureDownloader::downloadPagesInParallel()
+  struct PageDownload
+  {
+    explicit PageDownload( QgsWFSDataSourceURI &uri )
+      : request( uri )
+    {}
+
+    bool downloaded = false;
+    QgsWFSFeaturePageRequest request;
+    QFutureWatcher<ParsedPage> parsing;
+  };
+}
+///@endcond
 
 QgsWFSFeatureHitsAsyncRequest::QgsWFSFeatureHitsAsyncRequest( QgsWFSDataSourceURI &uri )
   : QgsWfsRequest( uri.uri() )
@@ -79,6 +149,26 @@ QString QgsWFSFeatureHitsAsyncRequest::errorMessageWithReason( const QString &re
 
 // -------------------------
 
+QgsWFSFeaturePageRequest::QgsWFSFeaturePageRequest( QgsWFSDataSourceURI &uri )
+  : QgsWfsRequest( uri.uri() )
+{
+}
+
+void QgsWFSFeaturePageRequest::launch( const QUrl &url )
+{
+  sendGET( url,
+           false, /* synchronous */
+           true, /* forceRefresh */
+           false /* cache */ );
+}
+
+QString QgsWFSFeaturePageRequest::errorMessageWithReason( const QString &reason )
+{
+  return tr( "Download of features failed: %1" ).arg( reason );
+}
+
+// -------------------------
+
 QgsWFSFeatureDownloader::QgsWFSFeatureDownloader( QgsWFSSharedData *shared )
   : QgsWfsRequest( shared->mURI.uri() )
   , mShared( shared )
@@ -433,6 +523,8 @@ void QgsWFSFeatureDownloader::run( bool serializeFeatures, int maxFeatures )
   bool truncatedResponse = false;
   QgsSettings s;
   const int maxRetry = s.value( QStringLiteral( "qgis/defaultTileMaxRetry" ), "3" ).toInt();
+  const int maxParallelRequests = s.value( QStringLiteral( "wfs/max_parallel_page_requests" ), "4" ).toInt();
+  int firstPageNumberMatched = -1;
   int retryIter = 0;
   int lastValidTotalDownloadedFeatureCount = 0;
   int pagingIter = 1;
@@ -668,6 +760,9 @@ void QgsWFSFeatureDownloader::run( bool serializeFeatures, int maxFeatures )
       }
     }
 
+    if ( success && pagingIter == 1 && parser->numberMatched() > 0 )
+      firstPageNumberMatched = parser->numberMatched();
+
     delete parser;
 
     if ( mStop )
@@ -705,6 +800,24 @@ void QgsWFSFeatureDownloader::run( bool serializeFeatures, int maxFeatures )
         mShared->mMaxFeatures = 0;
       }
     }
+
+    // Once two pages have shown that the server pages properly, the remaining
+    // pages of a result of known size are requested concurrently
+    const int numberMatched = firstPageNumberMatched > 0 ? firstPageNumberMatched : mNumberMatched;
+    if ( mSupportsPaging && pagingIter > 2 && maxFeatures == 0 && mShared->mMaxFeatures > 0 &&
+         maxParallelRequests > 1 && numberMatched > mTotalDownloadedFeatureCount )
+    {
+      const bool lastPage = downloadPagesInParallel( serializeFeatures, numberMatched, maxParallelRequests );
+      lastValidTotalDownloadedFeatureCount = mTotalDownloadedFeatureCount;
+      if ( mStop )
+      {
+        interrupted = true;
+        success = false;
+        break;
+      }
+      if ( lastPage )
+        break;
+    }
   }
 
   mStop = true;
@@ -741,6 +854,102 @@ QString QgsWFSFeatureDownloader::errorMessageWithReason( const QString &reason )
   return tr( "Download of features failed: %1" ).arg( reason );
 }
 
+bool QgsWFSFeatureDownloader::downloadPagesInParallel( bool serializeFeatures, int numberMatched, int maxParallelRequests )
+{
+  const int pageSize = mShared->mMaxFeatures;
+  const bool swapAxes = mShared->mGetFeatureEPSGDotHonoursEPSGOrder;
+
+  QEventLoop loop;
+  connect( this, &QgsWFSFeatureDownloader::doStop, &loop, &QEventLoop::quit );
+
+  // Pages being downloaded or parsed, in the order of their features. This
+  // bounds the memory used: a new page is only requested once the first one
+  // has been written to the cache.
+  std::deque< std::unique_ptr<PageDownload> > pages;
+  int nextStartIndex = mTotalDownloadedFeatureCount;
+  bool lastPage = false;
+  while ( !mStop )
+  {
+    while ( static_cast<int>( pages.size() ) < maxParallelRequests && nextStartIndex < numberMatched )
+    {
+      std::unique_ptr<PageDownload> page( new PageDownload( mShared->mURI ) );
+      PageDownload *pagePtr = page.get();
+      // Pages are parsed as soon as they are received, whatever their position in the queue
+      connect( &page->request, &QgsWfsRequest::downloadFinished, &loop, [this, pagePtr, swapAxes]
+      {
+        if ( pagePtr->request.errorCode() == NoError )
+          pagePtr->parsing.setFuture( QtConcurrent::run( parsePage, mShared->createParser(), pagePtr->request.response(), swapAxes ) );
+        pagePtr->downloaded = true;
+      } );
+      connect( &page->request, &QgsWfsRequest::downloadFinished, &loop, &QEventLoop::quit );
+      connect( &page->parsing, &QFutureWatcherBase::finished, &loop, &QEventLoop::quit );
+      page->request.launch( buildURL( nextStartIndex, pageSize, false ) );
+      pages.push_back( std::move( page ) );
+      nextStartIndex += pageSize;
+    }
+    if ( pages.empty() )
+      break;
+
+    PageDownload *page = pages.front().get();
+    if ( !page->downloaded || ( page->request.errorCode() == NoError && !page->parsing.isFinished() ) )
+    {
+      loop.exec( QEventLoop::ExcludeUserInputEvents );
+      continue;
+    }
+
+    ParsedPage result;
+    if ( page->request.errorCode() == NoError )
+      result = page->parsing.result();
+    else
+      result.errorMessage = page->request.errorMessage();
+    if ( !result.errorMessage.isEmpty() )
+    {
+      QgsDebugMsg( QString( "Page at index %1 failed: %2. Resuming the download sequentially" ).arg( mTotalDownloadedFeatureCount ).arg( result.errorMessage ) );
+      break;
+    }
+    pages.pop_front();
+
+    if ( result.missingIds && !mShared->mHasWarnedAboutMissingFeatureId )
+    {
+      QgsDebugMsg( "Server returns features without fid/gml:id. Computing a fake one using feature attributes" );
+      mShared->mHasWarnedAboutMissingFeatureId = true;
+    }
+
+    const int featureCount = result.features.size();
+    mTotalDownloadedFeatureCount += featureCount;
+    emit updateProgress( mTotalDownloadedFeatureCount );
+
+    // Same batches as the sequential download
+    for ( int i = 0; i < featureCount; i += 1000 )
+    {
+      QVector<QgsWFSFeatureGmlIdPair> featureList = result.features.mid( i, 1000 );
+      if ( serializeFeatures )
+        mShared->serializeFeatures( featureList );
+
+      if ( !featureList.isEmpty() )
+      {
+        emit featureReceived( featureList );
+        emit featureReceived( featureList.size() );
+      }
+    }
+
+    if ( featureCount < pageSize )
+    {
+      lastPage = true;
+      break;
+    }
+  }
+
+  // Drop the pages which will not be used
+  for ( const std::unique_ptr<PageDownload> &page : pages )
+  {
+    disconnect( &page->request, nullptr, &loop, nullptr );
+    page->request.abort();
+    page->parsing.waitForFinished();
+  }
+  return lastPage;
+}
+
 QgsWFSThreadedFeatureDownloader::QgsWFSThreadedFeatureDownloader( QgsWFSSharedData *shared )
   : mShared( shared )
   , mDownloader( nullptr )
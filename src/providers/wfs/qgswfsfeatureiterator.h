@@ -61,6 +61,20 @@ class QgsWFSFeatureHitsAsyncRequest: public QgsWfsRequest
 };
 
 
+//! Utility class to issue a GetFeature request for a single page, concurrently with other pages
+class QgsWFSFeaturePageRequest: public QgsWfsRequest
+{
+    Q_OBJECT
+  public:
+    explicit QgsWFSFeaturePageRequest( QgsWFSDataSourceURI &uri );
+
+    void launch( const QUrl &url );
+
+  protected:
+    virtual QString errorMessageWithReason( const QString &reason ) override;
+};
+
+
 //! Utility class for QgsWFSFeatureDownloader
 class QgsWFSProgressDialog: public QProgressDialog
 {
@@ -133,6 +147,14 @@ class QgsWFSFeatureDownloader: public QgsWfsRequest
 
   private:
     QUrl buildURL( int startIndex, int maxFeatures, bool forHits );
+
+    /** Downloads the pages from mTotalDownloadedFeatureCount up to \a numberMatched
+        features with up to \a maxParallelRequests concurrent requests. The pages
+        are parsed in the global thread pool as soon as they are received, and their
+        features are serialized and notified in order. Stops at the first page in
+        error, which the caller can retry.
+        \returns true if the last page of the layer was received */
+    bool downloadPagesInParallel( bool serializeFeatures, int numberMatched, int maxParallelRequests );
     void pushError( const QString &errorMsg );
     QString sanitizeFilter( QString filter );
 
@@ -20,14 +20,26 @@
 #include <QAbstractNetworkCache>
 #include <QImage>
 
-QCache<QUrl, QImage> QgsTileCache::sTileCache( 256 );
+#include <algorithm>
+
+// 64 MiB of decoded images, i.e. 256 tiles of 256x256 pixels
+QCache<QUrl, QImage> QgsTileCache::sTileCache( 64 * 1024 );
 QMutex QgsTileCache::sTileCacheMutex;
+QSet<QUrl> QgsTileCache::sPendingTiles;
+QMutex QgsTileCache::sPendingTilesMutex;
+QHash<QString, int> QgsTileCache::sRunningConnections;
+QMutex QgsTileCache::sRunningConnectionsMutex;
+
+static int imageCost( const QImage &image )
+{
+  return std::max( 1, image.byteCount() / 1024 );
+}
 
 
 void QgsTileCache::insertTile( const QUrl &url, const QImage &image )
 {
   QMutexLocker locker( &sTileCacheMutex );
-  sTileCache.insert( url, new QImage( image ) );
+  sTileCache.insert( url, new QImage( image ), imageCost( image ) );
 }
 
 bool QgsTileCache::tile( const QUrl &url, QImage &image )
@@ -48,10 +60,69 @@ bool QgsTileCache::tile( const QUrl &url, QImage &image )
       image = QImage::fromData( imageData );
 
       // cache it as well (mutex is already locked)
-      sTileCache.insert( url, new QImage( image ) );
+      sTileCache.insert( url, new QImage( image ), imageCost( image ) );
 
       return true;
     }
   }
   return false;
 }
+
+bool QgsTileCache::acquirePendingTile( const QUrl &url )
+{
+  QMutexLocker locker( &sPendingTilesMutex );
+  if ( sPendingTiles.contains( url ) )
+    return false;
+
+  sPendingTiles.insert( url );
+  return true;
+}
+
+void QgsTileCache::releasePendingTile( const QUrl &url, bool success )
+{
+  {
+    QMutexLocker locker( &sPendingTilesMutex );
+    if ( !sPendingTiles.remove( url ) )
+      return;
+  }
+
+  emit downloadNotifier()->tileDownloaded( url, success );
+}
+
+bool QgsTileCache::acquireConnection( const QString &host, int maxConnections )
+{
+  QMutexLocker locker( &sRunningConnectionsMutex );
+  int &running = sRunningConnections[ host ];
+  if ( running >= maxConnections )
+    return false;
+
+  running++;
+  return true;
+}
+
+void QgsTileCache::releaseConnection( const QString &host )
+{
+  {
+    QMutexLocker locker( &sRunningConnectionsMutex );
+    QHash<QString, int>::iterator it = sRunningConnections.find( host );
+    if ( it == sRunningConnections.end() )
+      return;
+
+    if ( --it.value() <= 0 )
+      sRunningConnections.erase( it );
+  }
+
+  emit downloadNotifier()->connectionReleased( host );
+}
+
+int QgsTileCache::runningConnections( const QString &host )
+{
+  QMutexLocker locker( &sRunningConnectionsMutex );
+  return sRunningConnections.value( host );
+}
+
+QgsTileDownloadNotifier *QgsTileCache::downloadNotifier()
+{
+  static QgsTileDownloadNotifier sNotifier;
+  return &sNotifier;
+}
@@ -18,15 +18,45 @@
 
 
 #include <QCache>
+#include <QHash>
 #include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QUrl>
 
 class QImage;
-class QUrl;
+
+/** Notifies tile downloads shared between concurrent renders.
+ * \see QgsTileCache::acquirePendingTile()
+ * \see QgsTileCache::acquireConnection()
+ */
+class QgsTileDownloadNotifier : public QObject
+{
+    Q_OBJECT
+
+  signals:
+
+    /** Emitted when the download of a pending tile is over.
+     * \param url the URL of the tile
+     * \param success true if the tile has been inserted in the cache
+     */
+    void tileDownloaded( const QUrl &url, bool success );
+
+    /** Emitted when a connection slot of a host is released.
+     * \param host the host of the connection
+     */
+    void connectionReleased( const QString &host );
+};
 
 /** A simple tile cache implementation. Tiles are cached according to their URL.
  * There is a small in-memory cache and a secondary caching in the local disk.
  * The in-memory cache is there to save CPU time otherwise wasted to read and
- * uncompress data saved on the disk.
+ * uncompress data saved on the disk. Its size is limited by the memory used
+ * by the decoded images.
+ *
+ * The cache also keeps track of the tiles being downloaded, so that concurrent
+ * renders requesting the same tile wait for a single download, and of the
+ * connections opened to each host by all the renders.
  *
  * The class is thread safe (its methods can be called from any thread).
  */
@@ -41,16 +71,57 @@ class QgsTileCache
     //! \returns true if the tile exists in the cache
     static bool tile( const QUrl &url, QImage &image );
 
-    //! how many tiles are stored in the in-memory cache
+    //! how many KiB of decoded images are stored in the in-memory cache
     static int totalCost() { return sTileCache.totalCost(); }
-    //! how many tiles can be stored in the in-memory cache
+    //! how many KiB of decoded images can be stored in the in-memory cache
     static int maxCost() { return sTileCache.maxCost(); }
 
+    /** Marks a tile as being downloaded.
+     * \returns true if the caller has to download the tile, false if the tile is
+     * already being downloaded: the caller should then wait for the
+     * QgsTileDownloadNotifier::tileDownloaded() signal.
+     */
+    static bool acquirePendingTile( const QUrl &url );
+
+    /** Marks the download of a tile acquired with acquirePendingTile() as done
+     * and notifies the renders waiting for this tile.
+     * \param url the URL of the tile
+     * \param success true if the tile has been inserted in the cache
+     */
+    static void releasePendingTile( const QUrl &url, bool success );
+
+    /** Takes a connection slot of a host, the slots are shared by all the renders.
+     * \param host the host of the tile server
+     * \param maxConnections maximum number of simultaneous connections to the host
+     * \returns false if all the slots of the host are already taken: the caller
+     * should then wait for the QgsTileDownloadNotifier::connectionReleased() signal.
+     */
+    static bool acquireConnection( const QString &host, int maxConnections );
+
+    /** Releases a connection slot taken with acquireConnection() and notifies
+     * the renders waiting for a connection to the host.
+     */
+    static void releaseConnection( const QString &host );
+
+    //! Returns the number of connection slots currently taken for a host
+    static int runningConnections( const QString &host );
+
+    //! Returns the object notifying the end of pending tile downloads and the released connections
+    static QgsTileDownloadNotifier *downloadNotifier();
+
   private:
-    //! in-memory cache
+    //! in-memory cache, costs are in KiB
     static QCache<QUrl, QImage> sTileCache;
     //! mutex to protect the in-memory cache
     static QMutex sTileCacheMutex;
+    //! tiles being downloaded
+    static QSet<QUrl> sPendingTiles;
+    //! mutex to protect the pending tiles
+    static QMutex sPendingTilesMutex;
+    //! number of running requests per host
+    static QHash<QString, int> sRunningConnections;
+    //! mutex to protect the running requests
+    static QMutex sRunningConnectionsMutex;
 };
 
 #endif // QGSTILECACHE_H
@@ -464,6 +464,7 @@ enum QgsWmsTileAttribute
   TileIndex = QNetworkRequest::User + 1,
   TileRect  = QNetworkRequest::User + 2,
   TileRetry = QNetworkRequest::User + 3,
+  TileUrl   = QNetworkRequest::User + 4, //!< URL of the tile in the tile cache (before any redirection)
 };
 
 enum QgsWmsDpiMode
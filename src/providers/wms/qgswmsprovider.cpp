@@ -778,9 +778,10 @@ QImage *QgsWmsProvider::draw( QgsRectangle const &viewExtent, int pixelWidth, in
     int t0 = t.elapsed();
 
 
-    // draw other res tiles if preview
+    // draw other res tiles if preview, or as placeholders while the tiles
+    // are downloaded when partial output is rendered
     QPainter p( image );
-    if ( feedback && feedback->isPreviewOnly() && missing.count() > 0 )
+    if ( feedback && ( feedback->isPreviewOnly() || feedback->renderPartialOutput() ) && missing.count() > 0 )
     {
       // some tiles are still missing, so let's see if we have any cached tiles
       // from lower or higher resolution available to give the user a bit of context
@@ -3723,6 +3724,16 @@ QgsWmsTiledImageDownloadHandler::QgsWmsTiledImageDownloadHandler( const QString
       return;
   }
 
+  QgsSettings s;
+  mMaxConnectionsPerHost = std::max( 1, s.value( QStringLiteral( "qgis/maxTileConnectionsPerHost" ), 6 ).toInt() );
+
+  // tiles requested by other renders (e.g. another canvas or a print layout)
+  connect( QgsTileCache::downloadNotifier(), &QgsTileDownloadNotifier::tileDownloaded, this, &QgsWmsTiledImageDownloadHandler::pendingTileDownloaded );
+  // the connection slots of a host are shared with the other renders
+  connect( QgsTileCache::downloadNotifier(), &QgsTileDownloadNotifier::connectionReleased, this, &QgsWmsTiledImageDownloadHandler::startQueuedRequests );
+
+  // requests are sorted by priority (closest to the center of the view first),
+  // they are queued so that the connection slots are taken in that order
   Q_FOREACH ( const QgsWmsProvider::TileRequest &r, requests )
   {
     QNetworkRequest request( r.url );
@@ -3733,16 +3744,37 @@ QgsWmsTiledImageDownloadHandler::QgsWmsTiledImageDownloadHandler( const QString
     request.setAttribute( static_cast<QNetworkRequest::Attribute>( TileIndex ), r.index );
     request.setAttribute( static_cast<QNetworkRequest::Attribute>( TileRect ), r.rect );
     request.setAttribute( static_cast<QNetworkRequest::Attribute>( TileRetry ), 0 );
+    request.setAttribute( static_cast<QNetworkRequest::Attribute>( TileUrl ), r.url );
 
-    QNetworkReply *reply = QgsNetworkAccessManager::instance()->get( request );
-    connect( reply, &QNetworkReply::finished, this, &QgsWmsTiledImageDownloadHandler::tileReplyFinished );
-
-    mReplies << reply;
+    if ( QgsTileCache::acquirePendingTile( r.url ) )
+    {
+      mAcquiredTiles << r.url;
+      mQueuedRequests << request;
+    }
+    else
+    {
+      // the same tile is already being downloaded, wait for it
+      mWaitingRequests.insert( r.url, request );
+    }
   }
+
+  startQueuedRequests();
 }
 
 QgsWmsTiledImageDownloadHandler::~QgsWmsTiledImageDownloadHandler()
 {
+  // let the renders waiting for our tiles download them by themselves
+  Q_FOREACH ( const QUrl &url, mAcquiredTiles )
+  {
+    QgsTileCache::releasePendingTile( url, false );
+  }
+
+  // their finished() signal is not connected anymore
+  Q_FOREACH ( QNetworkReply *reply, mReplies )
+  {
+    QgsTileCache::releaseConnection( reply->request().attribute( static_cast<QNetworkRequest::Attribute>( TileUrl ) ).toUrl().host() );
+  }
+
   delete mEventLoop;
 }
 
@@ -3751,11 +3783,110 @@ void QgsWmsTiledImageDownloadHandler::downloadBlocking()
   if ( mFeedback && mFeedback->isCanceled() )
     return; // nothing to do
 
+  if ( mReplies.isEmpty() && mQueuedRequests.isEmpty() && mWaitingRequests.isEmpty() )
+    return; // all tiles were already available
+
   mEventLoop->exec( QEventLoop::ExcludeUserInputEvents );
 
   Q_ASSERT( mReplies.isEmpty() );
 }
 
+void QgsWmsTiledImageDownloadHandler::startQueuedRequests()
+{
+  if ( mFeedback && mFeedback->isCanceled() )
+    return;
+
+  QList<QNetworkRequest>::iterator it = mQueuedRequests.begin();
+  while ( it != mQueuedRequests.end() )
+  {
+    if ( !QgsTileCache::acquireConnection( it->url().host(), mMaxConnectionsPerHost ) )
+    {
+      ++it;
+      continue;
+    }
+
+    QNetworkReply *reply = QgsNetworkAccessManager::instance()->get( *it );
+    connect( reply, &QNetworkReply::finished, this, &QgsWmsTiledImageDownloadHandler::tileReplyFinished );
+    mReplies << reply;
+
+    it = mQueuedRequests.erase( it );
+  }
+}
+
+void QgsWmsTiledImageDownloadHandler::drawTile( const QRectF &rect, const QImage &image )
+{
+  double cr = mViewExtent.width() / mImage->width();
+
+  QRectF dst( ( rect.left() - mViewExtent.xMinimum() ) / cr,
+              ( mViewExtent.yMaximum() - rect.bottom() ) / cr,
+              rect.width() / cr,
+              rect.height() / cr );
+
+  QPainter p( mImage );
+  // replace lower resolution placeholders drawn while the tile was downloaded
+  p.setCompositionMode( QPainter::CompositionMode_Source );
+  if ( mSmoothPixmapTransform )
+    p.setRenderHint( QPainter::SmoothPixmapTransform, true );
+  p.drawImage( dst, image );
+  p.end();
+
+  if ( mFeedback )
+    mFeedback->onNewData();
+}
+
+void QgsWmsTiledImageDownloadHandler::tileReplyDone( QNetworkReply *reply, bool tileReceived )
+{
+  const QUrl url = reply->request().attribute( static_cast<QNetworkRequest::Attribute>( TileUrl ) ).toUrl();
+
+  mReplies.removeOne( reply );
+  reply->deleteLater();
+
+  QgsTileCache::releaseConnection( url.host() );
+  if ( mAcquiredTiles.remove( url ) )
+    QgsTileCache::releasePendingTile( url, tileReceived );
+
+  startQueuedRequests();
+  finishIfDone();
+}
+
+void QgsWmsTiledImageDownloadHandler::finishIfDone()
+{
+  if ( mReplies.isEmpty() && mQueuedRequests.isEmpty() && mWaitingRequests.isEmpty() )
+    finish();
+}
+
+void QgsWmsTiledImageDownloadHandler::pendingTileDownloaded( const QUrl &url, bool success )
+{
+  QHash<QUrl, QNetworkRequest>::iterator it = mWaitingRequests.find( url );
+  if ( it == mWaitingRequests.end() )
+    return;
+
+  const QNetworkRequest request = it.value();
+  mWaitingRequests.erase( it );
+
+  QImage image;
+  if ( success && QgsTileCache::tile( url, image ) )
+  {
+    drawTile( request.attribute( static_cast<QNetworkRequest::Attribute>( TileRect ) ).toRectF(), image );
+  }
+  else if ( !( mFeedback && mFeedback->isCanceled() ) )
+  {
+    // the other render failed or gave up, download the tile ourselves
+    if ( QgsTileCache::acquirePendingTile( url ) )
+    {
+      mAcquiredTiles << url;
+      mQueuedRequests.prepend( request );
+      startQueuedRequests();
+    }
+    else
+    {
+      mWaitingRequests.insert( url, request );
+    }
+  }
+
+  finishIfDone();
+}
+
 
 void QgsWmsTiledImageDownloadHandler::tileReplyFinished()
 {
@@ -3829,6 +3960,7 @@ void QgsWmsTiledImageDownloadHandler::tileReplyFinished()
       request.setAttribute( static_cast<QNetworkRequest::Attribute>( TileIndex ), tileNo );
       request.setAttribute( static_cast<QNetworkRequest::Attribute>( TileRect ), r );
       request.setAttribute( static_cast<QNetworkRequest::Attribute>( TileRetry ), 0 );
+      request.setAttribute( static_cast<QNetworkRequest::Attribute>( TileUrl ), reply->request().attribute( static_cast<QNetworkRequest::Attribute>( TileUrl ) ) );
 
       mReplies.removeOne( reply );
       reply->deleteLater();
@@ -3849,12 +3981,7 @@ void QgsWmsTiledImageDownloadHandler::tileReplyFinished()
 
       QgsWmsProvider::showMessageBox( tr( "Tile request error" ), tr( "Status: %1\nReason phrase: %2" ).arg( status.toInt() ).arg( phrase.toString() ) );
 
-      mReplies.removeOne( reply );
-      reply->deleteLater();
-
-      if ( mReplies.isEmpty() )
-        finish();
-
+      tileReplyDone( reply, false );
       return;
     }
 
@@ -3888,49 +4015,26 @@ void QgsWmsTiledImageDownloadHandler::tileReplyFinished()
 #endif
       }
 
-      mReplies.removeOne( reply );
-      reply->deleteLater();
-
-      if ( mReplies.isEmpty() )
-        finish();
-
+      tileReplyDone( reply, false );
       return;
     }
 
+    bool tileReceived = false;
+
     // only take results from current request number
     if ( mTileReqNo == tileReqNo )
     {
-      double cr = mViewExtent.width() / mImage->width();
-
-      QRectF dst( ( r.left() - mViewExtent.xMinimum() ) / cr,
-                  ( mViewExtent.yMaximum() - r.bottom() ) / cr,
-                  r.width() / cr,
-                  r.height() / cr );
-
       QgsDebugMsg( QString( "tile reply: length %1" ).arg( reply->bytesAvailable() ) );
 
       QImage myLocalImage = QImage::fromData( reply->readAll() );
 
       if ( !myLocalImage.isNull() )
       {
-        QPainter p( mImage );
-        if ( mSmoothPixmapTransform )
-          p.setRenderHint( QPainter::SmoothPixmapTransform, true );
-        p.drawImage( dst, myLocalImage );
-#if 0
-        myLocalImage.save( QString( "%1/%2-tile-%3.png" ).arg( QDir::tempPath() ).arg( mTileReqNo ).arg( tileNo ) );
-        p.drawRect( dst ); // show tile bounds
-        p.drawText( dst, Qt::AlignCenter, QString( "(%1)\n%2,%3\n%4,%5\n%6x%7" )
-                    .arg( tileNo )
-                    .arg( r.left() ).arg( r.bottom() )
-                    .arg( r.right() ).arg( r.top() )
-                    .arg( r.width() ).arg( r.height() ) );
-#endif
-
-        QgsTileCache::insertTile( reply->url(), myLocalImage );
+        // cache under the requested url, which is the one looked up by the next renders
+        QgsTileCache::insertTile( reply->request().attribute( static_cast<QNetworkRequest::Attribute>( TileUrl ) ).toUrl(), myLocalImage );
+        tileReceived = true;
 
-        if ( mFeedback )
-          mFeedback->onNewData();
+        drawTile( r, myLocalImage );
       }
       else
       {
@@ -3943,12 +4047,7 @@ void QgsWmsTiledImageDownloadHandler::tileReplyFinished()
       QgsDebugMsg( QString( "Reply too late [%1]" ).arg( reply->url().toString() ) );
     }
 
-    mReplies.removeOne( reply );
-    reply->deleteLater();
-
-    if ( mReplies.isEmpty() )
-      finish();
-
+    tileReplyDone( reply, tileReceived );
   }
   else
   {
@@ -3961,16 +4060,17 @@ void QgsWmsTiledImageDownloadHandler::tileReplyFinished()
         stat.errors++;
 
         // if we reached timeout, let's try again (e.g. in case of slow connection or slow server)
-        if ( reply->error() == QNetworkReply::TimeoutError )
-          repeatTileRequest( reply->request() );
+        if ( reply->error() == QNetworkReply::TimeoutError && repeatTileRequest( reply->request() ) )
+        {
+          // the new request keeps the connection slot and the pending tile
+          mReplies.removeOne( reply );
+          reply->deleteLater();
+          return;
+        }
       }
     }
 
-    mReplies.removeOne( reply );
-    reply->deleteLater();
-
-    if ( mReplies.isEmpty() )
-      finish();
+    tileReplyDone( reply, false );
   }
 
 #if 0
@@ -3986,15 +4086,28 @@ void QgsWmsTiledImageDownloadHandler::tileReplyFinished()
 void QgsWmsTiledImageDownloadHandler::canceled()
 {
   QgsDebugMsg( "Caught canceled() signal" );
+
+  // drop the requests which were not sent yet
+  Q_FOREACH ( const QNetworkRequest &request, mQueuedRequests )
+  {
+    const QUrl url = request.attribute( static_cast<QNetworkRequest::Attribute>( TileUrl ) ).toUrl();
+    if ( mAcquiredTiles.remove( url ) )
+      QgsTileCache::releasePendingTile( url, false );
+  }
+  mQueuedRequests.clear();
+  mWaitingRequests.clear();
+
   Q_FOREACH ( QNetworkReply *reply, mReplies )
   {
     QgsDebugMsg( "Aborting tiled network request" );
     reply->abort();
   }
+
+  finishIfDone();
 }
 
 
-void QgsWmsTiledImageDownloadHandler::repeatTileRequest( QNetworkRequest const &oldRequest )
+bool QgsWmsTiledImageDownloadHandler::repeatTileRequest( QNetworkRequest const &oldRequest )
 {
   QgsWmsStatistics::Stat &stat = QgsWmsStatistics::statForUri( mProviderUri );
 
@@ -4020,7 +4133,7 @@ void QgsWmsTiledImageDownloadHandler::repeatTileRequest( QNetworkRequest const &
       QgsMessageLog::logMessage( tr( "Tile request max retry error. Failed %1 requests for tile %2 of tileRequest %3 (url: %4)" )
                                  .arg( maxRetry ).arg( tileNo ).arg( tileReqNo ).arg( url ), tr( "WMS" ) );
     }
-    return;
+    return false;
   }
 
   mAuth.setAuthorization( request );
@@ -4035,6 +4148,7 @@ void QgsWmsTiledImageDownloadHandler::repeatTileRequest( QNetworkRequest const &
   QNetworkReply *reply = QgsNetworkAccessManager::instance()->get( request );
   mReplies << reply;
   connect( reply, &QNetworkReply::finished, this, &QgsWmsTiledImageDownloadHandler::tileReplyFinished );
+  return true;
 }
 
 // Some servers like http://glogow.geoportal2.pl/map/wms/wms.php? do not BBOX
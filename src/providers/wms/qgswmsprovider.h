@@ -498,6 +498,11 @@ class QgsWmsTiledImageDownloadHandler : public QObject
     Q_OBJECT
   public:
 
+    /**
+     * Tiles are requested in the order of \a requests, with a bounded number of
+     * simultaneous connections per host. Tiles already being downloaded by another
+     * handler are not requested again: the handler waits for the other download.
+     */
     QgsWmsTiledImageDownloadHandler( const QString &providerUri, const QgsWmsAuthorization &auth, int reqNo, const QgsWmsProvider::TileRequests &requests, QImage *image, const QgsRectangle &viewExtent, bool smoothPixmapTransform, QgsRasterBlockFeedback *feedback );
     ~QgsWmsTiledImageDownloadHandler();
 
@@ -507,16 +512,32 @@ class QgsWmsTiledImageDownloadHandler : public QObject
     void tileReplyFinished();
     void canceled();
 
+    //! Draws a tile downloaded by another handler
+    void pendingTileDownloaded( const QUrl &url, bool success );
+
   protected:
 
     /**
      * \brief Relaunch tile request cloning previous request parameters and managing max repeat
      *
      * \param oldRequest request to clone to generate new tile request
+     * \returns true if the request has been relaunched
      *
      * request is not launched if max retry is reached. Message is logged.
      */
-    void repeatTileRequest( QNetworkRequest const &oldRequest );
+    bool repeatTileRequest( QNetworkRequest const &oldRequest );
+
+    //! Sends queued requests as long as the connection slots of their host shared by all handlers allow it
+    void startQueuedRequests();
+
+    //! Draws a tile image in the output image
+    void drawTile( const QRectF &rect, const QImage &image );
+
+    //! Removes a reply once its tile is processed and releases the tile for other handlers
+    void tileReplyDone( QNetworkReply *reply, bool tileReceived );
+
+    //! Stops the event loop when there is nothing left to wait for
+    void finishIfDone();
 
     void finish() { QMetaObject::invokeMethod( mEventLoop, "quit", Qt::QueuedConnection ); }
 
@@ -535,6 +556,18 @@ class QgsWmsTiledImageDownloadHandler : public QObject
     //! Running tile requests
     QList<QNetworkReply *> mReplies;
 
+    //! Tile requests waiting for a free connection, by priority
+    QList<QNetworkRequest> mQueuedRequests;
+
+    //! Tile requests waiting for the download of another handler
+    QHash<QUrl, QNetworkRequest> mWaitingRequests;
+
+    //! Tiles this handler is responsible for downloading
+    QSet<QUrl> mAcquiredTiles;
+
+    //! Maximum number of simultaneous requests per host, for all the handlers
+    int mMaxConnectionsPerHost = 6;
+
     QgsRasterBlockFeedback *mFeedback = nullptr;
 };
 
@@ -48,6 +48,7 @@ const QgsProject *QgsConfigCache::project( const QString &path )
     if ( prj->read( path ) )
     {
       mProjectCache.insert( path, prj.release() );
+      mFileSystemWatcher.addPath( path );
     }
   }
 
@@ -169,11 +170,14 @@ QDomDocument *QgsConfigCache::xmlDocument( const QString &filePath )
 void QgsConfigCache::removeChangedEntry( const QString &path )
 {
   mWMSConfigCache.remove( path );
+  mProjectCache.remove( path );
 
   //xml document must be removed last, as other config cache destructors may require it
   mXmlDocumentCache.remove( path );
 
   mFileSystemWatcher.removePath( path );
+
+  emit entryRemoved( path );
 }
 
 
@@ -55,6 +55,15 @@ class SERVER_EXPORT QgsConfigCache : public QObject
      */
     const QgsProject *project( const QString &path );
 
+  signals:
+
+    /** Emitted when the cached entries of a configuration file are removed,
+     *  either explicitly or because the file has changed on disk.
+     * \param path the filename of the configuration file
+     * \since QGIS 3.0
+     */
+    void entryRemoved( const QString &path );
+
   private:
     QgsConfigCache() SIP_FORCE;
 
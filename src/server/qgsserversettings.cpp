@@ -130,6 +130,50 @@ void QgsServerSettings::initSettings()
                                QVariant()
                              };
   mSettings[ sCacheSize.envVar ] = sCacheSize;
+
+  // metatile size
+  const Setting sMetatileSize = { QgsServerSettingsEnv::QGIS_SERVER_METATILE_SIZE,
+                                  QgsServerSettingsEnv::DEFAULT_VALUE,
+                                  "Number of tiles per side of a metatile rendered for tiled WMS getMap requests (0 to deactivate)",
+                                  "/qgis/metatile_size",
+                                  QVariant::Int,
+                                  QVariant( 0 ),
+                                  QVariant()
+                                };
+  mSettings[ sMetatileSize.envVar ] = sMetatileSize;
+
+  // tile cache directory
+  const Setting sTileCacheDir = { QgsServerSettingsEnv::QGIS_SERVER_TILE_CACHE_DIRECTORY,
+                                  QgsServerSettingsEnv::DEFAULT_VALUE,
+                                  "Specify the directory of the tile cache (tiles are kept in memory if empty)",
+                                  "/tilecache/directory",
+                                  QVariant::String,
+                                  QVariant( "" ),
+                                  QVariant()
+                                };
+  mSettings[ sTileCacheDir.envVar ] = sTileCacheDir;
+
+  // tile cache size
+  const Setting sTileCacheSize = { QgsServerSettingsEnv::QGIS_SERVER_TILE_CACHE_SIZE,
+                                   QgsServerSettingsEnv::DEFAULT_VALUE,
+                                   "Specify the size of the in-memory tile cache",
+                                   "/tilecache/size",
+                                   QVariant::LongLong,
+                                   QVariant( 50 * 1024 * 1024 ),
+                                   QVariant()
+                                 };
+  mSettings[ sTileCacheSize.envVar ] = sTileCacheSize;
+
+  // png compression level
+  const Setting sPngCompression = { QgsServerSettingsEnv::QGIS_SERVER_PNG_COMPRESSION_LEVEL,
+                                    QgsServerSettingsEnv::DEFAULT_VALUE,
+                                    "zlib compression level (0-9) of PNG images (-1 to use the image quality)",
+                                    "/qgis/png_compression_level",
+                                    QVariant::Int,
+                                    QVariant( -1 ),
+                                    QVariant()
+                                  };
+  mSettings[ sPngCompression.envVar ] = sPngCompression;
 }
 
 void QgsServerSettings::load()
@@ -305,3 +349,23 @@ QString QgsServerSettings::cacheDirectory() const
 {
   return value( QgsServerSettingsEnv::QGIS_SERVER_CACHE_DIRECTORY ).toString();
 }
+
+int QgsServerSettings::metatileSize() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_METATILE_SIZE ).toInt();
+}
+
+QString QgsServerSettings::tileCacheDirectory() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_TILE_CACHE_DIRECTORY ).toString();
+}
+
+qint64 QgsServerSettings::tileCacheSize() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_TILE_CACHE_SIZE ).toLongLong();
+}
+
+int QgsServerSettings::pngCompressionLevel() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_PNG_COMPRESSION_LEVEL ).toInt();
+}
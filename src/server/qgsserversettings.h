@@ -56,7 +56,11 @@ class SERVER_EXPORT QgsServerSettingsEnv : public QObject
       QGIS_PROJECT_FILE,
       MAX_CACHE_LAYERS,
       QGIS_SERVER_CACHE_DIRECTORY,
-      QGIS_SERVER_CACHE_SIZE
+      QGIS_SERVER_CACHE_SIZE,
+      QGIS_SERVER_METATILE_SIZE,
+      QGIS_SERVER_TILE_CACHE_DIRECTORY,
+      QGIS_SERVER_TILE_CACHE_SIZE,
+      QGIS_SERVER_PNG_COMPRESSION_LEVEL
     };
     Q_ENUM( EnvVar )
 };
@@ -144,6 +148,32 @@ class SERVER_EXPORT QgsServerSettings
       */
     QString cacheDirectory() const;
 
+    /** Returns the number of tiles per side of a metatile rendered for
+      * tiled GetMap requests. A value lower than 2 disables metatiling.
+      * \returns the metatile size.
+      * \since QGIS 3.0
+      */
+    int metatileSize() const;
+
+    /** Returns the directory where rendered tiles are stored. An empty
+      * string means that tiles are kept in memory.
+      * \returns the tile cache directory.
+      * \since QGIS 3.0
+      */
+    QString tileCacheDirectory() const;
+
+    /** Returns the maximum size in bytes of the in-memory tile cache.
+      * \returns the tile cache size.
+      * \since QGIS 3.0
+      */
+    qint64 tileCacheSize() const;
+
+    /** Returns the zlib compression level (0-9) used to encode PNG images.
+      * \returns the compression level or -1 to deduce it from the image quality.
+      * \since QGIS 3.0
+      */
+    int pngCompressionLevel() const;
+
   private:
     void initSettings();
     QVariant value( QgsServerSettingsEnv::EnvVar envVar ) const;
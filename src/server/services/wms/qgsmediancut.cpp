@@ -24,6 +24,11 @@
 #include <QList>
 #include <QMultiMap>
 #include <QHash>
+#include <QThread>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <climits>
 
 namespace QgsWms
 {
@@ -34,30 +39,160 @@ namespace QgsWms
   namespace
   {
 
+    // images with less pixels are processed on the calling thread
+    const int PARALLEL_PIXEL_THRESHOLD = 100000;
+
+    // above this number of colors, the histogram is reduced to the cells of the color cube
+    const int MAX_HISTOGRAM_COLORS = 32768;
+
+    // color cube with 5 bits per color channel and 4 bits for alpha
+    const int COLOR_CUBE_SIZE = 1 << 19;
+    const quint16 NO_COLOR_INDEX = 0xffff;
+
+    inline int colorCubeIndex( QRgb color )
+    {
+      return ( ( qAlpha( color ) >> 4 ) << 15 ) | ( ( qRed( color ) >> 3 ) << 10 ) | ( ( qGreen( color ) >> 3 ) << 5 ) | ( qBlue( color ) >> 3 );
+    }
+
+    //! Returns the color at the center of a color cube cell
+    inline QRgb colorCubeCellCenter( int index )
+    {
+      return qRgba( ( ( ( index >> 10 ) & 0x1f ) << 3 ) | 0x4,
+                    ( ( ( index >> 5 ) & 0x1f ) << 3 ) | 0x4,
+                    ( ( index & 0x1f ) << 3 ) | 0x4,
+                    ( ( ( index >> 15 ) & 0xf ) << 4 ) | 0x8 );
+    }
+
+    struct ScanLineBlock
+    {
+      int firstRow;
+      int lastRow; // excluded
+      QHash<QRgb, int> colors;
+    };
+
+    //! Splits the image in blocks of scanlines, one per thread for large images
+    QVector<ScanLineBlock> scanLineBlocks( const QImage &image )
+    {
+      int blockCount = 1;
+      if ( static_cast< qint64 >( image.width() ) * image.height() >= PARALLEL_PIXEL_THRESHOLD )
+      {
+        blockCount = std::min( std::max( 1, QThread::idealThreadCount() ), image.height() );
+      }
+
+      const int rowsPerBlock = ( image.height() + blockCount - 1 ) / std::max( 1, blockCount );
+      QVector<ScanLineBlock> blocks;
+      for ( int row = 0; row < image.height(); row += rowsPerBlock )
+      {
+        ScanLineBlock block;
+        block.firstRow = row;
+        block.lastRow = std::min( row + rowsPerBlock, image.height() );
+        blocks << block;
+      }
+      return blocks;
+    }
+
+    template <typename BlockOperation>
+    void runOnBlocks( QVector<ScanLineBlock> &blocks, BlockOperation operation )
+    {
+      if ( blocks.size() == 1 )
+        operation( blocks[0] );
+      else
+        QtConcurrent::blockingMap( blocks, operation );
+    }
+
     void imageColors( QHash<QRgb, int> &colors, const QImage &image )
     {
       colors.clear();
-      int width = image.width();
-      int height = image.height();
+      const int width = image.width();
+
+      QVector<ScanLineBlock> blocks = scanLineBlocks( image );
+      if ( blocks.isEmpty() )
+        return;
 
-      const QRgb *currentScanLine = nullptr;
-      QHash<QRgb, int>::iterator colorIt;
-      for ( int i = 0; i < height; ++i )
+      runOnBlocks( blocks, [&image, width]( ScanLineBlock & block )
       {
-        currentScanLine = ( const QRgb * )( image.scanLine( i ) );
-        for ( int j = 0; j < width; ++j )
+        QRgb previousColor = 0;
+        QHash<QRgb, int>::iterator colorIt = block.colors.end();
+        for ( int i = block.firstRow; i < block.lastRow; ++i )
         {
-          colorIt = colors.find( currentScanLine[j] );
-          if ( colorIt == colors.end() )
-          {
-            colors.insert( currentScanLine[j], 1 );
-          }
-          else
+          const QRgb *currentScanLine = reinterpret_cast< const QRgb * >( image.constScanLine( i ) );
+          for ( int j = 0; j < width; ++j )
           {
+            // neighbouring pixels share the same color most of the time
+            if ( colorIt == block.colors.end() || currentScanLine[j] != previousColor )
+            {
+              previousColor = currentScanLine[j];
+              colorIt = block.colors.find( previousColor );
+              if ( colorIt == block.colors.end() )
+                colorIt = block.colors.insert( previousColor, 0 );
+            }
             colorIt.value()++;
           }
         }
+      } );
+
+      colors.swap( blocks[0].colors );
+      for ( int b = 1; b < blocks.size(); ++b )
+      {
+        for ( auto colorIt = blocks[b].colors.constBegin(); colorIt != blocks[b].colors.constEnd(); ++colorIt )
+        {
+          colors[colorIt.key()] += colorIt.value();
+        }
       }
+
+      if ( colors.size() <= MAX_HISTOGRAM_COLORS )
+        return;
+
+      // too many colors for the median cut: use the average color of each cell of the color cube
+      struct CellColor
+      {
+        qint64 red = 0;
+        qint64 green = 0;
+        qint64 blue = 0;
+        qint64 alpha = 0;
+        int count = 0;
+      };
+      QHash<int, CellColor> cells;
+      for ( auto colorIt = colors.constBegin(); colorIt != colors.constEnd(); ++colorIt )
+      {
+        CellColor &cell = cells[colorCubeIndex( colorIt.key() )];
+        cell.red += static_cast< qint64 >( qRed( colorIt.key() ) ) * colorIt.value();
+        cell.green += static_cast< qint64 >( qGreen( colorIt.key() ) ) * colorIt.value();
+        cell.blue += static_cast< qint64 >( qBlue( colorIt.key() ) ) * colorIt.value();
+        cell.alpha += static_cast< qint64 >( qAlpha( colorIt.key() ) ) * colorIt.value();
+        cell.count += colorIt.value();
+      }
+
+      colors.clear();
+      for ( auto cellIt = cells.constBegin(); cellIt != cells.constEnd(); ++cellIt )
+      {
+        const CellColor &cell = cellIt.value();
+        const QRgb color = qRgba( cell.red / cell.count, cell.green / cell.count, cell.blue / cell.count, cell.alpha / cell.count );
+        colors[color] += cell.count;
+      }
+    }
+
+    //! Returns the index of the color of the table nearest to the given color
+    int nearestColorIndex( QRgb color, const QVector<QRgb> &colorTable )
+    {
+      int index = 0;
+      int minDistance = INT_MAX;
+      for ( int i = 0; i < colorTable.size(); ++i )
+      {
+        const int dr = qRed( color ) - qRed( colorTable[i] );
+        const int dg = qGreen( color ) - qGreen( colorTable[i] );
+        const int db = qBlue( color ) - qBlue( colorTable[i] );
+        const int da = qAlpha( color ) - qAlpha( colorTable[i] );
+        const int distance = dr * dr + dg * dg + db * db + da * da;
+        if ( distance < minDistance )
+        {
+          minDistance = distance;
+          index = i;
+          if ( distance == 0 )
+            break;
+        }
+      }
+      return index;
     }
 
     bool minMaxRange( const QgsColorBox &colorBox, int &redRange, int &greenRange, int &blueRange, int &alphaRange )
@@ -320,6 +455,72 @@ namespace QgsWms
     }
   }
 
-} // namespace QgsWms
+  QImage quantizeImage( const QImage &inputImage, const QVector<QRgb> &colorTable )
+  {
+    Q_ASSERT( inputImage.format() == QImage::Format_RGB32 || inputImage.format() == QImage::Format_ARGB32 );
+    Q_ASSERT( colorTable.size() <= 256 );
+
+    QImage result( inputImage.size(), QImage::Format_Indexed8 );
+    result.setColorTable( colorTable );
+    result.setDotsPerMeterX( inputImage.dotsPerMeterX() );
+    result.setDotsPerMeterY( inputImage.dotsPerMeterY() );
+    if ( colorTable.isEmpty() || result.isNull() )
+    {
+      result.fill( 0 );
+      return result;
+    }
 
+    // colors of the table are mapped without approximation
+    QHash<QRgb, uchar> exactColors;
+    for ( int i = colorTable.size() - 1; i >= 0; --i )
+    {
+      exactColors.insert( colorTable[i], static_cast< uchar >( i ) );
+    }
 
+    // get the raw buffer here so that the image is not detached concurrently
+    uchar *resultBits = result.bits();
+    const int resultBytesPerLine = result.bytesPerLine();
+    const int width = inputImage.width();
+
+    QVector<ScanLineBlock> blocks = scanLineBlocks( inputImage );
+    runOnBlocks( blocks, [&]( ScanLineBlock & block )
+    {
+      // each block has its own lookup table, as cells are filled on demand
+      QVector<quint16> colorCube( COLOR_CUBE_SIZE, NO_COLOR_INDEX );
+      QRgb previousColor = 0;
+      uchar previousIndex = 0;
+      bool hasPrevious = false;
+
+      for ( int i = block.firstRow; i < block.lastRow; ++i )
+      {
+        const QRgb *inputLine = reinterpret_cast< const QRgb * >( inputImage.constScanLine( i ) );
+        uchar *resultLine = resultBits + static_cast< qint64 >( i ) * resultBytesPerLine;
+        for ( int j = 0; j < width; ++j )
+        {
+          const QRgb color = inputLine[j];
+          if ( !hasPrevious || color != previousColor )
+          {
+            auto exactIt = exactColors.constFind( color );
+            if ( exactIt != exactColors.constEnd() )
+            {
+              previousIndex = exactIt.value();
+            }
+            else
+            {
+              const int cubeIndex = colorCubeIndex( color );
+              if ( colorCube[cubeIndex] == NO_COLOR_INDEX )
+                colorCube[cubeIndex] = nearestColorIndex( colorCubeCellCenter( cubeIndex ), colorTable );
+              previousIndex = static_cast< uchar >( colorCube[cubeIndex] );
+            }
+            previousColor = color;
+            hasPrevious = true;
+          }
+          resultLine[j] = previousIndex;
+        }
+      }
+    } );
+
+    return result;
+  }
+
+} // namespace QgsWms
@@ -39,6 +39,20 @@ namespace QgsWms
    */
   void medianCut( QVector<QRgb> &colorTable, int nColors, const QImage &inputImage );
 
+  /**
+   * Converts a 32 bits image to an 8 bits indexed image using the given color table.
+   *
+   * Each pixel is mapped to the nearest color of the table. Colors of the table are
+   * reproduced exactly, other colors are looked up in a color cube (5 bits per color
+   * channel, 4 bits for alpha) filled on demand, so that the nearest color search is
+   * done at most once per cell. Large images are processed in parallel by blocks of
+   * scanlines.
+   * \param inputImage image in QImage::Format_RGB32 or QImage::Format_ARGB32
+   * \param colorTable color table with at most 256 colors
+   * \since QGIS 3.0
+   */
+  QImage quantizeImage( const QImage &inputImage, const QVector<QRgb> &colorTable );
+
 } // namespace QgsWms
 
 #endif
@@ -55,6 +55,7 @@
 #include "qgsaccesscontrol.h"
 #include "qgsfeaturerequest.h"
 #include "qgsmaprendererjobproxy.h"
+#include "qgswmstilecache.h"
 #include "qgswmsserviceexception.h"
 #include "qgsserverprojectutils.h"
 #include "qgsgui.h"
@@ -75,6 +76,8 @@
 #include <QTextStream>
 #include <QDir>
 
+#include <cmath>
+
 //for printing
 #include "qgscomposition.h"
 #include <QBuffer>
@@ -419,10 +422,159 @@ namespace QgsWms
 
   QImage *QgsRenderer::getMap( HitTest *hitTest )
   {
+    if ( !hitTest && mSettings.metatileSize() > 1 )
+    {
+      QImage *tile = getMetatiledMap();
+      if ( tile )
+        return tile;
+    }
+
     QgsMapSettings mapSettings;
     return getMap( mapSettings, hitTest );
   }
 
+  QImage *QgsRenderer::getMetatiledMap()
+  {
+    const int width = mWmsParameters.widthAsInt();
+    const int height = mWmsParameters.heightAsInt();
+    QgsRectangle bbox = mWmsParameters.bboxAsRectangle();
+    if ( width <= 0 || height <= 0 || bbox.isEmpty() || !mProject )
+      return nullptr;
+
+    const QString key = tileCacheKey();
+    if ( key.isEmpty() )
+      return nullptr;
+
+    // the bbox is expressed with the CRS axis order
+    QString crs = mWmsParameters.crs();
+    bool inverted = false;
+    if ( mWmsParameters.versionAsNumber() >= QgsProjectVersion( 1, 3, 0 ) )
+    {
+      if ( crs.compare( QLatin1String( "CRS:84" ), Qt::CaseInsensitive ) == 0 )
+        crs = QStringLiteral( "EPSG:4326" );
+      else
+        inverted = QgsCoordinateReferenceSystem::fromOgcWmsCrs( crs ).hasAxisInverted();
+    }
+    if ( inverted )
+      bbox.invert();
+
+    // only tiles aligned on a grid whose cells are the size of the request
+    // can be shared with other requests
+    const double tileWidth = bbox.width();
+    const double tileHeight = bbox.height();
+    const double colF = bbox.xMinimum() / tileWidth;
+    const double rowF = bbox.yMinimum() / tileHeight;
+    const qint64 col = std::llround( colF );
+    const qint64 row = std::llround( rowF );
+    if ( !qgsDoubleNear( colF, col, 1E-6 ) || !qgsDoubleNear( rowF, row, 1E-6 ) )
+      return nullptr;
+
+    QgsWmsTileCache *cache = QgsWmsTileCache::instance( mSettings );
+    const QString projectPath = mProject->fileName();
+    const QString tileKey = QStringLiteral( "%1|%2|%3" ).arg( key ).arg( col ).arg( row );
+
+    QImage cached = cache->tile( projectPath, tileKey );
+    if ( !cached.isNull() )
+      return new QImage( cached );
+
+    // render the whole metatile containing the requested tile
+    const int size = mSettings.metatileSize();
+    const qint64 metaCol = static_cast<qint64>( std::floor( static_cast<double>( col ) / size ) ) * size;
+    const qint64 metaRow = static_cast<qint64>( std::floor( static_cast<double>( row ) / size ) ) * size;
+
+    QgsRectangle metaExtent( metaCol * tileWidth, metaRow * tileHeight,
+                             ( metaCol + size ) * tileWidth, ( metaRow + size ) * tileHeight );
+    if ( inverted )
+      metaExtent.invert();
+
+    QgsServerRequest::Parameters metaParameters = mParameters;
+    metaParameters[ QStringLiteral( "WIDTH" )] = QString::number( width * size );
+    metaParameters[ QStringLiteral( "HEIGHT" )] = QString::number( height * size );
+    metaParameters[ QStringLiteral( "BBOX" )] = QStringLiteral( "%1,%2,%3,%4" )
+        .arg( qgsDoubleToString( metaExtent.xMinimum(), 17 ),
+              qgsDoubleToString( metaExtent.yMinimum(), 17 ),
+              qgsDoubleToString( metaExtent.xMaximum(), 17 ),
+              qgsDoubleToString( metaExtent.yMaximum(), 17 ) );
+    mWmsParameters.load( metaParameters );
+
+    std::unique_ptr<QImage> metatile;
+    if ( checkMaximumWidthHeight() )
+    {
+      try
+      {
+        QgsMapSettings mapSettings;
+        metatile.reset( getMap( mapSettings ) );
+      }
+      catch ( ... )
+      {
+        mWmsParameters.load( mParameters );
+        throw;
+      }
+    }
+    mWmsParameters.load( mParameters );
+
+    if ( !metatile || metatile->width() != width * size || metatile->height() != height * size )
+      return nullptr;
+
+    // slice the metatile and keep every tile for the next requests
+    QImage *result = nullptr;
+    for ( int i = 0; i < size; ++i )
+    {
+      for ( int j = 0; j < size; ++j )
+      {
+        const qint64 tileCol = metaCol + i;
+        const qint64 tileRow = metaRow + j;
+        // image rows go downwards while map rows go upwards
+        QImage tile = metatile->copy( i * width, ( size - 1 - j ) * height, width, height );
+        tile.setDotsPerMeterX( metatile->dotsPerMeterX() );
+        tile.setDotsPerMeterY( metatile->dotsPerMeterY() );
+
+        cache->insertTile( projectPath, QStringLiteral( "%1|%2|%3" ).arg( key ).arg( tileCol ).arg( tileRow ), tile );
+        if ( tileCol == col && tileRow == row )
+          result = new QImage( tile );
+      }
+    }
+
+    return result;
+  }
+
+  QString QgsRenderer::tileCacheKey() const
+  {
+    // requests with dynamic content are not cached
+    if ( !mWmsParameters.sld().isEmpty()
+         || !mWmsParameters.filters().isEmpty()
+         || !mWmsParameters.selections().isEmpty()
+         || !mWmsParameters.highlightGeom().isEmpty()
+         || mWmsParameters.allLayersNickname().isEmpty()
+         || !mParameters.value( QStringLiteral( "GML" ) ).isEmpty() )
+    {
+      return QString();
+    }
+
+    QStringList key;
+#ifdef HAVE_SERVER_PYTHON_PLUGINS
+    // the rendering may depend on the access control plugins
+    if ( mAccessControl && !mAccessControl->fillCacheKey( key ) )
+      return QString();
+#endif
+
+    const QgsRectangle bbox = mWmsParameters.bboxAsRectangle();
+    key << mWmsParameters.version()
+        << mWmsParameters.crs()
+        << mWmsParameters.formatAsString()
+        << mWmsParameters.allLayersNickname().join( ',' )
+        << mWmsParameters.allStyles().join( ',' )
+        << mWmsParameters.opacities().join( ',' )
+        << QString::number( mWmsParameters.transparentAsBool() )
+        << mWmsParameters.backgroundColorAsColor().name( QColor::HexArgb )
+        << mWmsParameters.dpi()
+        << mWmsParameters.width()
+        << mWmsParameters.height()
+        << qgsDoubleToString( bbox.width(), 12 )
+        << qgsDoubleToString( bbox.height(), 12 );
+    return key.join( '|' );
+  }
+
   QImage *QgsRenderer::getMap( QgsMapSettings &mapSettings, HitTest *hitTest )
   {
     // check size
@@ -173,6 +173,16 @@ namespace QgsWms
       // Scale image with WIDTH/HEIGHT if necessary
       QImage *scaleImage( const QImage *image ) const;
 
+      /* Returns the requested tile by rendering (or reading from the tile
+       * cache) the metatile it belongs to, or a null pointer if the request
+       * is not a tiled request which can be served this way.
+       */
+      QImage *getMetatiledMap();
+
+      // Returns the part of the tile cache key which doesn't depend on the
+      // tile position, or an empty string if the request cannot be cached
+      QString tileCacheKey() const;
+
       // Check layer read permissions
       void checkLayerReadPermissions( QgsMapLayer *layer ) const;
 
@@ -0,0 +1,193 @@
+/***************************************************************************
+                              qgswmstilecache.cpp
+                              -------------------
+  begin                : October 2017
+  copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgswmstilecache.h"
+#include "qgsconfigcache.h"
+#include "qgsserversettings.h"
+#include "qgsmessagelog.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+
+namespace QgsWms
+{
+
+  namespace
+  {
+    QString hashedName( const QString &value )
+    {
+      return QString::fromLatin1( QCryptographicHash::hash( value.toUtf8(), QCryptographicHash::Md5 ).toHex() );
+    }
+
+    QString memoryKey( const QString &project, const QString &key )
+    {
+      return project + QChar( '\n' ) + key;
+    }
+  }
+
+  QgsWmsTileCache *QgsWmsTileCache::instance( const QgsServerSettings &settings )
+  {
+    static std::unique_ptr<QgsWmsTileCache> sInstance;
+    static QMutex sMutex;
+
+    QMutexLocker locker( &sMutex );
+    if ( !sInstance )
+    {
+      const QString directory = settings.tileCacheDirectory();
+      if ( directory.isEmpty() )
+        sInstance.reset( new QgsWmsMemoryTileCache( settings.tileCacheSize() ) );
+      else
+        sInstance.reset( new QgsWmsDiskTileCache( directory ) );
+
+      // tiles are outdated as soon as the project is modified
+      QgsWmsTileCache *cache = sInstance.get();
+      QObject::connect( QgsConfigCache::instance(), &QgsConfigCache::entryRemoved, [cache]( const QString & path )
+      {
+        cache->removeProject( path );
+      } );
+    }
+    return sInstance.get();
+  }
+
+  QgsWmsMemoryTileCache::QgsWmsMemoryTileCache( qint64 maxSize )
+  {
+    // QCache costs are ints, so we count in KiB
+    mTiles.setMaxCost( static_cast<int>( std::min< qint64 >( maxSize / 1024, std::numeric_limits<int>::max() ) ) );
+  }
+
+  QImage QgsWmsMemoryTileCache::tile( const QString &project, const QString &key )
+  {
+    QMutexLocker locker( &mMutex );
+    QImage *image = mTiles.object( memoryKey( project, key ) );
+    return image ? *image : QImage();
+  }
+
+  void QgsWmsMemoryTileCache::insertTile( const QString &project, const QString &key, const QImage &image )
+  {
+    QMutexLocker locker( &mMutex );
+    mTiles.insert( memoryKey( project, key ), new QImage( image ), std::max( 1, image.byteCount() / 1024 ) );
+  }
+
+  void QgsWmsMemoryTileCache::removeProject( const QString &project )
+  {
+    QMutexLocker locker( &mMutex );
+    const QString prefix = memoryKey( project, QString() );
+    Q_FOREACH ( const QString &key, mTiles.keys() )
+    {
+      if ( key.startsWith( prefix ) )
+        mTiles.remove( key );
+    }
+  }
+
+  void QgsWmsMemoryTileCache::clear()
+  {
+    QMutexLocker locker( &mMutex );
+    mTiles.clear();
+  }
+
+  QgsWmsDiskTileCache::QgsWmsDiskTileCache( const QString &directory )
+    : mDirectory( directory )
+  {
+    if ( !QDir().mkpath( mDirectory ) )
+    {
+      QgsMessageLog::logMessage( QStringLiteral( "Unable to create the tile cache directory '%1'" ).arg( mDirectory ),
+                                 QStringLiteral( "Server" ), QgsMessageLog::WARNING );
+    }
+  }
+
+  QImage QgsWmsDiskTileCache::tile( const QString &project, const QString &key )
+  {
+    QMutexLocker locker( &mMutex );
+    QImage image;
+    const QString path = tileFilePath( project, key );
+    if ( QFile::exists( path ) )
+      image.load( path, "PNG" );
+    return image;
+  }
+
+  void QgsWmsDiskTileCache::insertTile( const QString &project, const QString &key, const QImage &image )
+  {
+    QMutexLocker locker( &mMutex );
+    const QString directory = projectDirectory( project );
+    if ( !QDir( directory ).exists() )
+    {
+      // first tile since the project was modified
+      removeProjectDirectories( project, directory );
+      if ( !QDir().mkpath( directory ) )
+        return;
+    }
+
+    // write in a temporary file first so that a concurrent reader never
+    // sees a partially written tile
+    const QString path = tileFilePath( project, key );
+    const QString tmpPath = path + QStringLiteral( ".tmp" );
+    if ( image.save( tmpPath, "PNG" ) )
+    {
+      QFile::remove( path );
+      QFile::rename( tmpPath, path );
+    }
+  }
+
+  void QgsWmsDiskTileCache::removeProject( const QString &project )
+  {
+    QMutexLocker locker( &mMutex );
+    removeProjectDirectories( project, QString() );
+  }
+
+  void QgsWmsDiskTileCache::clear()
+  {
+    QMutexLocker locker( &mMutex );
+    QDir dir( mDirectory );
+    Q_FOREACH ( const QString &entry, dir.entryList( QDir::Dirs | QDir::NoDotAndDotDot ) )
+    {
+      QDir( dir.filePath( entry ) ).removeRecursively();
+    }
+  }
+
+  QString QgsWmsDiskTileCache::projectDirectory( const QString &project ) const
+  {
+    // tiles written before a modification of the project, by another server
+    // process or before a restart, are never found
+    const QDateTime lastModified = QFileInfo( project ).lastModified();
+    return QDir( mDirectory ).filePath( QStringLiteral( "%1_%2" ).arg( hashedName( project ) ).arg( lastModified.toMSecsSinceEpoch() ) );
+  }
+
+  void QgsWmsDiskTileCache::removeProjectDirectories( const QString &project, const QString &keep ) const
+  {
+    QDir dir( mDirectory );
+    const QStringList filter = QStringList() << hashedName( project ) + QStringLiteral( "_*" );
+    Q_FOREACH ( const QString &entry, dir.entryList( filter, QDir::Dirs | QDir::NoDotAndDotDot ) )
+    {
+      const QString path = dir.filePath( entry );
+      if ( path != keep )
+        QDir( path ).removeRecursively();
+    }
+  }
+
+  QString QgsWmsDiskTileCache::tileFilePath( const QString &project, const QString &key ) const
+  {
+    return QDir( projectDirectory( project ) ).filePath( hashedName( key ) + QStringLiteral( ".png" ) );
+  }
+
+} // namespace QgsWms
@@ -0,0 +1,130 @@
+/***************************************************************************
+                              qgswmstilecache.h
+                              -----------------
+  begin                : October 2017
+  copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSWMSTILECACHE_H
+#define QGSWMSTILECACHE_H
+
+#include <QCache>
+#include <QImage>
+#include <QMutex>
+#include <QString>
+
+class QgsServerSettings;
+
+namespace QgsWms
+{
+
+  /** \ingroup server
+   * Base class for caches of tiles produced by metatiled GetMap requests.
+   *
+   * Tiles are stored under a key computed by the renderer (layers, styles,
+   * format, grid position, ...) and grouped by project so that all tiles
+   * of a project can be dropped when QgsConfigCache detects a change.
+   * \since QGIS 3.0
+   */
+  class QgsWmsTileCache
+  {
+    public:
+
+      virtual ~QgsWmsTileCache() = default;
+
+      /** Returns the cache used by the WMS service according to the server
+       * settings: tiles are stored on disk if a tile cache directory is
+       * configured, in memory otherwise. The cache is created on first
+       * call and lives as long as the service module.
+       */
+      static QgsWmsTileCache *instance( const QgsServerSettings &settings );
+
+      /** Returns the tile stored for the given key, or a null image if the
+       * tile is not available.
+       * \param project the filename of the project
+       * \param key the tile key
+       */
+      virtual QImage tile( const QString &project, const QString &key ) = 0;
+
+      /** Stores a tile.
+       * \param project the filename of the project
+       * \param key the tile key
+       * \param image the tile image
+       */
+      virtual void insertTile( const QString &project, const QString &key, const QImage &image ) = 0;
+
+      //! Removes all tiles of a project
+      virtual void removeProject( const QString &project ) = 0;
+
+      //! Removes all tiles
+      virtual void clear() = 0;
+  };
+
+  /** \ingroup server
+   * Tile cache keeping tiles in memory, up to a maximum size in bytes.
+   * \since QGIS 3.0
+   */
+  class QgsWmsMemoryTileCache : public QgsWmsTileCache
+  {
+    public:
+
+      /** Constructor.
+       * \param maxSize maximum size of the cached images in bytes
+       */
+      explicit QgsWmsMemoryTileCache( qint64 maxSize );
+
+      QImage tile( const QString &project, const QString &key ) override;
+      void insertTile( const QString &project, const QString &key, const QImage &image ) override;
+      void removeProject( const QString &project ) override;
+      void clear() override;
+
+    private:
+      QMutex mMutex;
+      QCache<QString, QImage> mTiles;
+  };
+
+  /** \ingroup server
+   * Tile cache storing tiles as PNG files below a directory, with one
+   * sub directory per project. The name of the sub directory includes the
+   * last modification time of the project file, the directories of older
+   * versions of the project are removed when the first tile of the current
+   * version is stored.
+   * \since QGIS 3.0
+   */
+  class QgsWmsDiskTileCache : public QgsWmsTileCache
+  {
+    public:
+
+      /** Constructor.
+       * \param directory the root directory of the cache
+       */
+      explicit QgsWmsDiskTileCache( const QString &directory );
+
+      QImage tile( const QString &project, const QString &key ) override;
+      void insertTile( const QString &project, const QString &key, const QImage &image ) override;
+      void removeProject( const QString &project ) override;
+      void clear() override;
+
+    private:
+      QString projectDirectory( const QString &project ) const;
+      QString tileFilePath( const QString &project, const QString &key ) const;
+
+      //! Removes the directories of all versions of a project, except \a keep
+      void removeProjectDirectories( const QString &project, const QString &keep ) const;
+
+      QMutex mMutex;
+      QString mDirectory;
+  };
+
+} // namespace QgsWms
+
+#endif
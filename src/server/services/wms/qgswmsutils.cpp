@@ -25,6 +25,8 @@
 #include "qgsconfigcache.h"
 #include "qgsserverprojectutils.h"
 
+#include <algorithm>
+
 namespace QgsWms
 {
   QString ImplementationVersion()
@@ -118,7 +120,7 @@ namespace QgsWms
 
   // Write image response
   void writeImage( QgsServerResponse &response, QImage &img, const QString &formatStr,
-                   int imageQuality )
+                   int imageQuality, int pngCompressionLevel )
   {
     ImageOutputFormat outputFormat = parseImageFormat( formatStr );
     QImage  result;
@@ -133,11 +135,14 @@ namespace QgsWms
         break;
       case PNG8:
       {
+        // palette and pixels have to be computed on non premultiplied colors
+        QImage source = img;
+        if ( source.format() != QImage::Format_RGB32 && source.format() != QImage::Format_ARGB32 )
+          source = source.convertToFormat( QImage::Format_ARGB32 );
+
         QVector<QRgb> colorTable;
-        medianCut( colorTable, 256, img );
-        result = img.convertToFormat( QImage::Format_Indexed8, colorTable,
-                                      Qt::ColorOnly | Qt::ThresholdDither |
-                                      Qt::ThresholdAlphaDither | Qt::NoOpaqueDetection );
+        medianCut( colorTable, 256, source );
+        result = quantizeImage( source, colorTable );
       }
       contentType = "image/png";
       saveFormat = "PNG";
@@ -165,6 +170,12 @@ namespace QgsWms
         break;
     }
 
+    // Qt maps the quality of PNG images to the zlib compression level
+    if ( saveFormat == QLatin1String( "PNG" ) && pngCompressionLevel >= 0 )
+    {
+      imageQuality = 100 - ( std::min( pngCompressionLevel, 9 ) * 91 + 8 ) / 9;
+    }
+
     if ( outputFormat != UNKN )
     {
       response.setHeader( "Content-Type", contentType );
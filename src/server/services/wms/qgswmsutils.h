@@ -70,9 +70,12 @@ namespace QgsWms
   ImageOutputFormat parseImageFormat( const QString &format );
 
   /** Write image response
+   * \param imageQuality quality of the output image (-1 for default)
+   * \param pngCompressionLevel zlib compression level (0-9) for PNG outputs. If -1,
+   * the compression level is deduced from the image quality.
    */
   void writeImage( QgsServerResponse &response, QImage &img, const QString &formatStr,
-                   int imageQuality = -1 );
+                   int imageQuality = -1, int pngCompressionLevel = -1 );
 
   /**
    * Parse bbox parameter
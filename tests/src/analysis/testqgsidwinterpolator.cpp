@@ -0,0 +1,214 @@
+/***************************************************************************
+     testqgsidwinterpolator.cpp
+     --------------------------------------
+    Date                 : October 2017
+    Copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QDir>
+#include <QFile>
+#include <QTextStream>
+#include "qgstest.h"
+
+#include "qgsapplication.h"
+#include "qgsgridfilewriter.h"
+#include "qgsidwinterpolator.h"
+#include "qgsrasterlayer.h"
+#include "qgsrasterdataprovider.h"
+#include "qgstestutils.h"
+#include "testqgsinterpolatorpoints.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+/** \ingroup UnitTests
+ * This is a unit test for the IDW interpolator and the grid file writer
+ */
+class TestQgsIDWInterpolator : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void init() {}
+    void cleanup() {}
+
+    void allNeighbors();
+    void nearestNeighbors();
+    void searchRadius();
+    void gridFileWriter();
+
+  private:
+    //! Reference IDW value using the count nearest points (all points if count is 0)
+    double bruteForceIdw( double x, double y, int count ) const;
+
+    std::unique_ptr< TestQgsInterpolatorPoints > mData;
+};
+
+void TestQgsIDWInterpolator::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+
+  mData.reset( new TestQgsInterpolatorPoints( 500 ) );
+  QVERIFY( mData->layer() );
+}
+
+void TestQgsIDWInterpolator::cleanupTestCase()
+{
+  mData.reset();
+  QgsApplication::exitQgis();
+}
+
+double TestQgsIDWInterpolator::bruteForceIdw( double x, double y, int count ) const
+{
+  QVector< QPair< double, double > > distances;
+  Q_FOREACH ( const QgsPoint &p, mData->points() )
+    distances << qMakePair( std::sqrt( ( p.x() - x ) * ( p.x() - x ) + ( p.y() - y ) * ( p.y() - y ) ), p.z() );
+  std::sort( distances.begin(), distances.end() );
+  if ( count > 0 )
+    distances.resize( count );
+
+  double sumCounter = 0;
+  double sumDenominator = 0;
+  for ( const QPair< double, double > &d : distances )
+  {
+    double weight = 1 / ( d.first * d.first );
+    sumCounter += weight * d.second;
+    sumDenominator += weight;
+  }
+  return sumCounter / sumDenominator;
+}
+
+void TestQgsIDWInterpolator::allNeighbors()
+{
+  QgsIDWInterpolator interpolator( mData->layerData() );
+  QgsIDWInterpolator limited( mData->layerData() );
+  limited.setMaxNeighbors( mData->points().count() );
+
+  double result = 0;
+  double limitedResult = 0;
+  for ( double x = 5; x < 1000; x += 99 )
+  {
+    for ( double y = 5; y < 1000; y += 99 )
+    {
+      QCOMPARE( interpolator.interpolatePoint( x, y, result ), 0 );
+      QCOMPARE( limited.interpolatePoint( x, y, limitedResult ), 0 );
+      QGSCOMPARENEAR( limitedResult, result, 1e-9 );
+      QGSCOMPARENEAR( result, bruteForceIdw( x, y, 0 ), 1e-9 );
+    }
+  }
+
+  // exactly on a point
+  QCOMPARE( limited.interpolatePoint( mData->points().at( 10 ).x(), mData->points().at( 10 ).y(), result ), 0 );
+  QCOMPARE( result, mData->points().at( 10 ).z() );
+}
+
+void TestQgsIDWInterpolator::nearestNeighbors()
+{
+  QgsIDWInterpolator interpolator( mData->layerData() );
+  interpolator.setMaxNeighbors( 8 );
+  QCOMPARE( interpolator.maxNeighbors(), 8 );
+
+  double result = 0;
+  for ( double x = -100; x < 1100; x += 73 )
+  {
+    for ( double y = -100; y < 1100; y += 73 )
+    {
+      QCOMPARE( interpolator.interpolatePoint( x, y, result ), 0 );
+      QGSCOMPARENEAR( result, bruteForceIdw( x, y, 8 ), 1e-9 );
+    }
+  }
+}
+
+void TestQgsIDWInterpolator::searchRadius()
+{
+  QgsIDWInterpolator interpolator( mData->layerData() );
+  interpolator.setSearchRadius( 10 );
+  QCOMPARE( interpolator.searchRadius(), 10.0 );
+
+  // no point within the radius
+  double result = 0;
+  QCOMPARE( interpolator.interpolatePoint( 2000, 2000, result ), 1 );
+
+  // only the points within the radius are used
+  const QgsPoint &p = mData->points().at( 0 );
+  QCOMPARE( interpolator.interpolatePoint( p.x() + 0.5, p.y(), result ), 0 );
+  double sumCounter = 0;
+  double sumDenominator = 0;
+  Q_FOREACH ( const QgsPoint &other, mData->points() )
+  {
+    double distance = std::sqrt( ( other.x() - p.x() - 0.5 ) * ( other.x() - p.x() - 0.5 ) + ( other.y() - p.y() ) * ( other.y() - p.y() ) );
+    if ( distance > 10 )
+      continue;
+    sumCounter += other.z() / ( distance * distance );
+    sumDenominator += 1 / ( distance * distance );
+  }
+  QGSCOMPARENEAR( result, sumCounter / sumDenominator, 1e-9 );
+}
+
+void TestQgsIDWInterpolator::gridFileWriter()
+{
+  QgsIDWInterpolator interpolator( mData->layerData() );
+  interpolator.setMaxNeighbors( 12 );
+  interpolator.setSearchRadius( 150 );
+  QVERIFY( interpolator.supportsConcurrentInterpolation() );
+
+  const QgsRectangle extent( 0, 0, 1000, 1000 );
+  const int size = 200;
+  const double cellSize = extent.width() / size;
+
+  const QString asciiPath = QDir::tempPath() + "/idw_grid_writer.asc";
+  QgsGridFileWriter asciiWriter( &interpolator, asciiPath, extent, size, size, cellSize, cellSize );
+  QCOMPARE( asciiWriter.outputFormat(), QgsGridFileWriter::AsciiGrid );
+  QCOMPARE( asciiWriter.writeFile(), 0 );
+
+  const QString tiffPath = QDir::tempPath() + "/idw_grid_writer.tif";
+  QgsGridFileWriter tiffWriter( &interpolator, tiffPath, extent, size, size, cellSize, cellSize );
+  tiffWriter.setOutputFormat( QgsGridFileWriter::GeoTiff );
+  QCOMPARE( tiffWriter.writeFile(), 0 );
+
+  QgsRasterLayer ascii( asciiPath, QStringLiteral( "ascii" ), QStringLiteral( "gdal" ) );
+  QgsRasterLayer tiff( tiffPath, QStringLiteral( "tiff" ), QStringLiteral( "gdal" ) );
+  QVERIFY( ascii.isValid() );
+  QVERIFY( tiff.isValid() );
+  QCOMPARE( tiff.width(), size );
+  QCOMPARE( tiff.height(), size );
+  QVERIFY( tiff.crs() == mData->layer()->crs() );
+  QGSCOMPARENEAR( tiff.extent().xMinimum(), extent.xMinimum(), 1e-6 );
+  QGSCOMPARENEAR( tiff.extent().yMaximum(), extent.yMaximum(), 1e-6 );
+
+  std::unique_ptr< QgsRasterBlock > asciiBlock( ascii.dataProvider()->block( 1, ascii.extent(), size, size ) );
+  std::unique_ptr< QgsRasterBlock > tiffBlock( tiff.dataProvider()->block( 1, tiff.extent(), size, size ) );
+  for ( int row = 0; row < size; ++row )
+  {
+    const double y = extent.yMaximum() - ( row + 0.5 ) * cellSize;
+    for ( int col = 0; col < size; ++col )
+    {
+      const double x = extent.xMinimum() + ( col + 0.5 ) * cellSize;
+      double expected = 0;
+      if ( interpolator.interpolatePoint( x, y, expected ) != 0 )
+      {
+        QVERIFY( asciiBlock->isNoData( row, col ) );
+        QVERIFY( tiffBlock->isNoData( row, col ) );
+        continue;
+      }
+      // ascii grids have 8 significant digits, GeoTIFF files are float32
+      const double tolerance = std::max( std::fabs( expected ) * 1e-6, 1e-6 );
+      QGSCOMPARENEAR( asciiBlock->value( row, col ), expected, tolerance );
+      QGSCOMPARENEAR( tiffBlock->value( row, col ), expected, tolerance );
+    }
+  }
+}
+
+QGSTEST_MAIN( TestQgsIDWInterpolator )
+#include "testqgsidwinterpolator.moc"
@@ -0,0 +1,80 @@
+/***************************************************************************
+     testqgsinterpolatorpoints.h
+     --------------------------------------
+    Date                 : October 2017
+    Copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef TESTQGSINTERPOLATORPOINTS_H
+#define TESTQGSINTERPOLATORPOINTS_H
+
+#include "qgsfeature.h"
+#include "qgsgeometry.h"
+#include "qgsinterpolator.h"
+#include "qgspoint.h"
+#include "qgsvectordataprovider.h"
+#include "qgsvectorlayer.h"
+
+#include <memory>
+
+/** \ingroup UnitTests
+ * Base data of the interpolator tests: a memory point layer holding deterministic
+ * pseudo random points over a 1000 x 1000 square. The z value of each point, also
+ * pseudo random, is stored in the "value" attribute.
+ */
+class TestQgsInterpolatorPoints
+{
+  public:
+
+    //! Creates the layer with \a count points, the layer is invalid if the features can not be added
+    explicit TestQgsInterpolatorPoints( int count )
+      : mLayer( new QgsVectorLayer( QStringLiteral( "Point?crs=EPSG:3857&field=value:double" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) ) )
+    {
+      QgsFeatureList features;
+      unsigned int seed = 1;
+      auto next = [&seed]() { seed = seed * 1103515245u + 12345u; return ( seed >> 8 ) / 16777216.0 * 1000; };
+      for ( int i = 0; i < count; ++i )
+      {
+        const double x = next();
+        const double y = next();
+        QgsPoint p( x, y, next() );
+        mPoints << p;
+        QgsFeature f( mLayer->fields() );
+        f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( p.x(), p.y() ) ) );
+        f.setAttribute( 0, p.z() );
+        features << f;
+      }
+      if ( !mLayer->isValid() || !mLayer->dataProvider()->addFeatures( features ) )
+        mLayer.reset();
+    }
+
+    //! Returns the point layer, or nullptr if it could not be created
+    QgsVectorLayer *layer() const { return mLayer.get(); }
+
+    //! Returns the points of the layer, in feature order
+    const QVector< QgsPoint > &points() const { return mPoints; }
+
+    //! Returns the base data interpolating the "value" attribute of the layer
+    QList<QgsInterpolator::LayerData> layerData() const
+    {
+      QgsInterpolator::LayerData data;
+      data.vectorLayer = mLayer.get();
+      data.zCoordInterpolation = false;
+      data.interpolationAttribute = 0;
+      data.mInputType = QgsInterpolator::POINTS;
+      return QList<QgsInterpolator::LayerData>() << data;
+    }
+
+  private:
+    std::unique_ptr< QgsVectorLayer > mLayer;
+    QVector< QgsPoint > mPoints;
+};
+
+#endif // TESTQGSINTERPOLATORPOINTS_H
@@ -0,0 +1,150 @@
+/***************************************************************************
+     testqgstininterpolator.cpp
+     --------------------------------------
+    Date                 : October 2017
+    Copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+
+#include "qgsapplication.h"
+#include "qgsfeaturestore.h"
+#include "qgstestutils.h"
+#include "qgstininterpolator.h"
+#include "testqgsinterpolatorpoints.h"
+#include "DualEdgeTriangulation.h"
+#include "LinTriangleInterpolator.h"
+
+#include <algorithm>
+#include <memory>
+
+/** \ingroup UnitTests
+ * This is a unit test for the TIN interpolator
+ */
+class TestQgsTINInterpolator : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void init() {}
+    void cleanup() {}
+
+    void sameTriangulationAsSequentialInsertion();
+    void sameInterpolationAsSequentialInsertion();
+
+  private:
+    //! Triangulation built by inserting the points one by one in the order of the features
+    void sequentialTriangulation( DualEdgeTriangulation &triangulation ) const;
+
+    //! Sorted edges of a saved triangulation, as pairs of end points
+    static QList< QPair< QgsPointXY, QgsPointXY > > edges( const QgsFeatureStore &store );
+
+    std::unique_ptr< TestQgsInterpolatorPoints > mData;
+};
+
+void TestQgsTINInterpolator::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+
+  mData.reset( new TestQgsInterpolatorPoints( 1000 ) );
+  QVERIFY( mData->layer() );
+}
+
+void TestQgsTINInterpolator::cleanupTestCase()
+{
+  mData.reset();
+  QgsApplication::exitQgis();
+}
+
+void TestQgsTINInterpolator::sequentialTriangulation( DualEdgeTriangulation &triangulation ) const
+{
+  Q_FOREACH ( const QgsPoint &p, mData->points() )
+    QVERIFY( triangulation.addPoint( new QgsPoint( p ) ) != -100 );
+}
+
+QList< QPair< QgsPointXY, QgsPointXY > > TestQgsTINInterpolator::edges( const QgsFeatureStore &store )
+{
+  QList< QPair< QgsPointXY, QgsPointXY > > result;
+  Q_FOREACH ( const QgsFeature &f, store.features() )
+  {
+    const QgsPolyline line = f.geometry().asPolyline();
+    QgsPointXY p1 = line.at( 0 );
+    QgsPointXY p2 = line.at( 1 );
+    if ( p2.x() < p1.x() || ( p2.x() == p1.x() && p2.y() < p1.y() ) )
+      std::swap( p1, p2 );
+    result << qMakePair( p1, p2 );
+  }
+  std::sort( result.begin(), result.end(), []( const QPair< QgsPointXY, QgsPointXY > &a, const QPair< QgsPointXY, QgsPointXY > &b )
+  {
+    if ( a.first.x() != b.first.x() )
+      return a.first.x() < b.first.x();
+    if ( a.first.y() != b.first.y() )
+      return a.first.y() < b.first.y();
+    if ( a.second.x() != b.second.x() )
+      return a.second.x() < b.second.x();
+    return a.second.y() < b.second.y();
+  } );
+  return result;
+}
+
+void TestQgsTINInterpolator::sameTriangulationAsSequentialInsertion()
+{
+  // the points are in general position, so their Delaunay triangulation does not
+  // depend on the insertion order
+  QgsFeatureStore tinStore( QgsTINInterpolator::triangulationFields(), mData->layer()->crs() );
+  QgsTINInterpolator interpolator( mData->layerData() );
+  interpolator.setTriangulationSink( &tinStore );
+  double result = 0;
+  QCOMPARE( interpolator.interpolatePoint( 500, 500, result ), 0 );
+
+  DualEdgeTriangulation sequential( 100000, nullptr );
+  sequentialTriangulation( sequential );
+  QgsFeatureStore sequentialStore( QgsTINInterpolator::triangulationFields(), mData->layer()->crs() );
+  QVERIFY( sequential.saveTriangulation( &sequentialStore ) );
+
+  // a triangulation of n points has 3n - 3 - h edges, h of the points being on the convex hull
+  const QList< QPair< QgsPointXY, QgsPointXY > > tinEdges = edges( tinStore );
+  QVERIFY( tinEdges.count() > 2 * mData->points().count() );
+  QCOMPARE( tinEdges, edges( sequentialStore ) );
+}
+
+void TestQgsTINInterpolator::sameInterpolationAsSequentialInsertion()
+{
+  QgsTINInterpolator interpolator( mData->layerData() );
+
+  DualEdgeTriangulation sequential( 100000, nullptr );
+  sequentialTriangulation( sequential );
+  LinTriangleInterpolator sequentialInterpolator( &sequential );
+
+  int interpolated = 0;
+  for ( double x = -10.5; x < 1010; x += 19.7 )
+  {
+    for ( double y = -10.5; y < 1010; y += 23.3 )
+    {
+      double result = 0;
+      QgsPoint expected( 0, 0, 0 );
+      const bool expectedOk = sequentialInterpolator.calcPoint( x, y, &expected );
+      QCOMPARE( interpolator.interpolatePoint( x, y, result ) == 0, expectedOk );
+      if ( expectedOk )
+      {
+        QGSCOMPARENEAR( result, expected.z(), 1E-8 );
+        ++interpolated;
+      }
+    }
+  }
+  // points outside of the convex hull are not interpolated
+  QVERIFY( interpolated > 1500 );
+}
+
+QGSTEST_MAIN( TestQgsTINInterpolator )
+#include "testqgstininterpolator.moc"
@@ -17,6 +17,7 @@
 #include "qgscoordinatetransform.h"
 #include "qgsapplication.h"
 #include "qgsrectangle.h"
+#include "qgsexception.h"
 #include <QObject>
 #include "qgstest.h"
 #include "qgstestutils.h"
@@ -33,6 +34,7 @@ class TestQgsCoordinateTransform: public QObject
     void assignment();
     void isValid();
     void isShortCircuited();
+    void pseudoMercator();
 
   private:
 
@@ -207,5 +209,73 @@ void TestQgsCoordinateTransform::transformBoundingBox()
   QGSCOMPARENEAR( resultRect.yMaximum(), expectedRect.yMaximum(), 0.001 );
 }
 
+void TestQgsCoordinateTransform::pseudoMercator()
+{
+  // transformations between EPSG:4326 and EPSG:3857 are computed without proj
+  const QgsCoordinateReferenceSystem wgs84( QStringLiteral( "EPSG:4326" ) );
+  const QgsCoordinateReferenceSystem pseudoMercator( QStringLiteral( "EPSG:3857" ) );
+  QgsCoordinateTransform tr( wgs84, pseudoMercator );
+
+  QgsPointXY p = tr.transform( 10, 50 );
+  QGSCOMPARENEAR( p.x(), 1113194.9079327357, 0.0001 );
+  QGSCOMPARENEAR( p.y(), 6446275.8410171578, 0.0001 );
+  p = tr.transform( p, QgsCoordinateTransform::ReverseTransform );
+  QGSCOMPARENEAR( p.x(), 10, 1e-9 );
+  QGSCOMPARENEAR( p.y(), 50, 1e-9 );
+
+  // longitudes are wrapped like proj does
+  p = tr.transform( 190, 0 );
+  QGSCOMPARENEAR( p.x(), -18924313.434856508, 0.0001 );
+
+  // proj handles points outside of the domain of the closed form
+  QVector<double> x = QVector<double>() << 0 << 0;
+  QVector<double> y = QVector<double>() << 0 << 90;
+  QVector<double> z( 2, 0.0 );
+  bool failed = false;
+  try
+  {
+    tr.transformCoords( 2, x.data(), y.data(), z.data() );
+  }
+  catch ( QgsCsException & )
+  {
+    failed = true;
+  }
+  QVERIFY( failed );
+
+  // same results as proj with an equivalent custom definition
+  QgsCoordinateReferenceSystem customMercator;
+  customMercator.createFromProj4( QStringLiteral( "+proj=merc +a=6378137 +b=6378137 +lat_ts=0 +lon_0=0 +x_0=0 +y_0=0 +k=1 +units=m +nadgrids=@null +no_defs" ) );
+  QgsCoordinateTransform customTr( wgs84, customMercator );
+  x.clear();
+  y.clear();
+  for ( double lon = -180; lon <= 180; lon += 7.5 )
+  {
+    for ( double lat = -89; lat <= 89; lat += 3.7 )
+    {
+      x << lon;
+      y << lat;
+    }
+  }
+  z = QVector<double>( x.size(), 0.0 );
+  QVector<double> customX = x;
+  QVector<double> customY = y;
+  QVector<double> customZ = z;
+  tr.transformCoords( x.size(), x.data(), y.data(), z.data() );
+  customTr.transformCoords( customX.size(), customX.data(), customY.data(), customZ.data() );
+  for ( int i = 0; i < x.size(); ++i )
+  {
+    QGSCOMPARENEAR( std::fabs( x.at( i ) ), std::fabs( customX.at( i ) ), 0.0001 );
+    QGSCOMPARENEAR( y.at( i ), customY.at( i ), 0.0001 );
+  }
+
+  tr.transformCoords( x.size(), x.data(), y.data(), z.data(), QgsCoordinateTransform::ReverseTransform );
+  customTr.transformCoords( customX.size(), customX.data(), customY.data(), customZ.data(), QgsCoordinateTransform::ReverseTransform );
+  for ( int i = 0; i < x.size(); ++i )
+  {
+    QGSCOMPARENEAR( std::fabs( x.at( i ) ), std::fabs( customX.at( i ) ), 1e-9 );
+    QGSCOMPARENEAR( y.at( i ), customY.at( i ), 1e-9 );
+  }
+}
+
 QGSTEST_MAIN( TestQgsCoordinateTransform )
 #include "testqgscoordinatetransform.moc"
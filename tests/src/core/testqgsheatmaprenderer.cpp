@@ -0,0 +1,223 @@
+/***************************************************************************
+     testqgsheatmaprenderer.cpp
+     --------------------------------------
+    Date                 : October 2017
+    Copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QImage>
+#include <QPainter>
+
+#include "qgsapplication.h"
+#include "qgscolorramp.h"
+#include "qgsgeometry.h"
+#include "qgsheatmaprenderer.h"
+#include "qgsmaprenderercustompainterjob.h"
+#include "qgsmapsettings.h"
+#include "qgsvectordataprovider.h"
+#include "qgsvectorlayer.h"
+
+#include <cmath>
+#include <memory>
+
+/** \ingroup UnitTests
+ * This is a unit test for the heatmap renderer. Its renders are compared to
+ * heatmaps accumulated point by point, evaluating the kernel for every pixel
+ * around every point.
+ */
+class TestQgsHeatmapRenderer : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void init() {}
+    void cleanup() {}
+
+    void fewPoints();
+    void manyPoints();
+    void densePoints();
+    void negativeWeights();
+    void pointsOnTileBorders();
+
+  private:
+
+    /**
+     * Renders \a count pseudo random points, within the radius around the image,
+     * with weights between \a minWeight and \a maxWeight, and checks the image.
+     */
+    void checkRandomPoints( int count, double minWeight, double maxWeight );
+
+    //! Renders points given in map units, which are pixels, and checks the image
+    void checkRender( const QVector< QgsPointXY > &points, const QVector< double > &weights );
+};
+
+namespace
+{
+  const int WIDTH = 400;
+  const int HEIGHT = 300;
+  const int RADIUS = 20;
+}
+
+void TestQgsHeatmapRenderer::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsHeatmapRenderer::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+void TestQgsHeatmapRenderer::fewPoints()
+{
+  // splatted sequentially
+  checkRandomPoints( 200, 0.5, 3 );
+}
+
+void TestQgsHeatmapRenderer::manyPoints()
+{
+  // splatted by tiles in parallel
+  checkRandomPoints( 5000, 0.5, 3 );
+}
+
+void TestQgsHeatmapRenderer::densePoints()
+{
+  // more points than a quarter of the pixels, the weights are summed per pixel first
+  checkRandomPoints( 50000, 0.5, 3 );
+}
+
+void TestQgsHeatmapRenderer::negativeWeights()
+{
+  // as many points, but the weights are not summed per pixel
+  checkRandomPoints( 50000, -1, 3 );
+}
+
+void TestQgsHeatmapRenderer::pointsOnTileBorders()
+{
+  // the tiles are 128 pixels wide, points on both sides of their borders and
+  // of the image borders (map y is HEIGHT - pixel row)
+  QVector< QgsPointXY > points;
+  QVector< double > weights;
+  const QList< double > xs = QList< double >() << -RADIUS + 0.5 << -0.5 << 0.5 << 127.5 << 128.5 << 255.5 << 256.5 << 383.5 << 384.5 << 399.5 << 400.5;
+  const QList< double > ys = QList< double >() << -0.5 << 0.5 << 43.5 << 44.5 << 171.5 << 172.5 << 299.5 << 300.5 << HEIGHT + RADIUS - 0.5;
+  Q_FOREACH ( double x, xs )
+  {
+    Q_FOREACH ( double y, ys )
+    {
+      points << QgsPointXY( x, y );
+      weights << 1 + points.count() % 3;
+    }
+  }
+  checkRender( points, weights );
+}
+
+void TestQgsHeatmapRenderer::checkRandomPoints( int count, double minWeight, double maxWeight )
+{
+  QVector< QgsPointXY > points;
+  QVector< double > weights;
+  unsigned int seed = 1;
+  auto next = [&seed]() { seed = seed * 1103515245u + 12345u; return ( seed >> 8 ) / 16777216.0; };
+  for ( int i = 0; i < count; ++i )
+  {
+    const double x = -RADIUS + next() * ( WIDTH + 2 * RADIUS );
+    const double y = -RADIUS + next() * ( HEIGHT + 2 * RADIUS );
+    points << QgsPointXY( x, y );
+    weights << minWeight + next() * ( maxWeight - minWeight );
+  }
+  checkRender( points, weights );
+}
+
+void TestQgsHeatmapRenderer::checkRender( const QVector< QgsPointXY > &points, const QVector< double > &weights )
+{
+  std::unique_ptr< QgsVectorLayer > layer( new QgsVectorLayer( QStringLiteral( "Point?crs=EPSG:3857&field=weight:double" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) ) );
+  QVERIFY( layer->isValid() );
+  QgsFeatureList features;
+  for ( int i = 0; i < points.count(); ++i )
+  {
+    QgsFeature f( layer->fields() );
+    f.setGeometry( QgsGeometry::fromPointXY( points.at( i ) ) );
+    f.setAttribute( 0, weights.at( i ) );
+    features << f;
+  }
+  QVERIFY( layer->dataProvider()->addFeatures( features ) );
+
+  QgsHeatmapRenderer *renderer = new QgsHeatmapRenderer();
+  renderer->setRadius( RADIUS );
+  renderer->setRadiusUnit( QgsUnitTypes::RenderPixels );
+  renderer->setRenderQuality( 1 );
+  renderer->setWeightExpression( QStringLiteral( "weight" ) );
+  layer->setRenderer( renderer );
+
+  QgsMapSettings settings;
+  settings.setOutputSize( QSize( WIDTH, HEIGHT ) );
+  settings.setOutputDpi( 96 );
+  settings.setDestinationCrs( layer->crs() );
+  settings.setExtent( QgsRectangle( 0, 0, WIDTH, HEIGHT ) );
+  settings.setLayers( QList< QgsMapLayer * >() << layer.get() );
+
+  QImage image( WIDTH, HEIGHT, QImage::Format_ARGB32_Premultiplied );
+  image.fill( Qt::transparent );
+  QPainter painter( &image );
+  QgsMapRendererCustomPainterJob job( settings, &painter );
+  job.start();
+  job.waitForFinished();
+  painter.end();
+
+  // expected heatmap, the kernel being evaluated for every pixel around every point
+  const QgsMapToPixel &mapToPixel = settings.mapToPixel();
+  QVector< double > values( WIDTH * HEIGHT, 0.0 );
+  double maxValue = 0;
+  for ( int i = 0; i < points.count(); ++i )
+  {
+    const QgsPointXY pixel = mapToPixel.transform( points.at( i ) );
+    const int pointX = pixel.x();
+    const int pointY = pixel.y();
+    for ( int x = std::max( pointX - RADIUS, 0 ); x < std::min( pointX + RADIUS, WIDTH ); ++x )
+    {
+      for ( int y = std::max( pointY - RADIUS, 0 ); y < std::min( pointY + RADIUS, HEIGHT ); ++y )
+      {
+        const double distanceSquared = std::pow( pointX - x, 2.0 ) + std::pow( pointY - y, 2.0 );
+        if ( distanceSquared > RADIUS * RADIUS )
+          continue;
+
+        const double value = values.at( y * WIDTH + x ) + weights.at( i ) * std::pow( 1. - std::pow( std::sqrt( distanceSquared ) / RADIUS, 2 ), 2 );
+        maxValue = std::max( maxValue, value );
+        values[ y * WIDTH + x ] = value;
+      }
+    }
+  }
+  QVERIFY( maxValue > 0 );
+
+  // the ramp may round differently the values summed in another order
+  QgsGradientColorRamp ramp( QColor( 255, 255, 255 ), QColor( 0, 0, 0 ) );
+  int mismatches = 0;
+  for ( int y = 0; y < HEIGHT; ++y )
+  {
+    for ( int x = 0; x < WIDTH; ++x )
+    {
+      const double value = values.at( y * WIDTH + x );
+      const QColor expected = ramp.color( value > 0 ? std::min( value / maxValue, 1.0 ) : 0 );
+      const QColor actual = QColor::fromRgba( image.pixel( x, y ) );
+      if ( std::abs( actual.red() - expected.red() ) > 1 || std::abs( actual.green() - expected.green() ) > 1
+           || std::abs( actual.blue() - expected.blue() ) > 1 || actual.alpha() != expected.alpha() )
+      {
+        ++mismatches;
+      }
+    }
+  }
+  QCOMPARE( mismatches, 0 );
+}
+
+QGSTEST_MAIN( TestQgsHeatmapRenderer )
+#include "testqgsheatmaprenderer.moc"
@@ -0,0 +1,147 @@
+/***************************************************************************
+     testqgsrasterprojector.cpp
+     --------------------------------------
+    Date                 : October 2017
+    Copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QObject>
+#include <QString>
+
+#include "qgsrasterlayer.h"
+#include "qgsrasterdataprovider.h"
+#include "qgsrasterprojector.h"
+#include "qgscoordinatetransform.h"
+
+#include <memory>
+
+/** \ingroup UnitTests
+ * This is a unit test for the QgsRasterProjector class.
+ */
+class TestQgsRasterProjector : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();// will be called before the first testfunction is executed.
+    void cleanupTestCase();// will be called after the last testfunction was executed.
+
+    void noProjection();
+    void approximateVsExact();
+    void benchmarkApproximate();
+
+  private:
+    QgsRectangle destExtent() const;
+    QgsRasterBlock *projectedBlock( QgsRasterProjector::Precision precision, int width, int height ) const;
+
+    std::unique_ptr< QgsRasterLayer > mRasterLayer;
+    QgsCoordinateReferenceSystem mDestCrs;
+};
+
+//runs before all tests
+void TestQgsRasterProjector::initTestCase()
+{
+  // init QGIS's paths - true means that all path will be inited from prefix
+  QgsApplication::init();
+  QgsApplication::initQgis();
+
+  const QString raster = QStringLiteral( TEST_DATA_DIR ) + "/raster/band1_float32_noct_epsg4326.tif"; //defined in CmakeLists.txt
+  mRasterLayer.reset( new QgsRasterLayer( raster, QStringLiteral( "band1_float32" ) ) );
+  QVERIFY( mRasterLayer->isValid() );
+
+  mDestCrs = QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:3857" ) );
+  QVERIFY( mDestCrs.isValid() );
+}
+
+//runs after all tests
+void TestQgsRasterProjector::cleanupTestCase()
+{
+  mRasterLayer.reset();
+  QgsApplication::exitQgis();
+}
+
+QgsRectangle TestQgsRasterProjector::destExtent() const
+{
+  QgsCoordinateTransform ct( mRasterLayer->crs(), mDestCrs );
+  return ct.transformBoundingBox( mRasterLayer->dataProvider()->extent() );
+}
+
+QgsRasterBlock *TestQgsRasterProjector::projectedBlock( QgsRasterProjector::Precision precision, int width, int height ) const
+{
+  QgsRasterProjector projector;
+  projector.setInput( mRasterLayer->dataProvider() );
+  projector.setCrs( mRasterLayer->crs(), mDestCrs );
+  projector.setPrecision( precision );
+  return projector.block( 1, destExtent(), width, height );
+}
+
+void TestQgsRasterProjector::noProjection()
+{
+  QgsRasterDataProvider *provider = mRasterLayer->dataProvider();
+  QgsRasterProjector projector;
+  projector.setInput( provider );
+  projector.setCrs( mRasterLayer->crs(), mRasterLayer->crs() );
+
+  const QgsRectangle extent = provider->extent();
+  std::unique_ptr< QgsRasterBlock > projected( projector.block( 1, extent, provider->xSize(), provider->ySize() ) );
+  std::unique_ptr< QgsRasterBlock > original( provider->block( 1, extent, provider->xSize(), provider->ySize() ) );
+  QCOMPARE( projected->width(), original->width() );
+  QCOMPARE( projected->height(), original->height() );
+  for ( int row = 0; row < original->height(); ++row )
+  {
+    for ( int col = 0; col < original->width(); ++col )
+    {
+      QCOMPARE( projected->value( row, col ), original->value( row, col ) );
+    }
+  }
+}
+
+void TestQgsRasterProjector::approximateVsExact()
+{
+  // big enough to be processed in parallel
+  const int size = 800;
+  std::unique_ptr< QgsRasterBlock > approximate( projectedBlock( QgsRasterProjector::Approximate, size, size ) );
+  std::unique_ptr< QgsRasterBlock > exact( projectedBlock( QgsRasterProjector::Exact, size, size ) );
+  QVERIFY( approximate && approximate->isValid() );
+  QVERIFY( exact && exact->isValid() );
+  QCOMPARE( approximate->width(), size );
+  QCOMPARE( exact->height(), size );
+
+  // the approximation error is below half a destination pixel, only pixels
+  // close to source cell borders may differ
+  int dataCount = 0;
+  int diffCount = 0;
+  for ( int row = 0; row < size; ++row )
+  {
+    for ( int col = 0; col < size; ++col )
+    {
+      const bool approximateNoData = approximate->isNoData( row, col );
+      if ( !exact->isNoData( row, col ) )
+        dataCount++;
+      if ( approximateNoData != exact->isNoData( row, col ) ||
+           ( !approximateNoData && approximate->value( row, col ) != exact->value( row, col ) ) )
+        diffCount++;
+    }
+  }
+  QVERIFY( dataCount > size * size / 2 );
+  QVERIFY( diffCount <= size * size / 50 );
+}
+
+void TestQgsRasterProjector::benchmarkApproximate()
+{
+  QBENCHMARK
+  {
+    std::unique_ptr< QgsRasterBlock > block( projectedBlock( QgsRasterProjector::Approximate, 2000, 2000 ) );
+  }
+}
+
+QGSTEST_MAIN( TestQgsRasterProjector )
+#include "testqgsrasterprojector.moc"
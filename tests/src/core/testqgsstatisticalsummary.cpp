@@ -37,6 +37,9 @@ class TestQgsStatisticSummary: public QObject
     void maxMin();
     void countMissing();
     void noValues();
+    void approximate();
+    void approximateSmallInput();
+    void merge();
 
   private:
 
@@ -340,5 +343,136 @@ void TestQgsStatisticSummary::noValues()
   QVERIFY( std::isnan( s.statistic( QgsStatisticalSummary::InterQuartileRange ) ) );
 }
 
+void TestQgsStatisticSummary::approximate()
+{
+  // a permutation of 0 .. count - 1, so that values and ranks are the same
+  const int count = 100000;
+  QList<double> values;
+  for ( int i = 0; i < count; ++i )
+    values << ( i * 7919 ) % count;
+
+  QgsStatisticalSummary exact( QgsStatisticalSummary::All | QgsStatisticalSummary::StDevSample );
+  exact.calculate( values );
+  QgsStatisticalSummary s( QgsStatisticalSummary::All | QgsStatisticalSummary::StDevSample );
+  QVERIFY( !s.approximate() );
+  s.setApproximate( true );
+  QVERIFY( s.approximate() );
+  s.calculate( values );
+
+  QCOMPARE( s.count(), count );
+  QCOMPARE( s.sum(), exact.sum() );
+  QCOMPARE( s.mean(), exact.mean() );
+  QCOMPARE( s.min(), 0.0 );
+  QCOMPARE( s.max(), count - 1.0 );
+  QGSCOMPARENEAR( s.stDev(), exact.stDev(), exact.stDev() * 1e-9 );
+  QGSCOMPARENEAR( s.sampleStDev(), exact.sampleStDev(), exact.sampleStDev() * 1e-9 );
+
+  // rank error bound
+  QGSCOMPARENEAR( s.median(), count * 0.5, count * 0.0165 );
+  QGSCOMPARENEAR( s.firstQuartile(), count * 0.25, count * 0.0165 );
+  QGSCOMPARENEAR( s.thirdQuartile(), count * 0.75, count * 0.0165 );
+  QGSCOMPARENEAR( s.interQuartileRange(), count * 0.5, count * 0.033 );
+
+  // three times the standard error
+  QGSCOMPARENEAR( s.variety(), count, count * 0.048 );
+
+  // too many distinct values for the minority
+  QVERIFY( std::isnan( s.minority() ) );
+
+  // a frequent value is found among the distinct ones
+  for ( int i = 0; i < 1000; ++i )
+    values << -1;
+  s.calculate( values );
+  QCOMPARE( s.majority(), -1.0 );
+  QCOMPARE( s.min(), -1.0 );
+}
+
+void TestQgsStatisticSummary::approximateSmallInput()
+{
+  // below the sketch capacities the approximate mode matches the exact one,
+  // except for the quantile definition
+  QList<double> values;
+  values << 4 << 4 << 2 << 3 << 3 << 3 << 5 << 5 << 8 << 8;
+
+  QgsStatisticalSummary s( QgsStatisticalSummary::All );
+  s.setApproximate( true );
+  s.calculate( values );
+  QCOMPARE( s.count(), 10 );
+  QCOMPARE( s.sum(), 45.0 );
+  QCOMPARE( s.mean(), 4.5 );
+  QGSCOMPARENEAR( s.stDev(), 1.96214168703, 0.00001 );
+  QCOMPARE( s.min(), 2.0 );
+  QCOMPARE( s.max(), 8.0 );
+  QCOMPARE( s.range(), 6.0 );
+  QCOMPARE( s.median(), 4.0 );
+  QCOMPARE( s.firstQuartile(), 3.0 );
+  QCOMPARE( s.thirdQuartile(), 5.0 );
+  QCOMPARE( s.minority(), 2.0 );
+  QCOMPARE( s.majority(), 3.0 );
+  QCOMPARE( s.variety(), 5 );
+
+  // no values
+  s.calculate( QList<double>() );
+  QCOMPARE( s.count(), 0 );
+  QVERIFY( std::isnan( s.median() ) );
+  QVERIFY( std::isnan( s.stDev() ) );
+  QVERIFY( std::isnan( s.majority() ) );
+  QCOMPARE( s.variety(), 0 );
+}
+
+void TestQgsStatisticSummary::merge()
+{
+  QList<double> values;
+  for ( int i = 0; i < 5000; ++i )
+    values << ( i * 37 ) % 1001 - 500.5;
+
+  Q_FOREACH ( bool approximate, QList< bool >() << false << true )
+  {
+    QgsStatisticalSummary whole( QgsStatisticalSummary::All );
+    whole.setApproximate( approximate );
+    whole.calculate( values );
+
+    // uneven parts, including an empty one
+    QgsStatisticalSummary merged( QgsStatisticalSummary::All );
+    merged.setApproximate( approximate );
+    int start = 0;
+    Q_FOREACH ( int size, QList< int >() << 1 << 0 << 999 << 3000 << 1000 )
+    {
+      QgsStatisticalSummary part( QgsStatisticalSummary::All );
+      part.setApproximate( approximate );
+      part.calculate( values.mid( start, size ) );
+      part.addVariant( QVariant() );
+      merged.merge( part );
+      start += size;
+    }
+    merged.finalize();
+
+    QCOMPARE( merged.count(), whole.count() );
+    QCOMPARE( merged.countMissing(), 5 );
+    QGSCOMPARENEAR( merged.sum(), whole.sum(), 1e-6 );
+    QGSCOMPARENEAR( merged.mean(), whole.mean(), 1e-9 );
+    QGSCOMPARENEAR( merged.stDev(), whole.stDev(), 1e-9 );
+    QGSCOMPARENEAR( merged.sampleStDev(), whole.sampleStDev(), 1e-9 );
+    QCOMPARE( merged.min(), whole.min() );
+    QCOMPARE( merged.max(), whole.max() );
+    QCOMPARE( merged.majority(), whole.majority() );
+    QCOMPARE( merged.minority(), whole.minority() );
+    if ( approximate )
+    {
+      QGSCOMPARENEAR( merged.variety(), 1001, 1001 * 0.048 );
+      QGSCOMPARENEAR( merged.median(), 0, 1001 * 0.0165 );
+      QGSCOMPARENEAR( merged.firstQuartile(), -250, 1001 * 0.0165 );
+      QGSCOMPARENEAR( merged.thirdQuartile(), 250, 1001 * 0.0165 );
+    }
+    else
+    {
+      QCOMPARE( merged.variety(), whole.variety() );
+      QCOMPARE( merged.median(), whole.median() );
+      QCOMPARE( merged.firstQuartile(), whole.firstQuartile() );
+      QCOMPARE( merged.thirdQuartile(), whole.thirdQuartile() );
+    }
+  }
+}
+
 QGSTEST_MAIN( TestQgsStatisticSummary )
 #include "testqgsstatisticalsummary.moc"
@@ -0,0 +1,155 @@
+/***************************************************************************
+     testqgssvgcache.cpp
+     --------------------------------------
+    Date                 : October 2017
+    Copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QObject>
+#include <QImage>
+#include <QtConcurrentMap>
+
+#include "qgsapplication.h"
+#include "qgssvgcache.h"
+
+#include <functional>
+
+/** \ingroup UnitTests
+ * This is a unit test for the cache of rendered SVG files.
+ */
+class TestQgsSvgCache : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();// will be called before the first testfunction is executed.
+    void cleanupTestCase();// will be called after the last testfunction was executed.
+
+    void frontCache();
+    void separateCaches();
+    void nearlyEqualParameters();
+    void evictedFrontCacheEntries();
+    void concurrentLookups();
+
+  private:
+    QString mSvgPath;
+};
+
+void TestQgsSvgCache::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+  mSvgPath = QStringLiteral( TEST_DATA_DIR ) + "/sample_svg.svg"; //defined in CmakeLists.txt
+}
+
+void TestQgsSvgCache::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+void TestQgsSvgCache::frontCache()
+{
+  QgsSvgCache cache;
+  bool fitsInCache = false;
+  const QImage image = cache.svgAsImage( mSvgPath, 20, QColor( 255, 0, 0 ), QColor( 0, 0, 255 ), 1, 1, fitsInCache );
+  QVERIFY( fitsInCache );
+  QCOMPARE( image.width(), 20 );
+  QCOMPARE( cache.statistics().misses, 1LL );
+  QCOMPARE( cache.statistics().frontCacheHits, 0LL );
+
+  // same parameters, from the front cache of this thread
+  fitsInCache = false;
+  QCOMPARE( cache.svgAsImage( mSvgPath, 20, QColor( 255, 0, 0 ), QColor( 0, 0, 255 ), 1, 1, fitsInCache ), image );
+  QVERIFY( fitsInCache );
+  QCOMPARE( cache.statistics().frontCacheHits, 1LL );
+  QCOMPARE( cache.statistics().misses, 1LL );
+
+  // the picture comes from the same shared entry
+  cache.svgAsPicture( mSvgPath, 20, QColor( 255, 0, 0 ), QColor( 0, 0, 255 ), 1, 1 );
+  QCOMPARE( cache.statistics().hits, 1LL );
+
+  // any different parameter is a different entry
+  cache.svgAsImage( mSvgPath, 21, QColor( 255, 0, 0 ), QColor( 0, 0, 255 ), 1, 1, fitsInCache );
+  cache.svgAsImage( mSvgPath, 20, QColor( 255, 0, 1 ), QColor( 0, 0, 255 ), 1, 1, fitsInCache );
+  cache.svgAsImage( mSvgPath, 20, QColor( 255, 0, 0 ), QColor( 0, 0, 255 ), 2, 1, fitsInCache );
+  QCOMPARE( cache.statistics().misses, 4LL );
+
+  cache.resetStatistics();
+  QCOMPARE( cache.statistics().frontCacheHits, 0LL );
+  QCOMPARE( cache.statistics().hits, 0LL );
+  QCOMPARE( cache.statistics().misses, 0LL );
+  QCOMPARE( cache.statistics().contentions, 0LL );
+}
+
+void TestQgsSvgCache::separateCaches()
+{
+  // the front caches of a thread are not shared between caches
+  QgsSvgCache cache1;
+  QgsSvgCache cache2;
+  bool fitsInCache = false;
+  cache1.svgAsImage( mSvgPath, 30, Qt::red, Qt::black, 1, 1, fitsInCache );
+  cache2.svgAsImage( mSvgPath, 30, Qt::red, Qt::black, 1, 1, fitsInCache );
+  QCOMPARE( cache2.statistics().frontCacheHits, 0LL );
+  QCOMPARE( cache2.statistics().misses, 1LL );
+}
+
+void TestQgsSvgCache::nearlyEqualParameters()
+{
+  // parameters which are equal within the precision of the cache share the entry
+  QgsSvgCache cache;
+  bool fitsInCache = false;
+  cache.svgAsImage( mSvgPath, 20, Qt::red, Qt::black, 1, 1, fitsInCache );
+  cache.svgAsPicture( mSvgPath, 20 + 1e-12, Qt::red, Qt::black, 1 - 1e-12, 1 + 1e-12 );
+  QCOMPARE( cache.statistics().misses, 1LL );
+  QCOMPARE( cache.statistics().hits, 1LL );
+}
+
+void TestQgsSvgCache::evictedFrontCacheEntries()
+{
+  QgsSvgCache cache;
+  bool fitsInCache = false;
+  const QImage image = cache.svgAsImage( mSvgPath, 300, Qt::red, Qt::black, 1, 1, fitsInCache );
+  QVERIFY( fitsInCache );
+
+  // larger images evict the first one from the shared cache
+  for ( int size = 301; size < 320; ++size )
+    cache.svgAsImage( mSvgPath, size, Qt::red, Qt::black, 1, 1, fitsInCache );
+  QCOMPARE( cache.statistics().misses, 20LL );
+
+  // the front cache did not keep it either, it is rendered again
+  QCOMPARE( cache.svgAsImage( mSvgPath, 300, Qt::red, Qt::black, 1, 1, fitsInCache ), image );
+  QCOMPARE( cache.statistics().frontCacheHits, 0LL );
+  QCOMPARE( cache.statistics().misses, 21LL );
+}
+
+void TestQgsSvgCache::concurrentLookups()
+{
+  QgsSvgCache cache;
+  QVector< int > sizes;
+  for ( int i = 0; i < 400; ++i )
+    sizes << 10 + i % 20;
+
+  // width of the images, or -1 if they did not fit in the cache
+  const QVector< int > widths = QtConcurrent::blockingMapped< QVector< int > >( sizes, std::function< int( int ) >( [this, &cache]( int size )
+  {
+    bool fitsInCache = false;
+    const QImage image = cache.svgAsImage( mSvgPath, size, Qt::red, Qt::black, 1, 1, fitsInCache );
+    return fitsInCache ? image.width() : -1;
+  } ) );
+  QCOMPARE( widths, sizes );
+
+  const QgsSvgCache::Statistics statistics = cache.statistics();
+  QCOMPARE( statistics.misses, 20LL );
+  QCOMPARE( statistics.frontCacheHits + statistics.hits + statistics.misses, 400LL );
+}
+
+QGSTEST_MAIN( TestQgsSvgCache )
+#include "testqgssvgcache.moc"
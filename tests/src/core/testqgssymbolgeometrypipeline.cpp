@@ -0,0 +1,165 @@
+/***************************************************************************
+     testqgssymbolgeometrypipeline.cpp
+     --------------------------------------
+    Date                 : October 2017
+    Copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QObject>
+#include <QPolygonF>
+
+#include "qgsapplication.h"
+#include "qgslinestring.h"
+#include "qgsmaptopixel.h"
+#include "qgsrendercontext.h"
+#include "qgssymbolgeometrypipeline.h"
+#include "qgstestutils.h"
+#include "qgsvectorsimplifymethod.h"
+
+/** \ingroup UnitTests
+ * This is a unit test for the conversion of rendered geometries to screen coordinates.
+ */
+class TestQgsSymbolGeometryPipeline : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();// will be called before the first testfunction is executed.
+    void cleanupTestCase();// will be called after the last testfunction was executed.
+
+    void lineString();
+    void clippedLineString();
+    void pixelSimplification();
+    void smallRings();
+
+  private:
+    QgsRenderContext renderContext( double simplifyThreshold = 0 ) const;
+};
+
+void TestQgsSymbolGeometryPipeline::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsSymbolGeometryPipeline::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+QgsRenderContext TestQgsSymbolGeometryPipeline::renderContext( double simplifyThreshold ) const
+{
+  // 100 x 100 pixels, one map unit per pixel
+  QgsRenderContext context;
+  context.setMapToPixel( QgsMapToPixel( 1, 50, 50, 100, 100, 0 ) );
+  context.setExtent( QgsRectangle( 0, 0, 100, 100 ) );
+
+  QgsVectorSimplifyMethod method;
+  if ( simplifyThreshold > 0 )
+  {
+    method.setSimplifyHints( QgsVectorSimplifyMethod::GeometrySimplification );
+    method.setSimplifyAlgorithm( QgsVectorSimplifyMethod::Distance );
+    method.setForceLocalOptimization( true );
+    method.setThreshold( simplifyThreshold );
+    method.setTolerance( simplifyThreshold );
+  }
+  else
+  {
+    method.setSimplifyHints( QgsVectorSimplifyMethod::NoSimplification );
+  }
+  context.setVectorSimplifyMethod( method );
+  return context;
+}
+
+void TestQgsSymbolGeometryPipeline::lineString()
+{
+  const QgsRenderContext context = renderContext();
+  QVERIFY( !QgsSymbolGeometryPipeline::simplifiesInPixelSpace( context ) );
+
+  QgsLineString line( QVector<double>() << 10 << 20 << 20.2 << 90, QVector<double>() << 10 << 80 << 80 << 30 );
+  QPolygonF pts;
+  QgsSymbolGeometryPipeline::instance().lineString( pts, context, line, true );
+
+  QCOMPARE( pts.size(), line.numPoints() );
+  for ( int i = 0; i < line.numPoints(); ++i )
+  {
+    double x = line.xAt( i );
+    double y = line.yAt( i );
+    context.mapToPixel().transformInPlace( x, y );
+    QGSCOMPARENEAR( pts.at( i ).x(), x, 1e-9 );
+    QGSCOMPARENEAR( pts.at( i ).y(), y, 1e-9 );
+  }
+}
+
+void TestQgsSymbolGeometryPipeline::clippedLineString()
+{
+  const QgsRenderContext context = renderContext();
+
+  // goes far outside of the extent extended by 10%
+  QgsLineString line( QVector<double>() << 50 << 1000, QVector<double>() << 50 << 50 );
+  QPolygonF pts;
+  QgsSymbolGeometryPipeline::instance().lineString( pts, context, line, true );
+  QCOMPARE( pts.size(), 2 );
+  QGSCOMPARENEAR( pts.at( 0 ).x(), 50, 1e-9 );
+  QGSCOMPARENEAR( pts.at( 1 ).x(), 110, 1e-9 );
+
+  // not clipped
+  QgsSymbolGeometryPipeline::instance().lineString( pts, context, line, false );
+  QCOMPARE( pts.size(), 2 );
+  QGSCOMPARENEAR( pts.at( 1 ).x(), 1000, 1e-9 );
+}
+
+void TestQgsSymbolGeometryPipeline::pixelSimplification()
+{
+  const QgsRenderContext context = renderContext( 2 );
+  QVERIFY( QgsSymbolGeometryPipeline::simplifiesInPixelSpace( context ) );
+
+  QgsLineString line( QVector<double>() << 10 << 10.5 << 11 << 20 << 20.5, QVector<double>() << 10 << 10 << 10 << 10 << 10 );
+  QPolygonF pts;
+  QgsSymbolGeometryPipeline::instance().lineString( pts, context, line, true );
+
+  // vertices closer than 2 pixels to the last kept one are dropped, except the last one
+  QCOMPARE( pts.size(), 3 );
+  QGSCOMPARENEAR( pts.at( 0 ).x(), 10, 1e-9 );
+  QGSCOMPARENEAR( pts.at( 1 ).x(), 20, 1e-9 );
+  QGSCOMPARENEAR( pts.at( 2 ).x(), 20.5, 1e-9 );
+}
+
+void TestQgsSymbolGeometryPipeline::smallRings()
+{
+  const QgsRenderContext context = renderContext( 2 );
+  QgsSymbolGeometryPipeline &pipeline = QgsSymbolGeometryPipeline::instance();
+  pipeline.setCollectStatistics( true );
+  pipeline.resetStatistics();
+
+  QgsLineString ring( QVector<double>() << 10 << 11 << 11 << 10 << 10, QVector<double>() << 10 << 10 << 11 << 11 << 10 );
+  QPolygonF pts;
+
+  // small holes are dropped
+  pipeline.polygonRing( pts, context, ring, true, false );
+  QVERIFY( pts.isEmpty() );
+  QCOMPARE( pipeline.statistics().droppedRings, 1 );
+
+  // small exterior rings are replaced by their bounding box
+  pipeline.polygonRing( pts, context, ring, true, true );
+  QCOMPARE( pts.size(), 5 );
+  QCOMPARE( pts.first(), pts.last() );
+  QCOMPARE( pts.boundingRect(), QRectF( 10, 89, 1, 1 ) );
+
+  // without simplification rings are kept as is
+  pipeline.polygonRing( pts, renderContext(), ring, true, false );
+  QCOMPARE( pts.size(), 5 );
+
+  pipeline.setCollectStatistics( false );
+}
+
+QGSTEST_MAIN( TestQgsSymbolGeometryPipeline )
+#include "testqgssymbolgeometrypipeline.moc"
@@ -0,0 +1,149 @@
+/***************************************************************************
+     testqgstextpathcache.cpp
+     --------------------------------------
+    Date                 : October 2017
+    Copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QObject>
+#include <QFont>
+#include <QPainterPath>
+#include <QPainter>
+#include <QImage>
+#include <QtConcurrentMap>
+
+#include <functional>
+
+#include "qgsapplication.h"
+#include "qgsfontutils.h"
+#include "qgstextpathcache.h"
+
+/** \ingroup UnitTests
+ * This is a unit test for the cache of text outlines.
+ */
+class TestQgsTextPathCache : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();// will be called before the first testfunction is executed.
+    void cleanupTestCase();// will be called after the last testfunction was executed.
+
+    void cachedPath();
+    void fontProperties();
+    void budget();
+    void concurrentDrawing();
+};
+
+void TestQgsTextPathCache::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+  QgsFontUtils::loadStandardTestFonts( QStringList() << QStringLiteral( "Bold" ) );
+}
+
+void TestQgsTextPathCache::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+void TestQgsTextPathCache::cachedPath()
+{
+  QgsTextPathCache cache;
+  QFont font = QgsFontUtils::getStandardTestFont( QStringLiteral( "Bold" ), 20 );
+
+  QPainterPath expected;
+  expected.setFillRule( Qt::WindingFill );
+  expected.addText( 0, 0, font, QStringLiteral( "Label" ) );
+
+  const QPainterPath path = cache.textPath( font, QStringLiteral( "Label" ) );
+  QCOMPARE( path, expected );
+  QCOMPARE( path.fillRule(), Qt::WindingFill );
+  QCOMPARE( cache.statistics().hits, 0LL );
+  QCOMPARE( cache.statistics().misses, 1LL );
+  QVERIFY( cache.statistics().bytes > 0 );
+
+  QCOMPARE( cache.textPath( font, QStringLiteral( "Label" ) ), expected );
+  QCOMPARE( cache.statistics().hits, 1LL );
+
+  cache.resetStatistics();
+  QCOMPARE( cache.statistics().hits, 0LL );
+  QCOMPARE( cache.statistics().misses, 0LL );
+
+  cache.clear();
+  QCOMPARE( cache.statistics().bytes, 0 );
+  QCOMPARE( cache.textPath( font, QStringLiteral( "Label" ) ), expected );
+  QCOMPARE( cache.statistics().misses, 1LL );
+}
+
+void TestQgsTextPathCache::fontProperties()
+{
+  QgsTextPathCache cache;
+  QFont font = QgsFontUtils::getStandardTestFont( QStringLiteral( "Bold" ), 20 );
+  const QPainterPath path = cache.textPath( font, QStringLiteral( "Label" ) );
+
+  // spacing and capitalization are not part of QFont::key()
+  font.setLetterSpacing( QFont::AbsoluteSpacing, 5 );
+  const QPainterPath spaced = cache.textPath( font, QStringLiteral( "Label" ) );
+  QCOMPARE( cache.statistics().misses, 2LL );
+  QVERIFY( spaced.boundingRect().width() > path.boundingRect().width() );
+
+  font.setCapitalization( QFont::AllUppercase );
+  cache.textPath( font, QStringLiteral( "Label" ) );
+  QCOMPARE( cache.statistics().misses, 3LL );
+}
+
+void TestQgsTextPathCache::budget()
+{
+  QgsTextPathCache cache( 1 );
+  QCOMPARE( cache.maximumSize(), 1 );
+  QFont font = QgsFontUtils::getStandardTestFont( QStringLiteral( "Bold" ), 20 );
+
+  // too large to be cached, still returned
+  QVERIFY( !cache.textPath( font, QStringLiteral( "Label" ) ).isEmpty() );
+  QVERIFY( !cache.textPath( font, QStringLiteral( "Label" ) ).isEmpty() );
+  QCOMPARE( cache.statistics().hits, 0LL );
+  QCOMPARE( cache.statistics().bytes, 0 );
+
+  cache.setMaximumSize( 1024 * 1024 );
+  QCOMPARE( cache.maximumSize(), 1024 * 1024 );
+  cache.textPath( font, QStringLiteral( "Label" ) );
+  cache.textPath( font, QStringLiteral( "Label" ) );
+  QCOMPARE( cache.statistics().hits, 1LL );
+}
+
+void TestQgsTextPathCache::concurrentDrawing()
+{
+  QgsTextPathCache cache;
+  QFont font = QgsFontUtils::getStandardTestFont( QStringLiteral( "Bold" ), 20 );
+  cache.textPath( font, QStringLiteral( "Label" ) );
+
+  auto draw = [&cache, &font]( int )
+  {
+    // the painter writes lazily computed data into the paths it draws
+    QImage image( 100, 40, QImage::Format_ARGB32_Premultiplied );
+    image.fill( Qt::transparent );
+    QPainter painter( &image );
+    painter.setRenderHint( QPainter::Antialiasing );
+    painter.translate( 5, 30 );
+    painter.fillPath( cache.textPath( font, QStringLiteral( "Label" ) ), Qt::black );
+    painter.end();
+    return image;
+  };
+
+  const QImage expected = draw( 0 );
+  const QList<QImage> images = QtConcurrent::blockingMapped( QList<int>() << 1 << 2 << 3 << 4 << 5 << 6 << 7 << 8, std::function< QImage( int ) >( draw ) );
+  Q_FOREACH ( const QImage &image, images )
+    QCOMPARE( image, expected );
+}
+
+QGSTEST_MAIN( TestQgsTextPathCache )
+#include "testqgstextpathcache.moc"
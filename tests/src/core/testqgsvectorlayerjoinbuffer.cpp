@@ -62,6 +62,7 @@ class TestVectorLayerJoinBuffer : public QObject
     void testJoinLayerDefinitionFile();
     void testCacheUpdate_data();
     void testCacheUpdate();
+    void testJoinBatch();
     void testRemoveJoinOnLayerDelete();
     void testResolveReferences();
 
@@ -605,6 +606,80 @@ void TestVectorLayerJoinBuffer::testCacheUpdate()
   QCOMPARE( fA2.attribute( "B_value_b" ).toInt(), 12 );
 }
 
+void TestVectorLayerJoinBuffer::testJoinBatch()
+{
+  QgsVectorLayer *vlA = new QgsVectorLayer( QStringLiteral( "Point?field=id_a:integer" ), QStringLiteral( "batchA" ), QStringLiteral( "memory" ) );
+  QVERIFY( vlA->isValid() );
+  QgsVectorLayer *vlB = new QgsVectorLayer( QStringLiteral( "Point?field=id_b:integer&field=value_b:integer" ), QStringLiteral( "batchB" ), QStringLiteral( "memory" ) );
+  QVERIFY( vlB->isValid() );
+  mProject.addMapLayer( vlA );
+  mProject.addMapLayer( vlB );
+
+  // more features than a single batch, with repeated join values
+  QgsFeatureList featuresA;
+  for ( int i = 0; i < 2500; ++i )
+  {
+    QgsFeature f( vlA->dataProvider()->fields(), i + 1 );
+    f.setAttribute( QStringLiteral( "id_a" ), i % 1200 );
+    featuresA << f;
+  }
+  vlA->dataProvider()->addFeatures( featuresA );
+
+  // only even values have a joined feature
+  QgsFeatureList featuresB;
+  for ( int i = 0; i < 1200; i += 2 )
+  {
+    QgsFeature f( vlB->dataProvider()->fields(), i + 1 );
+    f.setAttribute( QStringLiteral( "id_b" ), i );
+    f.setAttribute( QStringLiteral( "value_b" ), i * 10 );
+    featuresB << f;
+  }
+  vlB->dataProvider()->addFeatures( featuresB );
+
+  QgsVectorLayerJoinInfo joinInfo;
+  joinInfo.setTargetFieldName( QStringLiteral( "id_a" ) );
+  joinInfo.setJoinLayer( vlB );
+  joinInfo.setJoinFieldName( QStringLiteral( "id_b" ) );
+  joinInfo.setUsingMemoryCache( false );
+  joinInfo.setPrefix( QStringLiteral( "B_" ) );
+  vlA->addJoin( joinInfo );
+
+  // uncommitted changes of the target field are taken into account
+  vlA->startEditing();
+  vlA->changeAttributeValue( 2, 0, 4 );
+
+  int count = 0;
+  QgsFeature f;
+  QgsFeatureIterator fi = vlA->getFeatures();
+  while ( fi.nextFeature( f ) )
+  {
+    const int id = f.attribute( "id_a" ).toInt();
+    if ( f.id() == 2 )
+      QCOMPARE( id, 4 );
+    if ( id % 2 == 0 )
+      QCOMPARE( f.attribute( "B_value_b" ).toInt(), id * 10 );
+    else
+      QVERIFY( f.attribute( "B_value_b" ).isNull() );
+    count++;
+  }
+  QCOMPARE( count, 2500 );
+
+  // limit smaller than a batch
+  QgsFeatureRequest request;
+  request.setLimit( 3 );
+  count = 0;
+  fi = vlA->getFeatures( request );
+  while ( fi.nextFeature( f ) )
+  {
+    const int id = f.attribute( "id_a" ).toInt();
+    QCOMPARE( f.attribute( "B_value_b" ).isNull(), id % 2 != 0 );
+    count++;
+  }
+  QCOMPARE( count, 3 );
+
+  vlA->rollBack();
+}
+
 void TestVectorLayerJoinBuffer::testRemoveJoinOnLayerDelete()
 {
   QgsVectorLayer *vlA = new QgsVectorLayer( QStringLiteral( "Point?field=id_a:integer" ), QStringLiteral( "cacheA" ), QStringLiteral( "memory" ) );
@@ -14,6 +14,7 @@
  ***************************************************************************/
 
 #include <limits>
+#include <memory>
 
 #include "qgstest.h"
 #include <QObject>
@@ -22,6 +23,11 @@
 #include <QApplication>
 #include <QFileInfo>
 #include <QDir>
+#include <QTemporaryDir>
+#include <QRegularExpression>
+#include <QThread>
+
+#include <gdal.h>
 
 //qgis includes...
 #include <qgis.h>
@@ -29,6 +35,8 @@
 #include <qgsproviderregistry.h>
 #include <qgsrasterdataprovider.h>
 #include <qgsrectangle.h>
+#include <qgsrasterblock.h>
+#include <qgssettings.h>
 #include "qgstestutils.h"
 
 /** \ingroup UnitTests
@@ -50,6 +58,8 @@ class TestQgsGdalProvider : public QObject
     void invalidNoDataInSourceIgnored();
     void isRepresentableValue();
     void mask();
+    void parallelRead_data();
+    void parallelRead(); //reads split in strips decoded in parallel must give the same result
 
   private:
     QString mTestDataDir;
@@ -221,5 +231,96 @@ void TestQgsGdalProvider::mask()
   delete provider;
 }
 
+void TestQgsGdalProvider::parallelRead_data()
+{
+  QTest::addColumn<double>( "xMin" );
+  QTest::addColumn<double>( "yMin" );
+  QTest::addColumn<double>( "xMax" );
+  QTest::addColumn<double>( "yMax" );
+  QTest::addColumn<int>( "width" );
+  QTest::addColumn<int>( "height" );
+
+  QTest::newRow( "full resolution" ) << 0.0 << -1500.0 << 2000.0 << 0.0 << 2000 << 1500;
+  QTest::newRow( "downsampled" ) << 0.0 << -1500.0 << 2000.0 << 0.0 << 517 << 389;
+  QTest::newRow( "upsampled" ) << 300.0 << -700.0 << 600.0 << -400.0 << 900 << 900;
+  QTest::newRow( "partially outside" ) << -500.0 << -1800.0 << 1500.0 << -300.0 << 700 << 600;
+}
+
+void TestQgsGdalProvider::parallelRead()
+{
+  QFETCH( double, xMin );
+  QFETCH( double, yMin );
+  QFETCH( double, xMax );
+  QFETCH( double, yMax );
+  QFETCH( int, width );
+  QFETCH( int, height );
+  const QgsRectangle extent( xMin, yMin, xMax, yMax );
+
+  QTemporaryDir dir;
+  const QString raster = dir.path() + "/tiled.tif";
+
+  // tiled raster with a different value for each pixel
+  const char *options[] = { "TILED=YES", "BLOCKXSIZE=64", "BLOCKYSIZE=64", nullptr };
+  GDALDatasetH dataset = GDALCreate( GDALGetDriverByName( "GTiff" ), raster.toUtf8().constData(), 2000, 1500, 1, GDT_Int32, const_cast<char **>( options ) );
+  QVERIFY( dataset );
+  double geoTransform[6] = { 0, 1, 0, 0, 0, -1 };
+  GDALSetGeoTransform( dataset, geoTransform );
+  QVector<int> values( 2000 * 1500 );
+  for ( int i = 0; i < values.size(); ++i )
+    values[i] = i;
+  QCOMPARE( GDALRasterIO( GDALGetRasterBand( dataset, 1 ), GF_Write, 0, 0, 2000, 1500, values.data(), 2000, 1500, GDT_Int32, 0, 0 ), CE_None );
+  GDALClose( dataset );
+
+  QgsSettings settings;
+  settings.setValue( QStringLiteral( "qgis/gdalParallelRead" ), false );
+  std::unique_ptr< QgsRasterDataProvider > sequential( dynamic_cast< QgsRasterDataProvider * >( QgsProviderRegistry::instance()->createProvider( QStringLiteral( "gdal" ), raster ) ) );
+  settings.setValue( QStringLiteral( "qgis/gdalParallelRead" ), true );
+  std::unique_ptr< QgsRasterDataProvider > parallel( dynamic_cast< QgsRasterDataProvider * >( QgsProviderRegistry::instance()->createProvider( QStringLiteral( "gdal" ), raster ) ) );
+  settings.remove( QStringLiteral( "qgis/gdalParallelRead" ) );
+  QVERIFY( sequential && sequential->isValid() );
+  QVERIFY( parallel && parallel->isValid() );
+
+  std::unique_ptr< QgsRasterBlock > expected( sequential->block( 1, extent, width, height ) );
+  std::unique_ptr< QgsRasterBlock > block( parallel->block( 1, extent, width, height ) );
+  QVERIFY( expected && block );
+
+  for ( int row = 0; row < height; ++row )
+  {
+    for ( int col = 0; col < width; ++col )
+    {
+      QCOMPARE( block->isNoData( row, col ), expected->isNoData( row, col ) );
+      QCOMPARE( block->value( row, col ), expected->value( row, col ) );
+    }
+  }
+
+  if ( QThread::idealThreadCount() < 2 )
+    QSKIP( "parallel reads need several cores" );
+
+  // reads, parallel reads, blocks read in parallel and estimated block cache hits shown in the metadata
+  auto statistics = []( QgsRasterDataProvider * provider )
+  {
+    const QRegularExpressionMatch reads = QRegularExpression( QStringLiteral( "Reads: (\\d+) \\((\\d+) in parallel\\)" ) ).match( provider->metadata() );
+    const QRegularExpressionMatch blocks = QRegularExpression( QStringLiteral( "Blocks read in parallel: (\\d+) \\(estimated block cache hits: (\\d+)\\)" ) ).match( provider->metadata() );
+    return QList<int>() << reads.captured( 1 ).toInt() << reads.captured( 2 ).toInt() << blocks.captured( 1 ).toInt() << blocks.captured( 2 ).toInt();
+  };
+  QList<int> stats = statistics( parallel.get() );
+  QCOMPARE( stats.at( 0 ), 1 );
+  QCOMPARE( stats.at( 1 ), 1 );
+  QVERIFY( stats.at( 2 ) > 0 );
+  QCOMPARE( stats.at( 3 ), 0 );
+  QVERIFY( !sequential->metadata().contains( QStringLiteral( "Read statistics" ) ) );
+
+  // renders read from clones, which share the handles and their block caches
+  std::unique_ptr< QgsRasterDataProvider > clone( parallel->clone() );
+  std::unique_ptr< QgsRasterBlock > again( clone->block( 1, extent, width, height ) );
+  QVERIFY( again );
+  QCOMPARE( again->value( height / 2, width / 2 ), expected->value( height / 2, width / 2 ) );
+  stats = statistics( parallel.get() );
+  QCOMPARE( stats.at( 0 ), 2 );
+  QCOMPARE( stats.at( 1 ), 2 );
+  QCOMPARE( stats.at( 3 ), stats.at( 2 ) / 2 );
+  QCOMPARE( statistics( clone.get() ), stats );
+}
+
 QGSTEST_MAIN( TestQgsGdalProvider )
 #include "testqgsgdalprovider.moc"
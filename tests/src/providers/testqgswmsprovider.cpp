@@ -14,8 +14,10 @@
  ***************************************************************************/
 #include <QFile>
 #include <QObject>
+#include <QSignalSpy>
 #include "qgstest.h"
 #include <qgswmsprovider.h>
+#include <qgstilecache.h>
 #include <qgsapplication.h>
 
 /** \ingroup UnitTests
@@ -75,6 +77,43 @@ class TestQgsWmsProvider: public QObject
       QCOMPARE( provider.getLegendGraphicUrl(), QString( "http://localhost:8380/mapserv?" ) );
     }
 
+    void connectionSlotsSharedPerHost()
+    {
+      QSignalSpy spy( QgsTileCache::downloadNotifier(), &QgsTileDownloadNotifier::connectionReleased );
+
+      // the slots of a host are shared by all the callers, whatever their own budget
+      QVERIFY( QgsTileCache::acquireConnection( QStringLiteral( "tiles.example.com" ), 2 ) );
+      QVERIFY( QgsTileCache::acquireConnection( QStringLiteral( "tiles.example.com" ), 2 ) );
+      QVERIFY( !QgsTileCache::acquireConnection( QStringLiteral( "tiles.example.com" ), 2 ) );
+      QVERIFY( QgsTileCache::acquireConnection( QStringLiteral( "tiles.example.com" ), 3 ) );
+      QVERIFY( !QgsTileCache::acquireConnection( QStringLiteral( "tiles.example.com" ), 3 ) );
+      QCOMPARE( QgsTileCache::runningConnections( QStringLiteral( "tiles.example.com" ) ), 3 );
+
+      // other hosts have their own slots
+      QVERIFY( QgsTileCache::acquireConnection( QStringLiteral( "other.example.com" ), 1 ) );
+      QVERIFY( !QgsTileCache::acquireConnection( QStringLiteral( "other.example.com" ), 1 ) );
+
+      QgsTileCache::releaseConnection( QStringLiteral( "tiles.example.com" ) );
+      QCOMPARE( spy.count(), 1 );
+      QCOMPARE( spy.at( 0 ).at( 0 ).toString(), QStringLiteral( "tiles.example.com" ) );
+      QCOMPARE( QgsTileCache::runningConnections( QStringLiteral( "tiles.example.com" ) ), 2 );
+      QVERIFY( !QgsTileCache::acquireConnection( QStringLiteral( "tiles.example.com" ), 2 ) );
+      QVERIFY( QgsTileCache::acquireConnection( QStringLiteral( "tiles.example.com" ), 3 ) );
+
+      QgsTileCache::releaseConnection( QStringLiteral( "tiles.example.com" ) );
+      QgsTileCache::releaseConnection( QStringLiteral( "tiles.example.com" ) );
+      QgsTileCache::releaseConnection( QStringLiteral( "tiles.example.com" ) );
+      QgsTileCache::releaseConnection( QStringLiteral( "other.example.com" ) );
+      QCOMPARE( QgsTileCache::runningConnections( QStringLiteral( "tiles.example.com" ) ), 0 );
+      QCOMPARE( QgsTileCache::runningConnections( QStringLiteral( "other.example.com" ) ), 0 );
+
+      // releasing a slot which was not taken is ignored
+      spy.clear();
+      QgsTileCache::releaseConnection( QStringLiteral( "tiles.example.com" ) );
+      QCOMPARE( spy.count(), 0 );
+      QCOMPARE( QgsTileCache::runningConnections( QStringLiteral( "tiles.example.com" ) ), 0 );
+    }
+
   private:
     QgsWmsCapabilities *mCapabilities = nullptr;
 };
@@ -16,6 +16,7 @@ __copyright__ = 'Copyright 2015, The QGIS Project'
 __revision__ = '$Format:%H$'
 
 from qgis.core import (
+    QgsAggregateCalculator,
     QgsRectangle,
     QgsFeatureRequest,
     QgsFeature,
@@ -56,6 +57,11 @@ class ProviderTestCase(FeatureSourceTestCase):
         should be partially compiled """
         return set()
 
+    def pushedDownAggregates(self):
+        """ Individual derived provider tests should override this to return a list of aggregates which
+        the provider calculates itself, instead of QGIS iterating the features """
+        return set()
+
     def assert_query(self, source, expression, expected):
         FeatureSourceTestCase.assert_query(self, source, expression, expected)
 
@@ -278,6 +284,57 @@ class ProviderTestCase(FeatureSourceTestCase):
         self.source.setSubsetString(None)
         self.assertEqual(max_value, 300)
 
+    def testAggregate(self):
+        """ aggregates calculated by the provider must match the ones calculated from the features """
+        aggregates = [QgsAggregateCalculator.Count,
+                      QgsAggregateCalculator.CountDistinct,
+                      QgsAggregateCalculator.CountMissing,
+                      QgsAggregateCalculator.Min,
+                      QgsAggregateCalculator.Max,
+                      QgsAggregateCalculator.Sum,
+                      QgsAggregateCalculator.Mean,
+                      QgsAggregateCalculator.Median,
+                      QgsAggregateCalculator.StDev,
+                      QgsAggregateCalculator.StDevSample,
+                      QgsAggregateCalculator.Range]
+        index = self.source.fields().lookupField('cnt')
+        # finish with the compiler enabled, the default
+        for compiled in [False, True]:
+            try:
+                if compiled:
+                    self.enableCompiler()
+                else:
+                    self.disableCompiler()
+            except AttributeError:
+                pass
+            for filter in ['', '"cnt" > 100', '"name" = \'Apple\'', '"name" = \'nothing\'']:
+                calculator = QgsAggregateCalculator(self.vl)
+                calculator.setFilter(filter)
+                params = QgsAggregateCalculator.AggregateParameters()
+                params.filter = filter
+                for aggregate in aggregates:
+                    message = 'aggregate {} with filter {}, compiled {}'.format(aggregate, filter, compiled)
+                    expected, ok = calculator.calculate(aggregate, 'cnt')
+                    self.assertTrue(ok)
+                    val, ok = self.vl.aggregate(aggregate, 'cnt', params)
+                    self.assertTrue(ok, message)
+                    self.assertAggregateEqual(val, expected, message)
+
+                    # the provider calculates the aggregates it supports itself, unless the
+                    # filter would have to be evaluated by QGIS
+                    val, ok = self.source.aggregate(aggregate, index, params, None)
+                    if aggregate in self.pushedDownAggregates() and (compiled or not filter):
+                        self.assertTrue(ok, message)
+                        self.assertAggregateEqual(val, expected, message)
+                    elif filter and not compiled:
+                        self.assertFalse(ok, message)
+
+    def assertAggregateEqual(self, val, expected, message):
+        if expected is None or expected == NULL:
+            self.assertTrue(val is None or val == NULL, '{}: got {}'.format(message, val))
+        else:
+            self.assertAlmostEqual(val, expected, 6, message)
+
     def testExtent(self):
         reference = QgsGeometry.fromRect(
             QgsRectangle(-71.123, 66.33, -65.32, 78.3))
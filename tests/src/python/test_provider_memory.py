@@ -478,5 +478,101 @@ class TestPyQgsMemoryProviderIndexed(unittest.TestCase, ProviderTestCase):
         pass
 
 
+class TestPyQgsMemoryProviderColumnar(unittest.TestCase, ProviderTestCase):
+
+    """Runs the provider test suite against a memory layer with columnar storage"""
+
+    @classmethod
+    def createLayer(cls):
+        vl = QgsVectorLayer(
+            'Point?crs=epsg:4326&storage=columnar&field=pk:integer&field=cnt:integer&field=name:string(0)&field=name2:string(0)&field=num_char:string&key=pk',
+            'test', 'memory')
+        assert (vl.isValid())
+
+        f1 = QgsFeature()
+        f1.setAttributes([5, -200, NULL, 'NuLl', '5'])
+        f1.setGeometry(QgsGeometry.fromWkt('Point (-71.123 78.23)'))
+
+        f2 = QgsFeature()
+        f2.setAttributes([3, 300, 'Pear', 'PEaR', '3'])
+
+        f3 = QgsFeature()
+        f3.setAttributes([1, 100, 'Orange', 'oranGe', '1'])
+        f3.setGeometry(QgsGeometry.fromWkt('Point (-70.332 66.33)'))
+
+        f4 = QgsFeature()
+        f4.setAttributes([2, 200, 'Apple', 'Apple', '2'])
+        f4.setGeometry(QgsGeometry.fromWkt('Point (-68.2 70.8)'))
+
+        f5 = QgsFeature()
+        f5.setAttributes([4, 400, 'Honey', 'Honey', '4'])
+        f5.setGeometry(QgsGeometry.fromWkt('Point (-65.32 78.3)'))
+
+        vl.dataProvider().addFeatures([f1, f2, f3, f4, f5])
+        return vl
+
+    @classmethod
+    def setUpClass(cls):
+        """Run before all tests"""
+        # Create test layer
+        cls.vl = cls.createLayer()
+        cls.source = cls.vl.dataProvider()
+
+        # poly layer
+        cls.poly_vl = QgsVectorLayer('Polygon?crs=epsg:4326&storage=columnar&field=pk:integer&key=pk',
+                                     'test', 'memory')
+        assert (cls.poly_vl.isValid())
+        cls.poly_provider = cls.poly_vl.dataProvider()
+
+        f1 = QgsFeature()
+        f1.setAttributes([1])
+        f1.setGeometry(QgsGeometry.fromWkt('Polygon ((-69.0 81.4, -69.0 80.2, -73.7 80.2, -73.7 76.3, -74.9 76.3, -74.9 81.4, -69.0 81.4))'))
+
+        f2 = QgsFeature()
+        f2.setAttributes([2])
+        f2.setGeometry(QgsGeometry.fromWkt('Polygon ((-67.6 81.2, -66.3 81.2, -66.3 76.9, -67.6 76.9, -67.6 81.2))'))
+
+        f3 = QgsFeature()
+        f3.setAttributes([3])
+        f3.setGeometry(QgsGeometry.fromWkt('Polygon ((-68.4 75.8, -67.5 72.6, -68.6 73.7, -70.2 72.9, -68.4 75.8))'))
+
+        f4 = QgsFeature()
+        f4.setAttributes([4])
+
+        cls.poly_provider.addFeatures([f1, f2, f3, f4])
+
+    @classmethod
+    def tearDownClass(cls):
+        """Run after all tests"""
+
+    def getEditableLayer(self):
+        return self.createLayer()
+
+    def testUri(self):
+        """Test that the storage mode is part of the uri"""
+        self.assertIn('storage=columnar', self.source.dataSourceUri())
+        clone = QgsVectorLayer(self.source.dataSourceUri(), 'clone', 'memory')
+        self.assertTrue(clone.isValid())
+        self.assertIn('storage=columnar', clone.dataProvider().dataSourceUri())
+        self.assertEqual([f.name() for f in clone.fields()], [f.name() for f in self.vl.fields()])
+
+    def testMixedValueTypes(self):
+        """Test that values which do not match the field type are kept"""
+        vl = QgsVectorLayer('None?storage=columnar&field=i:integer&field=s:string', 'test', 'memory')
+        self.assertTrue(vl.isValid())
+        f1 = QgsFeature()
+        f1.setAttributes([1, 'a'])
+        f2 = QgsFeature()
+        f2.setAttributes(['x', NULL])
+        f3 = QgsFeature()
+        f3.setAttributes([NULL, 'a'])
+        self.assertTrue(vl.dataProvider().addFeatures([f1, f2, f3]))
+        self.assertEqual([f.attributes() for f in vl.getFeatures()], [[1, 'a'], ['x', NULL], [NULL, 'a']])
+
+        fid = [f.id() for f in vl.getFeatures()][1]
+        self.assertTrue(vl.dataProvider().deleteFeatures([fid]))
+        self.assertEqual([f.attributes() for f in vl.getFeatures()], [[1, 'a'], [NULL, 'a']])
+
+
 if __name__ == '__main__':
     unittest.main()
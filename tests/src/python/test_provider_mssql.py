@@ -16,7 +16,7 @@ import qgis  # NOQA
 
 import os
 
-from qgis.core import QgsSettings, QgsVectorLayer, QgsFeatureRequest
+from qgis.core import QgsSettings, QgsVectorLayer, QgsFeatureRequest, QgsAggregateCalculator
 
 from qgis.PyQt.QtCore import QDate, QTime, QDateTime, QVariant
 
@@ -56,6 +56,19 @@ class TestPyQgsMssqlProvider(unittest.TestCase, ProviderTestCase):
     def disableCompiler(self):
         QgsSettings().setValue('/qgis/compileExpressions', False)
 
+    def pushedDownAggregates(self):
+        # the median is only available as a window function
+        return set([QgsAggregateCalculator.Count,
+                    QgsAggregateCalculator.CountDistinct,
+                    QgsAggregateCalculator.CountMissing,
+                    QgsAggregateCalculator.Min,
+                    QgsAggregateCalculator.Max,
+                    QgsAggregateCalculator.Sum,
+                    QgsAggregateCalculator.Mean,
+                    QgsAggregateCalculator.Range,
+                    QgsAggregateCalculator.StDev,
+                    QgsAggregateCalculator.StDevSample])
+
     # HERE GO THE PROVIDER SPECIFIC TESTS
     def testDateTimeTypes(self):
         vl = QgsVectorLayer('%s table="qgis_test"."date_times" sql=' %
@@ -19,7 +19,7 @@ import tempfile
 import shutil
 from osgeo import gdal, ogr
 
-from qgis.core import QgsVectorLayer, QgsVectorLayerExporter, QgsFeature, QgsGeometry, QgsRectangle, QgsSettings
+from qgis.core import QgsVectorLayer, QgsVectorLayerExporter, QgsFeature, QgsGeometry, QgsRectangle, QgsSettings, QgsAggregateCalculator, NULL
 from qgis.PyQt.QtCore import QCoreApplication
 from qgis.testing import start_app, unittest
 
@@ -76,6 +76,40 @@ class TestPyQgsOGRProviderGpkg(unittest.TestCase):
         # The geometries must be binarily identical
         self.assertEqual(got_geom.exportToWkb(), reference.exportToWkb(), 'Expected {}, got {}'.format(reference.exportToWkt(), got_geom.exportToWkt()))
 
+    def testAddFeaturesLeaveNoPreviousValues(self):
+
+        tmpfile = os.path.join(self.basetestpath, 'testAddFeaturesLeaveNoPreviousValues.gpkg')
+        ds = ogr.GetDriverByName('GPKG').CreateDataSource(tmpfile)
+        lyr = ds.CreateLayer('test', geom_type=ogr.wkbPoint)
+        lyr.CreateField(ogr.FieldDefn('str_field', ogr.OFTString))
+        lyr.CreateField(ogr.FieldDefn('int_field', ogr.OFTInteger))
+        ds = None
+
+        vl = QgsVectorLayer('{}|layerid=0'.format(tmpfile), 'test', 'ogr')
+        f1 = QgsFeature()
+        f1.setAttributes([None, 'one', 1])
+        f1.setGeometry(QgsGeometry.fromWkt('Point (1 1)'))
+        # neither geometry nor values, nothing must be inherited from the previous feature
+        f2 = QgsFeature()
+        f2.setAttributes([None])
+        f3 = QgsFeature()
+        f3.setAttributes([None, 'three', None])
+        f3.setGeometry(QgsGeometry.fromWkt('Point (3 3)'))
+        ok, added = vl.dataProvider().addFeatures([f1, f2, f3])
+        self.assertTrue(ok)
+        self.assertEqual([f.id() for f in added], [1, 2, 3])
+
+        got = [feat for feat in vl.getFeatures()]
+        self.assertEqual(len(got), 3)
+        self.assertEqual(got[0].attributes(), [1, 'one', 1])
+        self.assertEqual(got[0].geometry().exportToWkt(), 'Point (1 1)')
+        self.assertEqual(got[1]['fid'], 2)
+        self.assertEqual(got[1]['str_field'], NULL)
+        self.assertEqual(got[1]['int_field'], NULL)
+        self.assertFalse(got[1].hasGeometry())
+        self.assertEqual(got[2].attributes(), [3, 'three', NULL])
+        self.assertEqual(got[2].geometry().exportToWkt(), 'Point (3 3)')
+
     def testCurveGeometryType(self):
 
         tmpfile = os.path.join(self.basetestpath, 'testCurveGeometryType.gpkg')
@@ -513,6 +547,53 @@ class TestPyQgsOGRProviderGpkg(unittest.TestCase):
         reference = QgsGeometry.fromWkt('Point (5 5)')
         self.assertEqual(got_geom.exportToWkb(), reference.exportToWkb(), 'Expected {}, got {}'.format(reference.exportToWkt(), got_geom.exportToWkt()))
 
+    def testAggregate(self):
+        """ numeric aggregates are calculated by SQLite """
+        tmpfile = os.path.join(self.basetestpath, 'testAggregate.gpkg')
+        ds = ogr.GetDriverByName('GPKG').CreateDataSource(tmpfile)
+        lyr = ds.CreateLayer('test', geom_type=ogr.wkbPoint)
+        lyr.CreateField(ogr.FieldDefn('cnt', ogr.OFTInteger))
+        lyr.CreateField(ogr.FieldDefn('name', ogr.OFTString))
+        for cnt, name in [(100, 'Orange'), (200, 'Apple'), (None, 'Honey'), (300, 'Pear'), (-200, None)]:
+            f = ogr.Feature(lyr.GetLayerDefn())
+            if cnt is not None:
+                f['cnt'] = cnt
+            if name is not None:
+                f['name'] = name
+            lyr.CreateFeature(f)
+            f = None
+        ds = None
+
+        vl = QgsVectorLayer('{}|layerid=0'.format(tmpfile), 'test', 'ogr')
+        self.assertTrue(vl.isValid())
+        index = vl.fields().lookupField('cnt')
+        for filter in ['', '"cnt" > 100', '"name" = \'Apple\'', '"name" = \'nothing\'']:
+            calculator = QgsAggregateCalculator(vl)
+            calculator.setFilter(filter)
+            params = QgsAggregateCalculator.AggregateParameters()
+            params.filter = filter
+            for aggregate in [QgsAggregateCalculator.Count,
+                              QgsAggregateCalculator.CountDistinct,
+                              QgsAggregateCalculator.CountMissing,
+                              QgsAggregateCalculator.Min,
+                              QgsAggregateCalculator.Max,
+                              QgsAggregateCalculator.Sum,
+                              QgsAggregateCalculator.Mean,
+                              QgsAggregateCalculator.Range]:
+                message = 'aggregate {} with filter {}'.format(aggregate, filter)
+                expected, ok = calculator.calculate(aggregate, 'cnt')
+                self.assertTrue(ok)
+                val, ok = vl.dataProvider().aggregate(aggregate, index, params, None)
+                self.assertTrue(ok, message)
+                if expected is None or expected == NULL:
+                    self.assertTrue(val is None or val == NULL, '{}: got {}'.format(message, val))
+                else:
+                    self.assertAlmostEqual(val, expected, 6, message)
+
+        # no median in SQLite, it is calculated from the features
+        val, ok = vl.dataProvider().aggregate(QgsAggregateCalculator.Median, index, QgsAggregateCalculator.AggregateParameters(), None)
+        self.assertFalse(ok)
+
 
 if __name__ == '__main__':
     unittest.main()
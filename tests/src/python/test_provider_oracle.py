@@ -16,7 +16,7 @@ import qgis  # NOQA
 
 import os
 
-from qgis.core import QgsSettings, QgsVectorLayer, QgsFeatureRequest, NULL
+from qgis.core import QgsSettings, QgsVectorLayer, QgsFeatureRequest, QgsAggregateCalculator, NULL
 
 from qgis.PyQt.QtCore import QDate, QTime, QDateTime, QVariant
 
@@ -128,6 +128,19 @@ class TestPyQgsOracleProvider(unittest.TestCase, ProviderTestCase):
         ])
         return filters
 
+    def pushedDownAggregates(self):
+        return set([QgsAggregateCalculator.Count,
+                    QgsAggregateCalculator.CountDistinct,
+                    QgsAggregateCalculator.CountMissing,
+                    QgsAggregateCalculator.Min,
+                    QgsAggregateCalculator.Max,
+                    QgsAggregateCalculator.Sum,
+                    QgsAggregateCalculator.Mean,
+                    QgsAggregateCalculator.Range,
+                    QgsAggregateCalculator.StDev,
+                    QgsAggregateCalculator.StDevSample,
+                    QgsAggregateCalculator.Median])
+
     # HERE GO THE PROVIDER SPECIFIC TESTS
     def testDateTimeTypes(self):
         vl = QgsVectorLayer('%s table="QGIS"."DATE_TIMES" sql=' %
@@ -28,10 +28,13 @@ from qgis.core import (
     NULL,
     QgsVectorLayerUtils,
     QgsSettings,
-    QgsTransactionGroup
+    QgsTransactionGroup,
+    QgsAggregateCalculator,
+    QgsProject,
+    QgsProviderRegistry
 )
 from qgis.gui import QgsGui
-from qgis.PyQt.QtCore import QDate, QTime, QDateTime, QVariant, QDir
+from qgis.PyQt.QtCore import QDate, QTime, QDateTime, QVariant, QDir, QTemporaryDir
 from qgis.testing import start_app, unittest
 from utilities import unitTestDataPath
 from providertestbase import ProviderTestCase
@@ -100,6 +103,19 @@ class TestPyQgsPostgresProvider(unittest.TestCase, ProviderTestCase):
     def partiallyCompiledFilters(self):
         return set([])
 
+    def pushedDownAggregates(self):
+        return set([QgsAggregateCalculator.Count,
+                    QgsAggregateCalculator.CountDistinct,
+                    QgsAggregateCalculator.CountMissing,
+                    QgsAggregateCalculator.Min,
+                    QgsAggregateCalculator.Max,
+                    QgsAggregateCalculator.Sum,
+                    QgsAggregateCalculator.Mean,
+                    QgsAggregateCalculator.Range,
+                    QgsAggregateCalculator.StDev,
+                    QgsAggregateCalculator.StDevSample,
+                    QgsAggregateCalculator.Median])
+
     # HERE GO THE PROVIDER SPECIFIC TESTS
     def testDefaultValue(self):
         self.source.setProviderProperty(QgsDataProvider.EvaluateDefaultValues, True)
@@ -718,6 +734,47 @@ class TestPyQgsPostgresProvider(unittest.TestCase, ProviderTestCase):
         self.assertEqual(desclist, [])
         self.assertEqual(errmsg, "")
 
+    def testReadLayersConcurrently(self):
+        """
+        Test that the providers of postgres project layers created concurrently share a connection per lane
+        """
+        tmpDir = QTemporaryDir()
+        tmpFile = "{}/project.qgs".format(tmpDir.path())
+
+        project = QgsProject()
+        for i in range(6):
+            vl = QgsVectorLayer(self.dbconn + ' sslmode=disable key=\'pk\' srid=4326 type=POINT table="qgis_test"."someData" (geom) sql=', 'test{}'.format(i), 'postgres')
+            self.assertTrue(vl.isValid())
+            project.addMapLayer(vl)
+        self.assertTrue(project.write(tmpFile))
+
+        def connectionCount():
+            cur = self.con.cursor()
+            cur.execute("SELECT count(*) FROM pg_stat_activity WHERE datname = current_database()")
+            count = cur.fetchone()[0]
+            cur.close()
+            self.con.commit()
+            return count
+
+        settings = QgsSettings()
+        settings.setValue("qgis/parallelLayerLoadingPerConnection", 2)
+        before = connectionCount()
+        project2 = QgsProject()
+        pending = []
+        project2.loadingLayer.connect(lambda: pending.append(QgsProviderRegistry.instance().preparedProviderCount()))
+        self.assertTrue(project2.read(tmpFile))
+        settings.remove("qgis/parallelLayerLoadingPerConnection")
+
+        # every layer picked up its prepared provider
+        self.assertEqual(pending, [6, 5, 4, 3, 2, 1])
+        self.assertEqual(QgsProviderRegistry.instance().preparedProviderCount(), 0)
+        # one connection per lane, instead of one per layer
+        self.assertLessEqual(connectionCount() - before, 2)
+        for l in project2.mapLayers().values():
+            self.assertTrue(l.isValid())
+            self.assertEqual(l.dataProvider().thread(), l.thread())
+            self.assertEqual(l.featureCount(), self.vl.featureCount())
+
 
 class TestPyQgsPostgresProviderCompoundKey(unittest.TestCase, ProviderTestCase):
 
@@ -748,6 +805,19 @@ class TestPyQgsPostgresProviderCompoundKey(unittest.TestCase, ProviderTestCase):
     def partiallyCompiledFilters(self):
         return set([])
 
+    def pushedDownAggregates(self):
+        return set([QgsAggregateCalculator.Count,
+                    QgsAggregateCalculator.CountDistinct,
+                    QgsAggregateCalculator.CountMissing,
+                    QgsAggregateCalculator.Min,
+                    QgsAggregateCalculator.Max,
+                    QgsAggregateCalculator.Sum,
+                    QgsAggregateCalculator.Mean,
+                    QgsAggregateCalculator.Range,
+                    QgsAggregateCalculator.StDev,
+                    QgsAggregateCalculator.StDevSample,
+                    QgsAggregateCalculator.Median])
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -27,7 +27,8 @@ from qgis.core import (QgsVectorLayer,
                        QgsProject,
                        QgsFieldConstraints,
                        QgsVectorLayerUtils,
-                       QgsSettings)
+                       QgsSettings,
+                       QgsAggregateCalculator)
 
 from qgis.testing import start_app, unittest
 from utilities import unitTestDataPath
@@ -253,6 +254,17 @@ class TestQgsSpatialiteProvider(unittest.TestCase, ProviderTestCase):
                     'name LIKE \'aPple\''
                     ])
 
+    def pushedDownAggregates(self):
+        # no standard deviation nor median in SQLite
+        return set([QgsAggregateCalculator.Count,
+                    QgsAggregateCalculator.CountDistinct,
+                    QgsAggregateCalculator.CountMissing,
+                    QgsAggregateCalculator.Min,
+                    QgsAggregateCalculator.Max,
+                    QgsAggregateCalculator.Sum,
+                    QgsAggregateCalculator.Mean,
+                    QgsAggregateCalculator.Range])
+
     def test_SplitFeature(self):
         """Create SpatiaLite database"""
         layer = QgsVectorLayer("dbname=%s table=test_pg (geometry)" % self.dbname, "test_pg", "spatialite")
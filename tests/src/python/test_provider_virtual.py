@@ -16,15 +16,18 @@ import qgis  # NOQA
 import os
 
 from qgis.core import (QgsVectorLayer,
+                       QgsExpression,
                        QgsFeature,
                        QgsFeatureRequest,
+                       QgsField,
                        QgsGeometry,
                        QgsRectangle,
                        QgsVirtualLayerDefinition,
                        QgsVirtualLayerDefinitionUtils,
                        QgsWkbTypes,
                        QgsProject,
-                       QgsVectorLayerJoinInfo
+                       QgsVectorLayerJoinInfo,
+                       NULL
                        )
 
 from qgis.testing import start_app, unittest
@@ -33,7 +36,7 @@ from utilities import unitTestDataPath
 from providertestbase import ProviderTestCase
 from qgis.PyQt.QtCore import QUrl, QVariant
 
-from qgis.utils import spatialite_connect
+from qgis.utils import spatialite_connect, qgsfunction
 
 import tempfile
 
@@ -665,6 +668,81 @@ class TestQgsVirtualLayerProvider(unittest.TestCase, ProviderTestCase):
         ml.addFeatures([f3])
         self.assertEqual(ml.featureCount(), vl.featureCount())
 
+    def test_constraintsPushDown(self):
+        ml = QgsVectorLayer("Point?srid=EPSG:4326&field=a:int&field=b:string", "pushdown", "memory")
+        self.assertEqual(ml.isValid(), True)
+        QgsProject.instance().addMapLayer(ml)
+
+        features = []
+        for a, b in ((1, 'apple'), (2, 'Banana'), (3, 'apple pie'), (4, None)):
+            f = QgsFeature(ml.fields())
+            f.setAttributes([a, b])
+            f.setGeometry(QgsGeometry.fromWkt('POINT({} {})'.format(a, a)))
+            features.append(f)
+        ml.dataProvider().addFeatures(features)
+
+        def query(where):
+            vl = QgsVectorLayer("?query=select a from pushdown where {} order by a".format(where), "vl", "virtual")
+            self.assertEqual(vl.isValid(), True, where)
+            return [f['a'] for f in vl.getFeatures()]
+
+        # several constraints on the same table
+        self.assertEqual(query("a > 1 and a <= 3"), [2, 3])
+        self.assertEqual(query("b = 'apple' and a >= 1"), [1])
+        self.assertEqual(query("b like 'apple%' and a < 3"), [1])
+        # SQLite LIKE semantics are kept
+        self.assertEqual(query("b like 'BANANA'"), [2])
+        # comparisons to NULL are never true
+        self.assertEqual(query("a = NULL"), [])
+        self.assertEqual(query("a > 1.5 and a < 2.5"), [2])
+
+        # only some columns are read
+        vl = QgsVectorLayer("?query=select t1.a, t2.b from pushdown t1, pushdown t2 where t2.a = t1.a + 1 order by t1.a", "vl", "virtual")
+        self.assertEqual(vl.isValid(), True)
+        self.assertEqual([f.attributes() for f in vl.getFeatures()], [[1, 'Banana'], [2, 'apple pie'], [3, NULL]])
+        vl = QgsVectorLayer("?query=select count(*) as c from pushdown", "vl", "virtual")
+        self.assertEqual([f['c'] for f in vl.getFeatures()], [4])
+
+        QgsProject.instance().removeMapLayer(ml.id())
+
+    def test_constraintsPushDownRequest(self):
+        # the values of an expression field are only calculated for the features and
+        # the columns the source layer is asked for
+        evaluated = []
+
+        @qgsfunction(args='auto', group='testing', register=False, referenced_columns=['a'])
+        def pushdown_counted(value, feature, parent):
+            evaluated.append(value)
+            return value
+
+        QgsExpression.registerFunction(pushdown_counted)
+        ml = QgsVectorLayer("Point?srid=EPSG:4326&field=a:int", "pushdown_request", "memory")
+        self.assertEqual(ml.isValid(), True)
+        features = []
+        for a in range(1, 5):
+            f = QgsFeature(ml.fields())
+            f.setAttributes([a])
+            features.append(f)
+        ml.dataProvider().addFeatures(features)
+        ml.addExpressionField('pushdown_counted("a")', QgsField('v', QVariant.Int))
+        QgsProject.instance().addMapLayer(ml)
+
+        def query(sql):
+            vl = QgsVectorLayer("?query={}".format(sql), "vl", "virtual")
+            self.assertEqual(vl.isValid(), True, sql)
+            del evaluated[:]
+            values = [f.attributes() for f in vl.getFeatures()]
+            return values, sorted(evaluated)
+
+        # the column is not read
+        self.assertEqual(query("select a from pushdown_request where a > 2 order by a"), ([[3], [4]], []))
+        # the constraints filter the features of the source layer
+        self.assertEqual(query("select v from pushdown_request where a > 2 order by v"), ([[3], [4]], [3, 4]))
+        self.assertEqual(query("select v from pushdown_request where a >= 2 and a < 4 order by v"), ([[2], [3]], [2, 3]))
+
+        QgsProject.instance().removeMapLayer(ml.id())
+        QgsExpression.unregisterFunction('pushdown_counted')
+
     def test_ProjectDependencies(self):
         # make a virtual layer with living references and save it to a project
         l1 = QgsVectorLayer(os.path.join(self.testDataDir, "france_parts.shp"), "france_parts", "ogr", False)
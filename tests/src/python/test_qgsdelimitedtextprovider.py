@@ -805,6 +805,86 @@ class TestQgsDelimitedTextProviderOther(unittest.TestCase):
         requests = None
         self.runTest(filename, requests, **params)
 
+    def test_041_random_access(self):
+        # Features requested by id in any order, from a file with a byte order
+        # mark, windows line ends and a record spanning several lines
+        (filehandle, filename) = tempfile.mkstemp(suffix='.csv')
+        if os.name == "nt":
+            filename = filename.replace("\\", "/")
+        with os.fdopen(filehandle, "wb") as f:
+            f.write(b'\xef\xbb\xbfid,name\r\n')
+            for i in range(1, 1001):
+                if i == 500:
+                    f.write('{},"line 1\r\nline 2"\r\n'.format(i).encode('utf-8'))
+                else:
+                    f.write('{},nom \u00e9 {}\r\n'.format(i, i).encode('utf-8'))
+
+        url = MyUrl.fromLocalFile(filename)
+        url.addQueryItem("type", "csv")
+        url.addQueryItem("geomType", "none")
+        layer = QgsVectorLayer(url.toString(), 'test', 'delimitedtext')
+        self.assertTrue(layer.isValid())
+        self.assertEqual(layer.fields().names(), ['id', 'name'])
+
+        features = dict((f.id(), f.attributes()) for f in layer.getFeatures())
+        self.assertEqual(len(features), 1000)
+        self.assertEqual(features[2], [1, 'nom \u00e9 1'])
+        self.assertEqual(features[501], [500, 'line 1\nline 2'])
+        self.assertEqual(features[503], [501, 'nom \u00e9 501'])
+
+        for fid in sorted(features.keys(), reverse=True):
+            f = next(layer.getFeatures(QgsFeatureRequest(fid)))
+            self.assertEqual(f.attributes(), features[fid])
+
+        # the subset index is read by id too
+        layer.setSubsetString('id % 100 = 0')
+        self.assertEqual([f.attributes()[0] for f in layer.getFeatures()], list(range(100, 1001, 100)))
+        self.assertEqual(next(layer.getFeatures(QgsFeatureRequest(1002))).attributes(), [1000, 'nom \u00e9 1000'])
+
+    def truncatedFileLayer(self, watchFile):
+        (filehandle, filename) = tempfile.mkstemp(suffix='.csv')
+        if os.name == "nt":
+            filename = filename.replace("\\", "/")
+        with os.fdopen(filehandle, "wb") as f:
+            f.write(b'id,name\n')
+            for i in range(1, 100001):
+                f.write('{},name {}\n'.format(i, i).encode('utf-8'))
+
+        url = MyUrl.fromLocalFile(filename)
+        url.addQueryItem("type", "csv")
+        url.addQueryItem("geomType", "none")
+        if watchFile:
+            url.addQueryItem("watchFile", "yes")
+        layer = QgsVectorLayer(url.toString(), 'test', 'delimitedtext')
+        self.assertTrue(layer.isValid())
+        return layer, filename
+
+    def test_042_watched_file_truncated(self):
+        # A watched file truncated during an iteration must not crash the iterator
+        layer, filename = self.truncatedFileLayer(True)
+        it = layer.getFeatures()
+        f = next(it)
+        self.assertEqual(f.attributes(), [1, 'name 1'])
+        with open(filename, "wb") as f:
+            f.write(b'id,name\n')
+        count = 1 + sum(1 for f in it)
+        self.assertLessEqual(count, 100000)
+
+    def test_043_file_truncated(self):
+        # Nor a file which is not watched, and is read in blocks, whether it is
+        # read sequentially or from its line offsets
+        layer, filename = self.truncatedFileLayer(False)
+        it = layer.getFeatures()
+        f = next(it)
+        self.assertEqual(f.attributes(), [1, 'name 1'])
+        fidIt = layer.getFeatures(QgsFeatureRequest().setFilterFids([50002, 90002]))
+        f = next(fidIt)
+        self.assertEqual(f.attributes(), [50001, 'name 50001'])
+        with open(filename, "wb") as f:
+            f.write(b'id,name\n')
+        count = 1 + sum(1 for f in it)
+        self.assertLessEqual(count, 100000)
+        self.assertLessEqual(sum(1 for f in fidIt), 1)
 
 if __name__ == '__main__':
     unittest.main()
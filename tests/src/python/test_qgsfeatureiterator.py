@@ -23,7 +23,8 @@ from qgis.core import (QgsVectorLayer,
                        NULL,
                        QgsProject,
                        QgsVectorLayerJoinInfo,
-                       QgsGeometry)
+                       QgsGeometry,
+                       QgsRectangle)
 from qgis.testing import start_app, unittest
 from qgis.PyQt.QtCore import QVariant
 
@@ -369,6 +370,67 @@ class TestQgsFeatureIterator(unittest.TestCase):
         self.assertEqual(res, ['a', 'b'])
         layer.rollBack()
 
+    def test_Prefetch(self):
+        layer = QgsVectorLayer("Point?field=x:integer&field=y:string", "layer", "memory")
+        features = []
+        for i in range(3000):
+            f = QgsFeature()
+            f.setAttributes([i, 'f{}'.format(i)])
+            f.setGeometry(QgsGeometry.fromWkt('Point({} {})'.format(i % 100, i // 100)))
+            features.append(f)
+        self.assertTrue(layer.dataProvider().addFeatures(features))
+
+        # edits are visible through the prefetching iterator
+        layer.startEditing()
+        f = QgsFeature(layer.fields())
+        f.setAttributes([5000, 'added'])
+        self.assertTrue(layer.addFeature(f))
+        self.assertTrue(layer.deleteFeature(1))
+
+        def fetch(request):
+            it = layer.getFeatures(request)
+            features = [(f.id(), f.attributes(), f.geometry().asWkt()) for f in it]
+            return features, it.prefetchStatistics()
+
+        def assertSameFeatures(request):
+            expected, statistics = fetch(QgsFeatureRequest(request))
+            self.assertFalse(statistics.prefetched)
+            self.assertEqual(statistics.prefetchedFeatures, 0)
+
+            # the features went through the background thread
+            request.setFlags(request.flags() | QgsFeatureRequest.Prefetch)
+            features, statistics = fetch(request)
+            self.assertEqual(features, expected)
+            self.assertTrue(statistics.prefetched)
+            self.assertEqual(statistics.prefetchedFeatures, len(expected))
+            self.assertGreaterEqual(statistics.producerStallTime, 0)
+            self.assertGreaterEqual(statistics.consumerStallTime, 0)
+            return expected
+
+        self.assertEqual(len(assertSameFeatures(QgsFeatureRequest())), 3000)
+        self.assertEqual(len(assertSameFeatures(QgsFeatureRequest().setFilterExpression('x % 7 = 0'))), 428)
+        self.assertEqual(len(assertSameFeatures(QgsFeatureRequest().setFilterFids([2, 3, 2500]))), 3)
+        self.assertEqual(len(assertSameFeatures(QgsFeatureRequest().setFilterRect(QgsRectangle(10, 10, 20, 20)))), 121)
+        self.assertEqual(len(assertSameFeatures(QgsFeatureRequest().setLimit(1500))), 1500)
+        ordered = assertSameFeatures(QgsFeatureRequest().addOrderBy('x', False))
+        self.assertEqual(ordered[0][1], [5000, 'added'])
+
+        # rewind starts over
+        it = layer.getFeatures(QgsFeatureRequest().setFlags(QgsFeatureRequest.Prefetch).setLimit(10))
+        first = [f.id() for f in it]
+        self.assertTrue(it.rewind())
+        self.assertEqual([f.id() for f in it], first)
+        self.assertEqual(it.prefetchStatistics().prefetchedFeatures, 20)
+
+        # closing the iterator before the end stops the background thread
+        it = layer.getFeatures(QgsFeatureRequest().setFlags(QgsFeatureRequest.Prefetch))
+        f = QgsFeature()
+        self.assertTrue(it.nextFeature(f))
+        self.assertTrue(it.close())
+        self.assertFalse(it.nextFeature(f))
+
+        layer.rollBack()
+
 
 if __name__ == '__main__':
     unittest.main()
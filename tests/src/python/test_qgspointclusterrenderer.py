@@ -42,7 +42,11 @@ from qgis.core import (QgsVectorLayer,
                        QgsPointDisplacementRenderer,
                        QgsMapSettings,
                        QgsProperty,
-                       QgsSymbolLayer
+                       QgsSymbolLayer,
+                       QgsFeature,
+                       QgsGeometry,
+                       QgsPointXY,
+                       QgsMapRendererSequentialJob
                        )
 from qgis.testing import start_app, unittest
 from utilities import (unitTestDataPath)
@@ -182,6 +186,50 @@ class TestQgsPointClusterRenderer(unittest.TestCase):
         self.layer.renderer().setClusterSymbol(old_marker)
         self.assertTrue(result)
 
+    def renderImage(self, layers):
+        settings = QgsMapSettings(self.mapsettings)
+        settings.setDestinationCrs(layers[0].crs())
+        settings.setExtent(QgsRectangle(-10, 0, 80, 80))
+        settings.setLayers(layers)
+        job = QgsMapRendererSequentialJob(settings)
+        job.start()
+        job.waitForFinished()
+        return job.renderedImage()
+
+    def pointLayer(self, points):
+        layer = QgsVectorLayer('Point?crs=EPSG:3857', 'points', 'memory')
+        features = []
+        for x, y in points:
+            f = QgsFeature()
+            f.setGeometry(QgsGeometry.fromPointXY(QgsPointXY(x, y)))
+            features.append(f)
+        self.assertTrue(layer.dataProvider().addFeatures(features)[0])
+        return layer
+
+    def testRenderCellBoundaries(self):
+        """ test rendering of points grouped across the cells of the grouping grid """
+        # with a tolerance of 10 map units the grid cells are 10 units wide
+        pairs = [((9.99, 30), (10.01, 30)),  # on both sides of a cell border
+                 ((20, 50), (10.5, 50)),  # on a cell border, with a point in the previous cell
+                 ((40, 10), (50, 20)),  # at the tolerance in both directions
+                 ((-0.01, 60), (0.01, 60))]  # on both sides of the origin
+        singles = [(60, 40), (60, 29.99),  # just further than the tolerance, on both sides of a cell border
+                   (70, 70)]
+
+        layer = self.pointLayer([p for pair in pairs for p in pair] + singles)
+        renderer = self.renderer.clone()
+        renderer.setTolerance(10)
+        renderer.setToleranceUnit(QgsUnitTypes.RenderMapUnits)
+        layer.setRenderer(renderer)
+
+        # the same image with the groups drawn by a regular renderer
+        clusters = self.pointLayer([((a[0] + b[0]) / 2.0, (a[1] + b[1]) / 2.0) for a, b in pairs])
+        clusters.setRenderer(QgsSingleSymbolRenderer(renderer.clusterSymbol().clone()))
+        points = self.pointLayer(singles)
+        points.setRenderer(renderer.embeddedRenderer().clone())
+
+        self.assertEqual(self.renderImage([layer]), self.renderImage([clusters, points]))
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -23,7 +23,10 @@ from qgis.core import (QgsProject,
                        QgsUnitTypes,
                        QgsCoordinateReferenceSystem,
                        QgsVectorLayer,
-                       QgsMapLayer)
+                       QgsRasterLayer,
+                       QgsSettings,
+                       QgsMapLayer,
+                       QgsProviderRegistry)
 from qgis.gui import (QgsLayerTreeMapCanvasBridge,
                       QgsMapCanvas)
 
@@ -751,6 +754,52 @@ class TestQgsProject(unittest.TestCase):
         project2.clear()
         self.assertFalse(project2.isZipped())
 
+    def testReadLayersConcurrently(self):
+        """
+        Test that the providers of project layers created concurrently are picked up by the right layers
+        """
+        tmpDir = QTemporaryDir()
+        tmpFile = "{}/project.qgs".format(tmpDir.path())
+
+        project = QgsProject()
+        layers = [QgsVectorLayer(os.path.join(TEST_DATA_DIR, "points.shp"), "points", "ogr"),
+                  QgsVectorLayer(os.path.join(TEST_DATA_DIR, "lines.shp"), "lines", "ogr"),
+                  QgsVectorLayer(os.path.join(TEST_DATA_DIR, "points.shp"), "points2", "ogr"),
+                  QgsVectorLayer(os.path.join(TEST_DATA_DIR, "polys.shp"), "polys", "ogr"),
+                  QgsRasterLayer(os.path.join(TEST_DATA_DIR, "landsat.tif"), "landsat", "gdal"),
+                  createLayer("memory")]
+        # the memory provider is not created concurrently
+        for l in layers:
+            self.assertTrue(l.isValid())
+        project.addMapLayers(layers)
+        self.assertTrue(project.write(tmpFile))
+
+        settings = QgsSettings()
+        for perConnection in [0, 1, 4]:
+            settings.setValue("qgis/parallelLayerLoadingPerConnection", perConnection)
+            project2 = QgsProject()
+            # number of providers created ahead and not picked up yet, before each layer is read
+            pending = []
+            project2.loadingLayer.connect(lambda: pending.append(QgsProviderRegistry.instance().preparedProviderCount()))
+            self.assertTrue(project2.read(tmpFile))
+            self.assertEqual(len(project2.mapLayers()), len(layers))
+            self.assertEqual(QgsProviderRegistry.instance().preparedProviderCount(), 0)
+            if perConnection == 0:
+                self.assertEqual(set(pending), {0})
+            else:
+                # each ogr and gdal layer picks up its prepared provider
+                self.assertEqual(len(pending), len(layers))
+                self.assertEqual(sorted(set(pending), reverse=True)[:5], [5, 4, 3, 2, 1])
+            for l in layers:
+                l2 = project2.mapLayer(l.id())
+                self.assertTrue(l2.isValid())
+                self.assertEqual(l2.name(), l.name())
+                self.assertEqual(l2.source(), l.source())
+                self.assertEqual(l2.dataProvider().thread(), l2.thread())
+            self.assertEqual(project2.mapLayer(layers[0].id()).featureCount(), layers[0].featureCount())
+            self.assertEqual(project2.mapLayer(layers[3].id()).featureCount(), layers[3].featureCount())
+        settings.remove("qgis/parallelLayerLoadingPerConnection")
+
     def testUpgradeOtfFrom2x(self):
         """
         Test that upgrading a 2.x project correctly brings across project CRS and OTF transformation settings
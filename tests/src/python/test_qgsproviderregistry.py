@@ -0,0 +1,82 @@
+# -*- coding: utf-8 -*-
+"""QGIS Unit tests for QgsProviderRegistry.
+
+.. note:: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+"""
+__author__ = 'QGIS project'
+__date__ = '19/10/2017'
+__copyright__ = 'Copyright 2017, The QGIS Project'
+# This will get replaced with a git SHA1 when you do a git archive
+__revision__ = '$Format:%H$'
+
+import qgis  # NOQA
+
+import os
+
+from qgis.testing import start_app, unittest
+from qgis.core import QgsProviderRegistry, QgsApplication, QgsVectorLayer, QgsSettings
+from utilities import unitTestDataPath
+
+start_app()
+
+
+class TestQgsProviderRegistry(unittest.TestCase):
+
+    def describeRegistry(self, registry):
+        return (registry.providerList(), registry.pluginList(),
+                registry.fileVectorFilters(), registry.fileRasterFilters(),
+                registry.databaseDrivers(), registry.directoryDrivers(), registry.protocolDrivers())
+
+    def testMetadataCache(self):
+        """Test that providers described from the cache are the same as the loaded ones"""
+        registry = QgsProviderRegistry.instance()
+        cacheFile = os.path.join(QgsApplication.qgisSettingsDirPath(), 'providers.cache')
+
+        if os.path.exists(cacheFile):
+            os.remove(cacheFile)
+        registry.setLibraryDirectory(registry.libraryDirectory())
+        self.assertTrue(os.path.exists(cacheFile))
+        loaded = self.describeRegistry(registry)
+        self.assertIn('ogr', loaded[0])
+        self.assertIn('memory', loaded[0])
+
+        # described from the cache
+        modified = os.path.getmtime(cacheFile)
+        registry.setLibraryDirectory(registry.libraryDirectory())
+        self.assertEqual(self.describeRegistry(registry), loaded)
+        self.assertEqual(os.path.getmtime(cacheFile), modified)
+
+        # the cache holds translated descriptions, it is rebuilt for another locale
+        settings = QgsSettings()
+        locale = settings.value('locale/userLocale')
+        with open(cacheFile, 'rb') as f:
+            cached = f.read()
+        try:
+            settings.setValue('locale/userLocale', 'xx_YY')
+            registry.setLibraryDirectory(registry.libraryDirectory())
+            with open(cacheFile, 'rb') as f:
+                self.assertNotEqual(f.read(), cached)
+        finally:
+            if locale is None:
+                settings.remove('locale/userLocale')
+            else:
+                settings.setValue('locale/userLocale', locale)
+        registry.setLibraryDirectory(registry.libraryDirectory())
+        self.assertEqual(self.describeRegistry(registry), loaded)
+
+        # providers described from the cache are loaded when used
+        layer = QgsVectorLayer(os.path.join(unitTestDataPath(), 'points.shp'), 'points', 'ogr')
+        self.assertTrue(layer.isValid())
+
+        # an invalid cache is ignored
+        with open(cacheFile, 'wb') as f:
+            f.write(b'invalid')
+        registry.setLibraryDirectory(registry.libraryDirectory())
+        self.assertEqual(self.describeRegistry(registry), loaded)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -133,6 +133,33 @@ class TestQgsServerSettings(unittest.TestCase):
         self.assertEqual(self.settings.cacheDirectory(), "/tmp/fake")
         os.environ.pop(env)
 
+    def test_env_metatile_size(self):
+        env = "QGIS_SERVER_METATILE_SIZE"
+
+        # metatiling is deactivated by default
+        self.assertEqual(self.settings.metatileSize(), 0)
+
+        os.environ[env] = "4"
+        self.settings.load()
+        self.assertEqual(self.settings.metatileSize(), 4)
+        os.environ.pop(env)
+
+    def test_env_tile_cache(self):
+        env_dir = "QGIS_SERVER_TILE_CACHE_DIRECTORY"
+        env_size = "QGIS_SERVER_TILE_CACHE_SIZE"
+
+        # tiles are kept in memory by default
+        self.assertEqual(self.settings.tileCacheDirectory(), "")
+        self.assertEqual(self.settings.tileCacheSize(), 50 * 1024 * 1024)
+
+        os.environ[env_dir] = "/tmp/tiles"
+        os.environ[env_size] = "1024"
+        self.settings.load()
+        self.assertEqual(self.settings.tileCacheDirectory(), "/tmp/tiles")
+        self.assertEqual(self.settings.tileCacheSize(), 1024)
+        os.environ.pop(env_dir)
+        os.environ.pop(env_size)
+
     def test_priority(self):
         env = "QGIS_OPTIONS_PATH"
         dpath = "conf0"
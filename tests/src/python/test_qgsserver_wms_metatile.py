@@ -0,0 +1,186 @@
+# -*- coding: utf-8 -*-
+"""QGIS Unit tests for the metatiled WMS GetMap requests of QgsServer.
+
+From build dir, run: ctest -R PyQgsServerWMSMetatile -V
+
+.. note:: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+"""
+__author__ = 'QGIS project'
+__date__ = '19/10/2017'
+__copyright__ = 'Copyright 2017, The QGIS Project'
+# This will get replaced with a git SHA1 when you do a git archive
+__revision__ = '$Format:%H$'
+
+import os
+import glob
+import shutil
+import tempfile
+import time
+import urllib.parse
+
+# The tile cache is created with the settings of the first metatiled request
+TILE_CACHE_DIRECTORY = tempfile.mkdtemp()
+os.environ['QGIS_SERVER_METATILE_SIZE'] = '2'
+os.environ['QGIS_SERVER_TILE_CACHE_DIRECTORY'] = TILE_CACHE_DIRECTORY
+
+from qgis.testing import unittest
+from qgis.PyQt.QtCore import QCoreApplication
+from qgis.PyQt.QtGui import QImage, QColor
+from qgis.core import QgsProject, QgsVectorLayer
+from qgis.server import QgsConfigCache
+
+import osgeo.gdal  # NOQA
+
+from test_qgsserver import QgsServerTestBase
+from utilities import unitTestDataPath
+
+# Tiles of a 10 degrees grid, all in the same metatile
+TILES = ['-120,20,-110,30', '-110,20,-100,30', '-120,30,-110,40', '-110,30,-100,40']
+
+
+class TestQgsServerWMSMetatile(QgsServerTestBase):
+
+    """QGIS Server metatiled WMS GetMap Tests"""
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestQgsServerWMSMetatile, cls).setUpClass()
+        cls.projectDirectory = tempfile.mkdtemp()
+        cls.metatileProjectPath = os.path.join(cls.projectDirectory, 'metatile.qgs')
+        cls.writeProject('Points')
+
+    @classmethod
+    def tearDownClass(cls):
+        shutil.rmtree(cls.projectDirectory, True)
+        shutil.rmtree(TILE_CACHE_DIRECTORY, True)
+        super(TestQgsServerWMSMetatile, cls).tearDownClass()
+
+    @classmethod
+    def writeProject(cls, title):
+        project = QgsProject()
+        layer = QgsVectorLayer(os.path.join(unitTestDataPath(), 'points.shp'), 'points', 'ogr')
+        assert layer.isValid()
+        project.addMapLayer(layer)
+        project.setTitle(title)
+        assert project.write(cls.metatileProjectPath)
+
+    def setUp(self):
+        super(TestQgsServerWMSMetatile, self).setUp()
+        # start each test with an empty tile cache
+        QgsConfigCache.instance().removeEntry(self.metatileProjectPath)
+        self.server.putenv('QGIS_SERVER_METATILE_SIZE', '2')
+
+    def getMap(self, bbox):
+        qs = "?" + "&".join(["%s=%s" % i for i in list({
+            "MAP": urllib.parse.quote(self.metatileProjectPath),
+            "SERVICE": "WMS",
+            "VERSION": "1.1.1",
+            "REQUEST": "GetMap",
+            "LAYERS": "points",
+            "STYLES": "",
+            "FORMAT": "image/png",
+            "BBOX": bbox,
+            "HEIGHT": "256",
+            "WIDTH": "256",
+            "CRS": "EPSG:4326"
+        }.items())])
+
+        r, h = self._result(self._execute_request(qs))
+        self.assertEqual(h.get("Content-Type"), "image/png", r)
+        image = QImage.fromData(r, 'PNG')
+        self.assertFalse(image.isNull())
+        return image.convertToFormat(QImage.Format_ARGB32)
+
+    def cachedTiles(self):
+        return glob.glob(os.path.join(TILE_CACHE_DIRECTORY, '*', '*.png'))
+
+    def assertImagesEqual(self, image, expected, max_diff=10):
+        self.assertEqual(image.size(), expected.size())
+        mismatches = 0
+        for y in range(image.height()):
+            for x in range(image.width()):
+                if image.pixel(x, y) != expected.pixel(x, y):
+                    mismatches += 1
+        self.assertLessEqual(mismatches, max_diff)
+
+    def assertIsRed(self, image):
+        self.assertEqual(image.pixelColor(0, 0), QColor(255, 0, 0))
+        self.assertEqual(image.pixelColor(image.width() - 1, image.height() - 1), QColor(255, 0, 0))
+
+    def fillCachedTilesWithRed(self):
+        tiles = self.cachedTiles()
+        red = QImage(256, 256, QImage.Format_ARGB32)
+        red.fill(QColor(255, 0, 0))
+        for tile in tiles:
+            self.assertTrue(red.save(tile, 'PNG'))
+        return tiles
+
+    def test_metatile_matches_direct_render(self):
+        metatiled = [self.getMap(bbox) for bbox in TILES]
+        # the first request rendered the whole metatile
+        self.assertEqual(len(self.cachedTiles()), 4)
+
+        self.server.putenv('QGIS_SERVER_METATILE_SIZE', '0')
+        direct = [self.getMap(bbox) for bbox in TILES]
+
+        # some points are drawn in each tile
+        white = QColor(255, 255, 255).rgba()
+        for image in direct:
+            self.assertTrue(any(image.pixel(x, y) != white for x in range(0, 256, 2) for y in range(0, 256, 2)))
+
+        for image, expected in zip(metatiled, direct):
+            self.assertImagesEqual(image, expected)
+
+    def test_cache_hit(self):
+        self.getMap(TILES[0])
+        self.assertEqual(len(self.fillCachedTilesWithRed()), 4)
+
+        # the tiles of the metatile are served from the cache
+        for bbox in TILES:
+            self.assertIsRed(self.getMap(bbox))
+
+        # requests which are not aligned on the grid are rendered
+        self.assertNotEqual(self.getMap('-115,20,-105,30').pixelColor(0, 0), QColor(255, 0, 0))
+
+    def test_project_change(self):
+        self.getMap(TILES[0])
+        self.fillCachedTilesWithRed()
+        self.assertIsRed(self.getMap(TILES[0]))
+
+        # the tiles are dropped once the project file changes
+        self.writeProject('Points modified')
+        timeout = time.time() + 10
+        while self.cachedTiles() and time.time() < timeout:
+            QCoreApplication.processEvents()
+            time.sleep(0.05)
+        self.assertEqual(self.cachedTiles(), [])
+
+        image = self.getMap(TILES[0])
+        self.assertNotEqual(image.pixelColor(0, 0), QColor(255, 0, 0))
+        self.server.putenv('QGIS_SERVER_METATILE_SIZE', '0')
+        self.assertImagesEqual(image, self.getMap(TILES[0]))
+
+    def test_project_version(self):
+        self.getMap(TILES[0])
+        self.fillCachedTilesWithRed()
+        directories = os.listdir(TILE_CACHE_DIRECTORY)
+        self.assertEqual(len(directories), 1)
+
+        # tiles of an older version of the project, e.g. stored by another server
+        # process, are not served even if the change was not notified
+        mtime = os.path.getmtime(self.metatileProjectPath) + 10
+        os.utime(self.metatileProjectPath, (mtime, mtime))
+        self.assertNotEqual(self.getMap(TILES[0]).pixelColor(0, 0), QColor(255, 0, 0))
+
+        # and their directory is dropped
+        self.assertEqual(len(self.cachedTiles()), 4)
+        self.assertEqual(len(os.listdir(TILE_CACHE_DIRECTORY)), 1)
+        self.assertNotEqual(os.listdir(TILE_CACHE_DIRECTORY), directories)
+
+
+if __name__ == '__main__':
+    unittest.main()
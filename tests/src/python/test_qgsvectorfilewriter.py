@@ -20,6 +20,7 @@ import qgis  # NOQA
 from qgis.core import (QgsVectorLayer,
                        QgsFeature,
                        QgsField,
+                       QgsFields,
                        QgsGeometry,
                        QgsPointXY,
                        QgsCoordinateReferenceSystem,
@@ -723,6 +724,44 @@ class TestQgsVectorFileWriter(unittest.TestCase):
 
         gdal.Unlink(filename)
 
+    def testWriteGpkgAsSink(self):
+        """Tests adding features to a GeoPackage writer, outside of writeAsVectorFormat."""
+
+        fields = QgsFields()
+        fields.append(QgsField('id', QVariant.Int))
+        fields.append(QgsField('name', QVariant.String))
+
+        filename = '/vsimem/sink.gpkg'
+        writer = QgsVectorFileWriter(filename, 'utf-8', fields, QgsWkbTypes.Point, QgsCoordinateReferenceSystem('EPSG:4326'), 'GPKG')
+        self.assertEqual(writer.hasError(), QgsVectorFileWriter.NoError)
+        self.assertEqual(writer.featuresWritten(), 0)
+        self.assertEqual(writer.writeRate(), 0)
+
+        features = []
+        for i in range(2000):
+            f = QgsFeature(fields)
+            f.setAttributes([i, 'feature {}'.format(i)])
+            f.setGeometry(QgsGeometry.fromPointXY(QgsPointXY(i, -i)))
+            features.append(f)
+        self.assertTrue(writer.addFeatures(features))
+        self.assertTrue(writer.addFeature(features[0]))
+        self.assertEqual(writer.featuresWritten(), 2001)
+        self.assertGreater(writer.writeRate(), 0)
+        # closes the file and commits the pending transaction
+        del writer
+
+        ds = ogr.Open(filename)
+        lyr = ds.GetLayer(0)
+        self.assertEqual(lyr.GetFeatureCount(), 2001)
+        for f in lyr:
+            i = f['id']
+            self.assertEqual(f['name'], 'feature {}'.format(i))
+            self.assertEqual(f.GetGeometryRef().ExportToWkt(), 'POINT ({} {})'.format(i, -i))
+        del lyr
+        del ds
+
+        gdal.Unlink(filename)
+
     def testSupportedFormatExtensions(self):
         formats = QgsVectorFileWriter.supportedFormatExtensions()
         self.assertTrue('gpkg' in formats)
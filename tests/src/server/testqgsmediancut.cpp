@@ -0,0 +1,163 @@
+/***************************************************************************
+     testqgsmediancut.cpp
+     --------------------
+    Date                 : October 2017
+    Copyright            : (C) 2017 by the QGIS project
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include <QObject>
+#include <QBuffer>
+#include <QImage>
+#include <QPainter>
+#include <QLinearGradient>
+
+#include "qgsmediancut.h"
+
+/** \ingroup UnitTests
+ * Tests for the palette quantization used by the WMS service for 8 bits PNG outputs
+ */
+class TestQgsMedianCut : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void fewColors();
+    void manyColors();
+    void benchmarkEncode8bit_data();
+    void benchmarkEncode8bit();
+
+  private:
+    QImage gradientImage( int width, int height ) const;
+
+    // sum of the squared differences between the original and the quantized image
+    double meanSquaredError( const QImage &image, const QImage &quantized ) const;
+};
+
+void TestQgsMedianCut::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsMedianCut::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+QImage TestQgsMedianCut::gradientImage( int width, int height ) const
+{
+  QImage image( width, height, QImage::Format_ARGB32 );
+  image.fill( Qt::transparent );
+
+  QPainter painter( &image );
+  QLinearGradient gradient( 0, 0, width, height );
+  gradient.setColorAt( 0, QColor( 255, 0, 0 ) );
+  gradient.setColorAt( 0.5, QColor( 0, 255, 0, 128 ) );
+  gradient.setColorAt( 1, QColor( 0, 0, 255 ) );
+  painter.fillRect( 0, 0, width, height / 2, gradient );
+  painter.setBrush( QColor( 200, 200, 50 ) );
+  painter.drawEllipse( QRect( width / 4, height / 4, width / 2, height / 2 ) );
+  painter.end();
+  return image;
+}
+
+double TestQgsMedianCut::meanSquaredError( const QImage &image, const QImage &quantized ) const
+{
+  double error = 0;
+  for ( int i = 0; i < image.height(); ++i )
+  {
+    const QRgb *line = reinterpret_cast< const QRgb * >( image.constScanLine( i ) );
+    for ( int j = 0; j < image.width(); ++j )
+    {
+      const QRgb c1 = line[j];
+      const QRgb c2 = quantized.pixel( j, i );
+      error += ( qRed( c1 ) - qRed( c2 ) ) * ( qRed( c1 ) - qRed( c2 ) )
+               + ( qGreen( c1 ) - qGreen( c2 ) ) * ( qGreen( c1 ) - qGreen( c2 ) )
+               + ( qBlue( c1 ) - qBlue( c2 ) ) * ( qBlue( c1 ) - qBlue( c2 ) )
+               + ( qAlpha( c1 ) - qAlpha( c2 ) ) * ( qAlpha( c1 ) - qAlpha( c2 ) );
+    }
+  }
+  return error / ( static_cast< double >( image.width() ) * image.height() );
+}
+
+void TestQgsMedianCut::fewColors()
+{
+  // colors of images with less than 256 colors must be kept
+  QImage image( 400, 400, QImage::Format_ARGB32 );
+  const QList<QRgb> colors = QList<QRgb>() << qRgba( 255, 0, 0, 255 ) << qRgba( 0, 255, 0, 255 )
+                             << qRgba( 0, 0, 255, 255 ) << qRgba( 10, 20, 30, 40 ) << qRgba( 0, 0, 0, 0 );
+  for ( int i = 0; i < image.height(); ++i )
+  {
+    QRgb *line = reinterpret_cast< QRgb * >( image.scanLine( i ) );
+    for ( int j = 0; j < image.width(); ++j )
+      line[j] = colors.at( ( i / 10 + j ) % colors.size() );
+  }
+
+  QVector<QRgb> colorTable;
+  QgsWms::medianCut( colorTable, 256, image );
+  QCOMPARE( colorTable.size(), colors.size() );
+
+  QImage quantized = QgsWms::quantizeImage( image, colorTable );
+  QCOMPARE( quantized.format(), QImage::Format_Indexed8 );
+  QCOMPARE( quantized.size(), image.size() );
+  QCOMPARE( meanSquaredError( image, quantized ), 0.0 );
+}
+
+void TestQgsMedianCut::manyColors()
+{
+  QImage image = gradientImage( 800, 600 );
+
+  QVector<QRgb> colorTable;
+  QgsWms::medianCut( colorTable, 256, image );
+  QVERIFY( colorTable.size() <= 256 );
+
+  QImage quantized = QgsWms::quantizeImage( image, colorTable );
+  QCOMPARE( quantized.size(), image.size() );
+
+  // the result should be as good as the nearest color search done by Qt
+  QImage reference = image.convertToFormat( QImage::Format_Indexed8, colorTable,
+                     Qt::ColorOnly | Qt::ThresholdDither |
+                     Qt::ThresholdAlphaDither | Qt::NoOpaqueDetection );
+  QVERIFY( meanSquaredError( image, quantized ) <= meanSquaredError( image, reference ) * 1.5 + 1 );
+}
+
+void TestQgsMedianCut::benchmarkEncode8bit_data()
+{
+  QTest::addColumn<int>( "size" );
+  QTest::newRow( "256" ) << 256;
+  QTest::newRow( "1024" ) << 1024;
+  QTest::newRow( "4096" ) << 4096;
+}
+
+void TestQgsMedianCut::benchmarkEncode8bit()
+{
+  QFETCH( int, size );
+  const QImage image = gradientImage( size, size );
+
+  // measures the whole encoding of a mode=8bit PNG response
+  QBENCHMARK
+  {
+    QVector<QRgb> colorTable;
+    QgsWms::medianCut( colorTable, 256, image );
+    QImage quantized = QgsWms::quantizeImage( image, colorTable );
+
+    QByteArray data;
+    QBuffer buffer( &data );
+    buffer.open( QIODevice::WriteOnly );
+    quantized.save( &buffer, "PNG" );
+  }
+}
+
+QGSTEST_MAIN( TestQgsMedianCut )
+#include "testqgsmediancut.moc"